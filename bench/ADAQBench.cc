@@ -0,0 +1,739 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: ADAQBench.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: ADAQBench is a standalone binary that drives each of the
+//       AAComputation processing stages without the graphical user
+//       interface and reports the throughput of each stage in
+//       waveforms per second and megabytes (of digitized samples) per
+//       second. The stages benchmarked are: file loading and waveform
+//       readout; baseline-subtracted and zero-suppressed waveform
+//       calculation; peak finding; PSD histogram creation; spectrum
+//       creation with the simple maximum/sum (SMS) and peak finder
+//       (PF) algorithms; and despliced file creation. It is intended
+//       to be run on files written by ADAQSynthesizer via "make bench"
+//       but will run on any production format ADAQ file, including
+//       the EJ309 files bundled in test/.
+//
+//       Each spectrum (SMS, PF and WD algorithms in both pulse height
+//       and pulse area), each PSD histogram (SMS, PF and WD) and the
+//       per-pulse values from which they were filled are retained as
+//       results. The results may be written to a ROOT file to serve as
+//       a "golden" reference and later compared against that reference
+//       within a relative tolerance such that changes to the processing
+//       code can be checked for regressions in the output alongside the
+//       throughput. A nonzero value is returned if any result differs.
+//       The spectrum and PSD stages may be run in parallel through
+//       the ADAQAnalysis_MPI binary (par=<N>) such that the sequential,
+//       threaded (imt=<N>) and parallel results may each be checked
+//       against the same reference. References for the EJ309 files in
+//       test/ are written by "make golden" but are not distributed.
+//
+//       $ ADAQBench <ADAQFile> [key=value ...]
+//
+//       waveforms=<N>      : Number of waveforms to process (def: all)
+//       channel=<N>        : Digitizer channel to process (def: 0)
+//       write=<RefFile>    : Write the results to a reference ROOT file
+//       check=<RefFile>    : Compare the results to a reference ROOT file
+//       tolerance=<Value>  : Relative comparison tolerance (def: 1e-6)
+//       cache=<MB>         : TTreeCache size; 0 disables (def: 64)
+//       imt=<N>            : Implicit multithreading threads (def: 0)
+//       par=<N>            : Number of MPI processes for the spectrum
+//                            and PSD stages; 0 is sequential (def: 0)
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+
+// ROOT
+#include <TROOT.h>
+#include <TStopwatch.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TList.h>
+#include <TH1F.h>
+#include <TH2F.h>
+#include <TVectorD.h>
+
+// C++
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAComputation.hh"
+#include "AAParallel.hh"
+#include "AASettings.hh"
+#include "AATypes.hh"
+
+
+// The bytes of digitized data processed per waveform, used to convert
+// the waveform throughput into a data throughput
+static Double_t BytesPerWaveform = 0.;
+
+// The named results (histograms and per-pulse value vectors) retained
+// from each processing stage for writing or regression comparison
+static vector<string> ResultNames;
+static vector<TObject *> Results;
+
+
+void ReportStage(string Stage, Int_t Waveforms, TStopwatch &Timer)
+{
+  Double_t Seconds = Timer.RealTime();
+  Double_t Rate = (Seconds > 0.) ? Waveforms/Seconds : 0.;
+  Double_t MBRate = Rate * BytesPerWaveform / (1024.*1024.);
+
+  cout << "  " << setw(22) << left << Stage
+       << setw(12) << right << fixed << setprecision(4) << Seconds
+       << setw(16) << setprecision(1) << Rate
+       << setw(12) << setprecision(2) << MBRate
+       << endl;
+}
+
+
+// Fill the settings object with the same defaults that the GUI widgets
+// are initialized to such that each stage runs on a representative
+// configuration for the loaded file
+void InitializeSettings(AASettings *S, AAComputation *Mgr, Int_t Channel, Int_t Waveforms)
+{
+  ADAQReadoutInformation *ARI = Mgr->GetADAQReadoutInformation();
+  Int_t RecordLength = ARI->GetRecordLength();
+
+  S->ADAQFileName = Mgr->GetADAQFileName();
+  S->WaveformChannel = Channel;
+  S->WaveformToPlot = 0;
+  S->RawWaveform = false;
+  S->BSWaveform = true;
+  S->ZSWaveform = false;
+  S->WaveformPolarity = -1.0;
+  S->ZeroSuppressionCeiling = 15;
+  S->ZeroSuppressionBuffer = 10;
+  S->FindPeaks = true;
+  S->UseMarkovSmoothing = true;
+  S->MaxPeaks = 5;
+  S->Sigma = 2;
+  S->Floor = 50;
+  S->Resolution = 0.005;
+  S->UsePileupRejection = true;
+  S->UsePileupRecovery = false;
+  S->PulseTemplateFileName = "";
+  S->UsePeakTiming = false;
+  S->TimingCFD = true;
+  S->TimingLeadingEdge = false;
+  S->CFDFraction = 0.3;
+  S->CFDDelay = 4;
+  S->LeadingEdgeThreshold = 100.;
+  S->BaselineRegionMin = ARI->GetBaselineCalcMin().at(Channel);
+  S->BaselineRegionMax = ARI->GetBaselineCalcMax().at(Channel);
+  S->BaselineEstimator = 0;
+  S->BaselineTrimFraction = 0.1;
+  S->BaselineMedianWindow = 101;
+  S->BaselineTimeConstant = 200.;
+  S->BaselineThreshold = 20.;
+  S->AnalysisRegionMin = 0;
+  S->AnalysisRegionMax = RecordLength;
+  S->WaveformAnalysis = false;
+  S->PersistenceFirstWaveform = 0;
+  S->PersistenceLastWaveform = Waveforms;
+  S->PersistenceXBins = 1024;
+  S->PersistenceYBins = 512;
+  S->PersistenceYMin = -256.;
+  S->PersistenceYMax = 4096.;
+  S->PersistenceEnergyGate = false;
+  S->PersistenceEnergyMin = 0.;
+  S->PersistenceEnergyMax = 1.e9;
+  S->PersistencePSDGate = false;
+
+  S->WaveformsToHistogram = Waveforms;
+  S->SpectrumNumBins = 200;
+  S->SpectrumMinBin = 0.;
+  S->SpectrumMaxBin = 30000.;
+  S->SpectrumMinThresh = 0.;
+  S->SpectrumMaxThresh = 30000.;
+  S->ADAQSpectrumTypePAS = true;
+  S->ADAQSpectrumTypePHS = false;
+  S->ADAQSpectrumAlgorithmSMS = true;
+  S->ADAQSpectrumAlgorithmPF = false;
+  S->ADAQSpectrumAlgorithmWD = false;
+  S->ADAQSpectrumAlgorithmDS = false;
+  S->ShaperTrapezoid = true;
+  S->ShaperCRRC = false;
+  S->ShaperRiseTime = 10;
+  S->ShaperFlatTop = 5;
+  S->ShaperShapingTime = 8.;
+  S->ShaperOrder = 4;
+  S->ShaperDecayTime = 0.;
+  S->CalibrationType = "Linear fit";
+  S->EnergyUnit = 0;
+
+  S->PSDWaveformsToDiscriminate = Waveforms;
+  S->PSDThreshold = 100.;
+  S->PSDNumTotalBins = 150;
+  S->PSDMinTotalBin = 0.;
+  S->PSDMaxTotalBin = 30000.;
+  S->PSDXAxisADC = true;
+  S->PSDXAxisEnergy = false;
+  S->PSDNumTailBins = 150;
+  S->PSDMinTailBin = 0.;
+  S->PSDMaxTailBin = 1.;
+  S->PSDYAxisTail = false;
+  S->PSDYAxisTailTotal = true;
+  S->PSDTotalStart = -5;
+  S->PSDTotalStop = 50;
+  S->PSDTailStart = 6;
+  S->PSDTailStop = 50;
+  S->PSDAlgorithmSMS = true;
+  S->PSDAlgorithmPF = false;
+  S->PSDAlgorithmWD = false;
+  S->PSDInsideRegion = true;
+  S->PSDOutsideRegion = false;
+
+  S->SeqProcessing = true;
+  S->ParProcessing = false;
+  S->NumProcessors = 1;
+  S->UpdateFreq = 2;
+  S->UseFixedPoint = false;
+  S->WaveformsToDesplice = Waveforms;
+  S->DesplicedWaveformBuffer = 100;
+  S->DesplicedWaveformLength = 512;
+  S->DesplicedFileName = "/tmp/ADAQBench_Despliced.adaq.root";
+  S->ListModeOutput = false;
+  S->BuildPulseTemplates = false;
+  S->PulseTemplateOutputFileName = "";
+  S->TemplatePreSamples = 20;
+  S->TemplatePostSamples = 100;
+  S->TemplateWindowMin = 0.;
+  S->TemplateWindowMax = 1.e9;
+  S->ProfileProcessing = false;
+  S->ProfileFileName = "";
+  S->TreeCacheSize = 64;
+  S->TreeCacheLearnEntries = 10;
+  S->TreeCacheChannelOnly = false;
+  S->IMTThreads = 0;
+  S->ReadAheadSize = 256;
+  S->WaveformCacheSize = 0;
+  S->WaveformPrefetch = 0;
+
+  S->UseSpectraCalibrations = Mgr->GetUseSpectraCalibrations();
+  S->SpectraCalibrationData = Mgr->GetSpectraCalibrationData();
+  S->SpectraCalibrations = Mgr->GetSpectraCalibrations();
+  S->UsePSDRegions = Mgr->GetUsePSDRegions();
+  S->PSDRegions = Mgr->GetPSDRegions();
+}
+
+
+// Apply a settings change in the same manner as the GUI such that the
+// pipeline stage revisions are updated and cached results are not
+// incorrectly reused between benchmarked stages. The algorithm is one
+// of "SMS", "PF", "WD" or "DS" and applies to both spectra and PSD
+// (for which "DS" is not available and is treated as "SMS")
+void UpdateSettings(AASettings *S, AAComputation *Mgr, string Algorithm, Bool_t PAS = true)
+{
+  AASettings PreviousSettings(*S);
+  S->ADAQSpectrumAlgorithmSMS = (Algorithm == "SMS");
+  S->ADAQSpectrumAlgorithmPF = (Algorithm == "PF");
+  S->ADAQSpectrumAlgorithmWD = (Algorithm == "WD");
+  S->ADAQSpectrumAlgorithmDS = (Algorithm == "DS");
+  S->ADAQSpectrumTypePAS = PAS;
+  S->ADAQSpectrumTypePHS = !PAS;
+  S->PSDAlgorithmSMS = (Algorithm == "SMS" or Algorithm == "DS");
+  S->PSDAlgorithmPF = (Algorithm == "PF");
+  S->PSDAlgorithmWD = (Algorithm == "WD");
+  S->TrackChanges(&PreviousSettings);
+  Mgr->SetADAQSettings(S);
+}
+
+
+// Run a processing stage through the parallel binary in the same
+// manner as the GUI: the settings are written to the transient file
+// from which the parallel binary reads them, and the parallel results
+// are then absorbed into the manager
+void ProcessInParallel(AASettings *S, AAComputation *Mgr, string ProcessingType)
+{
+  string USER = getenv("USER");
+  string SettingsFileName = "/tmp/ADAQSettings_" + USER + ".root";
+
+  TFile *SettingsFile = new TFile(SettingsFileName.c_str(), "recreate");
+  S->Write("ADAQSettings");
+  SettingsFile->Write();
+  SettingsFile->Close();
+  delete SettingsFile;
+
+  Mgr->ProcessWaveformsInParallel(ProcessingType);
+}
+
+
+void StoreHistogram(string Name, TH1 *H)
+{
+  TH1 *Clone = (TH1 *)H->Clone(Name.c_str());
+  Clone->SetDirectory(0);
+
+  ResultNames.push_back(Name);
+  Results.push_back(Clone);
+}
+
+
+void StoreVector(string Name, const vector<Double_t> &V)
+{
+  TVectorD *Clone = new TVectorD(V.size());
+  for(size_t i=0; i<V.size(); i++)
+    (*Clone)[i] = V[i];
+
+  ResultNames.push_back(Name);
+  Results.push_back(Clone);
+}
+
+
+Bool_t WriteResults(string FileName)
+{
+  TFile *F = new TFile(FileName.c_str(), "recreate");
+  if(!F->IsOpen()){
+    cout << "\nADAQBench error! Could not create reference file '" << FileName << "'!\n" << endl;
+    return false;
+  }
+
+  for(size_t r=0; r<Results.size(); r++)
+    Results[r]->Write(ResultNames[r].c_str());
+
+  F->Close();
+  delete F;
+
+  cout << "ADAQBench : Wrote " << Results.size() << " results to '" << FileName << "'\n" << endl;
+
+  return true;
+}
+
+
+// Values are compared relative to their magnitude, falling back to an
+// absolute comparison for magnitudes less than unity (e.g. empty bins
+// or tail/total ratios) such that zero-valued results do not fail
+Bool_t WithinTolerance(Double_t Value, Double_t Reference, Double_t Tolerance)
+{
+  Double_t Scale = max(1., max(fabs(Value), fabs(Reference)));
+  return (fabs(Value - Reference) <= Tolerance*Scale);
+}
+
+
+Bool_t CheckResults(string FileName, Double_t Tolerance)
+{
+  TFile *F = new TFile(FileName.c_str(), "read");
+  if(!F->IsOpen()){
+    cout << "\nADAQBench error! Could not open reference file '" << FileName << "'!\n" << endl;
+    return false;
+  }
+
+  cout << "ADAQBench : Comparing results to '" << FileName
+       << "' (tolerance " << Tolerance << ")\n" << endl;
+
+  Int_t Failures = 0;
+
+  for(size_t r=0; r<Results.size(); r++){
+
+    string Name = ResultNames[r];
+    TObject *Reference = F->Get(Name.c_str());
+
+    Int_t Values = 0, Differences = 0;
+    Double_t MaxDeviation = 0.;
+    Bool_t SizeMatch = true;
+
+    if(Reference == NULL){
+      cout << "  FAIL  " << setw(26) << left << Name << " : missing from reference file" << endl;
+      Failures++;
+      continue;
+    }
+    else if(Results[r]->InheritsFrom(TH1::Class()) and Reference->InheritsFrom(TH1::Class())){
+      TH1 *H = (TH1 *)Results[r];
+      TH1 *HRef = (TH1 *)Reference;
+
+      SizeMatch = (H->GetNcells() == HRef->GetNcells());
+
+      for(Int_t c=0; SizeMatch and c<H->GetNcells(); c++){
+	Double_t Deviation = fabs(H->GetBinContent(c) - HRef->GetBinContent(c));
+	if(!WithinTolerance(H->GetBinContent(c), HRef->GetBinContent(c), Tolerance))
+	  Differences++;
+	MaxDeviation = max(MaxDeviation, Deviation);
+	Values++;
+      }
+    }
+    else if(Results[r]->InheritsFrom(TVectorD::Class()) and Reference->InheritsFrom(TVectorD::Class())){
+      TVectorD *V = (TVectorD *)Results[r];
+      TVectorD *VRef = (TVectorD *)Reference;
+
+      SizeMatch = (V->GetNrows() == VRef->GetNrows());
+
+      for(Int_t i=0; SizeMatch and i<V->GetNrows(); i++){
+	Double_t Deviation = fabs((*V)[i] - (*VRef)[i]);
+	if(!WithinTolerance((*V)[i], (*VRef)[i], Tolerance))
+	  Differences++;
+	MaxDeviation = max(MaxDeviation, Deviation);
+	Values++;
+      }
+    }
+    else
+      SizeMatch = false;
+
+    if(!SizeMatch){
+      cout << "  FAIL  " << setw(26) << left << Name << " : size or type differs from reference" << endl;
+      Failures++;
+    }
+    else if(Differences > 0){
+      cout << "  FAIL  " << setw(26) << left << Name << " : " << Differences << " of " << Values
+	   << " values differ (max deviation " << scientific << MaxDeviation << fixed << ")" << endl;
+      Failures++;
+    }
+    else
+      cout << "  PASS  " << setw(26) << left << Name << " : " << Values << " values" << endl;
+  }
+
+  // Results present in the reference but not produced by this run
+  // (e.g. a stage that no longer produces output) are also failures
+  Int_t ReferenceResults = F->GetListOfKeys()->GetSize();
+  if(ReferenceResults != (Int_t)Results.size()){
+    cout << "  FAIL  " << setw(26) << left << "Result count" << " : " << Results.size()
+	 << " results but " << ReferenceResults << " in reference file" << endl;
+    Failures++;
+  }
+
+  F->Close();
+  delete F;
+
+  cout << "\nADAQBench : " << (Failures ? "FAILED" : "PASSED") << " with " << Failures
+       << " failure(s) against the reference\n" << endl;
+
+  return (Failures == 0);
+}
+
+
+int main(int argc, char *argv[])
+{
+  if(argc < 2){
+    cout << "\nADAQBench error! Usage: ADAQBench <ADAQFile> [waveforms=<N>] [channel=<N>]\n"
+	 << "                        [write=<RefFile>] [check=<RefFile>] [tolerance=<Value>]\n"
+	 << "                        [cache=<MB>] [imt=<N>] [templates=<TemplateFile>]\n"
+	 << "                        [wfcache=<MB>] [baseline=<0-3>]\n"
+	 << "                        [fixedpoint=<0|1>] [par=<N>]\n" << endl;
+    return -42;
+  }
+
+  string FileName = argv[1];
+  Int_t Waveforms = -1;
+  Int_t Channel = 0;
+  string WriteFileName = "", CheckFileName = "";
+  Double_t Tolerance = 1e-6;
+  Int_t TreeCacheSize = 64, IMTThreads = 0, ParallelProcesses = 0;
+  // The decoded waveform cache is disabled by default such that the
+  // stage timings include reading the waveforms from the ADAQ file
+  Int_t WaveformCacheSize = 0;
+  Int_t BaselineEstimator = 0;
+  Bool_t UseFixedPoint = false;
+  string TemplateFileName = "";
+
+  for(Int_t arg=2; arg<argc; arg++){
+    string Arg = argv[arg];
+    size_t Pos = Arg.find('=');
+
+    if(Pos == string::npos){
+      cout << "\nADAQBench error! Arguments must be of the form key=value!\n" << endl;
+      return -42;
+    }
+
+    string Key = Arg.substr(0, Pos);
+    string Value = Arg.substr(Pos+1);
+
+    if(Key == "waveforms") Waveforms = atoi(Value.c_str());
+    else if(Key == "channel") Channel = atoi(Value.c_str());
+    else if(Key == "write") WriteFileName = Value;
+    else if(Key == "check") CheckFileName = Value;
+    else if(Key == "tolerance") Tolerance = atof(Value.c_str());
+    else if(Key == "cache") TreeCacheSize = atoi(Value.c_str());
+    else if(Key == "imt") IMTThreads = atoi(Value.c_str());
+    else if(Key == "par") ParallelProcesses = atoi(Value.c_str());
+    else if(Key == "wfcache") WaveformCacheSize = atoi(Value.c_str());
+    else if(Key == "baseline") BaselineEstimator = atoi(Value.c_str());
+    else if(Key == "fixedpoint") UseFixedPoint = (atoi(Value.c_str()) != 0);
+    else if(Key == "templates") TemplateFileName = Value;
+    else{
+      cout << "\nADAQBench error! Unrecognized option '" << Key << "'!\n" << endl;
+      return -42;
+    }
+  }
+
+  gROOT->SetBatch(true);
+
+  // The parallel manager locates the parallel binary and the transient
+  // file through which the parallel results are returned
+  if(ParallelProcesses > 0)
+    new AAParallel;
+
+  // Note that the settings are passed to the manager only once they
+  // have been initialized for the loaded file
+  AAComputation *Mgr = new AAComputation("Unspecified", false);
+  AASettings *Settings = new AASettings;
+
+  TStopwatch Timer;
+
+
+  //////////////////////////////////////
+  // Stage: file loading and readout
+
+  Timer.Start();
+
+  if(!Mgr->LoadADAQFile(FileName) or Mgr->GetADAQLegacyFileLoaded()){
+    cout << "\nADAQBench error! Could not load '" << FileName
+	 << "' as a production format ADAQ file!\n" << endl;
+    return -42;
+  }
+
+  Int_t Entries = Mgr->GetADAQNumberOfWaveforms();
+  if(Waveforms < 0 or Waveforms > Entries)
+    Waveforms = Entries;
+
+  if(Channel < 0 or Channel >= Mgr->GetADAQReadoutInformation()->GetDGNumChannels()){
+    cout << "\nADAQBench error! Channel " << Channel << " is not present in the file!\n" << endl;
+    return -42;
+  }
+
+  InitializeSettings(Settings, Mgr, Channel, Waveforms);
+  Settings->TreeCacheSize = TreeCacheSize;
+  Settings->IMTThreads = IMTThreads;
+  Settings->WaveformCacheSize = WaveformCacheSize;
+  Settings->BaselineEstimator = BaselineEstimator;
+  Settings->UseFixedPoint = UseFixedPoint;
+  Settings->NumProcessors = max(ParallelProcesses, 1);
+  Settings->UsePileupRecovery = (TemplateFileName != "");
+  Settings->PulseTemplateFileName = TemplateFileName;
+  UpdateSettings(Settings, Mgr, "SMS");
+
+  BytesPerWaveform = Mgr->GetADAQReadoutInformation()->GetRecordLength() * sizeof(Int_t);
+
+  for(Int_t wf=0; wf<Waveforms; wf++){
+    Mgr->ReadWaveformEntry(Channel, wf);
+    Mgr->CalculateRawWaveform(Channel, wf);
+  }
+
+  Timer.Stop();
+
+  cout << "\nADAQBench : " << FileName << " : " << Waveforms << " waveforms on channel "
+       << Channel;
+  if(ParallelProcesses > 0)
+    cout << " (spectrum and PSD stages with " << ParallelProcesses << " MPI processes)";
+  cout << "\n\n"
+       << "  " << setw(22) << left << "Stage"
+       << setw(12) << right << "Time [s]"
+       << setw(16) << "Waveforms/s"
+       << setw(12) << "MB/s"
+       << "\n  " << string(62, '-')
+       << endl;
+
+  ReportStage("Load + readout", Waveforms, Timer);
+
+
+  ////////////////////////////////////
+  // Stage: waveform calculation
+
+  Timer.Start();
+  for(Int_t wf=0; wf<Waveforms; wf++){
+    Mgr->ReadWaveformEntry(Channel, wf);
+    Mgr->CalculateBSWaveform(Channel, wf);
+  }
+  Timer.Stop();
+  ReportStage("BS waveform", Waveforms, Timer);
+
+  Timer.Start();
+  for(Int_t wf=0; wf<Waveforms; wf++){
+    Mgr->ReadWaveformEntry(Channel, wf);
+    Mgr->CalculateZSWaveform(Channel, wf);
+  }
+  Timer.Stop();
+  ReportStage("ZS waveform", Waveforms, Timer);
+
+
+  //////////////////////////
+  // Stage: peak finding
+
+  Mgr->CreateNewPeakFinder(Settings->MaxPeaks);
+
+  Timer.Start();
+  for(Int_t wf=0; wf<Waveforms; wf++){
+    Mgr->ReadWaveformEntry(Channel, wf);
+    Mgr->FindPeaks(Mgr->CalculateBSWaveform(Channel, wf), zPeakFinder);
+  }
+  Timer.Stop();
+  ReportStage("BS + FindPeaks", Waveforms, Timer);
+
+
+  // The waveform data (WD) algorithm reads the values calculated
+  // on-board the digitizer and is skipped when they were not stored.
+  // Note that it can only be processed sequentially
+
+  const Int_t NumAlgorithms = 3;
+  string Algorithms[NumAlgorithms] = {"SMS", "PF", "WD"};
+
+  // The digital shaping (DS) algorithm applies only to spectra
+  const Int_t NumSpectrumAlgorithms = 4;
+  string SpectrumAlgorithms[NumSpectrumAlgorithms] = {"SMS", "PF", "WD", "DS"};
+
+
+  ////////////////////////////////
+  // Stage: PSD histogram creation
+
+  for(Int_t a=0; a<NumAlgorithms; a++){
+    UpdateSettings(Settings, Mgr, Algorithms[a]);
+
+    Bool_t Parallel = (ParallelProcesses > 0 and Algorithms[a] != "WD");
+
+    Timer.Start();
+    if(Parallel)
+      ProcessInParallel(Settings, Mgr, "discriminating");
+    else
+      Mgr->ProcessPSDHistogramWaveforms();
+    Timer.Stop();
+
+    if(!Mgr->GetPSDHistogramExists())
+      continue;
+
+    ReportStage("PSD histogram (" + Algorithms[a] + ")", Waveforms, Timer);
+
+    StoreHistogram("PSDHistogram_" + Algorithms[a], Mgr->GetPSDHistogram());
+    StoreVector("PSDTotal_" + Algorithms[a], Mgr->GetPSDHistogramTotalVec(Channel));
+    StoreVector("PSDTail_" + Algorithms[a], Mgr->GetPSDHistogramTailVec(Channel));
+  }
+
+
+  ///////////////////////////
+  // Stage: spectrum creation
+
+  for(Int_t a=0; a<NumSpectrumAlgorithms; a++){
+    for(Int_t t=0; t<2; t++){
+      Bool_t PAS = (t == 0);
+      string Type = PAS ? "PAS" : "PHS";
+
+      UpdateSettings(Settings, Mgr, SpectrumAlgorithms[a], PAS);
+
+      // Switching between PAS and PHS only rebins the stored pulse
+      // values, which would time the spectrum creation rather than
+      // the waveform processing, so each type is fully reprocessed
+      Mgr->ClearProcessedSpectrum();
+
+      Bool_t Parallel = (ParallelProcesses > 0 and SpectrumAlgorithms[a] != "WD");
+
+      Timer.Start();
+      if(Parallel)
+	ProcessInParallel(Settings, Mgr, "histogramming");
+      else
+	Mgr->ProcessSpectrumWaveforms();
+      Timer.Stop();
+
+      if(!Mgr->GetSpectrumExists())
+	continue;
+
+      ReportStage("Spectrum (" + SpectrumAlgorithms[a] + ", " + Type + ")", Waveforms, Timer);
+
+      TH1F *Spectrum_H = Mgr->GetSpectrum();
+      StoreHistogram("Spectrum_" + SpectrumAlgorithms[a] + "_" + Type, Spectrum_H);
+      delete Spectrum_H;
+
+      if(PAS)
+	StoreVector("SpectrumPA_" + SpectrumAlgorithms[a], Mgr->GetSpectrumPAVec(Channel));
+      else
+	StoreVector("SpectrumPH_" + SpectrumAlgorithms[a], Mgr->GetSpectrumPHVec(Channel));
+    }
+  }
+
+
+  ///////////////////////////////////
+  // Stage: persistence map creation
+
+  UpdateSettings(Settings, Mgr, "SMS");
+
+  Timer.Start();
+  Mgr->CreatePersistenceMap();
+  Timer.Stop();
+
+  if(Mgr->GetPersistenceMapExists()){
+    ReportStage("Persistence map", Waveforms, Timer);
+    StoreHistogram("PersistenceMap", Mgr->GetPersistenceMap());
+  }
+
+
+  //////////////////////////////////
+  // Stage: despliced file creation
+
+  UpdateSettings(Settings, Mgr, "SMS");
+
+  Timer.Start();
+  Mgr->CreateDesplicedFile();
+  Timer.Stop();
+  ReportStage("Despliced write", Waveforms, Timer);
+
+  // The despliced waveforms of the channel are retained as results:
+  // the samples of all waveforms concatenated in entry order and the
+  // length of each waveform (which also sets the number of waveforms)
+  TFile *DesplicedFile = new TFile(Settings->DesplicedFileName.c_str(), "read");
+  if(DesplicedFile->IsOpen()){
+    TTree *DesplicedTree = (TTree *)DesplicedFile->Get("WaveformTree");
+    
+    stringstream SS;
+    SS << "VoltageInADC_Ch" << Channel;
+    
+    vector<Double_t> DesplicedSamples, DesplicedLengths;
+    
+    if(DesplicedTree and DesplicedTree->GetBranch(SS.str().c_str())){
+      vector<Int_t> *Voltage = NULL;
+      DesplicedTree->SetBranchStatus("*", 0);
+      DesplicedTree->SetBranchStatus(SS.str().c_str(), 1);
+      DesplicedTree->SetBranchAddress(SS.str().c_str(), &Voltage);
+      
+      for(Long64_t e=0; e<DesplicedTree->GetEntries(); e++){
+	DesplicedTree->GetEntry(e);
+	DesplicedLengths.push_back(Voltage->size());
+	DesplicedSamples.insert(DesplicedSamples.end(), Voltage->begin(), Voltage->end());
+      }
+      
+      DesplicedTree->ResetBranchAddresses();
+      delete Voltage;
+    }
+    
+    StoreVector("DesplicedLengths", DesplicedLengths);
+    StoreVector("DesplicedSamples", DesplicedSamples);
+    DesplicedFile->Close();
+  }
+  delete DesplicedFile;
+
+  cout << endl;
+
+  Bool_t Passed = true;
+
+  if(WriteFileName != "")
+    Passed = WriteResults(WriteFileName);
+
+  if(CheckFileName != "")
+    Passed = CheckResults(CheckFileName, Tolerance) and Passed;
+
+  for(size_t r=0; r<Results.size(); r++)
+    delete Results[r];
+
+  delete Mgr;
+
+  return (Passed ? 0 : 1);
+}
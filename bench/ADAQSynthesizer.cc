@@ -0,0 +1,365 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: ADAQSynthesizer.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: ADAQSynthesizer is a standalone binary that writes synthetic
+//       "production" format ADAQ files for benchmarking the
+//       ADAQAnalysis processing stages without access to measured
+//       data. Each waveform contains one or more organic scintillator
+//       pulses with EJ309-like fast/slow decay components: gamma
+//       pulses have a small slow fraction while neutron pulses have a
+//       large slow fraction such that the synthetic data is suitable
+//       for exercising pulse shape discrimination. The record length,
+//       number of channels, sampling rate, pulse rate, neutron
+//       fraction, pile-up fraction, and electronic noise are all
+//       configurable via "key=value" command line arguments:
+//
+//       $ ADAQSynthesizer file=/tmp/Synthetic.adaq.root waveforms=20000
+//
+//       Run with "help" to see all options and their defaults.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+
+// ROOT
+#include <TFile.h>
+#include <TTree.h>
+#include <TObjString.h>
+#include <TRandom3.h>
+#include <TMath.h>
+
+// C++
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+using namespace std;
+
+// ADAQ
+#include "ADAQReadoutInformation.hh"
+#include "ADAQWaveformData.hh"
+
+
+// Structure holding all configurable synthesis parameters
+struct SynthesisOptions{
+  string FileName;
+  Int_t Waveforms, Channels, RecordLength, Trigger, SamplingRate, BitDepth;
+  Int_t Baseline, Polarity, Seed;
+  Double_t Noise, MinAmplitude, MaxAmplitude;
+  Double_t NeutronFraction, PileupFraction, Rate;
+  Double_t RiseTime, FastDecay, SlowDecay, GammaSlowFraction, NeutronSlowFraction;
+
+  SynthesisOptions() : FileName("/tmp/ADAQSynthetic.adaq.root"),
+		       Waveforms(10000), Channels(1), RecordLength(256), Trigger(64),
+		       SamplingRate(250), BitDepth(12),
+		       Baseline(3200), Polarity(-1), Seed(42),
+		       Noise(2.5), MinAmplitude(50.), MaxAmplitude(2500.),
+		       NeutronFraction(0.3), PileupFraction(0.05), Rate(1.e5),
+		       RiseTime(1.), FastDecay(3.5), SlowDecay(32.),
+		       GammaSlowFraction(0.05), NeutronSlowFraction(0.25)
+  {}
+};
+
+
+void PrintUsage(SynthesisOptions &O)
+{
+  cout << "\nADAQSynthesizer usage: ADAQSynthesizer [key=value ...]\n"
+       << "  file=<string>        : Output ADAQ file name       [" << O.FileName << "]\n"
+       << "  waveforms=<int>      : Waveforms per channel       [" << O.Waveforms << "]\n"
+       << "  channels=<int>       : Digitizer channels          [" << O.Channels << "]\n"
+       << "  recordlength=<int>   : Samples per waveform        [" << O.RecordLength << "]\n"
+       << "  trigger=<int>        : Trigger sample              [" << O.Trigger << "]\n"
+       << "  samplingrate=<int>   : Sampling rate [MS/s]        [" << O.SamplingRate << "]\n"
+       << "  bitdepth=<int>       : Digitizer bit depth         [" << O.BitDepth << "]\n"
+       << "  baseline=<int>       : Baseline [ADC]              [" << O.Baseline << "]\n"
+       << "  polarity=<int>       : Pulse polarity (+1 or -1)   [" << O.Polarity << "]\n"
+       << "  noise=<double>       : Gaussian noise sigma [ADC]  [" << O.Noise << "]\n"
+       << "  minamplitude=<double>: Min pulse amplitude [ADC]   [" << O.MinAmplitude << "]\n"
+       << "  maxamplitude=<double>: Max pulse amplitude [ADC]   [" << O.MaxAmplitude << "]\n"
+       << "  neutrons=<double>    : Neutron pulse fraction      [" << O.NeutronFraction << "]\n"
+       << "  pileup=<double>      : Forced pile-up fraction     [" << O.PileupFraction << "]\n"
+       << "  rate=<double>        : Pulse rate [Hz]             [" << O.Rate << "]\n"
+       << "  rise=<double>        : Pulse rise time [ns]        [" << O.RiseTime << "]\n"
+       << "  fast=<double>        : Fast decay constant [ns]    [" << O.FastDecay << "]\n"
+       << "  slow=<double>        : Slow decay constant [ns]    [" << O.SlowDecay << "]\n"
+       << "  gammaslow=<double>   : Gamma slow fraction         [" << O.GammaSlowFraction << "]\n"
+       << "  neutronslow=<double> : Neutron slow fraction       [" << O.NeutronSlowFraction << "]\n"
+       << "  seed=<int>           : Random number seed          [" << O.Seed << "]\n"
+       << endl;
+}
+
+
+Bool_t ParseOptions(int argc, char *argv[], SynthesisOptions &O)
+{
+  for(int a=1; a<argc; a++){
+    string Arg = argv[a];
+    size_t Pos = Arg.find('=');
+
+    if(Arg == "help" or Pos == string::npos){
+      PrintUsage(O);
+      return false;
+    }
+
+    string Key = Arg.substr(0, Pos);
+    string Value = Arg.substr(Pos+1);
+
+    if(Key == "file") O.FileName = Value;
+    else if(Key == "waveforms") O.Waveforms = atoi(Value.c_str());
+    else if(Key == "channels") O.Channels = atoi(Value.c_str());
+    else if(Key == "recordlength") O.RecordLength = atoi(Value.c_str());
+    else if(Key == "trigger") O.Trigger = atoi(Value.c_str());
+    else if(Key == "samplingrate") O.SamplingRate = atoi(Value.c_str());
+    else if(Key == "bitdepth") O.BitDepth = atoi(Value.c_str());
+    else if(Key == "baseline") O.Baseline = atoi(Value.c_str());
+    else if(Key == "polarity") O.Polarity = (atoi(Value.c_str()) < 0) ? -1 : 1;
+    else if(Key == "noise") O.Noise = atof(Value.c_str());
+    else if(Key == "minamplitude") O.MinAmplitude = atof(Value.c_str());
+    else if(Key == "maxamplitude") O.MaxAmplitude = atof(Value.c_str());
+    else if(Key == "neutrons") O.NeutronFraction = atof(Value.c_str());
+    else if(Key == "pileup") O.PileupFraction = atof(Value.c_str());
+    else if(Key == "rate") O.Rate = atof(Value.c_str());
+    else if(Key == "rise") O.RiseTime = atof(Value.c_str());
+    else if(Key == "fast") O.FastDecay = atof(Value.c_str());
+    else if(Key == "slow") O.SlowDecay = atof(Value.c_str());
+    else if(Key == "gammaslow") O.GammaSlowFraction = atof(Value.c_str());
+    else if(Key == "neutronslow") O.NeutronSlowFraction = atof(Value.c_str());
+    else if(Key == "seed") O.Seed = atoi(Value.c_str());
+    else{
+      cout << "\nADAQSynthesizer error! Unknown option '" << Key << "'!" << endl;
+      PrintUsage(O);
+      return false;
+    }
+  }
+
+  if(O.Channels < 1 or O.Channels > 16 or O.RecordLength < 16 or
+     O.Trigger < 0 or O.Trigger >= O.RecordLength or O.Waveforms < 1){
+    cout << "\nADAQSynthesizer error! Invalid channel, record length, trigger, or waveform count!\n" << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+// Add a single scintillator pulse with amplitude 'A' [ADC] beginning
+// at 'Start' [ns] to the pulse buffer. The pulse is the product of an
+// exponential rise and a two-component (fast/slow) decay, normalized
+// such that the maximum is approximately equal to 'A'
+void AddPulse(vector<Double_t> &Pulse, Double_t Start, Double_t A,
+	      Double_t SlowFraction, Double_t SamplePeriod, SynthesisOptions &O)
+{
+  // Normalization is calculated numerically once per pulse shape and
+  // cached on the slow fraction, since the rise and decay times are
+  // fixed for the run such that the slow fraction sets the shape
+  static map<Double_t, Double_t> Normalizations;
+  
+  map<Double_t, Double_t>::iterator It = Normalizations.find(SlowFraction);
+  if(It == Normalizations.end()){
+    Double_t Norm = 0.;
+    for(Double_t t=0.; t<5*O.FastDecay; t+=0.05){
+      Double_t V = (1. - exp(-t/O.RiseTime)) *
+	((1.-SlowFraction)*exp(-t/O.FastDecay) + SlowFraction*exp(-t/O.SlowDecay));
+      if(V > Norm)
+	Norm = V;
+    }
+    It = Normalizations.insert(make_pair(SlowFraction, Norm)).first;
+  }
+  const Double_t Max = It->second;
+
+  for(size_t s=0; s<Pulse.size(); s++){
+    Double_t t = s*SamplePeriod - Start;
+    if(t <= 0.)
+      continue;
+
+    Pulse[s] += A/Max * (1. - exp(-t/O.RiseTime)) *
+      ((1.-SlowFraction)*exp(-t/O.FastDecay) + SlowFraction*exp(-t/O.SlowDecay));
+  }
+}
+
+
+int main(int argc, char *argv[])
+{
+  SynthesisOptions O;
+  if(!ParseOptions(argc, argv, O))
+    return -42;
+
+  TRandom3 *RNG = new TRandom3(O.Seed);
+
+  const Double_t SamplePeriod = 1000./O.SamplingRate; // [ns]
+  const Double_t RecordTime = O.RecordLength * SamplePeriod; // [ns]
+  const Int_t MaxADC = (1<<O.BitDepth) - 1;
+
+  // The expected number of random (uncorrelated) additional pulses
+  // within the waveform record length given the pulse rate
+  const Double_t MeanRandomPulses = O.Rate * RecordTime * 1.e-9;
+
+  // Analysis windows used to fill the ADAQWaveformData, matching the
+  // defaults of the ADAQAcquisition DPP-PSD firmware settings
+  const Int_t PSDTotalStart = O.Trigger - 4;
+  const Int_t PSDTotalStop = TMath::Min(O.Trigger + 100, O.RecordLength);
+  const Int_t PSDTailStart = O.Trigger + 6;
+  const Int_t BaselineMin = 0;
+  const Int_t BaselineMax = TMath::Max(O.Trigger - 10, 1);
+
+  TFile *OutputFile = new TFile(O.FileName.c_str(), "recreate");
+  if(!OutputFile->IsOpen()){
+    cout << "\nADAQSynthesizer error! Could not create '" << O.FileName << "'!\n" << endl;
+    return -42;
+  }
+
+
+  //////////////////////////////////////////////
+  // Create the waveform and waveform data tree
+
+  TTree *WaveformTree = new TTree("WaveformTree", "Synthetic ADAQ waveform tree");
+
+  vector<vector<Int_t> *> Waveforms(O.Channels);
+  vector<ADAQWaveformData *> WaveformData(O.Channels);
+
+  for(Int_t ch=0; ch<O.Channels; ch++){
+    Waveforms[ch] = new vector<Int_t>(O.RecordLength, O.Baseline);
+    WaveformData[ch] = new ADAQWaveformData;
+
+    stringstream SS;
+    SS << "WaveformCh" << ch;
+    WaveformTree->Branch(SS.str().c_str(), &Waveforms[ch]);
+
+    SS.str("");
+    SS << "WaveformDataCh" << ch;
+    WaveformTree->Branch(SS.str().c_str(), "ADAQWaveformData", &WaveformData[ch]);
+  }
+
+
+  ////////////////////////////////
+  // Synthesize and store waveforms
+
+  vector<Double_t> Pulse(O.RecordLength, 0.);
+  vector<Double_t> TimeStamp(O.Channels, 0.);
+
+  Int_t NeutronCount = 0, PileupCount = 0;
+
+  for(Int_t wf=0; wf<O.Waveforms; wf++){
+    for(Int_t ch=0; ch<O.Channels; ch++){
+
+      fill(Pulse.begin(), Pulse.end(), 0.);
+
+      // The triggering pulse
+      Bool_t Neutron = (RNG->Rndm() < O.NeutronFraction);
+      if(Neutron)
+	NeutronCount++;
+
+      Double_t SlowFraction = Neutron ? O.NeutronSlowFraction : O.GammaSlowFraction;
+      Double_t Amplitude = RNG->Uniform(O.MinAmplitude, O.MaxAmplitude);
+      AddPulse(Pulse, O.Trigger*SamplePeriod, Amplitude, SlowFraction, SamplePeriod, O);
+
+      // Forced pile-up pulse that arrives shortly after the trigger
+      // such that it overlaps the tail of the triggering pulse
+      Int_t Additional = RNG->Poisson(MeanRandomPulses);
+      if(RNG->Rndm() < O.PileupFraction){
+	Double_t Delay = RNG->Uniform(4*SamplePeriod, 3*O.SlowDecay);
+	Bool_t N = (RNG->Rndm() < O.NeutronFraction);
+	AddPulse(Pulse, O.Trigger*SamplePeriod + Delay,
+		 RNG->Uniform(O.MinAmplitude, O.MaxAmplitude),
+		 (N ? O.NeutronSlowFraction : O.GammaSlowFraction), SamplePeriod, O);
+	PileupCount++;
+      }
+
+      // Uncorrelated pulses anywhere in the record given the rate
+      for(Int_t p=0; p<Additional; p++){
+	Bool_t N = (RNG->Rndm() < O.NeutronFraction);
+	AddPulse(Pulse, RNG->Uniform(0., RecordTime),
+		 RNG->Uniform(O.MinAmplitude, O.MaxAmplitude),
+		 (N ? O.NeutronSlowFraction : O.GammaSlowFraction), SamplePeriod, O);
+      }
+
+      // Digitize with polarity, noise, and ADC saturation
+      Double_t PulseHeight = 0., PulseArea = 0., Total = 0., Tail = 0.;
+
+      for(Int_t s=0; s<O.RecordLength; s++){
+	Int_t Sample = TMath::Nint(O.Baseline + O.Polarity*Pulse[s] + RNG->Gaus(0., O.Noise));
+	(*Waveforms[ch])[s] = TMath::Max(0, TMath::Min(Sample, MaxADC));
+
+	Double_t Height = O.Polarity*((*Waveforms[ch])[s] - O.Baseline);
+
+	if(Height > PulseHeight)
+	  PulseHeight = Height;
+	PulseArea += Height;
+
+	if(s >= PSDTotalStart and s < PSDTotalStop)
+	  Total += Height;
+	if(s >= PSDTailStart and s < PSDTotalStop)
+	  Tail += Height;
+      }
+
+      // Exponentially distributed trigger time stamps at the given rate
+      TimeStamp[ch] += (O.Rate > 0.) ? RNG->Exp(1.e9/O.Rate) : RecordTime;
+
+      WaveformData[ch]->SetPulseHeight(PulseHeight);
+      WaveformData[ch]->SetPulseArea(PulseArea);
+      WaveformData[ch]->SetPSDTotalIntegral(Total);
+      WaveformData[ch]->SetPSDTailIntegral(Tail);
+      WaveformData[ch]->SetTimeStamp(TimeStamp[ch]);
+    }
+
+    WaveformTree->Fill();
+  }
+
+
+  //////////////////////////////////////////
+  // Store the metadata and readout objects
+
+  TObjString *OS = new TObjString("SyntheticV1");
+  OS->Write("FileVersion");
+  OS->SetString("ADAQSynthesizer");
+  OS->Write("MachineName");
+  OS->SetString((getenv("USER") ? getenv("USER") : "Unknown"));
+  OS->Write("MachineUser");
+  OS->SetString("Synthetic");
+  OS->Write("FileDate");
+
+  ADAQReadoutInformation *ARI = new ADAQReadoutInformation;
+  ARI->SetDGFWType("Standard");
+  ARI->SetDGNumChannels(O.Channels);
+  ARI->SetDGBitDepth(O.BitDepth);
+  ARI->SetDGSamplingRate(O.SamplingRate);
+  ARI->SetRecordLength(O.RecordLength);
+  ARI->SetChRecordLength(vector<Int_t>(O.Channels, O.RecordLength));
+  ARI->SetTrigger(vector<Int_t>(O.Channels, O.Baseline + O.Polarity*O.MinAmplitude));
+  ARI->SetBaselineCalcMin(vector<Int_t>(O.Channels, BaselineMin));
+  ARI->SetBaselineCalcMax(vector<Int_t>(O.Channels, BaselineMax));
+  ARI->SetStoreRawWaveforms(true);
+  ARI->SetStoreEnergyData(true);
+  ARI->SetStorePSDData(true);
+  ARI->Write("ReadoutInformation");
+
+  WaveformTree->Write();
+  OutputFile->Close();
+
+  cout << "\nADAQSynthesizer : Wrote " << O.Waveforms << " waveforms x "
+       << O.Channels << " channels x " << O.RecordLength << " samples to '"
+       << O.FileName << "'\n"
+       << "                  Neutron pulses = " << NeutronCount
+       << " ; Pile-up waveforms = " << PileupCount << "\n"
+       << endl;
+
+  delete RNG;
+
+  return 0;
+}
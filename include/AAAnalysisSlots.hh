@@ -44,6 +44,7 @@ public:
   void HandleComboBoxes(int, int);
   void HandleNumberEntries();
   void HandleRadioButtons();
+  void HandleTextButtons();
 
   ClassDef(AAAnalysisSlots, 0);
 
@@ -0,0 +1,102 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AABaselineEstimator.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AABaselineEstimator class computes the baseline of
+//       digitized waveforms with one of four estimators:
+//
+//         mean          : the average of the baseline region
+//         trimmed mean  : the average of the baseline region after
+//                         discarding a fraction of its lowest and
+//                         highest samples (e.g. pileup pulses)
+//         running median: the median of a window centered on each
+//                         sample, which follows baseline drift over
+//                         long records but ignores pulses shorter
+//                         than half of the window
+//         moving        : an exponential moving average that is
+//                         seeded with the baseline region average and
+//                         tracks the baseline between pulses, i.e.
+//                         only when samples are within a threshold
+//                         of the present baseline
+//
+//       The running median and moving estimators are evaluated
+//       sample-by-sample in the same pass that subtracts the baseline
+//       at a constant (amortized) cost per sample; the running median
+//       keeps a histogram of the integer ADC values in the window.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AABaselineEstimator_hh__
+#define __AABaselineEstimator_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+// C++
+#include <vector>
+using namespace std;
+
+class AABaselineEstimator
+{
+public:
+  AABaselineEstimator();
+
+  enum EstimatorTypes{zMeanBaseline, zTrimmedMeanBaseline,
+		      zRunningMedianBaseline, zMovingBaseline};
+
+  // Configure the estimator type, the baseline region [Min, Max)
+  // [samples], the fraction of the region samples discarded at each
+  // end by the trimmed mean, the running median window [samples], and
+  // the time constant [samples] and tracking threshold [ADC] of the
+  // moving baseline
+  void Configure(Int_t, Int_t, Int_t, Double_t, Int_t, Double_t, Double_t);
+
+  // Whether the baseline varies over the waveform
+  Bool_t IsVariable() const
+  {return (Type == zRunningMedianBaseline or Type == zMovingBaseline);}
+
+  // Compute the baseline of the baseline region of N samples. For the
+  // running median (moving) estimator this is the median (mean) of
+  // the region
+  Double_t Calculate(const Int_t *, Int_t);
+
+  // Compute the baseline of N samples and store the baseline-
+  // subtracted samples multiplied by the polarity into the output
+  // array in a single pass. Returns the baseline averaged over the
+  // samples (the region baseline for constant estimators)
+  Double_t Subtract(const Int_t *, Int_t, Double_t, Float_t *);
+
+private:
+  Double_t RegionMean(const Int_t *, Int_t, Int_t);
+  Double_t RegionTrimmedMean(const Int_t *, Int_t, Int_t, Double_t);
+  Double_t RunningMedian(const Int_t *, Int_t, Double_t, Float_t *);
+  Double_t Moving(const Int_t *, Int_t, Double_t, Float_t *);
+
+  Int_t Type, RegionMin, RegionMax;
+  Double_t TrimFraction;
+  Int_t HalfWindow;
+  Double_t Alpha, Threshold;
+
+  // Buffers reused between waveforms: the region samples (partially
+  // sorted by the trimmed mean) and the running median histogram,
+  // which is always left empty between waveforms
+  vector<Int_t> Region;
+  vector<Int_t> Histogram;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //      
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+// 
+// name: AABufferedWriter.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+// 
+// desc: The AABufferedWriter class provides a simple, fast writer
+//       for all of the ASCII (and binary) data files produced by
+//       ADAQAnalysis. Values are formatted directly into a large
+//       memory buffer that is only written to disk when full (or
+//       when the writer is closed), avoiding the per-line stream
+//       flush and formatting overhead of std::ofstream/std::endl
+//       that dominates the output time of large histograms.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AABufferedWriter_hh__
+#define __AABufferedWriter_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+// C++
+#include <cstdio>
+#include <string>
+#include <vector>
+using namespace std;
+
+class AABufferedWriter
+{
+public:
+  AABufferedWriter(string, Int_t BufferSize = 1048576);
+  ~AABufferedWriter();
+
+  Bool_t IsOpen() {return (File != NULL);}
+
+  // Set the number of significant digits used for floating point
+  // values; the default of 6 matches that of std::ofstream
+  void SetPrecision(Int_t P) {Precision = P;}
+
+  // Methods to format values into the buffer. An optional minimum
+  // field width right-aligns the value (equivalent to std::setw)
+  void Write(const char *, Int_t Width = 0);
+  void Write(string S, Int_t Width = 0) {Write(S.c_str(), Width);}
+  void Write(Double_t, Int_t Width = 0);
+  void Write(Int_t, Int_t Width = 0);
+  void Write(char);
+
+  // Method to copy unformatted (binary) data into the buffer
+  void WriteBinary(const void *, size_t);
+
+  Bool_t Flush();
+  Bool_t Close();
+
+private:
+  void Reserve(size_t);
+
+  FILE *File;
+  vector<char> Buffer;
+  size_t Position;
+  Int_t Precision;
+  Bool_t WriteError;
+};
+
+#endif
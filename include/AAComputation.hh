@@ -47,12 +47,14 @@
 #include <TRandom.h>
 #include <TColor.h>
 #include <TGProgressBar.h>
+#include <TGTextView.h>
 #include <TF1.h>
 #include <TCutG.h>
 
 // C++
 #include <string>
 #include <vector>
+#include <map>
 using namespace std;
 
 // ADAQ
@@ -66,6 +68,13 @@ using namespace std;
 #include "AASettings.hh"
 #include "AAParallelResults.hh"
 #include "AATypes.hh"
+#include "AAProfiler.hh"
+#include "AADigitalShaper.hh"
+#include "AABaselineEstimator.hh"
+#include "AAFixedPointWaveform.hh"
+#include "AAPileupFitter.hh"
+#include "AAPulseTemplateBuilder.hh"
+#include "AAWaveformCache.hh"
 
 #ifndef __CINT__
 #include <boost/array.hpp>
@@ -83,7 +92,8 @@ public:
 
   // Pointer set methods
   void SetProgressBarPointer(TGHProgressBar *PB) { ProcessingProgressBar = PB; }
-  void SetADAQSettings(AASettings *AAS) { ADAQSettings = AAS; }
+  void SetProfileTextViewPointer(TGTextView *TV) { ProfileTextView = TV; }
+  void SetADAQSettings(AASettings *AAS) { ADAQSettings = AAS; ConfigureTreeIO(); }
 
   
   ///////////////////////////
@@ -96,27 +106,66 @@ public:
   Bool_t SaveHistogramData(string, string, string);
   void CreateDesplicedFile();
 
+  // Apply the file I/O tuning settings (TTreeCache, branch selection,
+  // implicit multithreading, read-ahead, decoded waveform cache) to
+  // the loaded waveform TTree if they differ from those presently
+  // applied (or if forced)
+  void ConfigureTreeIO(Bool_t Force=false);
+
+  // Build (or extend) the per-channel trigger index over the waveform
+  // TTree entries [Begin, End) and return the first entry at or after
+  // the specified entry in which the specified channel triggered
+  void BuildTriggerIndex(Int_t, Int_t);
+  Int_t NextTriggeredEntry(Int_t, Int_t);
+
   // Waveform creation
   TH1F *CalculateRawWaveform(Int_t, Int_t);
+
+  // Returns the waveform histogram if it already holds the specified
+  // waveform and no waveform extraction settings have changed since
+  // it was calculated; otherwise returns 0
+  TH1F *GetCachedWaveform(Int_t, Int_t, Int_t);
   TH1F *CalculateBSWaveform(Int_t, Int_t, Bool_t CurrentWaveform=false);
   TH1F *CalculateZSWaveform(Int_t, Int_t, Bool_t CurrentWaveform=false);
+
+  // Read a browsed waveform entry through the decoded waveform cache;
+  // the Calculate*Waveform() methods act on the presently read entry.
+  // A cache hit reads only the channel's waveform and waveform data
+  void ReadWaveformEntry(Int_t, Int_t);
+
+  // Prefetch the waveforms of a channel following the specified
+  // waveform in the direction of browsing (+1 or -1) in the background
+  void PrefetchWaveforms(Int_t Channel, Int_t Waveform, Int_t Direction)
+  { WaveformCache.Prefetch(Channel, Waveform, Direction); }
+  const AAWaveformCache &GetWaveformCache() { return WaveformCache; }
   Double_t CalculateBaseline(vector<Int_t> *);  
   Double_t CalculateBaseline(TH1F *);
   
   // Waveform processing 
   Bool_t FindPeaks(TH1F *, Int_t);
   void FindPeakLimits(TH1F *);
-  void IntegratePeaks();
-  void FindPeakHeights();
+  void FindPeakTimes(TH1F *);
+  Double_t CalculatePeakTime(TH1F *, Double_t, Double_t);
+  void MeasurePeak(TH1F *, const PeakInfoStruct &, Int_t, Int_t, Double_t &, Double_t &);
   void RejectPileup(TH1F *);
+  void RecoverPileup(TH1F *, Int_t);
+  Bool_t LoadPulseTemplates(string);
+  void AccumulatePulseTemplate(TH1F *, Double_t, Double_t, Double_t, Bool_t);
+  void BeginPulseTemplates();
+  void WritePulseTemplates(Int_t);
   void AnalyzeWaveform(TH1F *);
   
   // Spectrum creation
   void ProcessSpectrumWaveforms();
   void CreateSpectrum();
   void CreateASIMSpectrum();
+  Bool_t CreateASIMSpectra(vector<ASIMSpectrumStruct> &, Long64_t);
   void CalculateSpectrumBackground();
 
+  // Discards the stored pulse height/area values such that the next
+  // spectrum is created by reprocessing the waveforms
+  void ClearProcessedSpectrum() {ProcessedSpectrumChannel = -1;}
+
   // Spectrum processing
   void FindSpectrumPeaks();
   void IntegrateSpectrum();
@@ -138,17 +187,36 @@ public:
   TH2F *CreatePSDHistogram();
 
   void CalculatePSDIntegrals(Bool_t);
+  void ConvertPSDIntegrals(Int_t, Double_t &, Double_t &);
   Bool_t ApplyPSDRegion(Double_t, Double_t);
 
   void AddPSDRegionPoint(Int_t, Int_t);
   void CreatePSDRegion();
   void ClearPSDRegion();
   void CreatePSDHistogramSlice(Int_t, Int_t);
+
+  // Waveform persistence (density) map of the present channel
+  TH2F *CreatePersistenceMap();
   
   // Processing methods
   void UpdateProcessingProgress(Int_t);
   void ProcessWaveformsInParallel(string);
 
+  // Read the stored waveform data of a channel at a list of entries
+  Bool_t ReadWaveformData(Int_t, const vector<Int_t> &, vector<ListModeRecordStruct> &);
+
+  // Processing profile of the most recent waveform processing run
+  const AAProfiler &GetProfiler() { return Profiler; }
+
+  // List-mode output methods
+  Bool_t OpenListModeFile();
+  void FillListModeRecord(Int_t, Int_t, Double_t, Double_t, Double_t, Bool_t, Bool_t,
+			  Double_t PeakTime=-1.);
+  void FillListModeRecord(Int_t, Int_t, ADAQWaveformData *, Bool_t);
+  void FillListModeRecord(const ListModeRecordStruct &);
+  void FillListModeRecords(Int_t, Int_t);
+  void CloseListModeFile();
+
 
   ////////////////////////////////////////
   // Public access methods for member data
@@ -165,11 +233,17 @@ public:
   {
     Spectrum_H = H;
     SpectrumExists = true;
+    SpectrumRevision++;
+    ProcessedSpectrumChannel = -1;
   }
   
   TH1F *GetSpectrum() {return (TH1F *)Spectrum_H->Clone();}
   TH1F *GetSpectrumBackground() {return (TH1F *)SpectrumBackground_H->Clone();}
   TH1F *GetSpectrumWithoutBackground() {return (TH1F *)SpectrumDeconvolved_H->Clone();}
+
+  // Per-pulse values from the most recent spectrum creation
+  const vector<Double_t> &GetSpectrumPHVec(Int_t Channel) {return SpectrumPHVec[Channel];}
+  const vector<Double_t> &GetSpectrumPAVec(Int_t Channel) {return SpectrumPAVec[Channel];}
   
   // Spectra calibrations
   vector<TGraph *> GetSpectraCalibrationData() { return SpectraCalibrationData; }
@@ -190,6 +264,12 @@ public:
   // Pulse shape discrimination histograms
   TH2F *GetPSDHistogram() { return PSDHistogram_H; }
   TH1D *GetPSDHistogramSlice() { return PSDHistogramSlice_H; }
+  const vector<Double_t> &GetPSDHistogramTotalVec(Int_t Channel) {return PSDHistogramTotalVec[Channel];}
+  const vector<Double_t> &GetPSDHistogramTailVec(Int_t Channel) {return PSDHistogramTailVec[Channel];}
+
+  // Waveform persistence map and the number of waveforms within it
+  TH2F *GetPersistenceMap() { return PersistenceMap_H; }
+  Long64_t GetPersistenceMapWaveforms() { return PersistenceMapWaveforms; }
   
   // Pulse shape discrimination regions
   vector<TCutG *> GetPSDRegions() { return PSDRegions; }
@@ -207,7 +287,9 @@ public:
   
   // ASIM file data
   string GetASIMFileName() { return ASIMFileName; }
-  TList *GetASIMEventTreeList() { return ASIMEventTreeList; }
+  const vector<string> &GetASIMEventTreeNames() { return ASIMEventTreeNames; }
+  TTree *GetASIMEventTree(string);
+  Long64_t GetASIMEventTreeEntries(string);
   
   // Bool_Teans
   Bool_t GetADAQFileLoaded() { return ADAQFileLoaded; }
@@ -217,6 +299,7 @@ public:
   Bool_t GetSpectrumDerivativeExists() { return SpectrumDerivativeExists; }
   Bool_t GetPSDHistogramExists() { return PSDHistogramExists; }
   Bool_t GetPSDHistogramSliceExists() { return PSDHistogramSliceExists; }
+  Bool_t GetPersistenceMapExists() { return PersistenceMapExists; }
 
 
   ////////////////
@@ -232,7 +315,61 @@ private:
 
   static AAComputation *TheComputationManager;
 
+  // Methods to select and run the compile-time policy-based spectrum
+  // waveform processing kernel that matches the present settings
+  void DispatchSpectrumKernel(Int_t);
+#ifndef __CINT__
+  template<class Transform>
+  void DispatchSpectrumKernel(Int_t);
+  template<class Transform, class Algorithm>
+  void DispatchSpectrumKernel(Int_t);
+  template<class Transform, class Algorithm, class Spectrum>
+  void DispatchSpectrumKernel(Int_t);
+  template<class Transform, class Algorithm, class Spectrum, class Calibration>
+  void DispatchSpectrumKernel(Int_t);
+  template<class Transform, class Algorithm, class Spectrum, class Calibration, Bool_t PSDFilter>
+  void ProcessSpectrumWaveformsKernel(Int_t);
+#endif
+
+  // Methods to select and run the fixed-point spectrum kernels and
+  // to process PSD waveforms in fixed point (if enabled and possible
+  // with the present settings)
+  Bool_t UseFixedPointProcessing(Bool_t);
+  void DispatchFixedPointKernel(Int_t);
+#ifndef __CINT__
+  template<class Spectrum>
+  void DispatchFixedPointKernel(Int_t);
+  template<class Spectrum, class Calibration>
+  void DispatchFixedPointKernel(Int_t);
+  template<class Spectrum, class Calibration, Bool_t PSDFilter>
+  void ProcessSpectrumWaveformsFixedPointKernel(Int_t);
+#endif
+  void ProcessFixedPointPSDWaveform(Int_t, Int_t);
+  void CalculateFixedPointPSDIntegrals(Int_t, Double_t &, Double_t &);
+
+  // Methods to reset/rebin histograms in place and to reuse clones
+  TH1F *PrepareHistogram(TH1F *, string, string, Int_t, Double_t, Double_t);
+  TH2F *PrepareHistogram(TH2F *, string, string,
+			 Int_t, Double_t, Double_t,
+			 Int_t, Double_t, Double_t);
+  TH1F *CopyHistogram(TH1F *, TH1F *, string);
+  TH1F *GetPooledClone(TH1F *, string);
+  void ClearHistogramPool();
+
+  // Method to record the waveform presently held by Waveform_H
+  void SetCachedWaveform(Int_t, Int_t, Int_t);
+
+
+  // Method to configure the baseline estimator from the settings
+  void ConfigureBaselineEstimator();
+
+  // Methods to begin and end profiling a waveform processing run;
+  // the profile is reported at the end of the run (if enabled)
+  void BeginProfile(string);
+  void EndProfile();
+
   TGHProgressBar *ProcessingProgressBar;
+  TGTextView *ProfileTextView;
   AASettings *ADAQSettings;
 
   // Bool_Ts to specify architecture type
@@ -255,10 +392,23 @@ private:
   
   ADAQRootMeasParams *ADAQMeasParams;
 
+  // The file I/O tuning presently applied to the waveform TTree
+  Int_t TreeIOCacheSize, TreeIOLearnEntries, TreeIOChannel;
+  Int_t TreeIOThreads, TreeIOReadAhead;
+
+  // The sorted waveform TTree entries in which each channel actually
+  // triggered over the range of entries [Begin, End) that is indexed
+  vector<Int_t> TriggerEntries[MAX_DG_CHANNELS];
+  Int_t TriggerIndexBegin, TriggerIndexEnd;
+
   TFile *ASIMFile;
   string ASIMFileName;
   Bool_t ASIMFileLoaded;
 
+  // The catalog of ASIM event TTree names is built from the file keys
+  // while the TTrees themselves are only instantiated (and then
+  // retained in the TList) when they are first required
+  vector<string> ASIMEventTreeNames;
   TList *ASIMEventTreeList;
   ASIMEvent *ASIMEvt;
 
@@ -274,6 +424,15 @@ private:
   vector<Int_t> Time, RawVoltage;
   Int_t RecordLength;
   Double_t Baseline;
+
+  // Estimator of the waveform baseline (configured from the present
+  // settings) and the baseline-subtracted samples of the present
+  // zero-suppressed waveform
+  AABaselineEstimator BaselineEstimator;
+  vector<Float_t> BSVoltage;
+
+  // Integer view of the present waveform for fixed-point processing
+  AAFixedPointWaveform FixedPointWaveform;
   
   // Peak finding machinery
 
@@ -291,6 +450,11 @@ private:
   // Waveform analysis results
   Double_t WaveformAnalysisHeight, WaveformAnalysisArea;
 
+  // The type, channel, number and waveform stage revision of the
+  // waveform presently held by Waveform_H
+  Int_t CachedWaveformType, CachedWaveformChannel, CachedWaveformNumber;
+  Int_t CachedWaveformRevision;
+
   
   /////////////////////
   // Spectrum variables
@@ -302,6 +466,20 @@ private:
   TH1F *SpectrumBackground_H, *SpectrumDeconvolved_H;
   TH1F *SpectrumIntegral_H;
   TF1 *SpectrumFit_F;
+
+  // Pool of transient histogram clones that are reused by name
+  map<string, TH1F *> HistogramPool;
+
+  // Counter incremented each time Spectrum_H is refilled
+  Int_t SpectrumRevision;
+
+  // The channel and combined revision of the stages that the pulse
+  // height/area vectors depend on when they were last filled
+  Int_t ProcessedSpectrumChannel, ProcessedSpectrumRevision;
+  
+  // The analysis stage and spectrum revisions for which the present
+  // background was calculated
+  Int_t BackgroundAnalysisRevision, BackgroundSpectrumRevision;
   Double_t SpectrumIntegralValue, SpectrumIntegralError;
 
   // Vectors used to store processed waveform values
@@ -332,11 +510,66 @@ private:
   vector<Double_t> PSDRegionXPoints, PSDRegionYPoints;
 
 
+  /////////////////////////
+  // Waveform persistence
+
+  TH2F *PersistenceMap_H;
+  Long64_t PersistenceMapWaveforms;
+
+
+  ////////////////////
+  // List-mode output
+
+  // The TFile and columnar TTree into which per-pulse records are
+  // streamed during waveform processing when list-mode is enabled
+  TFile *ListModeFile;
+  TTree *ListModeTree;
+  ListModeRecordStruct ListModeRecord;
+  Bool_t ListModeActive;
+
+
+  ///////////////////////
+  // Processing profiling
+
+  AAProfiler Profiler;
+  Long64_t ProfileReadCalls;
+
+
+  ///////////////////////////////////
+  // Digital shaping (DS) algorithm
+
+  AADigitalShaper Shaper;
+
+
+  //////////////////////////////////////
+  // Pileup recovery by template fitting
+
+  // Per-channel pulse template fitters and the name and modification
+  // time of the file from which the present templates were loaded
+  AAPileupFitter PileupFitters[MAX_DG_CHANNELS];
+  string PulseTemplateFileName;
+  Long_t PulseTemplateFileTime;
+
+  // Accumulator of the average pulse templates built during waveform
+  // processing when enabled
+  AAPulseTemplateBuilder TemplateBuilder;
+
+
+  //////////////////////////
+  // Decoded waveform cache
+
+  // Recently browsed waveforms (and those prefetched while browsing)
+  // are copied from the cache into CacheVoltage rather than reread
+  AAWaveformCache WaveformCache;
+  vector<Int_t> CacheVoltage;
+
+
   ///////////
   // Bool_Teans
   Bool_t SpectrumExists, SpectrumBackgroundExists, SpectrumDerivativeExists;
   Bool_t SpectrumFitExists;
   Bool_t PSDHistogramExists, PSDHistogramSliceExists;
+  Bool_t PersistenceMapExists;
 
 
   ///////////
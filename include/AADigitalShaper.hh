@@ -0,0 +1,74 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AADigitalShaper.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AADigitalShaper class implements the recursive digital
+//       pulse shapers used by the digital shaping (DS) spectrum
+//       algorithm: a trapezoidal shaper (V.T. Jordanov and
+//       G.F. Knoll, NIM A 345 (1994) 337) and a CR-RC^n shaper. Both
+//       are computed in a single streaming pass over the waveform at
+//       a constant cost per sample. An optional pole-zero correction
+//       first converts exponentially decaying input pulses with the
+//       specified decay constant into steps; without it the input is
+//       assumed to be step-like (e.g. a charge-sensitive preamplifier
+//       output). The shaped output is normalized such that its
+//       maximum is equal to the input step amplitude.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AADigitalShaper_hh__
+#define __AADigitalShaper_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+// C++
+#include <vector>
+using namespace std;
+
+class AADigitalShaper
+{
+public:
+  AADigitalShaper();
+
+  enum ShaperTypes{zTrapezoidShaper, zCRRCShaper};
+
+  // Configure the shaper type, the trapezoid rise and flat top times
+  // [samples], the CR-RC^n shaping time [samples] and order, and the
+  // input pulse decay constant for pole-zero correction [samples; 0
+  // disables the correction]
+  void Configure(Int_t, Int_t, Int_t, Double_t, Int_t, Double_t);
+
+  // Shape N samples and return the maximum (and its sample) and the
+  // sum of the shaped signal over the samples [Min, Max]
+  void Shape(const Float_t *, Int_t, Int_t, Int_t, Double_t &, Int_t &, Double_t &);
+
+private:
+  Int_t Type, RiseTime, FlatTop, Order;
+  Double_t ShapingTime, DecayTime;
+
+  // Recursion coefficients computed once per configuration
+  Double_t PZCoefficient, CRCoefficient, RCCoefficient, Normalization;
+
+  // The pole-zero corrected input is retained as the delay line of
+  // the trapezoidal shaper; the buffer is reused between waveforms
+  vector<Double_t> Step;
+  vector<Double_t> RCState;
+};
+
+#endif
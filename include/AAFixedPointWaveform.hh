@@ -0,0 +1,79 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAFixedPointWaveform.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAFixedPointWaveform class provides the pulse features of
+//       a baseline-subtracted waveform (maximum and its sample,
+//       integrals) computed directly from the integer digitized
+//       samples without creating a floating point waveform. The
+//       baseline is held in fixed point with FractionalBits bits of
+//       fraction; the baseline subtraction and polarity are applied
+//       to the results rather than to each sample, such that the
+//       per-sample work is integer maxima and sums over the samples.
+//       Results are fixed-point values (see ToDouble()) that are
+//       converted to floating point only for the final features. The
+//       baseline is rounded to the nearest fixed-point value such that
+//       heights are within 1/512 ADC of the floating point path (see
+//       test/ADAQFixedPointTest.cc). Note that the samples are read in
+//       place as the Int_t stored in the waveform TTree rather than
+//       converted to int16 storage: a conversion pass would cost more
+//       than it saves on sums that require 64 bits regardless.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AAFixedPointWaveform_hh__
+#define __AAFixedPointWaveform_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+class AAFixedPointWaveform
+{
+public:
+  AAFixedPointWaveform();
+
+  // The baseline resolution is 1/256 ADC
+  static const Int_t FractionalBits = 8;
+
+  static Double_t ToDouble(Long64_t Value)
+  {return Value*(1./(1 << FractionalBits));}
+
+  // Set the N samples of the waveform (which are not copied), its
+  // polarity (+1 or -1) and the baseline region [Min, Max); the
+  // fixed-point baseline is the average of the region
+  void Set(const Int_t *, Int_t, Int_t, Int_t, Int_t);
+
+  // Return the first sample of the maximum of the baseline-subtracted
+  // waveform within the samples [Min, Max] and its fixed-point height
+  // (-1 if there are no samples in the range)
+  Int_t GetMaximum(Int_t, Int_t, Long64_t &) const;
+
+  // Return the fixed-point integral of the baseline-subtracted
+  // waveform over the samples [Min, Max]
+  Long64_t GetIntegral(Int_t, Int_t) const;
+
+  Long64_t GetBaseline() const {return Baseline;}
+  Int_t GetNumSamples() const {return NumSamples;}
+
+private:
+  const Int_t *Samples;
+  Int_t NumSamples, Polarity;
+  Long64_t Baseline;
+};
+
+#endif
@@ -47,6 +47,7 @@
 #include "AAComputation.hh"
 #include "AAInterface.hh"
 #include "AASettings.hh"
+#include "AAWaveformDecimator.hh"
 
 
 class AAGraphics : public TObject
@@ -86,6 +87,7 @@ public:
   // Waveform plotting methods
   
   void PlotWaveform(int Color=kBlue);
+  void PlotPersistenceMap();
 
 
   ///////////////////////////
@@ -94,6 +96,10 @@ public:
   void PlotSpectrum();
   void PlotSpectrumDerivative();
 
+  // Converts a calibrated spectrum into the selected particle energy
+  // (owned by the caller); NULL is returned if no conversion applies
+  TH1F *ConvertSpectrumEnergy(TH1F *);
+
   
   //////////////////////////////////////////////
   // Pulse shape discrimination plotting methods
@@ -164,6 +170,18 @@ private:
 
   Double_t PSDFigureOfMerit;
 
+  // Long waveforms are drawn as the min/max envelope of the visible
+  // range, which is computed from the pyramid of the plotted waveform
+  // (identified by its type, channel, number and waveform revision)
+  AAWaveformDecimator WaveformDecimator;
+  Int_t DecimatedType, DecimatedChannel, DecimatedWaveform, DecimatedRevision;
+  vector<Double_t> EnvelopeX, EnvelopeY;
+  TGraph *WaveformEnvelope_G;
+
+  // The last plotted waveform sets the direction in which the
+  // neighbouring waveforms are prefetched while browsing
+  Int_t LastPlottedWaveform;
+
   ClassDef(AAGraphics, 1)
 };
 
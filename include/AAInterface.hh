@@ -45,6 +45,7 @@
 #include <TLine.h>
 #include <TBox.h>
 #include <TGProgressBar.h>
+#include <TGTextView.h>
 #include <TObject.h>
 #include <TRandom3.h>
 #include <TGMsgBox.h>
@@ -126,6 +127,10 @@ public:
   void SetCalibrationWidgetState(bool, EButtonState);
   void SetEAGammaWidgetState(bool, EButtonState);
   void SetEANeutronWidgetState(bool, EButtonState);
+
+  // Method to list the scintillator response libraries and select the
+  // response (and its conversion factor) of the present channel
+  void UpdateEAResponseWidgets();
   void SetSpectrumBackgroundWidgetState(bool, EButtonState);
   
 
@@ -179,6 +184,9 @@ private:
   TGCheckButton *PlotBaselineRegion_CB;
   ADAQNumberEntryWithLabel *BaselineRegionMin_NEL;
   ADAQNumberEntryWithLabel *BaselineRegionMax_NEL;
+  ADAQComboBoxWithLabel *BaselineEstimator_CBL;
+  ADAQNumberEntryWithLabel *BaselineTrimFraction_NEL, *BaselineMedianWindow_NEL;
+  ADAQNumberEntryWithLabel *BaselineTimeConstant_NEL, *BaselineThreshold_NEL;
 
   // Widgets for controlling peak finding and plotting
   TGCheckButton *PlotZeroSuppressionCeiling_CB;
@@ -196,12 +204,26 @@ private:
 
   // Widget to enable/disable pileup rejection algorithm
   TGCheckButton *UsePileupRejection_CB;
+
+  // Widgets for controlling the per-peak CFD/leading-edge timing
+  TGCheckButton *UsePeakTiming_CB;
+  TGButtonGroup *PeakTiming_BG;
+  TGRadioButton *TimingCFD_RB, *TimingLeadingEdge_RB;
+  ADAQNumberEntryWithLabel *CFDFraction_NEL, *CFDDelay_NEL, *LeadingEdgeThreshold_NEL;
   
   TGCheckButton *AutoYAxisRange_CB;
 
   TGCheckButton *WaveformAnalysis_CB;
   ADAQNumberEntryWithLabel *WaveformIntegral_NEL, *WaveformHeight_NEL;
 
+  // Widgets for creating the waveform persistence map
+  ADAQNumberEntryWithLabel *PersistenceFirstWaveform_NEL, *PersistenceLastWaveform_NEL;
+  ADAQNumberEntryWithLabel *PersistenceXBins_NEL, *PersistenceYBins_NEL;
+  ADAQNumberEntryWithLabel *PersistenceYMin_NEL, *PersistenceYMax_NEL;
+  TGCheckButton *PersistenceEnergyGate_CB, *PersistencePSDGate_CB;
+  ADAQNumberEntryWithLabel *PersistenceEnergyMin_NEL, *PersistenceEnergyMax_NEL;
+  TGTextButton *CreatePersistenceMap_TB;
+
 
   ///////////////////////////////////////////
   // Widgets for the spectrum tabbed frame //
@@ -222,6 +244,12 @@ private:
   TGRadioButton *ADAQSpectrumAlgorithmSMS_RB;
   TGRadioButton *ADAQSpectrumAlgorithmPF_RB;
   TGRadioButton *ADAQSpectrumAlgorithmWD_RB;
+  TGRadioButton *ADAQSpectrumAlgorithmDS_RB;
+
+  TGRadioButton *ShaperTrapezoid_RB, *ShaperCRRC_RB;
+  ADAQNumberEntryWithLabel *ShaperRiseTime_NEL, *ShaperFlatTop_NEL;
+  ADAQNumberEntryWithLabel *ShaperShapingTime_NEL, *ShaperOrder_NEL;
+  ADAQNumberEntryWithLabel *ShaperDecayTime_NEL;
 
   //TGButtonGroup *ASIMSpectrumType_BG;
   TGRadioButton *ASIMSpectrumTypeEnergy_RB;
@@ -292,11 +320,13 @@ private:
   ADAQNumberEntryWithLabel *EAGammaEDep_NEL;
   TGCheckButton *EAEscapePeaks_CB;
 
-  TGRadioButton *EAEJ301_RB, *EAEJ309_RB;
+  ADAQComboBoxWithLabel *EAResponse_CBL;
+  TGTextButton *EAResponseLoad_TB;
   ADAQNumberEntryWithLabel *EALightConversionFactor_NEL;
   ADAQNumberEntryWithLabel *EAErrorWidth_NEL;
   ADAQNumberEntryWithLabel *EAElectronEnergy_NEL, *EAGammaEnergy_NEL;
   ADAQNumberEntryWithLabel *EAProtonEnergy_NEL, *EAAlphaEnergy_NEL, *EACarbonEnergy_NEL;
+  ADAQComboBoxWithLabel *EASpectrumEnergy_CBL;
 
 
   //////////////////////////////////////
@@ -382,6 +412,7 @@ private:
   TGRadioButton *ProcessingSeq_RB, *ProcessingPar_RB;
   ADAQNumberEntryWithLabel *NumProcessors_NEL;
   ADAQNumberEntryWithLabel *UpdateFreq_NEL;
+  TGCheckButton *UseFixedPoint_CB;
 
   TGTextButton *DesplicedFileSelection_TB;
   TGTextEntry *DesplicedFileName_TE;
@@ -390,6 +421,30 @@ private:
   ADAQNumberEntryWithLabel *DesplicedWaveformLength_NEL;
   TGTextButton *DesplicedFileCreation_TB;
 
+  TGCheckButton *ListModeOutput_CB;
+  TGTextButton *ListModeFileSelection_TB;
+  TGTextEntry *ListModeFileName_TE;
+
+  TGCheckButton *UsePileupRecovery_CB;
+  TGTextButton *PulseTemplateFileSelection_TB;
+  TGTextEntry *PulseTemplateFileName_TE;
+
+  TGCheckButton *BuildPulseTemplates_CB;
+  TGTextButton *PulseTemplateOutputSelection_TB;
+  TGTextEntry *PulseTemplateOutputFileName_TE;
+  ADAQNumberEntryWithLabel *TemplatePreSamples_NEL, *TemplatePostSamples_NEL;
+  ADAQNumberEntryWithLabel *TemplateWindowMin_NEL, *TemplateWindowMax_NEL;
+
+  ADAQNumberEntryWithLabel *TreeCacheSize_NEL, *TreeCacheLearnEntries_NEL;
+  TGCheckButton *TreeCacheChannelOnly_CB;
+  ADAQNumberEntryWithLabel *IMTThreads_NEL, *ReadAheadSize_NEL;
+  ADAQNumberEntryWithLabel *WaveformCacheSize_NEL, *WaveformPrefetch_NEL;
+
+  TGCheckButton *ProfileProcessing_CB;
+  TGTextButton *ProfileFileSelection_TB;
+  TGTextEntry *ProfileFileName_TE;
+  TGTextView *ProfileReport_TV;
+
 
   ///////////////////////////////////////////
   // Widget objects for the "Canvas" frame //
@@ -443,6 +498,8 @@ private:
 
   // Variables relating to files (paths, bools)
   string DataDirectory, PrintDirectory, DesplicedDirectory, HistogramDirectory;
+  string ListModeDirectory, ProfileDirectory, PulseTemplateDirectory;
+  string ResponseDirectory;
   bool ADAQFileLoaded, ASIMFileLoaded;
   string ADAQFileName, ASIMFileName;
 
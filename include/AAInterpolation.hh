@@ -20,11 +20,10 @@
 // desc: The AAInterpolation class handles the conversion of energy
 //       deposited in liquid organic scintillators (obtained from
 //       calibrated energy deposition spectra) into incident kinetic
-//       energy of various particles. At present, only a single set of
-//       response functions for EJ301/BC501A/NE213 is implemented;
-//       future work will incorporate multiple response functions and
-//       multiple scintillators for a more thorough set of analysis
-//       tools.
+//       energy of various particles. The conversions are made by
+//       scintillator response libraries (see AAScintillatorResponse):
+//       the compiled EJ301 response is the default, and libraries for
+//       other scintillators may be loaded and assigned per channel.
 //
 /////////////////////////////////////////////////////////////////////////////////
 
@@ -35,9 +34,15 @@
 #include <TROOT.h>
 #include <TObject.h>
 #include <TGraph.h>
+#include <TH1F.h>
 
 // C++
 #include <vector>
+#include <string>
+#include <map>
+
+// ADAQAnalysis
+#include "AAScintillatorResponse.hh"
 
 class AAInterpolation : public TObject
 {
@@ -47,36 +52,54 @@ public:
 
   static AAInterpolation *GetInstance();
 
+  // Particle energies into which electron equivalent energies and
+  // spectra may be converted
+  enum ConversionTypes{zGammaConversion = AAScintillatorResponse::zGammaConversion,
+		       zProtonConversion = AAScintillatorResponse::zProtonConversion,
+		       zAlphaConversion = AAScintillatorResponse::zAlphaConversion,
+		       zCarbonConversion = AAScintillatorResponse::zCarbonConversion};
+
+  // Methods to manage the scintillator response libraries. The
+  // compiled EJ301 library is always present and is the default
+  // response; further libraries are loaded from data files (replacing
+  // any library of the same name) and assigned to digitizer channels.
+  // LoadResponseLibrary() returns the library name ("" on failure)
+  string LoadResponseLibrary(string);
+  vector<string> GetResponseLibraryNames();
+  AAScintillatorResponse *GetResponseLibrary(string);
+
+  bool SetChannelResponse(int, string);
+  AAScintillatorResponse *GetChannelResponse(int);
+  vector<string> GetChannelResponseNames(int);
+  AAScintillatorResponse *GetDefaultResponse() {return DefaultResponse;}
+
   // Method to construct particle-dependent light responses
-  void ConstructResponses();
+  void ConstructResponses() {DefaultResponse->ConstructResponses();}
   
-  // Set/get methods for member data
+  // Set/get methods for member data. Unless otherwise specified by a
+  // channel, conversions use the default (EJ301) response
 
-  void SetConversionFactor(double CF) {ConversionFactor = CF;}
-  double GetConversionFactor() {return ConversionFactor;}
+  void SetConversionFactor(double CF) {DefaultResponse->SetConversionFactor(CF);}
+  double GetConversionFactor() {return DefaultResponse->GetConversionFactor();}
 
-  double GetElectronEnergy(double, int);
-  double GetGammaEnergy(double);
-  double GetProtonEnergy(double);
-  double GetAlphaEnergy(double);
-  double GetCarbonEnergy(double);
-  
-  TGraph *GetElectronResponse() {return Response[ELECTRON];}
-  TGraph *GetProtonResponse() {return Response[PROTON];}
-  TGraph *GetAlphaResponse() {return Response[ALPHA];}
-  TGraph *GetCarbonResponse() {return Response[CARBON];}
+  double GetElectronEnergy(double E, int P) {return DefaultResponse->GetElectronEnergy(E, P);}
+  double GetGammaEnergy(double EE) {return DefaultResponse->GetGammaEnergy(EE);}
+  double GetProtonEnergy(double EE) {return DefaultResponse->GetProtonEnergy(EE);}
+  double GetAlphaEnergy(double EE) {return DefaultResponse->GetAlphaEnergy(EE);}
+  double GetCarbonEnergy(double EE) {return DefaultResponse->GetCarbonEnergy(EE);}
+
+  TGraph *GetElectronResponse() {return DefaultResponse->GetResponse(AAScintillatorResponse::ELECTRON);}
+  TGraph *GetProtonResponse() {return DefaultResponse->GetResponse(AAScintillatorResponse::PROTON);}
+  TGraph *GetAlphaResponse() {return DefaultResponse->GetResponse(AAScintillatorResponse::ALPHA);}
+  TGraph *GetCarbonResponse() {return DefaultResponse->GetResponse(AAScintillatorResponse::CARBON);}
   
 private:
-  const double m_e, MeV2GeV;
-  const int NumParticles;
-
-  enum {ELECTRON, PROTON, ALPHA, CARBON};
-
-  double ConversionFactor;
+  AAScintillatorResponse *DefaultResponse;
 
-  vector<const double *> Data;
-  vector< vector<double> > Light;
-  vector<TGraph *> Response, Inverse;
+  // All response libraries (owned) by name and the response assigned
+  // to each channel (NULL selects the default response)
+  map<string, AAScintillatorResponse *> ResponseLibraries;
+  vector<AAScintillatorResponse *> ChannelResponses;
 
   static AAInterpolation *TheInterpolationManager;
 };
@@ -0,0 +1,76 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAPileupFitter.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAPileupFitter class recovers the individual pulses of a
+//       pileup event by a least-squares fit of a channel's average
+//       pulse template to the waveform. The position of each
+//       constituent pulse is fixed by the peak finder such that the
+//       fit is linear in the pulse amplitudes: the template is shifted
+//       (with sub-sample linear interpolation) to each peak position
+//       and the small KxK normal equations for K overlapping pulses
+//       are solved directly. No iterative minimization is required
+//       and the cost of a fit is proportional to K^2 times the length
+//       of the pileup region.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AAPileupFitter_hh__
+#define __AAPileupFitter_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+// C++
+#include <vector>
+using namespace std;
+
+class AAPileupFitter
+{
+public:
+  AAPileupFitter();
+
+  // Set the pulse template from N samples. The template is normalized
+  // to unit height at its maximum such that fitted amplitudes are
+  // pulse heights; false is returned if the template has no maximum
+  Bool_t SetTemplate(const Double_t *, Int_t);
+  void ClearTemplate();
+
+  Bool_t HasTemplate() {return !Template.empty();}
+
+  // Integrate the unit height template shifted to the specified pulse
+  // position [samples] over the samples [Lower, Upper]
+  Double_t Integrate(Double_t, Int_t, Int_t);
+
+  // Fit pulses at the specified positions [samples] to the waveform
+  // samples [Min, Max] and return the fitted pulse heights; false is
+  // returned if the pulses cannot be separated (singular system)
+  Bool_t Fit(const Float_t *, Int_t, Int_t, const vector<Double_t> &, vector<Double_t> &);
+
+private:
+  Double_t Evaluate(Double_t);
+
+  vector<Double_t> Template;
+  Int_t TemplatePeak;
+
+  // Work buffers reused between fits: the shifted templates and the
+  // normal equations
+  vector<Double_t> Shifted, Matrix, Vector;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAProfiler.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAProfiler class accumulates the time spent in, and the
+//       number of calls to, each region of the waveform processing
+//       pipeline (TTree reads, waveform calculation, peak finding,
+//       etc) along with a set of event counters over a single
+//       processing run. When profiling is disabled the cost of each
+//       instrumented region is a single branch. Stages that read in
+//       parallel threads profile each thread separately and merge
+//       the thread profilers at the join, such that their region
+//       times are summed over threads (and may exceed the run time),
+//       and profilers on separate MPI nodes are aggregated to the
+//       master. At the end of a run
+//       the results can be formatted as a human-readable report or
+//       written as a machine-readable JSON file.
+//
+//       The AAProfileTimer class is a scoped timer: it begins timing
+//       a region when constructed and adds the elapsed time to the
+//       profiler when destroyed (or when explicitly stopped).
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AAProfiler_hh__
+#define __AAProfiler_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+// C++
+#include <string>
+#include <vector>
+using namespace std;
+
+// ADAQAnalysis
+#include "AATypes.hh"
+
+class AAProfiler
+{
+public:
+  AAProfiler();
+
+  void SetEnabled(Bool_t E) {Enabled = E;}
+  Bool_t GetEnabled() const {return Enabled;}
+
+  // Monotonic wall clock time [s]
+  static Double_t Now();
+
+  // Clear all accumulated results and begin timing a new run
+  void BeginRun(string);
+
+  // Stop timing the present run
+  void EndRun();
+
+  void AddTime(Int_t Region, Double_t Seconds)
+  {
+    RegionTime[Region] += Seconds;
+    RegionCalls[Region]++;
+  }
+
+  void Count(Int_t Counter, Long64_t N = 1) {Counters[Counter] += N;}
+
+  // Record a named run parameter (e.g. a peak finding setting) that is
+  // included in the report to correlate processing cost with settings
+  void SetParameter(string, Double_t);
+
+  // Add the results of another profiler (e.g. from another thread)
+  void Merge(const AAProfiler &);
+
+  // Merge the profilers of the threads of a parallel stage at the join
+  void MergeThreads(const vector<AAProfiler> &);
+
+  // Sum the results of all MPI nodes onto the master node. Must be
+  // called by all nodes; only the master's results are meaningful
+  void AggregateToMaster();
+
+  string GetReport() const;
+  Bool_t WriteJSON(string) const;
+
+  Double_t GetRegionTime(Int_t Region) const {return RegionTime[Region];}
+  Long64_t GetRegionCalls(Int_t Region) const {return RegionCalls[Region];}
+  Long64_t GetCounter(Int_t Counter) const {return Counters[Counter];}
+  Double_t GetRunTime() const {return RunTime;}
+
+private:
+  Bool_t Enabled;
+
+  string RunName;
+  Double_t RunStart, RunTime;
+  Int_t Nodes, Threads;
+
+  Double_t RegionTime[zNumProfileRegions];
+  Long64_t RegionCalls[zNumProfileRegions];
+  Long64_t Counters[zNumProfileCounters];
+
+  vector<string> ParameterNames;
+  vector<Double_t> ParameterValues;
+};
+
+
+class AAProfileTimer
+{
+public:
+  AAProfileTimer(AAProfiler *P, Int_t R)
+    : Profiler(P->GetEnabled() ? P : 0), Region(R),
+      Start(Profiler ? AAProfiler::Now() : 0.)
+  {}
+
+  ~AAProfileTimer() {Stop();}
+
+  void Stop()
+  {
+    if(Profiler){
+      Profiler->AddTime(Region, AAProfiler::Now() - Start);
+      Profiler = 0;
+    }
+  }
+
+private:
+  AAProfiler *Profiler;
+  Int_t Region;
+  Double_t Start;
+};
+
+#endif
@@ -0,0 +1,89 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAPulseTemplateBuilder.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAPulseTemplateBuilder class accumulates the average pulse
+//       shape (and its sample-by-sample RMS) of detector pulses while
+//       waveforms are processed into spectra or PSD histograms. Each
+//       pulse is aligned on its peak position or CFD time (with
+//       sub-sample linear interpolation), normalized to unit height,
+//       and added to the running sums of the pulse class into which
+//       it falls: pulses that pass or that fail the channel's PSD
+//       region. All accumulated state is held in a single array of
+//       sums such that the accumulators of each parallel node are
+//       merged by a single array reduction. The resulting templates
+//       are written to a ROOT file in the format read by the pileup
+//       recovery template fits (see AAComputation::LoadPulseTemplates)
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AAPulseTemplateBuilder_hh__
+#define __AAPulseTemplateBuilder_hh__ 1
+
+// ROOT
+#include <TH1F.h>
+
+// C++
+#include <vector>
+#include <string>
+using namespace std;
+
+class AAPulseTemplateBuilder
+{
+public:
+  AAPulseTemplateBuilder();
+
+  enum TemplateClasses{zAcceptedPulses, zRejectedPulses, zNumTemplateClasses};
+
+  // Set the number of samples before and after the alignment point
+  // and clear all accumulated pulses
+  void Configure(Int_t, Int_t);
+  void Reset();
+
+  // Accumulate the pulse of the specified class from N waveform
+  // samples aligned at the specified (fractional) sample and with
+  // the specified height; false is returned (and the pulse is not
+  // accumulated) if the template window extends beyond the waveform
+  Bool_t Accumulate(Int_t, const Float_t *, Int_t, Double_t, Double_t);
+
+  Double_t GetNumPulses(Int_t Class) {return State[Class];}
+  Int_t GetLength() {return Length;}
+
+  // The array of sums (pulse counts, sums and sums of squares) that
+  // may be summed element-wise to merge accumulators
+  vector<Double_t> &GetState() {return State;}
+
+  // Create the mean and RMS template histograms (owned by the
+  // caller); NULL is returned if no pulses of the class were
+  // accumulated
+  TH1F *CreateMean(Int_t, string);
+  TH1F *CreateRMS(Int_t, string);
+
+  // Write the templates of all classes for the specified channel to
+  // the ROOT file, preserving the templates of other channels
+  Bool_t Write(string, Int_t);
+
+private:
+  Int_t PreSamples, Length;
+
+  vector<Double_t> State;
+  Double_t *Sum(Int_t Class) {return &State[zNumTemplateClasses + Class*Length];}
+  Double_t *SumSq(Int_t Class) {return &State[zNumTemplateClasses + (zNumTemplateClasses+Class)*Length];}
+};
+
+#endif
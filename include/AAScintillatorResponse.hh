@@ -0,0 +1,125 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAScintillatorResponse.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAScintillatorResponse class holds the particle-dependent
+//       scintillation light response of a single scintillator
+//       (e.g. EJ301, EJ309, stilbene, plastic) and converts energy
+//       deposited in electron equivalent units into the energy of
+//       electrons, gammas, protons, alphas and carbon ions. The light
+//       response data is either provided as compiled tables or loaded
+//       from a response library data file (see Load()). The cubic
+//       splines of the response and inverse response functions are
+//       computed once when the responses are constructed such that
+//       conversions are inexpensive enough to be used within the
+//       waveform processing loop.
+//
+//       Response library data files are plain text. Blank lines and
+//       lines beginning with '#' are ignored; the header keywords are
+//       followed by one row per energy deposition with columns:
+//
+//         Name             <name>
+//         PhotonsPerMeVee  <photons per MeVee>
+//         ConversionFactor <light units to MeVee>
+//         <EnergyDep [MeV]> <proton light> <alpha light> <carbon light>
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AAScintillatorResponse_hh__
+#define __AAScintillatorResponse_hh__ 1
+
+// ROOT
+#include <TGraph.h>
+#include <TSpline.h>
+#include <TH1F.h>
+
+// C++
+#include <vector>
+#include <string>
+using namespace std;
+
+class AAScintillatorResponse
+{
+public:
+  AAScintillatorResponse(string, double, double, const vector<double> &,
+			 const vector<double> &, const vector<double> &,
+			 const vector<double> &);
+  ~AAScintillatorResponse();
+
+  // Method to create a response from a response library data file;
+  // NULL is returned if the file cannot be read or is invalid
+  static AAScintillatorResponse *Load(string);
+
+  enum {ELECTRON, PROTON, ALPHA, CARBON, NumParticles};
+
+  // Particle energies into which electron equivalent energies and
+  // spectra may be converted
+  enum ConversionTypes{zGammaConversion, zProtonConversion,
+		       zAlphaConversion, zCarbonConversion};
+
+  // Method to construct particle-dependent light responses
+  void ConstructResponses();
+
+  // Set/get methods for member data
+
+  string GetName() {return Name;}
+
+  void SetConversionFactor(double CF) {ConversionFactor = CF;}
+  double GetConversionFactor() {return ConversionFactor;}
+
+  double GetElectronEnergy(double, int);
+  double GetGammaEnergy(double);
+  double GetProtonEnergy(double);
+  double GetAlphaEnergy(double);
+  double GetCarbonEnergy(double);
+
+  // Batch methods to convert an array of N electron equivalent
+  // energies into the particle energies in a single call
+  void GetGammaEnergy(const double *, double *, int);
+  void GetProtonEnergy(const double *, double *, int);
+  void GetAlphaEnergy(const double *, double *, int);
+  void GetCarbonEnergy(const double *, double *, int);
+  void ConvertEnergies(int, const double *, double *, int);
+
+  // Method to convert a calibrated electron equivalent energy
+  // spectrum into a particle energy spectrum (owned by the caller);
+  // the optional argument is the spectrum energy unit in MeVee
+  TH1F *ConvertSpectrum(TH1F *, int, double Unit = 1.);
+
+  TGraph *GetResponse(int Particle) {return Response[Particle];}
+
+private:
+  const double m_e, MeV2GeV;
+
+  string Name;
+  double PhotonsPerMeVee, ConversionFactor;
+
+  // Energy deposition and per-particle light data [light units]
+  vector<double> EnergyDep;
+  vector< vector<double> > Data;
+
+  vector< vector<double> > Light;
+  vector<TGraph *> Response, Inverse;
+
+  // Cubic splines of the response and inverse functions are computed
+  // once when the responses are constructed rather than by each
+  // TGraph::Eval(x, 0, "S") call
+  vector<TSpline3 *> ResponseSpline, InverseSpline;
+};
+
+#endif
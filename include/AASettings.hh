@@ -21,11 +21,41 @@
 #include <string>
 using namespace std;
 
+#include "AATypes.hh"
+
 
 class AASettings : public TObject
 {
 public:
 
+  AASettings();
+
+  
+  //////////////////////////////
+  // Settings change tracking //
+  //////////////////////////////
+
+  // Compares the present settings to the previous settings, records
+  // the names of the fields that have changed, and invalidates the
+  // pipeline stages that each changed field affects
+  void TrackChanges(const AASettings *);
+  
+  // Whether the stage was invalidated by the most recent changes
+  Bool_t StageChanged(Int_t Stage) const {return (ChangedStages & (1<<Stage));}
+
+  // A counter that is incremented each time the stage is invalidated;
+  // results computed at a given stage may store the revision and
+  // compare it to the present revision to determine if recomputation
+  // is required
+  Int_t GetStageRevision(Int_t Stage) const {return StageRevisions[Stage];}
+
+  // The combined revision of all stages in the mask (see AATypes.hh),
+  // which changes whenever any one of the stages is invalidated
+  Int_t GetRevision(UInt_t) const;
+
+  const vector<string> &GetChangedFields() const {return ChangedFields;}
+
+
   /////////////////////
   // Waveform frame  //
   /////////////////////
@@ -45,15 +75,49 @@ public:
   Bool_t PlotFloor, PlotCrossings, PlotPeakIntegrationRegion;
   
   Bool_t UsePileupRejection;
+
+  // Pileup recovery: peaks flagged as pileup are separated by fitting
+  // the per-channel pulse templates from the specified ROOT file
+  Bool_t UsePileupRecovery;
+  string PulseTemplateFileName;
+
+  // Per-peak timing computed during peak finding: digital
+  // constant-fraction (CFD) with fraction and delay [samples] or
+  // leading-edge discrimination with threshold [ADC]
+  Bool_t UsePeakTiming, TimingCFD, TimingLeadingEdge;
+  Double_t CFDFraction;
+  Int_t CFDDelay;
+  Double_t LeadingEdgeThreshold;
   
   Bool_t PlotBaselineRegion;
   Int_t BaselineRegionMin, BaselineRegionMax;
+
+  // Baseline estimator (mean, trimmed mean, running median or moving;
+  // see AABaselineEstimator), the fraction of the baseline region
+  // discarded at each end by the trimmed mean, the running median
+  // window [samples] and the time constant [samples] and tracking
+  // threshold [ADC] of the moving baseline
+  Int_t BaselineEstimator;
+  Double_t BaselineTrimFraction;
+  Int_t BaselineMedianWindow;
+  Double_t BaselineTimeConstant, BaselineThreshold;
   
   Bool_t PlotAnalysisRegion;
   Int_t AnalysisRegionMin, AnalysisRegionMax;
   
   Bool_t PlotTrigger, WaveformAnalysis;
 
+  // Persistence map of the waveforms [First, Last) with the number of
+  // time bins (at most one per sample), the number of voltage bins
+  // over [YMin, YMax] [ADC] and optional gates on the calibrated
+  // stored pulse height and on the PSD region of the channel
+  Int_t PersistenceFirstWaveform, PersistenceLastWaveform;
+  Int_t PersistenceXBins, PersistenceYBins;
+  Double_t PersistenceYMin, PersistenceYMax;
+  Bool_t PersistenceEnergyGate;
+  Double_t PersistenceEnergyMin, PersistenceEnergyMax;
+  Bool_t PersistencePSDGate;
+
   
   ////////////////////
   // Spectrum frame //
@@ -66,6 +130,17 @@ public:
   
   Bool_t ADAQSpectrumTypePAS, ADAQSpectrumTypePHS;
   Bool_t ADAQSpectrumAlgorithmSMS, ADAQSpectrumAlgorithmPF, ADAQSpectrumAlgorithmWD;
+  Bool_t ADAQSpectrumAlgorithmDS;
+
+  // Digital shaping (DS) algorithm: trapezoidal or CR-RC^n shaper, the
+  // trapezoid rise and flat top times [samples], the CR-RC^n shaping
+  // time [samples] and order, and the input pulse decay constant for
+  // pole-zero correction [samples; 0 = disabled]
+  Bool_t ShaperTrapezoid, ShaperCRRC;
+  Int_t ShaperRiseTime, ShaperFlatTop;
+  Double_t ShaperShapingTime;
+  Int_t ShaperOrder;
+  Double_t ShaperDecayTime;
   
   Bool_t ASIMSpectrumTypeEnergy;
   Bool_t ASIMSpectrumTypePhotonsCreated;
@@ -97,6 +172,15 @@ public:
   Bool_t SpectrumFindIntegral, SpectrumIntegralInCounts;
   Bool_t SpectrumUseGaussianFit, SpectrumNormalizeToCurrent;
 
+  // The particle energy in which calibrated spectra are plotted (see
+  // SpectrumParticleEnergies in AATypes.hh)
+  Int_t SpectrumParticleEnergy;
+
+  // The name of the scintillator response library used by each
+  // channel to convert spectra into particle energy (see
+  // AAInterpolation); unassigned channels use the EJ301 default
+  vector<string> ScintillatorResponses;
+
 
   ///////////////
   // PSD frame //
@@ -155,10 +239,41 @@ public:
 
   Bool_t SeqProcessing, ParProcessing;
   Int_t NumProcessors, UpdateFreq;
+
+  // Process simple max/sum spectra and PSD histograms of baseline-
+  // subtracted waveforms in integer fixed point where possible (see
+  // AAComputation::UseFixedPointProcessing())
+  Bool_t UseFixedPoint;
   
   Int_t WaveformsToDesplice, DesplicedWaveformBuffer, DesplicedWaveformLength;
   string DesplicedFileName;
 
+  Bool_t ListModeOutput;
+  string ListModeFileName;
+
+  // Average pulse templates accumulated during waveform processing:
+  // the output ROOT file, the template window before/after the
+  // alignment point [samples], and the window of the spectrum (or PSD
+  // total integral) axis within which pulses are accumulated
+  Bool_t BuildPulseTemplates;
+  string PulseTemplateOutputFileName;
+  Int_t TemplatePreSamples, TemplatePostSamples;
+  Double_t TemplateWindowMin, TemplateWindowMax;
+  Bool_t ProfileProcessing;
+  string ProfileFileName;
+
+  // ADAQ file I/O tuning: TTreeCache size [MB] and learning entries,
+  // whether only the selected channel's branches are read (off by
+  // default since each entry read then leaves the other channels'
+  // waveforms and data stale), the number of ROOT implicit
+  // multithreading threads (0 = disabled), the file read-ahead size
+  // [kB], and the per-channel decoded waveform cache size [MB] and
+  // number of waveforms prefetched while browsing
+  Int_t TreeCacheSize, TreeCacheLearnEntries;
+  Bool_t TreeCacheChannelOnly;
+  Int_t IMTThreads, ReadAheadSize;
+  Int_t WaveformCacheSize, WaveformPrefetch;
+
   // Canvas
 
   Double_t XAxisMin, XAxisMax, XAxisPtr;
@@ -172,8 +287,24 @@ public:
   
   string ADAQFileName;
   string ASIMFileName;
+
+private:
+
+  void InvalidateStages(string, UInt_t);
+  void RecordContents();
+  
+  Bool_t Tracked; //!
+  UInt_t ChangedStages; //!
+  Int_t StageRevisions[zNumPipelineStages]; //!
+  vector<string> ChangedFields; //!
+
+  // The PSD regions and calibrations are held by pointer and may be
+  // modified in place, so their contents are recorded when tracked
+  vector<string> PSDRegionContents; //!
+  vector<string> SpectraCalibrationContents; //!
+  vector<string> SpectraCalibrationDataContents; //!
   
-  ClassDef(AASettings, 1);
+  ClassDef(AASettings, 15);
 };
 
 #endif
@@ -29,6 +29,7 @@
 #define __AATypes_hh__ 1
 
 #include <TGraph.h>
+#include <TH1F.h>
 
 #include <vector>
 #include <string>
@@ -52,6 +53,9 @@ struct PeakInfoStruct{
   bool AnalyzeFlag; // Flag to indicate whether the current peak should be analyzed into a spectrum
   bool PileupFlag; // Flag to indicate whether current peak is part of a pileup events
   bool PSDFilterFlag; // Flag to indicate whether current peak should be filtered out due to pulse shape
+  double PeakTime; // Constant-fraction or leading-edge time of the peak [sub-sample number] (-1 if not found)
+  double FitHeight; // Height of a pileup peak from the pulse template fit [ADC] (-1 if not fitted)
+  double FitArea; // Area of a pileup peak from the pulse template fit [ADC] (-1 if not fitted)
   
   // Initialization for the variables
   PeakInfoStruct() : PeakID(-1),
@@ -61,7 +65,45 @@ struct PeakInfoStruct{
 		     PeakLimit_Upper(-1),
 		     AnalyzeFlag(true),
 		     PileupFlag(false), // Convention : true == pileup; false == no pile up
-		     PSDFilterFlag(false) // Convention : true == filter out; false == do not filter out
+		     PSDFilterFlag(false), // Convention : true == filter out; false == do not filter out
+		     PeakTime(-1.),
+		     FitHeight(-1.),
+		     FitArea(-1.)
+  {}
+};
+
+
+// Structure that contains the features extracted from a single
+// detector pulse during waveform processing. When list-mode output
+// is enabled, one structure is filled per pulse and written as a
+// single entry into the list-mode TTree, with each member stored in
+// its own branch such that downstream tools can read only the
+// columns that they require
+struct ListModeRecordStruct{
+  int Entry; // Waveform (entry) number in the ADAQ waveform TTree
+  int Channel; // Digitizer channel of the pulse
+  double PeakPosX; // Peak position along the X-axis [sample number]
+  double PulseHeight; // Uncalibrated pulse height [ADC]
+  double PulseArea; // Uncalibrated pulse area [ADC]
+  double PSDTotal; // Pulse shape discrimination total integral [ADC]
+  double PSDTail; // Pulse shape discrimination tail integral [ADC]
+  bool PileupFlag; // Flag to indicate whether the pulse is part of a pileup event
+  bool PSDFilterFlag; // Flag to indicate whether the pulse failed the PSD region
+  double TimeStamp; // Digitizer trigger time stamp (-1 if unavailable)
+  double PeakTime; // Constant-fraction or leading-edge time of the pulse [sub-sample number] (-1 if unavailable)
+
+  // Initialization for the variables
+  ListModeRecordStruct() : Entry(-1),
+			   Channel(-1),
+			   PeakPosX(-1),
+			   PulseHeight(0.),
+			   PulseArea(0.),
+			   PSDTotal(0.),
+			   PSDTail(0.),
+			   PileupFlag(false),
+			   PSDFilterFlag(false),
+			   TimeStamp(-1.),
+			   PeakTime(-1.)
   {}
 };
 
@@ -77,16 +119,98 @@ struct ADAQChannelCalibrationData{
 };
 
 
+// Structure that specifies a single spectrum to be created from an
+// ASIM file: the ASIM event tree, the ASIMEvent data member to be
+// histogrammed (see the ASIMQuantities enumerator) and the histogram
+// to be filled. Several structures may be processed in a single pass
+// over the ASIM file (see AAComputation::CreateASIMSpectra)
+struct ASIMSpectrumStruct{
+  string TreeName;
+  Int_t Quantity;
+  TH1F *Spectrum_H;
+};
+
+
 /////////////////
 // Enumerators //
 /////////////////
 
 // An enumerator that specifies what type of plot is presently
 // contained in the main embedded canvas
-enum CanvasContentTypes{zEmpty, zWaveform, zSpectrum, zSpectrumDerivative, zPSDHistogram};
+enum CanvasContentTypes{zEmpty, zWaveform, zSpectrum, zSpectrumDerivative, zPSDHistogram,
+			 zPersistenceMap};
 
 enum PeakFindingAlgorithm{zPeakFinder, zWholeWaveform};
 
+enum WaveformTypes{zRawWaveform, zBSWaveform, zZSWaveform};
+
+// An enumerator that specifies the particle energy into which a
+// calibrated (electron equivalent) spectrum is converted for plotting
+enum SpectrumParticleEnergies{zEnergyDeposited, zGammaEnergy, zProtonEnergy,
+			      zAlphaEnergy, zCarbonEnergy};
+
+// An enumerator that specifies the ASIMEvent data member that is
+// histogrammed when creating an ASIM spectrum
+enum ASIMQuantities{zASIMEnergyDep, zASIMPhotonsCreated, zASIMPhotonsDetected, zNumASIMQuantities};
+
+// An enumerator that specifies the stages of the waveform processing
+// pipeline. Each stage carries a revision that is incremented when a
+// setting that the stage's results depend on is changed (see
+// AASettings.cc); the stages do not form a chain, i.e. a change to
+// one stage does not invalidate any other stage
+enum PipelineStages{zStageWaveform,     // Waveform extraction (raw/BS/ZS)
+		    zStagePeakFinding,  // Peak and peak limit finding
+		    zStageFeatures,     // Pulse height/area
+		    zStagePSD,          // PSD integrals and regions
+		    zStageCalibration,  // Spectra calibration
+		    zStageHistogram,    // Spectrum and PSD histogramming
+		    zStageAnalysis,     // Spectrum background and integration
+		    zStagePlot,         // Graphical attributes only
+		    zNumPipelineStages};
+
+// Bit masks of the pipeline stages. Each tracked setting specifies
+// the stages that it affects, and each stored result specifies the
+// stages that it depends on
+enum PipelineStageMasks{zWaveformMask = (1<<zStageWaveform),
+			zPeakFindingMask = (1<<zStagePeakFinding),
+			zFeaturesMask = (1<<zStageFeatures),
+			zPSDMask = (1<<zStagePSD),
+			zCalibrationMask = (1<<zStageCalibration),
+			zHistogramMask = (1<<zStageHistogram),
+			zAnalysisMask = (1<<zStageAnalysis),
+			zPlotMask = (1<<zStagePlot),
+			zAllStagesMask = (1<<zNumPipelineStages)-1,
+
+			// The stored uncalibrated pulse heights/areas
+			zPulseValuesMask = (zWaveformMask | zPeakFindingMask | zFeaturesMask)};
+
+// Enumerators that specify the instrumented regions of the waveform
+// processing pipeline and the event counters that are accumulated by
+// the processing profiler (see AAProfiler)
+enum ProfileRegions{zProfileRead,          // TTree entry reads
+		    zProfileTransform,     // Waveform calculation (BS/ZS)
+		    zProfilePeakFinding,   // Peak finding
+		    zProfilePeakLimits,    // Peak limit finding
+		    zProfilePeakTiming,    // Constant-fraction/leading-edge timing
+		    zProfilePileupFit,     // Pileup recovery template fits
+		    zProfileTemplates,     // Average pulse template accumulation
+		    zProfilePSDIntegrals,  // PSD integral calculation
+		    zProfileCalibration,   // Spectra calibration
+		    zProfileHistogramFill, // Spectrum and PSD histogram filling
+		    zProfileOutput,        // List-mode and despliced file output
+		    zNumProfileRegions};
+
+enum ProfileCounters{zCountWaveforms,        // Waveforms processed
+		     zCountBytesRead,        // Bytes read from the TTree
+		     zCountPeaks,            // Peaks found
+		     zCountPileupPeaks,      // Peaks rejected as pileup
+		     zCountRecoveredPeaks,   // Pileup peaks recovered by template fits
+		     zCountTemplatePulses,   // Pulses added to average pulse templates
+		     zCountPSDRejected,      // Pulses rejected by PSD regions
+		     zCountHistogramEntries, // Histogram fills
+		     zCountReadCalls,        // File read calls (syscalls)
+		     zNumProfileCounters};
+
 // The following enumerator is used to create unique integers that
 // will be assigned as the "widget ID" to the ROOT widgets that make
 // up the ADAQ analysis graphical interface. The widget IDs are used
@@ -146,6 +270,11 @@ enum{
   PlotBaselineRegion_CB_ID,
   BaselineRegionMin_NEL_ID,
   BaselineRegionMax_NEL_ID,
+  BaselineEstimator_CBL_ID,
+  BaselineTrimFraction_NEL_ID,
+  BaselineMedianWindow_NEL_ID,
+  BaselineTimeConstant_NEL_ID,
+  BaselineThreshold_NEL_ID,
 
   PlotZeroSuppressionCeiling_CB_ID,
   ZeroSuppressionCeiling_NEL_ID,
@@ -155,6 +284,7 @@ enum{
   UsePileupRejection_CB_ID,
   AutoYAxisRange_CB_ID,
   WaveformAnalysis_CB_ID,
+  CreatePersistenceMap_TB_ID,
 
   
   /////////////////////////////////////////
@@ -172,6 +302,9 @@ enum{
   ADAQSpectrumAlgorithmSMS_RB_ID,
   ADAQSpectrumAlgorithmPF_RB_ID,
   ADAQSpectrumAlgorithmWD_RB_ID,
+  ADAQSpectrumAlgorithmDS_RB_ID,
+  ShaperTrapezoid_RB_ID,
+  ShaperCRRC_RB_ID,
 
   ASIMSpectrumTypeEnergy_RB_ID,
   ASIMSpectrumTypePhotonsCreated_RB_ID,
@@ -228,8 +361,8 @@ enum{
   EAGammaEDep_NEL_ID,
   EAEscapePeaks_CB_ID,
 
-  EAEJ301_RB_ID,
-  EAEJ309_RB_ID,
+  EAResponse_CBL_ID,
+  EAResponseLoad_TB_ID,
   EALightConversionFactor_NEL_ID,
   EAErrorWidth_NEL_ID,
   EAElectronEnergy_NEL_ID,
@@ -237,6 +370,7 @@ enum{
   EAProtonEnergy_NEL_ID,
   EAAlphaEnergy_NEL_ID,
   EACarbonEnergy_NEL_ID,
+  EASpectrumEnergy_CBL_ID,
 
   ///////////////////////////
   // Values for the PSD frame
@@ -352,6 +486,16 @@ enum{
 
   DesplicedFileSelection_TB_ID,
   DesplicedFileCreation_TB_ID,
+
+  ListModeOutput_CB_ID,
+  ListModeFileSelection_TB_ID,
+  UsePileupRecovery_CB_ID,
+  PulseTemplateFileSelection_TB_ID,
+  BuildPulseTemplates_CB_ID,
+  PulseTemplateOutputSelection_TB_ID,
+
+  ProfileProcessing_CB_ID,
+  ProfileFileSelection_TB_ID,
   
   //////////////////////////////////////////
   // Values for the "Canvas + Sliders" frame
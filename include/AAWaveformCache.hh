@@ -0,0 +1,85 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAWaveformCache.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAWaveformCache class holds recently read (decoded)
+//       digitized waveforms such that browsing back and forth through
+//       the waveforms of an ADAQ file does not reread and decompress
+//       them. Each channel has a least-recently-used (LRU) cache that
+//       is bounded by a memory budget. A background thread, which
+//       opens its own TFile, prefetches the entries following the
+//       presently viewed waveform in the direction of browsing into
+//       the cache. Prefetching requires ROOT v6 or higher for thread
+//       safety; the cache itself is always available. The cache data
+//       and the thread are held privately in the source file such
+//       that this header may be parsed for the ROOT dictionary.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AAWaveformCache_hh__
+#define __AAWaveformCache_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+// C++
+#include <vector>
+#include <string>
+using namespace std;
+
+struct AAWaveformCacheData;
+
+class AAWaveformCache
+{
+public:
+  AAWaveformCache();
+  ~AAWaveformCache();
+
+  // Set the ADAQ file, waveform tree and channel waveform branch name
+  // prefix (e.g. "WaveformCh") from which waveforms are read; the
+  // cache is cleared and prefetching is stopped
+  void SetFile(string, string, string);
+
+  // Set the memory budget of each channel [MB; 0 = disabled] and the
+  // number of entries to prefetch [0 = disabled]
+  void Configure(Int_t, Int_t);
+
+  void Clear();
+
+  // Copy the cached waveform of a channel and entry into the vector;
+  // returns false if the waveform is not cached
+  Bool_t Get(Int_t, Int_t, vector<Int_t> &);
+
+  // Add the waveform of a channel and entry to the cache, evicting the
+  // least recently used waveforms of the channel if required
+  void Insert(Int_t, Int_t, const vector<Int_t> &);
+
+  // Request that the entries following the specified channel and entry
+  // in the specified direction (+1 or -1) be read into the cache in
+  // the background. A new request supersedes an unfinished one
+  void Prefetch(Int_t, Int_t, Int_t);
+
+  Long64_t GetHits() const;
+  Long64_t GetMisses() const;
+
+private:
+  AAWaveformCacheData *Data;
+};
+
+#endif
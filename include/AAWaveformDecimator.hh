@@ -0,0 +1,71 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAWaveformDecimator.hh
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAWaveformDecimator class reduces long waveforms to the
+//       min/max envelope that is visible at the resolution of the
+//       canvas. A multi-level min/max pyramid (level L holds the
+//       minimum and maximum of blocks of 2^L samples) is built once
+//       per waveform; the envelope of any X range is then computed
+//       at a cost of O(log N) per column rather than O(N) such that
+//       zooming and panning long records remains interactive.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __AAWaveformDecimator_hh__
+#define __AAWaveformDecimator_hh__ 1
+
+// ROOT
+#include <Rtypes.h>
+
+// C++
+#include <vector>
+using namespace std;
+
+class AAWaveformDecimator
+{
+public:
+  AAWaveformDecimator();
+
+  // Build the pyramid of N samples, where sample n is located at the
+  // X position Start + n*Width
+  void Build(const Float_t *, Int_t, Double_t, Double_t);
+
+  // Compute the min/max envelope of the samples within [XMin, XMax]
+  // using the specified number of columns. Each column contributes
+  // its minimum and maximum at the column center X. Returns false
+  // (and no envelope) if there are too few samples within the range
+  // to decimate, in which case the samples should be drawn directly
+  Bool_t Decimate(Double_t, Double_t, Int_t, vector<Double_t> &, vector<Double_t> &) const;
+
+  Int_t GetNumSamples() const {return NumSamples;}
+  Int_t GetNumLevels() const {return Min.size();}
+
+private:
+  // Minimum and maximum of the samples [First, Last)
+  void GetRange(Int_t, Int_t, Float_t &, Float_t &) const;
+
+  Int_t NumSamples;
+  Double_t Start, Width;
+
+  // Level 0 is the samples themselves
+  vector< vector<Float_t> > Min, Max;
+};
+
+#endif
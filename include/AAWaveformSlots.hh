@@ -43,6 +43,7 @@ public:
   void HandleComboBoxes(int, int);
   void HandleNumberEntries();
   void HandleRadioButtons();
+  void HandleTextButtons();
 
   ClassDef(AAWaveformSlots, 0);
 
@@ -23,6 +23,9 @@
 //
 /////////////////////////////////////////////////////////////////////////////////
 
+// ROOT
+#include <TGFileDialog.h>
+
 // ADAQAnalysis
 #include "AAAnalysisSlots.hh"
 #include "AANontabSlots.hh"
@@ -178,6 +181,28 @@ void AAAnalysisSlots::HandleComboBoxes(int ComboBoxID, int SelectedID)
       TheInterface->SetEANeutronWidgetState(true, kButtonUp);
     }
     break;
+
+  case EASpectrumEnergy_CBL_ID:
+    if(ComputationMgr->GetSpectrumExists())
+      GraphicsMgr->PlotSpectrum();
+    break;
+
+  case EAResponse_CBL_ID:{
+    int Channel = TheInterface->ChannelSelector_CBL->GetComboBox()->GetSelected();
+    vector<string> Names = InterpolationMgr->GetResponseLibraryNames();
+    
+    if(SelectedID >= 0 and SelectedID < (int)Names.size())
+      InterpolationMgr->SetChannelResponse(Channel, Names[SelectedID]);
+
+    TheInterface->UpdateEAResponseWidgets();
+    TheInterface->SaveSettings();
+    
+    if(ComputationMgr->GetSpectrumExists() and
+       TheInterface->EASpectrumEnergy_CBL->GetComboBox()->GetSelected() != zEnergyDeposited)
+      GraphicsMgr->PlotSpectrum();
+    TheInterface->NontabSlots->HandleTripleSliderPointer();
+    break;
+  }
     
   default:
     break;
@@ -226,9 +251,17 @@ void AAAnalysisSlots::HandleNumberEntries()
   }
     
   case EALightConversionFactor_NEL_ID:{
+    // The conversion factor belongs to the response of the channel
+    int Channel = TheInterface->ChannelSelector_CBL->GetComboBox()->GetSelected();
+    AAScintillatorResponse *Response = InterpolationMgr->GetChannelResponse(Channel);
+
     double CF = TheInterface->EALightConversionFactor_NEL->GetEntry()->GetNumber();
-    InterpolationMgr->SetConversionFactor(CF);
-    InterpolationMgr->ConstructResponses();
+    Response->SetConversionFactor(CF);
+    Response->ConstructResponses();
+
+    if(ComputationMgr->GetSpectrumExists() and
+       TheInterface->EASpectrumEnergy_CBL->GetComboBox()->GetSelected() != zEnergyDeposited)
+      GraphicsMgr->PlotSpectrum();
     TheInterface->NontabSlots->HandleTripleSliderPointer();
     break;
   }
@@ -288,3 +321,62 @@ void AAAnalysisSlots::HandleRadioButtons()
 
   }
 }
+
+
+void AAAnalysisSlots::HandleTextButtons()
+{
+  if(!TheInterface->EnableInterface)
+    return;
+  
+  TGTextButton *TextButton = (TGTextButton *) gTQSender;
+  int TextButtonID = TextButton->WidgetId();
+  
+  TheInterface->SaveSettings();
+  
+  switch(TextButtonID){
+
+  case EAResponseLoad_TB_ID:{
+
+    const char *FileTypes[] = {"Response library", "*.dat",
+			       "All files",        "*",
+			       0, 0};
+    
+    TGFileInfo FileInformation;
+    FileInformation.fFileTypes = FileTypes;
+    FileInformation.fIniDir = StrDup(TheInterface->ResponseDirectory.c_str());
+    new TGFileDialog(gClient->GetRoot(), TheInterface, kFDOpen, &FileInformation);
+    
+    if(FileInformation.fFilename==NULL)
+      TheInterface->CreateMessageBox("A response library file was not selected!","Stop");
+    else{
+      string ResponseFileName = FileInformation.fFilename;
+      
+      size_t Found = ResponseFileName.find_last_of("/");
+      if(Found != string::npos)
+	TheInterface->ResponseDirectory = ResponseFileName.substr(0, Found);
+
+      // Load the library and assign it to the present channel
+      string Name = InterpolationMgr->LoadResponseLibrary(ResponseFileName);
+      if(Name == ""){
+	TheInterface->CreateMessageBox("The selected file is not a valid response library!","Stop");
+	break;
+      }
+
+      int Channel = TheInterface->ChannelSelector_CBL->GetComboBox()->GetSelected();
+      InterpolationMgr->SetChannelResponse(Channel, Name);
+
+      TheInterface->UpdateEAResponseWidgets();
+      TheInterface->SaveSettings();
+
+      if(ComputationMgr->GetSpectrumExists() and
+	 TheInterface->EASpectrumEnergy_CBL->GetComboBox()->GetSelected() != zEnergyDeposited)
+	GraphicsMgr->PlotSpectrum();
+      TheInterface->NontabSlots->HandleTripleSliderPointer();
+    }
+    break;
+  }
+
+  default:
+    break;
+  }
+}
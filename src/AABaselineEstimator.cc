@@ -0,0 +1,221 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AABaselineEstimator.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AABaselineEstimator class implements the mean, trimmed
+//       mean, running median and moving waveform baseline estimators
+//       and single-pass baseline subtraction.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// ADAQAnalysis
+#include "AABaselineEstimator.hh"
+
+
+AABaselineEstimator::AABaselineEstimator()
+  : Type(zMeanBaseline), RegionMin(0), RegionMax(1), TrimFraction(0.),
+    HalfWindow(1), Alpha(0.01), Threshold(0.)
+{;}
+
+
+void AABaselineEstimator::Configure(Int_t T, Int_t Min, Int_t Max, Double_t Trim,
+				    Int_t Window, Double_t TimeConstant, Double_t Thresh)
+{
+  Type = T;
+  RegionMin = (Min < 0) ? 0 : Min;
+  RegionMax = Max;
+
+  // At least one sample must remain after trimming both ends
+  TrimFraction = (Trim < 0.) ? 0. : ((Trim > 0.49) ? 0.49 : Trim);
+
+  // The running median window is 2*HalfWindow+1 samples wide
+  HalfWindow = (Window < 2) ? 1 : Window/2;
+
+  Alpha = (TimeConstant > 1.) ? 1./TimeConstant : 1.;
+  Threshold = (Thresh > 0.) ? Thresh : 0.;
+}
+
+
+Double_t AABaselineEstimator::Calculate(const Int_t *Samples, Int_t N)
+{
+  Int_t Max = min(RegionMax, N);
+  if(RegionMin >= Max)
+    return 0.;
+
+  // The median is the trimmed mean with all but the middle sample(s)
+  // of the region discarded
+  if(Type == zTrimmedMeanBaseline)
+    return RegionTrimmedMean(Samples, RegionMin, Max, TrimFraction);
+  else if(Type == zRunningMedianBaseline)
+    return RegionTrimmedMean(Samples, RegionMin, Max, 0.5);
+  else
+    return RegionMean(Samples, RegionMin, Max);
+}
+
+
+Double_t AABaselineEstimator::Subtract(const Int_t *Samples, Int_t N,
+				       Double_t Polarity, Float_t *Output)
+{
+  if(N <= 0)
+    return 0.;
+
+  if(Type == zRunningMedianBaseline)
+    return RunningMedian(Samples, N, Polarity, Output);
+
+  else if(Type == zMovingBaseline)
+    return Moving(Samples, N, Polarity, Output);
+
+  Double_t Baseline = Calculate(Samples, N);
+  for(Int_t n=0; n<N; n++)
+    Output[n] = Polarity*(Samples[n] - Baseline);
+
+  return Baseline;
+}
+
+
+Double_t AABaselineEstimator::RegionMean(const Int_t *Samples, Int_t Min, Int_t Max)
+{
+  Double_t Sum = 0.;
+  for(Int_t s=Min; s<Max; s++)
+    Sum += Samples[s];
+  return Sum/(Max - Min);
+}
+
+
+// The samples of the region below and above the trimmed range are
+// separated by two partial sorts in O(region) time
+Double_t AABaselineEstimator::RegionTrimmedMean(const Int_t *Samples, Int_t Min, Int_t Max,
+						Double_t Fraction)
+{
+  const Int_t Length = Max - Min;
+  Int_t Trim = (Int_t)(Fraction*Length);
+  if(2*Trim >= Length)
+    Trim = (Length-1)/2;
+
+  if(Trim == 0)
+    return RegionMean(Samples, Min, Max);
+
+  Region.assign(Samples+Min, Samples+Max);
+  vector<Int_t>::iterator Begin = Region.begin();
+
+  nth_element(Begin, Begin+Trim, Region.end());
+  nth_element(Begin+Trim, Begin+(Length-Trim), Region.end());
+
+  Double_t Sum = 0.;
+  for(Int_t s=Trim; s<Length-Trim; s++)
+    Sum += Region[s];
+  return Sum/(Length - 2*Trim);
+}
+
+
+// The running median of the window [n-HalfWindow, n+HalfWindow]
+// (clipped at the ends of the waveform) is tracked with a histogram
+// of the window's ADC values, the histogram bin holding the median
+// and the number of window samples below that bin. Adding or removing
+// a sample changes the rank of the median by at most one, such that
+// the median bin moves only to the neighbouring occupied bin
+Double_t AABaselineEstimator::RunningMedian(const Int_t *Samples, Int_t N,
+					    Double_t Polarity, Float_t *Output)
+{
+  Int_t Lowest = Samples[0], Highest = Samples[0];
+  for(Int_t n=1; n<N; n++){
+    Lowest = min(Lowest, Samples[n]);
+    Highest = max(Highest, Samples[n]);
+  }
+
+  if((Int_t)Histogram.size() < Highest-Lowest+1)
+    Histogram.resize(Highest-Lowest+1, 0);
+  Int_t *H = &Histogram[0];
+
+  Int_t Count = 0, Median = 0, Below = 0;
+  Double_t Sum = 0.;
+
+  for(Int_t n=0; n<min(HalfWindow, N); n++){
+    H[Samples[n]-Lowest]++;
+    Count++;
+  }
+
+  for(Int_t n=0; n<N; n++){
+    if(n+HalfWindow < N){
+      Int_t Bin = Samples[n+HalfWindow] - Lowest;
+      H[Bin]++;
+      Count++;
+      if(Bin < Median)
+	Below++;
+    }
+
+    if(n-HalfWindow-1 >= 0){
+      Int_t Bin = Samples[n-HalfWindow-1] - Lowest;
+      H[Bin]--;
+      Count--;
+      if(Bin < Median)
+	Below--;
+    }
+
+    // Move the median bin such that it holds the sample of rank
+    // (Count-1)/2, i.e. the lower median of even windows
+    const Int_t Rank = (Count-1)/2;
+    while(Below > Rank){
+      Median--;
+      Below -= H[Median];
+    }
+    while(Below + H[Median] <= Rank){
+      Below += H[Median];
+      Median++;
+    }
+
+    const Double_t Baseline = Median + Lowest;
+    Output[n] = Polarity*(Samples[n] - Baseline);
+    Sum += Baseline;
+  }
+
+  // Empty the histogram for the next waveform
+  for(Int_t n=max(0, N-HalfWindow-1); n<N; n++)
+    H[Samples[n]-Lowest] = 0;
+
+  return Sum/N;
+}
+
+
+// The moving baseline is only updated by samples within the
+// threshold of the present baseline such that it holds its value
+// while pulses are present. Note that a baseline step larger than
+// the threshold is therefore not followed
+Double_t AABaselineEstimator::Moving(const Int_t *Samples, Int_t N,
+				     Double_t Polarity, Float_t *Output)
+{
+  Int_t Max = min(RegionMax, N);
+  Double_t Baseline = (RegionMin < Max) ? RegionMean(Samples, RegionMin, Max) : Samples[0];
+  Double_t Sum = 0.;
+
+  for(Int_t n=0; n<N; n++){
+    const Double_t Deviation = Samples[n] - Baseline;
+    if(fabs(Deviation) <= Threshold)
+      Baseline += Alpha*Deviation;
+
+    Output[n] = Polarity*(Samples[n] - Baseline);
+    Sum += Baseline;
+  }
+
+  return Sum/N;
+}
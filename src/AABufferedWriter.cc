@@ -0,0 +1,141 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //      
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+// 
+// name: AABufferedWriter.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+// 
+// desc: The AABufferedWriter class provides a simple, fast writer
+//       for all of the ASCII (and binary) data files produced by
+//       ADAQAnalysis. Values are formatted directly into a large
+//       memory buffer that is only written to disk when full (or
+//       when the writer is closed).
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <cstring>
+using namespace std;
+
+// ADAQAnalysis
+#include "AABufferedWriter.hh"
+
+
+AABufferedWriter::AABufferedWriter(string FileName, Int_t BufferSize)
+  : File(NULL), Buffer(BufferSize), Position(0), Precision(6), WriteError(false)
+{
+  File = fopen(FileName.c_str(), "wb");
+}
+
+
+AABufferedWriter::~AABufferedWriter()
+{
+  Close();
+}
+
+
+// Ensure that at least N bytes are free in the buffer, writing the
+// present buffer contents to disk if necessary
+void AABufferedWriter::Reserve(size_t N)
+{
+  if(Position + N <= Buffer.size())
+    return;
+  
+  Flush();
+
+  if(N > Buffer.size())
+    Buffer.resize(N);
+}
+
+
+void AABufferedWriter::Write(const char *S, Int_t Width)
+{
+  size_t Length = strlen(S);
+
+  size_t Padding = 0;
+  if(Width > 0 and Length < (size_t)Width)
+    Padding = Width - Length;
+
+  Reserve(Length + Padding);
+  
+  memset(&Buffer[Position], ' ', Padding);
+  Position += Padding;
+  
+  memcpy(&Buffer[Position], S, Length);
+  Position += Length;
+}
+
+
+void AABufferedWriter::Write(Double_t Value, Int_t Width)
+{
+  // Format directly into the buffer; 64 bytes accomodates the
+  // longest possible "%g" representation of a double
+  Reserve(Width + 64);
+  Position += snprintf(&Buffer[Position], Width + 64, "%*.*g", Width, Precision, Value);
+}
+
+
+void AABufferedWriter::Write(Int_t Value, Int_t Width)
+{
+  Reserve(Width + 32);
+  Position += snprintf(&Buffer[Position], Width + 32, "%*d", Width, Value);
+}
+
+
+void AABufferedWriter::Write(char C)
+{
+  Reserve(1);
+  Buffer[Position++] = C;
+}
+
+
+void AABufferedWriter::WriteBinary(const void *Data, size_t Bytes)
+{
+  Reserve(Bytes);
+  memcpy(&Buffer[Position], Data, Bytes);
+  Position += Bytes;
+}
+
+
+Bool_t AABufferedWriter::Flush()
+{
+  if(!File)
+    return false;
+
+  if(Position > 0){
+    if(fwrite(&Buffer[0], 1, Position, File) != Position)
+      WriteError = true;
+    Position = 0;
+  }
+  return !WriteError;
+}
+
+
+// Method to write any remaining buffered data to disk and close the
+// file. Returns false if any write to disk has failed
+Bool_t AABufferedWriter::Close()
+{
+  if(!File)
+    return false;
+  
+  Flush();
+  
+  if(fclose(File) != 0)
+    WriteError = true;
+
+  File = NULL;
+  
+  return !WriteError;
+}
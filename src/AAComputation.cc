@@ -37,12 +37,17 @@
 #include <TDirectory.h>
 #include <TKey.h>
 #include <TFitResult.h>
+#include <TTreeCache.h>
+#include <TBranch.h>
+#include <TROOT.h>
+#include <RVersion.h>
 
 // C++
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <chrono>
+#include <cfloat>
 using namespace std;
 
 // MPI
@@ -57,6 +62,7 @@ using namespace std;
 // ADAQAnalysis
 #include "AAComputation.hh"
 #include "AAParallel.hh"
+#include "AABufferedWriter.hh"
 
 
 AAComputation *AAComputation::TheComputationManager = 0;
@@ -67,9 +73,13 @@ AAComputation *AAComputation::GetInstance()
 
 
 AAComputation::AAComputation(string CmdLineArg, bool PA)
-  : SequentialArchitecture(!PA), ParallelArchitecture(PA),
+  : ProcessingProgressBar(0), ProfileTextView(0), ADAQSettings(0),
+    SequentialArchitecture(!PA), ParallelArchitecture(PA),
     ADAQFile(new TFile), ADAQFileName(""), ADAQFileLoaded(false), ADAQLegacyFileLoaded(false),
-    ADAQWaveformTree(new TTree),
+    ADAQWaveformTree(new TTree), ADAQMeasParams(0),
+    TreeIOCacheSize(-1), TreeIOLearnEntries(-1), TreeIOChannel(-1),
+    TreeIOThreads(0), TreeIOReadAhead(-1),
+    TriggerIndexBegin(0), TriggerIndexEnd(0),
 
     ASIMFile(new TFile), ASIMFileName(""), ASIMFileLoaded(false), 
     ASIMEventTreeList(new TList), ASIMEvt(new ASIMEvent),
@@ -80,15 +90,23 @@ AAComputation::AAComputation(string CmdLineArg, bool PA)
     PeakIntegral_LowerLimit(0), PeakIntegral_UpperLimit(0), PeakLimits(0),
     WaveformStart(0), WaveformEnd(0),
     WaveformAnalysisHeight(0.), WaveformAnalysisArea(0.), 
+    CachedWaveformType(-1), CachedWaveformChannel(-1), CachedWaveformNumber(-1),
+    CachedWaveformRevision(-1),
     Spectrum_H(new TH1F), SpectrumDerivative_H(new TH1F), SpectrumDerivative_G(new TGraph),
     SpectrumBackground_H(new TH1F), SpectrumDeconvolved_H(new TH1F), 
     SpectrumIntegral_H(new TH1F), SpectrumFit_F(new TF1),
+    SpectrumRevision(0), ProcessedSpectrumChannel(-1), ProcessedSpectrumRevision(-1),
+    BackgroundAnalysisRevision(-1), BackgroundSpectrumRevision(-1),
     PSDHistogram_H(new TH2F), MasterPSDHistogram_H(new TH2F), PSDHistogramSlice_H(new TH1D),
     PSDRegionPolarity(1.),
+    PersistenceMap_H(new TH2F), PersistenceMapWaveforms(0),
+    ListModeFile(0), ListModeTree(0), ListModeActive(false),
+    ProfileReadCalls(0), PulseTemplateFileName(""), PulseTemplateFileTime(0),
    
     SpectrumExists(false), SpectrumBackgroundExists(false), SpectrumDerivativeExists(false),
     SpectrumFitExists(false),
     PSDHistogramExists(false), PSDHistogramSliceExists(false),
+    PersistenceMapExists(false),
 
     MPI_Size(1), MPI_Rank(0), IsMaster(true), IsSlave(false), ParallelVerbose(true),
     Verbose(false), NumDataChannels(16), TotalPeaks(0), 
@@ -208,7 +226,9 @@ AAComputation::AAComputation(string CmdLineArg, bool PA)
 
 
 AAComputation::~AAComputation()
-{;}
+{
+  ClearHistogramPool();
+}
 
 
 bool AAComputation::LoadADAQFile(string FileName)
@@ -321,10 +341,273 @@ bool AAComputation::LoadADAQFile(string FileName)
     // An ADAQ file should be successfull loaded at this point
     ADAQFileLoaded = true;
   }
+
+  // Previously calculated waveforms and processed spectrum values
+  // belong to the previous file and must not be reused
+  CachedWaveformNumber = -1;
+  ProcessedSpectrumChannel = -1;
+
+  // The trigger index belongs to the previous file
+  for(Int_t ch=0; ch<MAX_DG_CHANNELS; ch++)
+    TriggerEntries[ch].clear();
+  TriggerIndexBegin = TriggerIndexEnd = 0;
+
+  // Waveforms of the previous file must not be served from the cache
+  WaveformCache.SetFile(FileName, "WaveformTree",
+			(ADAQLegacyFileLoaded) ? "VoltageInADC_Ch" : "WaveformCh");
+
+  // Tune reading of the new waveform TTree
+  if(ADAQFileLoaded)
+    ConfigureTreeIO(true);
   
   return ADAQFileLoaded;
 }
 
+
+// Method to configure how the waveform TTree is read from disk. By
+// default, each call to TTree::GetEntry() issues a separate small
+// read for every basket of every enabled branch and decompresses them
+// serially, which is very slow on network file systems. Instead, a
+// TTreeCache is used to prefetch the baskets of many entries with a
+// few large reads; only the branches of the selected digitizer
+// channel are optionally enabled and cached since waveform
+// processing acts on a single channel, in which case the branches
+// are reselected whenever the channel changes; ROOT's implicit
+// multithreading (if available) decompresses baskets in parallel; and
+// the file read-ahead size is set for sequential reading
+void AAComputation::ConfigureTreeIO(Bool_t Force)
+{
+  if(!ADAQFileLoaded or !ADAQWaveformTree)
+    return;
+
+  // The settings may not yet exist when the file is first loaded, in
+  // which case the AASettings defaults are used for all channels
+  AASettings Defaults;
+  AASettings *S = (ADAQSettings) ? ADAQSettings : &Defaults;
+
+  Int_t Channel = (ADAQSettings and S->TreeCacheChannelOnly) ? S->WaveformChannel : -1;
+
+  // The decoded waveform cache is independent of the TTree settings
+  WaveformCache.Configure(S->WaveformCacheSize, S->WaveformPrefetch);
+  
+  if(!Force and
+     S->TreeCacheSize == TreeIOCacheSize and
+     S->TreeCacheLearnEntries == TreeIOLearnEntries and
+     Channel == TreeIOChannel and
+     S->IMTThreads == TreeIOThreads and
+     S->ReadAheadSize == TreeIOReadAhead)
+    return;
+
+  
+  //////////////////////
+  // Branch selection
+
+  // Enable only the selected channel's branches (or all channels'
+  // branches if Channel == -1) such that GetEntry() reads only them
+  Int_t NumChannels = (ADAQLegacyFileLoaded) ? NumDataChannels : ARI->GetDGNumChannels();
+  vector<string> CacheBranches;
+  
+  for(Int_t ch=0; ch<NumChannels; ch++){
+    Bool_t Status = (Channel == -1 or ch == Channel);
+
+    stringstream SS;
+    if(ADAQLegacyFileLoaded){
+      SS << "VoltageInADC_Ch" << ch;
+      ADAQWaveformTree->SetBranchStatus(SS.str().c_str(), Status);
+      if(Status)
+	CacheBranches.push_back(SS.str());
+    }
+    else{
+      SS << "WaveformCh" << ch;
+      ADAQWaveformTree->SetBranchStatus(SS.str().c_str(), Status);
+      if(Status)
+	CacheBranches.push_back(SS.str());
+
+      SS.str("");
+      SS << "WaveformDataCh" << ch;
+      ADAQWaveformTree->SetBranchStatus(SS.str().c_str(), Status);
+      if(Status)
+	CacheBranches.push_back(SS.str());
+    }
+  }
+
+
+  /////////////////
+  // Read-ahead
+
+  TFile::SetReadaheadSize(S->ReadAheadSize*1024);
+
+  
+  ///////////////
+  // TTreeCache
+
+  // Setting a zero cache size removes the cache entirely
+  TTreeCache::SetLearnEntries(S->TreeCacheLearnEntries);
+  ADAQWaveformTree->SetCacheSize((Long64_t)S->TreeCacheSize*1024*1024);
+
+  if(S->TreeCacheSize > 0){
+
+    // With a single channel selected the cached branches are known
+    // exactly so the learning phase is skipped; otherwise the cache
+    // learns the branches that are used over the first entries
+    if(Channel != -1){
+      for(size_t b=0; b<CacheBranches.size(); b++)
+	ADAQWaveformTree->AddBranchToCache(CacheBranches[b].c_str(), true);
+      ADAQWaveformTree->StopCacheLearningPhase();
+    }
+  }
+
+
+  //////////////////////////////
+  // Implicit multithreading
+
+  // Note that implicit multithreading is global to the ROOT session
+  // and requires ROOT v6.08 or higher
+  if(S->IMTThreads != TreeIOThreads){
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+    if(ROOT::IsImplicitMTEnabled())
+      ROOT::DisableImplicitMT();
+    if(S->IMTThreads > 0)
+      ROOT::EnableImplicitMT(S->IMTThreads);
+#else
+    if(S->IMTThreads > 0)
+      cout << "\nADAQAnalysis warning! Implicit multithreading requires ROOT v6.08 or higher!\n" << endl;
+#endif
+  }
+
+  TreeIOCacheSize = S->TreeCacheSize;
+  TreeIOLearnEntries = S->TreeCacheLearnEntries;
+  TreeIOChannel = Channel;
+  TreeIOThreads = S->IMTThreads;
+  TreeIOReadAhead = S->ReadAheadSize;
+}
+
+
+// Method to build the per-channel trigger index. As of ADAQ libraries
+// version 1.6.0, all digitizer channels are stored in a single TTree
+// with channel-specific branches; when TTree::Fill() is called all
+// branches are saved such that the branches of channels that did not
+// trigger hold stale data from their previous trigger. A channel is
+// therefore determined to have triggered in an entry if its waveform
+// data (or, if no waveform data was stored, its waveform) differs
+// from that of the previous entry. The index is built once per file
+// (extending it as necessary) such that all per-channel processing
+// loops need only read the entries of their own channel
+void AAComputation::BuildTriggerIndex(Int_t Begin, Int_t End)
+{
+  if(!ADAQFileLoaded or ADAQLegacyFileLoaded)
+    return;
+  
+  End = min(End, (Int_t)ADAQWaveformTree->GetEntries());
+
+  Bool_t Indexed = (TriggerIndexEnd > TriggerIndexBegin);
+  
+  // The range is already indexed
+  if(Indexed and Begin >= TriggerIndexBegin and End <= TriggerIndexEnd)
+    return;
+  
+  // Extend the present index if the range overlaps its end;
+  // otherwise discard it and index the new range
+  Int_t ScanBegin = Begin;
+  
+  if(Indexed and Begin >= TriggerIndexBegin and Begin <= TriggerIndexEnd)
+    ScanBegin = TriggerIndexEnd;
+  else{
+    for(Int_t ch=0; ch<MAX_DG_CHANNELS; ch++)
+      TriggerEntries[ch].clear();
+    TriggerIndexBegin = Begin;
+  }
+
+  Int_t NumChannels = ARI->GetDGNumChannels();
+
+  // The waveforms themselves are only compared (and therefore read)
+  // when the digitizer did not store any waveform data
+  Bool_t CompareWaveforms = !(ARI->GetStoreEnergyData() or ARI->GetStorePSDData());
+
+  // All channels must be read during the scan
+  for(Int_t ch=0; ch<NumChannels; ch++){
+    stringstream SS;
+    SS << "WaveformCh" << ch;
+    ADAQWaveformTree->SetBranchStatus(SS.str().c_str(), CompareWaveforms);
+    
+    SS.str("");
+    SS << "WaveformDataCh" << ch;
+    ADAQWaveformTree->SetBranchStatus(SS.str().c_str(), 1);
+  }
+
+  const Int_t NumValues = 5;
+  vector<Double_t> Data(NumValues, 0.);
+  vector<Double_t> PrevData[MAX_DG_CHANNELS];
+  vector<Int_t> PrevWaveform[MAX_DG_CHANNELS];
+
+  // The channel data preceding the first entry is either that of the
+  // previous entry or, at the start of the file, empty
+  if(ScanBegin > 0)
+    ADAQWaveformTree->GetEntry(ScanBegin-1);
+
+  for(Int_t ch=0; ch<NumChannels; ch++){
+    PrevData[ch].assign(NumValues, 0.);
+    if(ScanBegin > 0){
+      PrevData[ch][0] = WaveformData[ch]->GetPulseHeight();
+      PrevData[ch][1] = WaveformData[ch]->GetPulseArea();
+      PrevData[ch][2] = WaveformData[ch]->GetPSDTotalIntegral();
+      PrevData[ch][3] = WaveformData[ch]->GetPSDTailIntegral();
+      PrevData[ch][4] = WaveformData[ch]->GetTimeStamp();
+      if(CompareWaveforms and Waveforms[ch])
+	PrevWaveform[ch] = *Waveforms[ch];
+    }
+  }
+  
+  for(Int_t entry=ScanBegin; entry<End; entry++){
+
+    if(SequentialArchitecture and entry % 1000 == 0)
+      gSystem->ProcessEvents();
+    
+    {
+      AAProfileTimer Timer(&Profiler, zProfileRead);
+      Profiler.Count(zCountBytesRead, ADAQWaveformTree->GetEntry(entry));
+    }
+
+    for(Int_t ch=0; ch<NumChannels; ch++){
+      Data[0] = WaveformData[ch]->GetPulseHeight();
+      Data[1] = WaveformData[ch]->GetPulseArea();
+      Data[2] = WaveformData[ch]->GetPSDTotalIntegral();
+      Data[3] = WaveformData[ch]->GetPSDTailIntegral();
+      Data[4] = WaveformData[ch]->GetTimeStamp();
+      
+      Bool_t Triggered = (Data != PrevData[ch]);
+      PrevData[ch].swap(Data);
+
+      if(CompareWaveforms and Waveforms[ch] and *Waveforms[ch] != PrevWaveform[ch]){
+	PrevWaveform[ch] = *Waveforms[ch];
+	Triggered = true;
+      }
+      
+      if(Triggered)
+	TriggerEntries[ch].push_back(entry);
+    }
+  }
+  
+  TriggerIndexEnd = End;
+
+  // Restore the branch selection used for processing
+  ConfigureTreeIO(true);
+}
+
+
+Int_t AAComputation::NextTriggeredEntry(Int_t Channel, Int_t Entry)
+{
+  // Without an index covering the entry all entries are processed
+  if(Entry < TriggerIndexBegin or Entry >= TriggerIndexEnd)
+    return Entry;
+
+  vector<Int_t>::const_iterator It = lower_bound(TriggerEntries[Channel].begin(),
+						 TriggerEntries[Channel].end(),
+						 Entry);
+
+  return (It == TriggerEntries[Channel].end()) ? TriggerIndexEnd : *It;
+}
+
 void AAComputation::LoadLegacyADAQFile()
 {
   /////////////////////////////////////
@@ -418,29 +701,33 @@ bool AAComputation::LoadASIMFile(string FileName)
   ASIMFile = new TFile(FileName.c_str(), "read");
 
   // Recreate the TList that contains TTrees with ADAQSimulationEvents
+  // and the catalog of TTree names
   if(ASIMEventTreeList) delete ASIMEventTreeList;
   ASIMEventTreeList = new TList;
+  ASIMEventTreeNames.clear();
   
   if(!ASIMFile->IsOpen()){
     ASIMFileLoaded = false;
   }
   else{
     // Iterate over the TFile using the TObject keys to search for
-    // TTrees to add to the EventTreeList. The EventTreeList will be
-    // access later for analysis. Note that the only TTrees that
-    // should be present in ASIM files are those that contain
-    // event-level information in branches with ADAQSimulationEvent
-    // objects.
+    // TTrees to add to the catalog of event trees. Note that the only
+    // TTrees that should be present in ASIM files are those that
+    // contain event-level information in branches with
+    // ADAQSimulationEvent objects. Only the class name stored in each
+    // key is inspected such that no TTree is read from the file until
+    // it is required for analysis (see GetASIMEventTree()); keys for
+    // older cycles of a TTree follow the newest and are skipped
 
     TIter It(ASIMFile->GetListOfKeys());
     TKey *Key;
     while((Key = (TKey *)It.Next())){
-      TString ClassType = ASIMFile->Get(Key->GetName())->ClassName();
+      TString ClassType = Key->GetClassName();
+      string TreeName = Key->GetName();
       
-      if(ClassType == "TTree"){
-	TTree *Tree = (TTree *)ASIMFile->Get(Key->GetName());
-	ASIMEventTreeList->Add(Tree);
-      }
+      if(ClassType == "TTree" and
+	 find(ASIMEventTreeNames.begin(), ASIMEventTreeNames.end(), TreeName) == ASIMEventTreeNames.end())
+	ASIMEventTreeNames.push_back(TreeName);
     }
     ASIMFileLoaded = true;
   }
@@ -448,12 +735,37 @@ bool AAComputation::LoadASIMFile(string FileName)
 }
 
 
-TH1F *AAComputation::CalculateRawWaveform(int Channel, int Waveform)
+// Method to get an ASIM event TTree by name from the catalog. The
+// TTree is read from the ASIM file when first requested and retained
+// for subsequent requests. NULL is returned for unknown names
+TTree *AAComputation::GetASIMEventTree(string TreeName)
 {
-  // Readout the desired waveform from the tree
-  ADAQWaveformTree->GetEntry(Waveform);
+  TTree *Tree = (TTree *)ASIMEventTreeList->FindObject(TreeName.c_str());
+  if(Tree)
+    return Tree;
+
+  if(!ASIMFileLoaded or
+     find(ASIMEventTreeNames.begin(), ASIMEventTreeNames.end(), TreeName) == ASIMEventTreeNames.end())
+    return NULL;
+
+  Tree = (TTree *)ASIMFile->Get(TreeName.c_str());
+  if(Tree)
+    ASIMEventTreeList->Add(Tree);
+  
+  return Tree;
+}
+
+
+Long64_t AAComputation::GetASIMEventTreeEntries(string TreeName)
+{
+  TTree *Tree = GetASIMEventTree(TreeName);
+  return (Tree) ? Tree->GetEntries() : -1;
+}
 
-  // Set individual channel waveform address
+
+TH1F *AAComputation::CalculateRawWaveform(int Channel, int Waveform)
+{
+  // The waveform entry has been read from the tree (or the cache)
   vector<int> RawVoltage = *Waveforms[Channel];
 
   // Get waveform size. This accounts for the possibility of waveforms
@@ -461,9 +773,8 @@ TH1F *AAComputation::CalculateRawWaveform(int Channel, int Waveform)
   int Size = RawVoltage.size();
   
   // Create a TH1F representing the waveform
-  if(Waveform_H[Channel])
-    delete Waveform_H[Channel];
-  Waveform_H[Channel] = new TH1F("Waveform_H", "Raw Waveform", Size-1, 0, Size);
+  Waveform_H[Channel] = PrepareHistogram(Waveform_H[Channel], "Waveform_H", "Raw Waveform",
+					 Size-1, 0, Size);
   
   if(!RawVoltage.empty()){
     Baseline = CalculateBaseline(&RawVoltage);
@@ -472,6 +783,8 @@ TH1F *AAComputation::CalculateRawWaveform(int Channel, int Waveform)
     for(iter=RawVoltage.begin(); iter!=RawVoltage.end(); iter++)
       Waveform_H[Channel]->SetBinContent((iter-RawVoltage.begin()), *iter);
   }
+  SetCachedWaveform(zRawWaveform, Channel, Waveform);
+  
   return Waveform_H[Channel];
 }
 
@@ -482,89 +795,172 @@ TH1F *AAComputation::CalculateRawWaveform(int Channel, int Waveform)
 // depracated code but left in place for potential future use
 TH1F* AAComputation::CalculateBSWaveform(int Channel, int Waveform, bool CurrentWaveform)
 {
-  ADAQWaveformTree->GetEntry(Waveform);
-
-  vector<Int_t> RawVoltage = *Waveforms[Channel];
+  const vector<Int_t> &RawVoltage = *Waveforms[Channel];
   
   Int_t Size = RawVoltage.size();
 
-  if(Waveform_H[Channel])
-    delete Waveform_H[Channel];
-  Waveform_H[Channel] = new TH1F("Waveform_H","Baseline-subtracted Waveform", Size-1, 0, Size);
+  Waveform_H[Channel] = PrepareHistogram(Waveform_H[Channel], "Waveform_H", "Baseline-subtracted Waveform",
+					 Size-1, 0, Size);
   
   Double_t Polarity = ADAQSettings->WaveformPolarity;
   
+  // The baseline is estimated in the same pass that subtracts it,
+  // which writes sample n directly into bin n of the waveform
   if(!RawVoltage.empty()){
-    Baseline = CalculateBaseline(&RawVoltage);
-    
-    vector<int>::iterator it;  
-    for(it=RawVoltage.begin(); it!=RawVoltage.end(); it++)
-      Waveform_H[Channel]->SetBinContent((it-RawVoltage.begin()),
-					 Polarity*(*it-Baseline));
+    ConfigureBaselineEstimator();
+    Baseline = BaselineEstimator.Subtract(&RawVoltage[0], Size, Polarity,
+					  Waveform_H[Channel]->GetArray());
+    Waveform_H[Channel]->SetEntries(Size);
   }
+  SetCachedWaveform(zBSWaveform, Channel, Waveform);
+  
   return Waveform_H[Channel];
 }
 
 
+namespace{
+
+  // Stream compaction of the N samples at or above the ceiling into
+  // the front of the output array, which may be the input array. The
+  // sample is always written and the output position only advanced
+  // if it is kept such that the loop contains no data-dependent
+  // branch to mispredict on noisy waveforms. Returns the number of
+  // samples kept
+  Int_t CompactAboveCeiling(const Float_t *Input, Int_t N, Float_t Ceiling, Float_t *Output)
+  {
+    Int_t Kept = 0;
+    for(Int_t n=0; n<N; n++){
+      const Float_t Sample = Input[n];
+      Output[Kept] = Sample;
+      Kept += (Sample >= Ceiling);
+    }
+    return Kept;
+  }
+}
+
+
 // Method to extract the digitized data on the specified data channel
 // and store it into a TH1F object after computing the zero-suppresion
 // (ZS) waveform. The baseline is calculated and stored into the class
-// member for later use. Note that the function argument bool is
+// member for later use. The baseline-subtracted samples are compacted
+// in place within a buffer that is reused between waveforms and then
+// copied into the waveform after the leading zero buffer; the zero
+// buffers themselves are never written since the waveform histogram
+// is reset (and only rebinned if its size changes) by
+// PrepareHistogram(). Note that the function argument bool is
 // depracated but left in place for potential future use.
 TH1F *AAComputation::CalculateZSWaveform(int Channel, int Waveform, bool CurrentWaveform)
 {
-  ADAQWaveformTree->GetEntry(Waveform);
-  
   Double_t Polarity = ADAQSettings->WaveformPolarity;
   
-  vector<Int_t> RawVoltage = *Waveforms[Channel];
-  
-  if(Waveform_H[Channel])
-    delete Waveform_H[Channel];
+  const vector<Int_t> &RawVoltage = *Waveforms[Channel];
   
   if(RawVoltage.empty()){
-    Waveform_H[Channel] = new TH1F("Waveform_H","Zero Suppression Waveform", RecordLength-1, 0, RecordLength);
+    Waveform_H[Channel] = PrepareHistogram(Waveform_H[Channel], "Waveform_H", "Zero Suppression Waveform",
+					   RecordLength-1, 0, RecordLength);
   }
   else{
-    Baseline = CalculateBaseline(&RawVoltage);
+    Int_t Size = RawVoltage.size();
+    if((Int_t)BSVoltage.size() < Size)
+      BSVoltage.resize(Size);
     
-    vector<Double_t> ZSVoltage(ADAQSettings->ZeroSuppressionBuffer,0);
+    ConfigureBaselineEstimator();
+    Baseline = BaselineEstimator.Subtract(&RawVoltage[0], Size, Polarity, &BSVoltage[0]);
     
-    vector<int>::iterator it;
-    for(it=RawVoltage.begin(); it!=RawVoltage.end(); it++){
-
-      Double_t VoltageMinusBaseline = Polarity*(*it-Baseline);
-      
-      if(VoltageMinusBaseline >= ADAQSettings->ZeroSuppressionCeiling)
-	ZSVoltage.push_back(VoltageMinusBaseline);
-    }
+    Int_t Kept = CompactAboveCeiling(&BSVoltage[0], Size,
+				     ADAQSettings->ZeroSuppressionCeiling, &BSVoltage[0]);
     
-    for(Int_t sample=0; sample<ADAQSettings->ZeroSuppressionBuffer; sample++)
-      ZSVoltage.push_back(0);
+    Int_t Buffer = ADAQSettings->ZeroSuppressionBuffer;
+    Int_t ZSWaveformSize = Kept + 2*Buffer;
+    Waveform_H[Channel] = PrepareHistogram(Waveform_H[Channel], "Waveform_H", "Zero Suppression Waveform",
+					   ZSWaveformSize-1, 0, ZSWaveformSize);
+    
+    if(Kept > 0){
+      copy(BSVoltage.begin(), BSVoltage.begin()+Kept, Waveform_H[Channel]->GetArray()+Buffer);
+      Waveform_H[Channel]->SetEntries(ZSWaveformSize);
+    }
+  }
+  SetCachedWaveform(zZSWaveform, Channel, Waveform);
   
-    Int_t ZSWaveformSize = ZSVoltage.size();
-    Waveform_H[Channel] = new TH1F("Waveform_H","Zero Suppression Waveform", ZSWaveformSize-1, 0, ZSWaveformSize);
+  return Waveform_H[Channel];
+}
+
+
+// Method to read a waveform entry that is browsed in the GUI. On a
+// miss the entry is read from the waveform TTree and the channel's
+// waveform is added to the decoded waveform cache. On a hit the
+// channel's waveform is restored from the cache and only the
+// channel's (small) waveform data branch is read; the waveform
+// branches of the other channels are not read and must not be used
+// after a hit. Waveform processing reads each entry itself and
+// bypasses the cache
+void AAComputation::ReadWaveformEntry(Int_t Channel, Int_t Waveform)
+{
+  if(!Waveforms[Channel] or !WaveformCache.Get(Channel, Waveform, CacheVoltage)){
+    ADAQWaveformTree->GetEntry(Waveform);
+    WaveformCache.Insert(Channel, Waveform, *Waveforms[Channel]);
+    return;
+  }
   
-    vector<double>::iterator iter;
-    for(iter=ZSVoltage.begin(); iter!=ZSVoltage.end(); iter++)
-      Waveform_H[Channel]->SetBinContent((iter-ZSVoltage.begin()), *iter);
+  // Legacy ADAQ files do not contain waveform data branches
+  if(!ADAQLegacyFileLoaded){
+    stringstream SS;
+    SS << "WaveformDataCh" << Channel;
+    TBranch *DataBranch = ADAQWaveformTree->GetBranch(SS.str().c_str());
+    if(DataBranch and ADAQWaveformTree->GetBranchStatus(SS.str().c_str()))
+      DataBranch->GetEntry(Waveform);
   }
-  return Waveform_H[Channel];
+  
+  Waveforms[Channel]->swap(CacheVoltage);
+}
+
+
+void AAComputation::SetCachedWaveform(Int_t Type, Int_t Channel, Int_t Waveform)
+{
+  CachedWaveformType = Type;
+  CachedWaveformChannel = Channel;
+  CachedWaveformNumber = Waveform;
+  CachedWaveformRevision = ADAQSettings->GetStageRevision(zStageWaveform);
+}
+
+
+TH1F *AAComputation::GetCachedWaveform(Int_t Type, Int_t Channel, Int_t Waveform)
+{
+  if(Type == CachedWaveformType and
+     Channel == CachedWaveformChannel and
+     Waveform == CachedWaveformNumber and
+     CachedWaveformRevision == ADAQSettings->GetStageRevision(zStageWaveform))
+    return Waveform_H[Channel];
+  else
+    return 0;
+}
+
+
+void AAComputation::ConfigureBaselineEstimator()
+{
+  BaselineEstimator.Configure(ADAQSettings->BaselineEstimator,
+			      ADAQSettings->BaselineRegionMin,
+			      ADAQSettings->BaselineRegionMax,
+			      ADAQSettings->BaselineTrimFraction,
+			      ADAQSettings->BaselineMedianWindow,
+			      ADAQSettings->BaselineTimeConstant,
+			      ADAQSettings->BaselineThreshold);
 }
 
 
 // The following methods compute the baseline of a waveform (as a
-// vector<int> or as a TH1F *). The baseline is the average of the
-// waveform voltage taken over the specified range in time. The units
-// of the baseline are in [samples]
+// vector<int> or as a TH1F *) over the specified range in time. The
+// baseline of a vector<int> is computed by the selected estimator
+// (the median of the range for the running median and the average
+// for the moving baseline); that of a TH1F * is the average. The
+// units of the baseline are in [ADC]
 double AAComputation::CalculateBaseline(vector<int> *Waveform)
 {
-  int BaselineRegionLength = ADAQSettings->BaselineRegionMax - ADAQSettings->BaselineRegionMin;
-  double Baseline = 0.;
-  for(int sample=ADAQSettings->BaselineRegionMin; sample<ADAQSettings->BaselineRegionMax; sample++)
-    Baseline += ((*Waveform)[sample]*1.0/BaselineRegionLength);
-
-  return Baseline;
+  if(Waveform->empty())
+    return 0.;
+  
+  ConfigureBaselineEstimator();
+  return BaselineEstimator.Calculate(&(*Waveform)[0], Waveform->size());
 }
 
 double AAComputation::CalculateBaseline(TH1F *Waveform)
@@ -596,6 +992,9 @@ bool AAComputation::FindPeaks(TH1F *Histogram_H, int PeakFindingAlgorithm)
   // find many peaks within a single record length
 
   if(PeakFindingAlgorithm == zPeakFinder){
+
+    // Time the search separately from the peak limit finding
+    AAProfileTimer SearchTimer(&Profiler, zProfilePeakFinding);
     
     // Use the PeakFinder to determine the number of potential peaks
     // in the waveform and return the total number of peaks that the
@@ -654,6 +1053,7 @@ bool AAComputation::FindPeaks(TH1F *Histogram_H, int PeakFindingAlgorithm)
     // Call the member functions that will find the lower (leftwards on
     // the time axis) and upper (rightwards on the time axis)
     // integration limits for each successful peak in the waveform
+    SearchTimer.Stop();
     FindPeakLimits(Histogram_H);
   }
   
@@ -667,6 +1067,8 @@ bool AAComputation::FindPeaks(TH1F *Histogram_H, int PeakFindingAlgorithm)
   // the peak position, the algorithm is extremely fast.
 
   else if(PeakFindingAlgorithm == zWholeWaveform){
+
+    AAProfileTimer Timer(&Profiler, zProfilePeakFinding);
     
     // Create a new peak info struct, fill it, and push it back into
     // the storage vector; note only one peak will be found
@@ -679,10 +1081,16 @@ bool AAComputation::FindPeaks(TH1F *Histogram_H, int PeakFindingAlgorithm)
     NumPeaks++;
   }
 
+  // Compute the time of each peak in the same pass such that timing
+  // is available to list-mode output without re-reading waveforms
+  if(ADAQSettings->UsePeakTiming and NumPeaks > 0)
+    FindPeakTimes(Histogram_H);
   
   // Function returns 'false' if zero peaks are found; algorithms can
   // use this flag to exit from analysis for this acquisition window
   // to save on CPU time
+  Profiler.Count(zCountPeaks, NumPeaks);
+
   if(NumPeaks == 0)
     return false;
   else
@@ -694,6 +1102,8 @@ bool AAComputation::FindPeaks(TH1F *Histogram_H, int PeakFindingAlgorithm)
 // Method to find the lower/upper peak limits in any histogram.
 void AAComputation::FindPeakLimits(TH1F *Histogram_H)
 {
+  AAProfileTimer Timer(&Profiler, zProfilePeakLimits);
+
   // Vector that will hold the sample number after which the floor was
   // crossed from the low (below the floor) to the high (above the
   // floor) side. The vector will eventually hold all the candidates for
@@ -845,19 +1255,234 @@ void AAComputation::FindPeakLimits(TH1F *Histogram_H)
 }
 
 
+// Method to compute the time of each peak in the PeakInfoVec. The
+// search for each peak's leading edge is bounded below by its lower
+// peak limit (or the waveform analysis region when peak limits are
+// unavailable, e.g. for the "whole waveform" algorithm)
+void AAComputation::FindPeakTimes(TH1F *Histogram_H)
+{
+  AAProfileTimer Timer(&Profiler, zProfilePeakTiming);
+  
+  vector<PeakInfoStruct>::iterator it;
+  for(it=PeakInfoVec.begin(); it!=PeakInfoVec.end(); it++){
+    Double_t Lower = (*it).PeakLimit_Lower;
+    if(Lower < 0)
+      Lower = ADAQSettings->AnalysisRegionMin;
+    
+    (*it).PeakTime = CalculatePeakTime(Histogram_H, (*it).PeakPosX, Lower);
+  }
+}
+
+
+// Method to calculate the time of a single pulse with its peak at
+// sample PeakPosX and whose leading edge begins no earlier than
+// sample Lower. The time is returned in units of samples with
+// sub-sample precision obtained by linear interpolation between the
+// two samples bracketing the crossing; -1 is returned if no crossing
+// is found. Both algorithms search backwards from the peak such that
+// the crossing belonging to the present peak is found even when an
+// earlier piled-up pulse shares the same rising floor crossing:
+//
+//  - Digital CFD: the bipolar signal y(n) = f*x(n) - x(n-D), with
+//    fraction f and delay D, is positive on the leading edge and
+//    negative after the peak. The time of its positive-to-negative
+//    zero crossing, less the delay D, is returned, which is
+//    independent of the pulse amplitude and (for a delay longer than
+//    the pulse rise time) lies on the leading edge where the pulse
+//    reaches the fraction f of its height
+//
+//  - Leading edge: the time at which the pulse first crosses the
+//    threshold on its rising edge before the peak
+Double_t AAComputation::CalculatePeakTime(TH1F *Histogram_H, Double_t PeakPosX, Double_t Lower)
+{
+  // Stream over the bin array, in which the index is the bin number
+  const Float_t *X = Histogram_H->GetArray();
+  const Int_t LastBin = Histogram_H->GetNbinsX();
+  
+  const Int_t Peak = (Int_t)PeakPosX;
+  const Int_t Start = (Lower < 1) ? 1 : (Int_t)Lower;
+  
+  if(Peak < Start or Peak > LastBin)
+    return -1.;
+  
+  if(ADAQSettings->TimingLeadingEdge){
+    const Double_t Threshold = ADAQSettings->LeadingEdgeThreshold;
+    
+    if(X[Peak] < Threshold)
+      return -1.;
+    
+    for(Int_t n=Peak; n>Start; n--){
+      if(X[n-1] < Threshold and X[n] >= Threshold)
+	return (n-1) + (Threshold - X[n-1])/(X[n] - X[n-1]);
+    }
+    return -1.;
+  }
+  
+  const Double_t Fraction = ADAQSettings->CFDFraction;
+  const Int_t Delay = (ADAQSettings->CFDDelay < 1) ? 1 : ADAQSettings->CFDDelay;
+  
+  // The bipolar signal is negative at the peak plus the delay since
+  // the delayed sample is then the pulse maximum
+  Int_t End = Peak + Delay;
+  if(End > LastBin)
+    End = LastBin;
+  
+  const Int_t First = (Start > Delay) ? Start : Delay;
+  
+  if(End <= First)
+    return -1.;
+  
+  Double_t Post = Fraction*X[End] - X[End-Delay];
+  for(Int_t n=End; n>First; n--){
+    Double_t Pre = Fraction*X[n-1] - X[n-1-Delay];
+    
+    if(Pre > 0. and Post <= 0.)
+      return (n-1) + Pre/(Pre - Post) - Delay;
+    
+    Post = Pre;
+  }
+  
+  return -1.;
+}
+
+
+//////////////////////////////////////////////
+// Histogram object reuse and clone pooling //
+//////////////////////////////////////////////
+
+// Histograms that are recomputed repeatedly during an analysis
+// session (spectra, PSD histograms, etc) are reset and rebinned in
+// place rather than deleted and reallocated each time. The TH2F PSD
+// histogram in particular can be hundreds of MB at fine binning, and
+// rapid recomputation driven by the GUI sliders would otherwise
+// produce large allocation spikes. Note that the underlying bin
+// arrays are only reallocated by ROOT if the number of bins changes
+
+TH1F *AAComputation::PrepareHistogram(TH1F *H, string Name, string Title,
+				      Int_t NumBins, Double_t MinBin, Double_t MaxBin)
+{
+  if(!H)
+    return new TH1F(Name.c_str(), Title.c_str(), NumBins, MinBin, MaxBin);
+
+  TAxis *XAxis = H->GetXaxis();
+  if(H->GetNbinsX() != NumBins or
+     XAxis->GetXmin() != MinBin or
+     XAxis->GetXmax() != MaxBin)
+    H->SetBins(NumBins, MinBin, MaxBin);
+
+  // Reset the contents, errors, statistics, fit functions and the
+  // min/max values but preserve the allocated bin arrays
+  H->Reset("M");
+  XAxis->SetRange(0, 0);
+  H->SetNameTitle(Name.c_str(), Title.c_str());
+  
+  return H;
+}
+
+
+TH2F *AAComputation::PrepareHistogram(TH2F *H, string Name, string Title,
+				      Int_t NumXBins, Double_t MinXBin, Double_t MaxXBin,
+				      Int_t NumYBins, Double_t MinYBin, Double_t MaxYBin)
+{
+  if(!H)
+    return new TH2F(Name.c_str(), Title.c_str(),
+		    NumXBins, MinXBin, MaxXBin,
+		    NumYBins, MinYBin, MaxYBin);
+  
+  TAxis *XAxis = H->GetXaxis();
+  TAxis *YAxis = H->GetYaxis();
+  if(H->GetNbinsX() != NumXBins or
+     XAxis->GetXmin() != MinXBin or
+     XAxis->GetXmax() != MaxXBin or
+     H->GetNbinsY() != NumYBins or
+     YAxis->GetXmin() != MinYBin or
+     YAxis->GetXmax() != MaxYBin)
+    H->SetBins(NumXBins, MinXBin, MaxXBin,
+	       NumYBins, MinYBin, MaxYBin);
+  
+  H->Reset("M");
+  XAxis->SetRange(0, 0);
+  YAxis->SetRange(0, 0);
+  H->SetNameTitle(Name.c_str(), Title.c_str());
+  
+  return H;
+}
+
+
+// Method to copy a source histogram into an existing target
+// histogram, which is equivalent to TH1::Clone() except that the
+// target's bin arrays are reused when the binning is unchanged. If
+// the target does not exist then a clone is created
+TH1F *AAComputation::CopyHistogram(TH1F *Source, TH1F *Target, string Name)
+{
+  if(!Target)
+    Target = (TH1F *)Source->Clone(Name.c_str());
+  else{
+    Source->Copy(*Target);
+    Target->SetName(Name.c_str());
+  }
+  
+  // Pooled and copied histograms are owned by AAComputation rather
+  // than by the current ROOT directory
+  Target->SetDirectory(0);
+  
+  return Target;
+}
+
+
+// Method to obtain a transient clone of the source histogram from
+// the histogram pool. The clone with the specified name is created
+// once and subsequently reused such that transient clones (used only
+// within a single calculation) are neither leaked nor reallocated
+TH1F *AAComputation::GetPooledClone(TH1F *Source, string Name)
+{
+  TH1F *Clone = 0;
+
+  map<string, TH1F *>::iterator It = HistogramPool.find(Name);
+  if(It != HistogramPool.end())
+    Clone = It->second;
+
+  Clone = CopyHistogram(Source, Clone, Name);
+  HistogramPool[Name] = Clone;
+  
+  return Clone;
+}
+
+
+void AAComputation::ClearHistogramPool()
+{
+  map<string, TH1F *>::iterator It;
+  for(It=HistogramPool.begin(); It!=HistogramPool.end(); It++)
+    delete It->second;
+  HistogramPool.clear();
+}
+
+
 void AAComputation::ProcessSpectrumWaveforms()
 {
   // Get the current digitizer channel to analyze
   Int_t Channel = ADAQSettings->WaveformChannel;
-  
-  // Delete the previous Spectrum_H TH1F object if it exists to
-  // prevent memory leaks
-  
-  if(Spectrum_H){
-    delete Spectrum_H;
-    SpectrumExists = false;
+
+  // If the pulse height/area vectors for this channel were filled by
+  // a previous processing run and no setting that the stored values
+  // depend on has changed since, then the spectrum is recreated from
+  // the stored values rather than by rereading and reprocessing the
+  // waveforms. Note that runs with list-mode output or a PSD filter
+  // are always fully processed since they act on each waveform
+  if(SequentialArchitecture and
+     !ADAQSettings->ListModeOutput and
+     !ADAQSettings->UsePSDRegions[Channel] and
+     ProcessedSpectrumChannel == Channel and
+     ProcessedSpectrumRevision == ADAQSettings->GetRevision(zPulseValuesMask)){
+    CreateSpectrum();
+    return;
   }
   
+  SpectrumExists = false;
+  ProcessedSpectrumChannel = -1;
+
+  BeginProfile("Spectrum");
+  
   // Clear the spectrum pulse value vectors to zero elements. I have
   // chosen *not* to preallocate memory intentionally since (a)
   // vector::push_back() is easily sufficiently fast compared to
@@ -869,23 +1494,22 @@ void AAComputation::ProcessSpectrumWaveforms()
   SpectrumPAVec[Channel].clear();
   
   // Reset the waveform progress bar
-  if(SequentialArchitecture){
+  if(SequentialArchitecture and ProcessingProgressBar){
     ProcessingProgressBar->Reset();
     ProcessingProgressBar->SetBarColor(ColorManager->Number2Pixel(33));
     ProcessingProgressBar->SetForegroundColor(ColorManager->Number2Pixel(1));
   }
   
-  // Create a new TH1F histogram object for spectra creation
-  Spectrum_H = new TH1F("Spectrum_H", "ADAQ spectrum", 
-			ADAQSettings->SpectrumNumBins, 
-			ADAQSettings->SpectrumMinBin,
-			ADAQSettings->SpectrumMaxBin);
+  // Reset (or create) the TH1F histogram object for spectra creation
+  Spectrum_H = PrepareHistogram(Spectrum_H, "Spectrum_H", "ADAQ spectrum", 
+				ADAQSettings->SpectrumNumBins, 
+				ADAQSettings->SpectrumMinBin,
+				ADAQSettings->SpectrumMaxBin);
   
   // Variables for calculating pulse height and area
 
-  Double_t SampleHeight = 0.;
-  Double_t PulseHeight = 0., PrevPulseHeight = 0.;
-  Double_t PulseArea = 0., PrevPulseArea = 0.;
+  Double_t PulseHeight = 0.;
+  Double_t PulseArea = 0.;
   
   
   ///////////////////////////////////////////////////
@@ -916,42 +1540,27 @@ void AAComputation::ProcessSpectrumWaveforms()
     SS << "WaveformDataCh" << Channel;
     string WDName = SS.str();
 
-    // Readout appropriate waveform data into the spectrum
-    for(Int_t entry=0; entry<ADAQSettings->WaveformsToHistogram; entry++){
-      
-      // Ensure only the specified number of events are processed
-      if(entry == ADAQSettings->WaveformsToHistogram)
-	break;
+    // Create the list-mode file if the user has enabled it
+    OpenListModeFile();
+
+    // Readout appropriate waveform data into the spectrum from only
+    // the entries in which the channel triggered
+    Int_t EntryEnd = ADAQSettings->WaveformsToHistogram;
+    BuildTriggerIndex(0, EntryEnd);
+
+    for(Int_t entry=NextTriggeredEntry(Channel, 0); entry<EntryEnd;
+	entry=NextTriggeredEntry(Channel, entry+1)){
       
-      ADAQWaveformTree->GetEntry(entry);
+      {
+	AAProfileTimer Timer(&Profiler, zProfileRead);
+	Profiler.Count(zCountBytesRead, ADAQWaveformTree->GetEntry(entry));
+      }
+      Profiler.Count(zCountWaveforms);
       
       // Get the pulse height and area...
       
       PulseHeight = WaveformData[Channel]->GetPulseHeight();
       PulseArea = WaveformData[Channel]->GetPulseArea();
-
-      // The following is a temporary hack. As of ADAQ libraries
-      // version 1.6.0, all digitizer channel data is stored in a
-      // single tree with channel-specific branches. When a
-      // TTree::Fill() is called, all branches are saved. When
-      // operating with multiple detectors, this causes non-triggered
-      // branched to write whatever data is present from previously
-      // triggered events. The fix below prevents adding this
-      // redundant data to the spectra. In the future, each channel is
-      // likely to get its own TTree, resolving this issue
-
-      if(ADAQSettings->ADAQSpectrumTypePHS){
-	if(PulseHeight == PrevPulseHeight)
-	  continue;
-	else
-	  PrevPulseHeight = PulseHeight;
-      }
-      else if(ADAQSettings->ADAQSpectrumTypePAS){
-	if(PulseArea == PrevPulseArea)
-	  continue;
-	else
-	  PrevPulseArea = PulseArea;
-      }
       
       // If specified, assess the waveform's pulse shape and exclude
       // it from the pulse spectra if it fails the test
@@ -968,9 +1577,14 @@ void AAComputation::ProcessSpectrumWaveforms()
 	if(ApplyPSDRegion(Total, Tail))
 	  PSDReject = true;
       }
+
+      // Stream the waveform data to the list-mode file (if enabled)
+      FillListModeRecord(entry, Channel, WaveformData[Channel], PSDReject);
       
-      if(PSDReject)
+      if(PSDReject){
+	Profiler.Count(zCountPSDRejected);
 	continue;
+      }
 
       // Add uncalibrated waveform data to the storage vectors for
       // potential later use
@@ -988,6 +1602,7 @@ void AAComputation::ProcessSpectrumWaveforms()
       // Convert the quantity if calibration has been activated
 
       if(ADAQSettings->UseSpectraCalibrations[Channel]){
+	AAProfileTimer Timer(&Profiler, zProfileCalibration);
 	if(SpectraCalibrationType[Channel] == zCalibrationFit)      	  
 	  Quantity = ADAQSettings->SpectraCalibrations[Channel]->Eval(Quantity);
 	else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
@@ -997,10 +1612,21 @@ void AAComputation::ProcessSpectrumWaveforms()
       // Fill the spectrum is quantity is within thresholds
       
       if(Quantity > ADAQSettings->SpectrumMinThresh and
-	 Quantity < ADAQSettings->SpectrumMaxThresh)
+	 Quantity < ADAQSettings->SpectrumMaxThresh){
+	AAProfileTimer Timer(&Profiler, zProfileHistogramFill);
 	Spectrum_H->Fill(Quantity);
+	Profiler.Count(zCountHistogramEntries);
+      }
     }
+    CloseListModeFile();
+
+    EndProfile();
+    
     SpectrumExists = true;
+    SpectrumRevision++;
+    
+    ProcessedSpectrumChannel = Channel;
+    ProcessedSpectrumRevision = ADAQSettings->GetRevision(zPulseValuesMask);
   }
   
   
@@ -1019,6 +1645,12 @@ void AAComputation::ProcessSpectrumWaveforms()
     if(PeakFinder) delete PeakFinder;
     PeakFinder = new TSpectrum(ADAQSettings->MaxPeaks);
 
+    // Create the list-mode file if the user has enabled it
+    OpenListModeFile();
+
+    // Prepare the average pulse template accumulators (if enabled)
+    BeginPulseTemplates();
+
     // Assign the range of waveforms that will be analyzed to create a
     // histogram. Note that in sequential architecture if N waveforms
     // are to be histogrammed, waveforms from waveform_ID == 0 to
@@ -1064,188 +1696,28 @@ void AAComputation::ProcessSpectrumWaveforms()
 
 #endif
 
-    bool PeaksFound = false;
+    // Index the entries in which the channel triggered such that the
+    // processing kernel reads only those entries
+    BuildTriggerIndex(WaveformStart, WaveformEnd);
 
-    // Process the waveforms. 
-    for(int waveform=WaveformStart; waveform<WaveformEnd; waveform++){
-      // Run processing in a separate thread to enable use of the GUI by
-      // the user while the spectrum is being created
-      if(SequentialArchitecture)
-	gSystem->ProcessEvents();
-
-      // Get the data from the ADAQ TTree for the current waveform
-      ADAQWaveformTree->GetEntry(waveform);
-      
-      // Assign the raw waveform voltage to a class member vector<int>
-      RawVoltage = *Waveforms[Channel];
-    
-      // Calculate the selected waveform that will be analyzed into the
-      // spectrum histogram. Note that "raw" waveforms may not be
-      // analyzed (simply due to how the code is presently setup) and
-      // will default to analyzing the baseline subtracted waveform
-      if(ADAQSettings->RawWaveform or ADAQSettings->BSWaveform)
-	CalculateBSWaveform(Channel, waveform);
-      else if(ADAQSettings->ZSWaveform)
-	CalculateZSWaveform(Channel, waveform);
-    
-      ///////////////////////////////////////////
-      // Simple max/sum (SMS) waveform processing
+    // Process the waveforms with the processing kernel that matches
+    // the present settings (see AAComputation::DispatchSpectrumKernel)
+    DispatchSpectrumKernel(Channel);
+  
+    // Make final updates to the progress bar, ensuring that it reaches
+    // 100% and changes color to acknoqledge that processing is complete
 
-      if(ADAQSettings->ADAQSpectrumAlgorithmSMS){
-	
-	// If specified, calculate the PSD integrals for the waveform
-	// and determine if they meet the acceptance criterion defined
-	// by the current channel's PSD region. If not, continue the
-	// processing loop to prevent adding the waveform height/area to
-	// the pulse spectrum
-
-	if(ADAQSettings->UsePSDRegions[Channel]){
-	
-	  FindPeaks(Waveform_H[Channel], zWholeWaveform);
-	  CalculatePSDIntegrals(false);
-	
-	  if(PeakInfoVec[0].PSDFilterFlag == true)
-	    continue;
-	}
-
-	////////////////////////////////////////////////
-	// Calculation of waveform pulse height and area
-	
-	Int_t AnalysisMin = ADAQSettings->AnalysisRegionMin;
-	Int_t AnalysisMax = ADAQSettings->AnalysisRegionMax;
-
-	// Pulse height
-
-	// Get the pulse height by finding the maximum bin value
-	// within the waveform analysis region from the Waveform_H
-	// TH1F via class methods. Note that spectra are always
-	// created with positive polarity waveforms
-	Waveform_H[Channel]->GetXaxis()->SetRange(AnalysisMin, AnalysisMax);
-	PulseHeight = Waveform_H[Channel]->
-	  GetBinContent(Waveform_H[Channel]->GetMaximumBin());
-	
-	
-	// Store the uncalibrated pulse height in the designated vector
-	SpectrumPHVec[Channel].push_back(PulseHeight);
-	
-	// If the calibration manager is to be used to convert the
-	// value from pulse units [ADC] to energy units [keV, MeV,
-	// ...] then do so
-	if(ADAQSettings->UseSpectraCalibrations[Channel]){
-	  if(SpectraCalibrationType[Channel] == zCalibrationFit)
-	    PulseHeight = ADAQSettings->SpectraCalibrations[Channel]->Eval(PulseHeight);
-	  else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
-	    PulseHeight = ADAQSettings->SpectraCalibrationData[Channel]->Eval(PulseHeight);
-	}
-	// Pulse area
-	
-	// Reset the pulse area "integral" to zero
-	PulseArea = 0.;
-	
-	// ...iterate through the bins in the Waveform_H histogram
-	// and add each bin value to the pulse area integral. Note
-	// the integral is over the entire waveform.
-	for(Int_t sample=AnalysisMin; sample<=AnalysisMax; sample++){
-	  SampleHeight = Waveform_H[Channel]->GetBinContent(sample);
-	  PulseArea += SampleHeight;
-	}
-	
-	// Store the uncalibrated pulse height in the designated vector
-	SpectrumPAVec[Channel].push_back(PulseArea);
-
-	// If the calibration manager is to be used to convert the
-	// value from pulse units [ADC] to energy units [keV, MeV,
-	// ...] then do so
-	if(ADAQSettings->UseSpectraCalibrations[Channel]){
-	  if(SpectraCalibrationType[Channel] == zCalibrationFit)
-	    PulseArea = ADAQSettings->SpectraCalibrations[Channel]->Eval(PulseArea);
-	  else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
-	    PulseArea = ADAQSettings->SpectraCalibrationData[Channel]->Eval(PulseArea);
-	}
-
-	// Initial spectra creation
-	
-	// Add the pulse value to the spectrum object depending on
-	// type of spectrum that is to be created initially
-
-	if(ADAQSettings->ADAQSpectrumTypePHS){
-	  if(PulseHeight > ADAQSettings->SpectrumMinThresh and
-	     PulseHeight < ADAQSettings->SpectrumMaxThresh){
-	    Spectrum_H->Fill(PulseHeight);
-	  }
-	}
-	
-	else if(ADAQSettings->ADAQSpectrumTypePAS){
-	  if(PulseArea > ADAQSettings->SpectrumMinThresh and
-	     PulseArea < ADAQSettings->SpectrumMaxThresh){
-	    Spectrum_H->Fill(PulseArea);
-	  }
-	}
-	
-	// Note that we must add a +1 to the waveform number in order to
-	// get the modulo to land on the correct intervals
-	if(IsMaster)
-	  // Check to ensure no floating point exception for low number
-	  if(WaveformEnd >= 50)
-	    if((waveform+1) % int(WaveformEnd*ADAQSettings->UpdateFreq*1.0/100) == 0)
-	      UpdateProcessingProgress(waveform);
-      }
-      
-      
-      //////////////////////////////////
-      // Peak-finder waveform processing
-    
-      // If the peak-finding/limit-finding algorithm is to be used to
-      // create the pulse spectrum ...
-      else if(ADAQSettings->ADAQSpectrumAlgorithmPF){
-	
-	// ...pass the Waveform_H[Channel] TH1F object to the peak-finding
-	// algorithm, passing 'false' as the second argument to turn off
-	// plotting of the waveforms. ADAQAnalysisInterface::FindPeaks() will
-	// fill up a vector<PeakInfoStruct> that will be used to either
-	// integrate the valid peaks to create a PAS or find the peak
-	// heights to create a PHS, returning true. If zero peaks are
-	// found in the waveform then FindPeaks() returns false
-	PeaksFound = FindPeaks(Waveform_H[Channel], zPeakFinder);
-
-	// Because the peak finding algorithm skips analysis of
-	// waveforms for which it cannot find peaks, we need to update
-	// the progress bar here to ensure that bar ends at 100% when
-	// actual processing ends. It would be nice to do this more
-	// accurately in the future (i.e. update the bar when processing
-	// actually finished!). Note that we must add a +1 to the
-	// waveform number in order to get the modulo to land on the
-	// correct intervals
-	if(IsMaster)
-	  if(WaveformEnd >= 50)
-	    if((waveform+1) % int(WaveformEnd*ADAQSettings->UpdateFreq*1.0/100) == 0)
-	      UpdateProcessingProgress(waveform);
-
-	// If no peaks are present in the current waveform then continue
-	// on to the next waveform for analysis
-	if(!PeaksFound)
-	  continue;
-
-	// Calculate the PSD integrals and determine if they pass
-	// the pulse-shape filterthrough the pulse-shape filter
-	if(UsePSDRegions[ADAQSettings->WaveformChannel])
-	  CalculatePSDIntegrals(false);
-	
-	// Find both pulse area and peak heights during processing so
-	// that the values can be added to the spectrum vectors
-	IntegratePeaks();
-	FindPeakHeights();
-      }
-    }
-  
-    // Make final updates to the progress bar, ensuring that it reaches
-    // 100% and changes color to acknoqledge that processing is complete
-
-    if(SequentialArchitecture){
+    if(SequentialArchitecture and ProcessingProgressBar){
       ProcessingProgressBar->Increment(100);
       ProcessingProgressBar->SetBarColor(ColorManager->Number2Pixel(32));
       ProcessingProgressBar->SetForegroundColor(ColorManager->Number2Pixel(0));
     }
+
+    // Write and close the list-mode file (if enabled)
+    CloseListModeFile();
+
+    // Write the average pulse templates (if enabled)
+    WritePulseTemplates(Channel);
   
 #ifdef MPI_ENABLED
 
@@ -1421,25 +1893,710 @@ void AAComputation::ProcessSpectrumWaveforms()
       system(RemoveFilesCommand.c_str()); 
     }
 #endif
+    EndProfile();
+    
     SpectrumExists = true;
+    SpectrumRevision++;
+    
+    ProcessedSpectrumChannel = Channel;
+    ProcessedSpectrumRevision = ADAQSettings->GetRevision(zPulseValuesMask);
   }
 }
 
 
-void AAComputation::CreateSpectrum()
+///////////////////////////////////////////////////////
+// Policy-based spectrum waveform processing kernels //
+///////////////////////////////////////////////////////
+
+// The spectrum waveform processing loop is expressed as a kernel
+// template that is parametrized by a set of compile-time "policies":
+// the waveform transform (baseline-subtracted or zero-suppressed),
+// the processing algorithm (simple max/sum or peak finder), the
+// spectrum type (pulse height or area), the calibration type (none,
+// fit, or interpolation) and whether the PSD filter is applied. All
+// combinations are instantiated by the compiler and the appropriate
+// kernel is selected once at the start of processing via the
+// AAComputation::DispatchSpectrumKernel() chain of methods. Each
+// kernel therefore contains no per-waveform or per-peak tests of the
+// settings, allowing the compiler to fully inline the processing.
+
+namespace{
+
+  // Waveform transform policies
+  
+  struct BSTransform{
+    static TH1F *Calculate(AAComputation *C, Int_t Channel, Int_t Waveform)
+    { return C->CalculateBSWaveform(Channel, Waveform); }
+  };
+
+  struct ZSTransform{
+    static TH1F *Calculate(AAComputation *C, Int_t Channel, Int_t Waveform)
+    { return C->CalculateZSWaveform(Channel, Waveform); }
+  };
+
+
+  // Processing algorithm policies
+  
+  struct SMSAlgorithm{ static const Bool_t PeakFinding = false, Shaping = false; };
+  struct PFAlgorithm{ static const Bool_t PeakFinding = true, Shaping = false; };
+  struct DSAlgorithm{ static const Bool_t PeakFinding = false, Shaping = true; };
+
+
+  // Spectrum type policies
+  
+  struct PHSpectrum{
+    static Double_t Select(Double_t Height, Double_t) { return Height; }
+  };
+  
+  struct PASpectrum{
+    static Double_t Select(Double_t, Double_t Area) { return Area; }
+  };
+
+  
+  // Spectrum calibration policies
+  
+  struct NoCalibration{
+    static Double_t Apply(Double_t Quantity, TF1 *, TGraph *) { return Quantity; }
+  };
+
+  struct FitCalibration{
+    static Double_t Apply(Double_t Quantity, TF1 *Fit, TGraph *)
+    { return Fit->Eval(Quantity); }
+  };
+
+  struct InterpCalibration{
+    static Double_t Apply(Double_t Quantity, TF1 *, TGraph *Data)
+    { return Data->Eval(Quantity); }
+  };
+
+
+  // Find the maximum (first maximum bin) and the sum of the waveform
+  // bin values within [Min, Max] by reading the bin array directly,
+  // in which the array index is the bin number. As with the axis
+  // range used by TH1::GetMaximumBin() the maximum is restricted to
+  // the histogram bins, while the sum clips its samples to the
+  // overflow bin as TH1::GetBinContent() does
+  void MaxSumBins(TH1F *Waveform, Int_t Min, Int_t Max,
+		  Int_t &MaxBin, Double_t &MaxValue, Double_t &Sum)
+  {
+    const Float_t *Samples = Waveform->GetArray();
+    const Int_t NumBins = Waveform->GetNbinsX();
+    
+    Int_t First = max(Min, 1), Last = min(Max, NumBins);
+    if(Last < First){
+      First = 1;
+      Last = NumBins;
+    }
+    
+    Float_t Maximum = -FLT_MAX;
+    MaxBin = First;
+    for(Int_t bin=First; bin<=Last; bin++)
+      if(Samples[bin] > Maximum){
+	Maximum = Samples[bin];
+	MaxBin = bin;
+      }
+    MaxValue = Maximum;
+    
+    Sum = 0.;
+    for(Int_t sample=max(Min, 0); sample<=Max; sample++)
+      Sum += Samples[min(sample, NumBins+1)];
+  }
+}
+
+
+void AAComputation::DispatchSpectrumKernel(Int_t Channel)
 {
-  // Delete the previous Spectrum_H TH1F object if it exists to
-  // prevent memory leaks
-  if(Spectrum_H){
-    delete Spectrum_H;
-    SpectrumExists = false;
+  if(UseFixedPointProcessing(false)){
+    DispatchFixedPointKernel(Channel);
+    return;
   }
+  
+  // Note that "raw" waveforms may not be analyzed (simply due to how
+  // the code is presently setup) and will default to analyzing the
+  // baseline subtracted waveform
+  if(ADAQSettings->ZSWaveform)
+    DispatchSpectrumKernel<ZSTransform>(Channel);
+  else
+    DispatchSpectrumKernel<BSTransform>(Channel);
+}
+
+
+template<class Transform>
+void AAComputation::DispatchSpectrumKernel(Int_t Channel)
+{
+  if(ADAQSettings->ADAQSpectrumAlgorithmPF)
+    DispatchSpectrumKernel<Transform, PFAlgorithm>(Channel);
+  else if(ADAQSettings->ADAQSpectrumAlgorithmDS)
+    DispatchSpectrumKernel<Transform, DSAlgorithm>(Channel);
+  else
+    DispatchSpectrumKernel<Transform, SMSAlgorithm>(Channel);
+}
+
+
+template<class Transform, class Algorithm>
+void AAComputation::DispatchSpectrumKernel(Int_t Channel)
+{
+  if(ADAQSettings->ADAQSpectrumTypePAS)
+    DispatchSpectrumKernel<Transform, Algorithm, PASpectrum>(Channel);
+  else
+    DispatchSpectrumKernel<Transform, Algorithm, PHSpectrum>(Channel);
+}
+
+
+template<class Transform, class Algorithm, class Spectrum>
+void AAComputation::DispatchSpectrumKernel(Int_t Channel)
+{
+  if(!ADAQSettings->UseSpectraCalibrations[Channel])
+    DispatchSpectrumKernel<Transform, Algorithm, Spectrum, NoCalibration>(Channel);
+  else if(SpectraCalibrationType[Channel] == zCalibrationFit)
+    DispatchSpectrumKernel<Transform, Algorithm, Spectrum, FitCalibration>(Channel);
+  else
+    DispatchSpectrumKernel<Transform, Algorithm, Spectrum, InterpCalibration>(Channel);
+}
+
+
+template<class Transform, class Algorithm, class Spectrum, class Calibration>
+void AAComputation::DispatchSpectrumKernel(Int_t Channel)
+{
+  // Note that the peak finder has always applied the PSD filter of
+  // the waveform channel set via the computation manager rather than
+  // the processed channel's setting used by the other algorithms
+  const Bool_t PSDFilter = (Algorithm::PeakFinding ?
+			    UsePSDRegions[ADAQSettings->WaveformChannel] :
+			    ADAQSettings->UsePSDRegions[Channel]);
+  
+  if(PSDFilter)
+    ProcessSpectrumWaveformsKernel<Transform, Algorithm, Spectrum, Calibration, true>(Channel);
+  else
+    ProcessSpectrumWaveformsKernel<Transform, Algorithm, Spectrum, Calibration, false>(Channel);
+}
+
+
+template<class Transform, class Algorithm, class Spectrum, class Calibration, Bool_t PSDFilter>
+void AAComputation::ProcessSpectrumWaveformsKernel(Int_t Channel)
+{
+  // Hoist all remaining run-constant settings out of the loop
+
+  const Int_t AnalysisMin = ADAQSettings->AnalysisRegionMin;
+  const Int_t AnalysisMax = ADAQSettings->AnalysisRegionMax;
+  
+  const Double_t MinThresh = ADAQSettings->SpectrumMinThresh;
+  const Double_t MaxThresh = ADAQSettings->SpectrumMaxThresh;
+
+  const Bool_t UsePileupRejection = ADAQSettings->UsePileupRejection;
+
+  // Pileup peaks are fit with the channel's pulse template only when
+  // the peak finder is used and pileup is being flagged
+  const Bool_t UsePileupRecovery = (Algorithm::PeakFinding and UsePileupRejection and
+				    ADAQSettings->UsePileupRecovery and
+				    LoadPulseTemplates(ADAQSettings->PulseTemplateFileName) and
+				    PileupFitters[Channel].HasTemplate());
+
+  const Bool_t BuildTemplates = ADAQSettings->BuildPulseTemplates;
 
-  // Create the TH1F histogram object for spectra creation
-  Spectrum_H = new TH1F("Spectrum_H", "ADAQ spectrum", 
-			ADAQSettings->SpectrumNumBins, 
-			ADAQSettings->SpectrumMinBin,
-			ADAQSettings->SpectrumMaxBin);
+  // Peak times are only required by the list-mode output and for the
+  // alignment of pulses in the average pulse templates
+  const Bool_t UsePeakTiming = (ADAQSettings->UsePeakTiming and
+				(ListModeActive or BuildTemplates));
+
+  TF1 *CalibrationFit = ADAQSettings->SpectraCalibrations[Channel];
+  TGraph *CalibrationInterp = ADAQSettings->SpectraCalibrationData[Channel];
+
+  if(Algorithm::Shaping)
+    Shaper.Configure((ADAQSettings->ShaperCRRC ?
+		      AADigitalShaper::zCRRCShaper : AADigitalShaper::zTrapezoidShaper),
+		     ADAQSettings->ShaperRiseTime,
+		     ADAQSettings->ShaperFlatTop,
+		     ADAQSettings->ShaperShapingTime,
+		     ADAQSettings->ShaperOrder,
+		     ADAQSettings->ShaperDecayTime);
+
+  // Note that WaveformEnd must be >= 50 to prevent a floating point
+  // exception from the modulo of the update interval
+  const Bool_t UpdateProgress = (IsMaster and WaveformEnd >= 50);
+  const Int_t UpdateInterval = Int_t(WaveformEnd*ADAQSettings->UpdateFreq*1.0/100);
+  
+  vector<Double_t> &PHVec = SpectrumPHVec[Channel];
+  vector<Double_t> &PAVec = SpectrumPAVec[Channel];
+  
+  for(Int_t waveform=NextTriggeredEntry(Channel, WaveformStart); waveform<WaveformEnd;
+      waveform=NextTriggeredEntry(Channel, waveform+1)){
+    
+    // Run processing in a separate thread to enable use of the GUI by
+    // the user while the spectrum is being created
+    if(SequentialArchitecture)
+      gSystem->ProcessEvents();
+    
+    // Get the data from the ADAQ TTree for the current waveform
+    {
+      AAProfileTimer Timer(&Profiler, zProfileRead);
+      Profiler.Count(zCountBytesRead, ADAQWaveformTree->GetEntry(waveform));
+    }
+    Profiler.Count(zCountWaveforms);
+    
+    // Assign the raw waveform voltage to a class member vector<int>
+    RawVoltage = *Waveforms[Channel];
+    
+    // Calculate the selected waveform that will be analyzed into the
+    // spectrum histogram
+    AAProfileTimer TransformTimer(&Profiler, zProfileTransform);
+    TH1F *Waveform = Transform::Calculate(this, Channel, waveform);
+    TransformTimer.Stop();
+    
+    /////////////////////////////////////////////////////////////
+    // Simple max/sum (SMS) or digital shaping (DS) waveform processing
+    
+    if(!Algorithm::PeakFinding){
+      
+      // If specified, calculate the PSD integrals for the waveform
+      // and determine if they meet the acceptance criterion defined
+      // by the current channel's PSD region. If not, continue the
+      // processing loop to prevent adding the waveform height/area to
+      // the pulse spectrum. Note that when list-mode output or pulse
+      // templates are enabled the rejected waveform's height/area must
+      // still be calculated such that it can be written with its PSD
+      // flag or added to the rejected pulse template
+      
+      Bool_t PSDReject = false;
+      
+      if(PSDFilter){
+	FindPeaks(Waveform, zWholeWaveform);
+	CalculatePSDIntegrals(false);
+	
+	PSDReject = PeakInfoVec[0].PSDFilterFlag;
+
+	if(PSDReject)
+	  Profiler.Count(zCountPSDRejected);
+	
+	if(PSDReject and !ListModeActive and !BuildTemplates)
+	  continue;
+      }
+      
+      Int_t PeakPosX = 0;
+      Double_t PulseHeight = 0., PulseArea = 0.;
+      
+      // Get the pulse height and area as the maximum and sum of the
+      // shaped waveform within the waveform analysis region. The
+      // shaper streams directly over the waveform's bin array, in
+      // which the array index is the bin number
+      if(Algorithm::Shaping){
+	AAProfileTimer Timer(&Profiler, zProfileTransform);
+	Shaper.Shape(Waveform->GetArray(), Waveform->GetNbinsX()+1, AnalysisMin, AnalysisMax,
+		     PulseHeight, PeakPosX, PulseArea);
+      }
+      else{
+	// Get the pulse height and area as the maximum and sum of the
+	// bin values within the waveform analysis region. Note that
+	// spectra are always created with positive polarity waveforms
+	MaxSumBins(Waveform, AnalysisMin, AnalysisMax, PeakPosX, PulseHeight, PulseArea);
+      }
+      
+      // Time the pulse on the waveform (the "whole waveform" PSD
+      // peak finding above has already done so if enabled)
+      Double_t PeakTime = -1.;
+      if(UsePeakTiming){
+	if(PSDFilter)
+	  PeakTime = PeakInfoVec[0].PeakTime;
+	else{
+	  AAProfileTimer Timer(&Profiler, zProfilePeakTiming);
+	  
+	  // The shaped maximum lags the pulse so the unshaped maximum
+	  // is used to locate the leading edge
+	  Int_t TimingPosX = PeakPosX;
+	  if(Algorithm::Shaping){
+	    Waveform->GetXaxis()->SetRange(AnalysisMin, AnalysisMax);
+	    TimingPosX = Waveform->GetMaximumBin();
+	  }
+	  PeakTime = CalculatePeakTime(Waveform, TimingPosX, AnalysisMin);
+	}
+      }
+      
+      // Stream the uncalibrated pulse values to the list-mode file
+      // (if enabled) before any PSD rejection is applied
+      FillListModeRecord(waveform, Channel, PeakPosX, PulseHeight, PulseArea,
+			 false, PSDReject, PeakTime);
+      
+      // Add the pulse, aligned on its time if available, to the
+      // average pulse templates (if enabled)
+      if(BuildTemplates)
+	AccumulatePulseTemplate(Waveform, (PeakTime >= 0.) ? PeakTime : PeakPosX, PulseHeight,
+				Calibration::Apply(Spectrum::Select(PulseHeight, PulseArea),
+						   CalibrationFit, CalibrationInterp),
+				PSDReject);
+      
+      if(PSDReject)
+	continue;
+      
+      // Store the uncalibrated pulse height and area in the
+      // designated vectors
+      PHVec.push_back(PulseHeight);
+      PAVec.push_back(PulseArea);
+      
+      // Calibrate and histogram only the selected spectrum quantity
+      AAProfileTimer CalibrationTimer(&Profiler, zProfileCalibration);
+      Double_t Quantity = Calibration::Apply(Spectrum::Select(PulseHeight, PulseArea),
+					     CalibrationFit, CalibrationInterp);
+      CalibrationTimer.Stop();
+      
+      if(Quantity > MinThresh and Quantity < MaxThresh){
+	AAProfileTimer Timer(&Profiler, zProfileHistogramFill);
+	Spectrum_H->Fill(Quantity);
+	Profiler.Count(zCountHistogramEntries);
+      }
+      
+      // Note that we must add a +1 to the waveform number in order to
+      // get the modulo to land on the correct intervals
+      if(UpdateProgress)
+	if((waveform+1) % UpdateInterval == 0)
+	  UpdateProcessingProgress(waveform);
+    }
+    
+    
+    //////////////////////////////////
+    // Peak-finder waveform processing
+    
+    else{
+      
+      // Find the peaks and peak limits in the waveform. If zero
+      // peaks are found then FindPeaks() returns false
+      Bool_t PeaksFound = FindPeaks(Waveform, zPeakFinder);
+      
+      // Because the peak finding algorithm skips analysis of
+      // waveforms for which it cannot find peaks, we need to update
+      // the progress bar here to ensure that bar ends at 100% when
+      // actual processing ends
+      if(UpdateProgress)
+	if((waveform+1) % UpdateInterval == 0)
+	  UpdateProcessingProgress(waveform);
+      
+      if(!PeaksFound)
+	continue;
+      
+      // Calculate the PSD integrals and determine if they pass
+      // through the pulse-shape filter
+      if(PSDFilter)
+	CalculatePSDIntegrals(false);
+      
+      // Separate the pulses of pileup events by template fitting
+      if(UsePileupRecovery)
+	RecoverPileup(Waveform, Channel);
+      
+      // Find both the pulse area and peak height of each peak so that
+      // the values can be added to the spectrum vectors
+      vector<PeakInfoStruct>::iterator it;
+      for(it=PeakInfoVec.begin(); it!=PeakInfoVec.end(); it++){
+	
+	// Skip peaks that are part of (unrecovered) pileup events, that
+	// fail the PSD filter, or that fall outside the waveform
+	// analysis region
+	if(UsePileupRejection and (*it).PileupFlag and (*it).FitHeight < 0){
+	  Profiler.Count(zCountPileupPeaks);
+	  continue;
+	}
+	
+	// Peaks that fail the PSD filter are still required by the
+	// average pulse templates
+	const Bool_t PSDReject = (PSDFilter and (*it).PSDFilterFlag);
+	
+	if(PSDReject){
+	  Profiler.Count(zCountPSDRejected);
+	  if(!BuildTemplates)
+	    continue;
+	}
+	
+	if((*it).PeakPosX < AnalysisMin or (*it).PeakPosX > AnalysisMax)
+	  continue;
+	
+	Double_t PeakArea = 0., PeakHeight = 0.;
+	MeasurePeak(Waveform, *it, (*it).PeakLimit_Lower, (*it).PeakLimit_Upper,
+		    PeakHeight, PeakArea);
+	
+	// Add single (not piled-up) pulses, aligned on their time if
+	// available, to the average pulse templates (if enabled)
+	if(BuildTemplates and !(*it).PileupFlag)
+	  AccumulatePulseTemplate(Waveform, ((*it).PeakTime >= 0.) ? (*it).PeakTime : (*it).PeakPosX,
+				  PeakHeight,
+				  Calibration::Apply(Spectrum::Select(PeakHeight, PeakArea),
+						     CalibrationFit, CalibrationInterp),
+				  PSDReject);
+	
+	if(PSDReject)
+	  continue;
+	
+	PHVec.push_back(PeakHeight);
+	PAVec.push_back(PeakArea);
+	
+	AAProfileTimer CalibrationTimer(&Profiler, zProfileCalibration);
+	Double_t Quantity = Calibration::Apply(Spectrum::Select(PeakHeight, PeakArea),
+					       CalibrationFit, CalibrationInterp);
+	CalibrationTimer.Stop();
+	
+	if(Quantity > MinThresh and Quantity < MaxThresh){
+	  AAProfileTimer Timer(&Profiler, zProfileHistogramFill);
+	  Spectrum_H->Fill(Quantity);
+	  Profiler.Count(zCountHistogramEntries);
+	}
+      }
+      
+      // Stream all peaks to the list-mode file (if enabled)
+      FillListModeRecords(waveform, Channel);
+    }
+  }
+}
+
+
+// The fixed-point spectrum kernels process simple max/sum (SMS)
+// spectra of baseline-subtracted waveforms with the region average
+// baseline directly from the integer samples using
+// AAFixedPointWaveform, i.e. without creating a floating point
+// waveform; the pulse height and area are converted to floating
+// point only once computed. They are selected (when enabled) by
+// AAComputation::UseFixedPointProcessing() from the same spectrum
+// type, calibration and PSD filter policies as the floating point
+// kernels
+
+void AAComputation::DispatchFixedPointKernel(Int_t Channel)
+{
+  if(ADAQSettings->ADAQSpectrumTypePAS)
+    DispatchFixedPointKernel<PASpectrum>(Channel);
+  else
+    DispatchFixedPointKernel<PHSpectrum>(Channel);
+}
+
+
+template<class Spectrum>
+void AAComputation::DispatchFixedPointKernel(Int_t Channel)
+{
+  if(!ADAQSettings->UseSpectraCalibrations[Channel])
+    DispatchFixedPointKernel<Spectrum, NoCalibration>(Channel);
+  else if(SpectraCalibrationType[Channel] == zCalibrationFit)
+    DispatchFixedPointKernel<Spectrum, FitCalibration>(Channel);
+  else
+    DispatchFixedPointKernel<Spectrum, InterpCalibration>(Channel);
+}
+
+
+template<class Spectrum, class Calibration>
+void AAComputation::DispatchFixedPointKernel(Int_t Channel)
+{
+  if(ADAQSettings->UsePSDRegions[Channel])
+    ProcessSpectrumWaveformsFixedPointKernel<Spectrum, Calibration, true>(Channel);
+  else
+    ProcessSpectrumWaveformsFixedPointKernel<Spectrum, Calibration, false>(Channel);
+}
+
+
+template<class Spectrum, class Calibration, Bool_t PSDFilter>
+void AAComputation::ProcessSpectrumWaveformsFixedPointKernel(Int_t Channel)
+{
+  const Int_t AnalysisMin = ADAQSettings->AnalysisRegionMin;
+  const Int_t AnalysisMax = ADAQSettings->AnalysisRegionMax;
+  
+  const Double_t MinThresh = ADAQSettings->SpectrumMinThresh;
+  const Double_t MaxThresh = ADAQSettings->SpectrumMaxThresh;
+
+  const Int_t Polarity = (ADAQSettings->WaveformPolarity < 0.) ? -1 : 1;
+  const Int_t BaselineMin = ADAQSettings->BaselineRegionMin;
+  const Int_t BaselineMax = ADAQSettings->BaselineRegionMax;
+
+  TF1 *CalibrationFit = ADAQSettings->SpectraCalibrations[Channel];
+  TGraph *CalibrationInterp = ADAQSettings->SpectraCalibrationData[Channel];
+
+  const Bool_t UpdateProgress = (IsMaster and WaveformEnd >= 50);
+  const Int_t UpdateInterval = Int_t(WaveformEnd*ADAQSettings->UpdateFreq*1.0/100);
+  
+  vector<Double_t> &PHVec = SpectrumPHVec[Channel];
+  vector<Double_t> &PAVec = SpectrumPAVec[Channel];
+  
+  for(Int_t waveform=NextTriggeredEntry(Channel, WaveformStart); waveform<WaveformEnd;
+      waveform=NextTriggeredEntry(Channel, waveform+1)){
+    
+    if(SequentialArchitecture)
+      gSystem->ProcessEvents();
+    
+    {
+      AAProfileTimer Timer(&Profiler, zProfileRead);
+      Profiler.Count(zCountBytesRead, ADAQWaveformTree->GetEntry(waveform));
+    }
+    Profiler.Count(zCountWaveforms);
+
+    if(UpdateProgress)
+      if((waveform+1) % UpdateInterval == 0)
+	UpdateProcessingProgress(waveform);
+    
+    // The samples are used in place within the waveform branch buffer
+    const vector<Int_t> &Voltage = *Waveforms[Channel];
+    if(Voltage.empty())
+      continue;
+    
+    AAProfileTimer TransformTimer(&Profiler, zProfileTransform);
+    FixedPointWaveform.Set(&Voltage[0], Voltage.size(), Polarity, BaselineMin, BaselineMax);
+    TransformTimer.Stop();
+    
+    // The PSD integrals are computed about the maximum of the whole
+    // waveform as with the "whole waveform" peak finding algorithm
+    Bool_t PSDReject = false;
+    
+    if(PSDFilter){
+      Long64_t PeakHeight = 0;
+      Int_t Peak = FixedPointWaveform.GetMaximum(1, Voltage.size()-1, PeakHeight);
+      
+      if(Peak >= AnalysisMin and Peak <= AnalysisMax){
+	AAProfileTimer Timer(&Profiler, zProfilePSDIntegrals);
+	
+	Double_t TotalIntegral, TailIntegral;
+	CalculateFixedPointPSDIntegrals(Peak, TotalIntegral, TailIntegral);
+	ConvertPSDIntegrals(Channel, TotalIntegral, TailIntegral);
+	
+	PSDReject = ApplyPSDRegion(TotalIntegral, TailIntegral);
+      }
+      
+      if(PSDReject)
+	Profiler.Count(zCountPSDRejected);
+      
+      if(PSDReject and !ListModeActive)
+	continue;
+    }
+    
+    // Get the pulse height and area as the maximum and sum of the
+    // waveform within the waveform analysis region
+    Long64_t Height = 0;
+    Int_t PeakPosX = FixedPointWaveform.GetMaximum(AnalysisMin, AnalysisMax, Height);
+    
+    Double_t PulseHeight = AAFixedPointWaveform::ToDouble(Height);
+    Double_t PulseArea = AAFixedPointWaveform::ToDouble(FixedPointWaveform.GetIntegral(AnalysisMin, AnalysisMax));
+    
+    FillListModeRecord(waveform, Channel, PeakPosX, PulseHeight, PulseArea,
+		       false, PSDReject, -1.);
+    
+    if(PSDReject)
+      continue;
+    
+    PHVec.push_back(PulseHeight);
+    PAVec.push_back(PulseArea);
+    
+    AAProfileTimer CalibrationTimer(&Profiler, zProfileCalibration);
+    Double_t Quantity = Calibration::Apply(Spectrum::Select(PulseHeight, PulseArea),
+					   CalibrationFit, CalibrationInterp);
+    CalibrationTimer.Stop();
+    
+    if(Quantity > MinThresh and Quantity < MaxThresh){
+      AAProfileTimer Timer(&Profiler, zProfileHistogramFill);
+      Spectrum_H->Fill(Quantity);
+      Profiler.Count(zCountHistogramEntries);
+    }
+  }
+}
+
+
+// Method to determine whether the spectrum (or, if PSD is true, the
+// PSD histogram) may be processed in fixed point: it must be enabled
+// and the waveforms must be baseline-subtracted with the average
+// baseline and processed with the simple max/sum (or "whole
+// waveform") algorithm. Features that require the floating point
+// waveform (pulse templates and peak timing of list-mode records)
+// are not available in fixed point
+Bool_t AAComputation::UseFixedPointProcessing(Bool_t PSD)
+{
+  if(!ADAQSettings->UseFixedPoint or
+     ADAQSettings->ZSWaveform or
+     ADAQSettings->BaselineEstimator != AABaselineEstimator::zMeanBaseline or
+     ADAQSettings->BuildPulseTemplates or
+     (ADAQSettings->UsePeakTiming and ListModeActive))
+    return false;
+  
+  if(PSD)
+    return ADAQSettings->PSDAlgorithmSMS;
+  else
+    return (!ADAQSettings->ADAQSpectrumAlgorithmPF and
+	    !ADAQSettings->ADAQSpectrumAlgorithmDS);
+}
+
+
+// Method to add the PSD integrals of a waveform to the PSD histogram
+// in fixed point. This is the equivalent of the "whole waveform" peak
+// finding followed by AAComputation::CalculatePSDIntegrals() and
+// AAComputation::FillListModeRecords()
+void AAComputation::ProcessFixedPointPSDWaveform(Int_t Entry, Int_t Channel)
+{
+  const vector<Int_t> &Voltage = *Waveforms[Channel];
+  if(Voltage.empty())
+    return;
+  
+  {
+    AAProfileTimer Timer(&Profiler, zProfileTransform);
+    FixedPointWaveform.Set(&Voltage[0], Voltage.size(),
+			   (ADAQSettings->WaveformPolarity < 0.) ? -1 : 1,
+			   ADAQSettings->BaselineRegionMin,
+			   ADAQSettings->BaselineRegionMax);
+  }
+  
+  Long64_t Height = 0;
+  Int_t Peak = 0;
+  {
+    AAProfileTimer Timer(&Profiler, zProfilePeakFinding);
+    Peak = FixedPointWaveform.GetMaximum(1, Voltage.size()-1, Height);
+  }
+  Profiler.Count(zCountPeaks);
+  
+  if(Peak < ADAQSettings->AnalysisRegionMin or Peak > ADAQSettings->AnalysisRegionMax)
+    return;
+  
+  AAProfileTimer Timer(&Profiler, zProfilePSDIntegrals);
+  
+  Double_t TotalIntegral, TailIntegral;
+  CalculateFixedPointPSDIntegrals(Peak, TotalIntegral, TailIntegral);
+  
+  PSDHistogramTotalVec[Channel].push_back(TotalIntegral);
+  PSDHistogramTailVec[Channel].push_back(TailIntegral);
+  
+  ConvertPSDIntegrals(Channel, TotalIntegral, TailIntegral);
+  
+  Bool_t PSDReject = (ADAQSettings->UsePSDRegions[Channel] and
+		      ApplyPSDRegion(TotalIntegral, TailIntegral));
+  
+  if(TotalIntegral > ADAQSettings->PSDThreshold and !PSDReject){
+    PSDHistogram_H->Fill(TotalIntegral, TailIntegral);
+    Profiler.Count(zCountHistogramEntries);
+  }
+  Timer.Stop();
+  
+  // The height (at least zero) and area of "whole waveform" peaks
+  // are taken over the waveform analysis region
+  if(ListModeActive){
+    Long64_t PeakHeight = 0;
+    FixedPointWaveform.GetMaximum(ADAQSettings->AnalysisRegionMin,
+				  ADAQSettings->AnalysisRegionMax-1, PeakHeight);
+    
+    FillListModeRecord(Entry, Channel, Peak,
+		       AAFixedPointWaveform::ToDouble(max(PeakHeight, (Long64_t)0)),
+		       AAFixedPointWaveform::ToDouble(FixedPointWaveform.GetIntegral(ADAQSettings->AnalysisRegionMin,
+										     ADAQSettings->AnalysisRegionMax)),
+		       false, PSDReject, -1.);
+  }
+}
+
+
+// Method to compute the PSD total and tail integrals about the
+// specified peak of the present fixed-point waveform
+void AAComputation::CalculateFixedPointPSDIntegrals(Int_t Peak, Double_t &Total, Double_t &Tail)
+{
+  Total = AAFixedPointWaveform::ToDouble(FixedPointWaveform.GetIntegral(Peak + ADAQSettings->PSDTotalStart,
+									 Peak + ADAQSettings->PSDTotalStop));
+  Tail = AAFixedPointWaveform::ToDouble(FixedPointWaveform.GetIntegral(Peak + ADAQSettings->PSDTailStart,
+									Peak + ADAQSettings->PSDTailStop));
+}
+
+
+void AAComputation::CreateSpectrum()
+{
+  SpectrumExists = false;
+
+  // Reset (or create) the TH1F histogram object for spectra creation
+  Spectrum_H = PrepareHistogram(Spectrum_H, "Spectrum_H", "ADAQ spectrum", 
+				ADAQSettings->SpectrumNumBins, 
+				ADAQSettings->SpectrumMinBin,
+				ADAQSettings->SpectrumMaxBin);
 
   // Get the current digitizer channel to analyze
   Int_t Channel = ADAQSettings->WaveformChannel;
@@ -1485,122 +2642,41 @@ void AAComputation::CreateSpectrum()
       Spectrum_H->Fill(Quantity);
   }
   SpectrumExists = true;
+  SpectrumRevision++;
 }
 
 
-void AAComputation::IntegratePeaks()
+// Method to measure the height (the maximum sample) and area (the
+// integral) of a peak between the specified sample limits. Recovered
+// pileup peaks use the template fit height and area instead
+void AAComputation::MeasurePeak(TH1F *Waveform, const PeakInfoStruct &Peak,
+				Int_t Lower, Int_t Upper,
+				Double_t &PeakHeight, Double_t &PeakArea)
 {
-  // Iterate over each peak stored in the vector of PeakInfoStructs...
-  vector<PeakInfoStruct>::iterator it;
-  for(it=PeakInfoVec.begin(); it!=PeakInfoVec.end(); it++){
-    
-    // If pileup rejection is begin used, examine the pileup flag
-    // stored in each PeakInfoStruct to determine whether or not this
-    // peak is part of a pileup events. If so, skip it...
-    //if(UsePileupRejection_CB->IsDown() and (*it).PileupFlag==true)
-    if(ADAQSettings->UsePileupRejection and (*it).PileupFlag==true)
-      continue;
-    
-    // If the PSD filter is desired, examine the PSD filter flag
-    // stored in each PeakInfoStruct to determine whether or not this
-    // peak should be filtered out of the spectrum.
-    if(UsePSDRegions[ADAQSettings->WaveformChannel] and (*it).PSDFilterFlag==true)
-      continue;
-
-    // If the peak falls outside the user-specific waveform analysis
-    // region then filter this peak out of the spectrum
-    if((*it).PeakPosX < ADAQSettings->AnalysisRegionMin or
-       (*it).PeakPosX > ADAQSettings->AnalysisRegionMax)
-      continue;
-    
-    // ...and use the lower and upper peak limits to calculate the
-    // integral under each waveform peak that has passed all criterion
-    Double_t PeakIntegral = Waveform_H[ADAQSettings->WaveformChannel]->Integral((*it).PeakLimit_Lower,
-										(*it).PeakLimit_Upper);
-    
-    Int_t Channel = ADAQSettings->WaveformChannel;
-    
-    // Add the uncalibrated integral to the spectrum vector
-    SpectrumPAVec[Channel].push_back(PeakIntegral);
-    
-    // If the user has calibrated the spectrum, then transform the
-    // peak integral in pulse units [ADC] to energy units
-    if(ADAQSettings->UseSpectraCalibrations[Channel]){
-      if(SpectraCalibrationType[Channel] == zCalibrationFit)
-	PeakIntegral = ADAQSettings->SpectraCalibrations[Channel]->Eval(PeakIntegral);
-      else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
-	PeakIntegral = ADAQSettings->SpectraCalibrationData[Channel]->Eval(PeakIntegral);
-    }
-    
-    // Add the integral to the spectrum if a pulse area spectrum is
-    // desired to create the initial post-processing histogram
-    if(ADAQSettings->ADAQSpectrumTypePAS){
-      if(PeakIntegral > ADAQSettings->SpectrumMinThresh and
-	 PeakIntegral < ADAQSettings->SpectrumMaxThresh){
-	Spectrum_H->Fill(PeakIntegral);
-      }
-    }
+  PeakHeight = 0.;
+  PeakArea = 0.;
+  
+  if(Peak.FitHeight >= 0){
+    PeakHeight = Peak.FitHeight;
+    PeakArea = Peak.FitArea;
+    return;
   }
-}
-
-
-void AAComputation::FindPeakHeights()
-{
-  // Iterate over each peak stored in the vector of PeakInfoStructs...
-  vector<PeakInfoStruct>::iterator it;
-  for(it=PeakInfoVec.begin(); it!=PeakInfoVec.end(); it++){
-
-    // If pileup rejection is begin used, examine the pileup flag
-    // stored in each PeakInfoStruct to determine whether or not this
-    // peak is part of a pileup events. If so, skip it...
-    if(ADAQSettings->UsePileupRejection and (*it).PileupFlag==true)
-      continue;
-
-    // If the PSD filter is desired, examine the PSD filter flag
-    // stored in each PeakInfoStruct to determine whether or not this
-    // peak should be filtered out of the spectrum.
-    if(UsePSDRegions[ADAQSettings->WaveformChannel] and (*it).PSDFilterFlag==true)
-      continue;
-
-    // If the peak falls outside the user-specific waveform analysis
-    // region then filter this peak out of the spectrum
-    if((*it).PeakPosX < ADAQSettings->AnalysisRegionMin or
-       (*it).PeakPosX > ADAQSettings->AnalysisRegionMax)
-      continue;
-    
-    // Initialize the peak height for each peak region
-    Double_t PeakHeight = 0.;
-
-    // Get the waveform processing channel number
-    Int_t Channel = ADAQSettings->WaveformChannel;
-
-    // Iterate over the samples between lower and upper integration
-    // limits to determine the maximum peak height
-    for(Int_t sample=(*it).PeakLimit_Lower; sample<(*it).PeakLimit_Upper; sample++){
-      if(Waveform_H[Channel]->GetBinContent(sample) > PeakHeight)
-	PeakHeight = Waveform_H[Channel]->GetBinContent(sample);
-    }
-
-    // Add the uncalibrated peak height to the spectrum vector
-    SpectrumPHVec[Channel].push_back(PeakHeight);
-    
-    // If the user has calibrated the spectrum then transform the peak
-    // heights in pulse units [ADC] to energy
-    if(ADAQSettings->UseSpectraCalibrations[Channel]){
-      if(SpectraCalibrationType[Channel] == zCalibrationFit)
-	PeakHeight = ADAQSettings->SpectraCalibrations[Channel]->Eval(PeakHeight);
-      else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
-	PeakHeight = ADAQSettings->SpectraCalibrationData[Channel]->Eval(PeakHeight);
-    }
-    
-    // Add the integral to the spectrum if a pulse area spectrum is
-    // desired to create the initial post-processing histogram
-    if(ADAQSettings->ADAQSpectrumTypePHS){
-      if(PeakHeight > ADAQSettings->SpectrumMinThresh and
-	 PeakHeight < ADAQSettings->SpectrumMaxThresh){
-	Spectrum_H->Fill(PeakHeight);
-      }
-    }
+  
+  // Read the samples directly from the bin array, in which the array
+  // index is the bin number, with the limits clipped to the array as
+  // TH1::Integral() and TH1::GetBinContent() clip them
+  const Float_t *Samples = Waveform->GetArray();
+  const Int_t Overflow = Waveform->GetNbinsX() + 1;
+  
+  const Int_t First = max(Lower, 0);
+  const Int_t Last = (Upper > Overflow or Upper < First) ? Overflow : Upper;
+  for(Int_t sample=First; sample<=Last; sample++)
+    PeakArea += Samples[sample];
+  
+  for(Int_t sample=First; sample<Upper; sample++){
+    Double_t SampleHeight = Samples[min(sample, Overflow)];
+    if(SampleHeight > PeakHeight)
+      PeakHeight = SampleHeight;
   }
 }
 
@@ -1608,7 +2684,7 @@ void AAComputation::FindPeakHeights()
 void AAComputation::UpdateProcessingProgress(int Waveform)
 {
 #ifndef MPI_ENABLED
-  if(Waveform > 0)
+  if(Waveform > 0 and ProcessingProgressBar)
     ProcessingProgressBar->Increment(ADAQSettings->UpdateFreq);
 #else
   if(Waveform == 0)
@@ -1623,6 +2699,66 @@ void AAComputation::UpdateProcessingProgress(int Waveform)
 }
 
 
+// Method to begin profiling a waveform processing run. The settings
+// that most strongly affect processing cost are recorded with the
+// profile such that their cost may be compared between runs
+void AAComputation::BeginProfile(string Run)
+{
+  Profiler.SetEnabled(ADAQSettings->ProfileProcessing);
+  if(!Profiler.GetEnabled())
+    return;
+
+  Profiler.BeginRun(Run);
+  Profiler.SetParameter("Channel", ADAQSettings->WaveformChannel);
+  Profiler.SetParameter("MaxPeaks", ADAQSettings->MaxPeaks);
+  Profiler.SetParameter("Sigma", ADAQSettings->Sigma);
+  Profiler.SetParameter("Resolution", ADAQSettings->Resolution);
+  Profiler.SetParameter("Floor", ADAQSettings->Floor);
+  Profiler.SetParameter("Markov", ADAQSettings->UseMarkovSmoothing);
+  Profiler.SetParameter("TreeCacheMB", TreeIOCacheSize);
+  Profiler.SetParameter("IMTThreads", TreeIOThreads);
+
+  // Note that the threaded readers open their own files, the read
+  // calls of which are not included
+  ProfileReadCalls = ADAQFile->GetReadCalls();
+}
+
+
+// Method to end profiling a waveform processing run and report the
+// profile: to the GUI profile panel in sequential architecture or to
+// stdout in parallel architecture (or when running without the GUI)
+// and, if a file has been selected, to a JSON file. Note that in
+// parallel architecture this method must be reached by all nodes
+void AAComputation::EndProfile()
+{
+  if(!Profiler.GetEnabled())
+    return;
+
+  Profiler.EndRun();
+  Profiler.Count(zCountReadCalls, ADAQFile->GetReadCalls() - ProfileReadCalls);
+
+  if(ParallelArchitecture)
+    Profiler.AggregateToMaster();
+
+  if(!IsMaster)
+    return;
+
+  string Report = Profiler.GetReport();
+
+  if(SequentialArchitecture and ProfileTextView)
+    ProfileTextView->LoadBuffer(Report.c_str());
+  else
+    cout << "\n" << Report << endl;
+
+  string FileName = ADAQSettings->ProfileFileName;
+  if(FileName != "" and FileName != "<No file currently selected>"){
+    if(!Profiler.WriteJSON(FileName))
+      cout << "\nADAQAnalysis error! The processing profile could not be written to '"
+	   << FileName << "'!\n" << endl;
+  }
+}
+
+
 // Method to compute a background of a TH1F object representing a
 // detector pulse height / energy spectrum.
 void AAComputation::CalculateSpectrumBackground()//TH1F *Spectrum_H)
@@ -1631,9 +2767,15 @@ void AAComputation::CalculateSpectrumBackground()//TH1F *Spectrum_H)
   // background = background component of raw spectrum
   // deconvolved = raw spectrum less background spectrum
 
+  // The background need only be recalculated if the spectrum or any
+  // background setting has changed since it was last calculated
+  if(SpectrumBackgroundExists and
+     BackgroundSpectrumRevision == SpectrumRevision and
+     BackgroundAnalysisRevision == ADAQSettings->GetStageRevision(zStageAnalysis))
+    return;
 
-  // Clone the Spectrum_H object and give the clone a unique name
-  TH1F *SpectrumClone_H = (TH1F *)Spectrum_H->Clone("SpectrumClone_H");
+  // Obtain a pooled clone of the Spectrum_H object
+  TH1F *SpectrumClone_H = GetPooledClone(Spectrum_H, "SpectrumClone_H");
   
   // Set the range of the Spectrum_H clone to correspond to the range
   // that the user has specified to calculate the background over
@@ -1651,48 +2793,54 @@ void AAComputation::CalculateSpectrumBackground()//TH1F *Spectrum_H)
   //
   // PeakFinder = new TSpectrum(SpectrumNumPeaks_NEL->GetEntry()->GetIntNumber());
 
-  // Delete the TH1F object that holds a previous background histogram
-  if(SpectrumBackground_H){
-    delete SpectrumBackground_H;
-    SpectrumBackgroundExists = false;
-  }
-
-  // Use the TSpectrum::Background() method to compute the spectrum
-  // background; Set the resulting TH1F objects graphic attributes
-
-  int Iterations = ADAQSettings->BackgroundIterations;
+  SpectrumBackgroundExists = false;
 
-  string Compton = "";
-  if(ADAQSettings->BackgroundCompton)
-    Compton = " Compton ";
+  // Use the array-based TSpectrum::Background() method to compute the
+  // spectrum background over the user-specified range. This is
+  // identical to the TH1-based method (which allocates and returns a
+  // new histogram on every call) except that the result is written
+  // into the reused SpectrumBackground_H object
 
-  string Smoothing = " nosmoothing ";
-  if(ADAQSettings->BackgroundSmoothing)
-    Smoothing = "";
+  Int_t Iterations = ADAQSettings->BackgroundIterations;
 
-  string Direction;
-  if(ADAQSettings->BackgroundDirection == 0)
-    Direction = " BackIncreasingWindow ";
-  else if(ADAQSettings->BackgroundDirection == 1)
-    Direction = " BackDecreasingWindow ";
-
-  stringstream ss;
-
-  string FilterOrder;
-  ss << " BackOrder" << ADAQSettings->BackgroundFilterOrder << " ";
-  FilterOrder = ss.str();
-
-  ss.str("");
-
-  string SmoothingWidth;
-  ss << " BackSmoothing" << ADAQSettings->BackgroundSmoothingWidth << " ";
-  SmoothingWidth = ss.str();
-
-  string BackgroundOptionsString = Compton + Smoothing + Direction + FilterOrder + SmoothingWidth;
-
-  SpectrumBackground_H = (TH1F *)PeakFinder->Background(SpectrumClone_H, 
-							Iterations,
-							BackgroundOptionsString.c_str());
+  Int_t Direction = TSpectrum::kBackIncreasingWindow;
+  if(ADAQSettings->BackgroundDirection == 1)
+    Direction = TSpectrum::kBackDecreasingWindow;
+  
+  // The filter order setting is 2, 4, 6, or 8, whereas the TSpectrum
+  // enumerator is kBackOrder2 (== 0) through kBackOrder8 (== 3)
+  Int_t FilterOrder = ADAQSettings->BackgroundFilterOrder/2 - 1;
+  
+  // The smoothing width setting is the smoothing window size
+  Int_t SmoothingWidth = ADAQSettings->BackgroundSmoothingWidth;
+  
+  Int_t First = SpectrumClone_H->GetXaxis()->GetFirst();
+  Int_t Last = SpectrumClone_H->GetXaxis()->GetLast();
+  Int_t Size = Last - First + 1;
+  
+  vector<Double_t> Source(Size);
+  for(Int_t i=0; i<Size; i++)
+    Source[i] = SpectrumClone_H->GetBinContent(i + First);
+  
+  PeakFinder->Background(&Source[0], Size,
+			 Iterations,
+			 Direction,
+			 FilterOrder,
+			 ADAQSettings->BackgroundSmoothing,
+			 SmoothingWidth,
+			 ADAQSettings->BackgroundCompton);
+  
+  // Only bins in the user-specified range contain the background
+  SpectrumBackground_H = PrepareHistogram(SpectrumBackground_H,
+					  "SpectrumClone_H_background",
+					  Spectrum_H->GetTitle(),
+					  ADAQSettings->SpectrumNumBins, 
+					  ADAQSettings->SpectrumMinBin, 
+					  ADAQSettings->SpectrumMaxBin);
+  
+  for(Int_t i=0; i<Size; i++)
+    SpectrumBackground_H->SetBinContent(i + First, Source[i]);
+  
   SpectrumBackground_H->SetLineColor(2);
   SpectrumBackground_H->SetLineWidth(2);
 
@@ -1708,27 +2856,26 @@ void AAComputation::CalculateSpectrumBackground()//TH1F *Spectrum_H)
   // background TH1F object
   SpectrumBackground_H->SetEntries(SpectrumBackground_H->Integral(0, ADAQSettings->SpectrumNumBins+1));
   
-  // Delete the TH1F object that holds a previous deconvolved TH1F
-  if(SpectrumDeconvolved_H)
-    delete SpectrumDeconvolved_H;
-
-  // Create a new deconvolved spectrum. Note that the bin number and
+  // Reset (or create) the deconvolved spectrum. Note that the bin number and
   // range match those of the raw spectrum, whereas the background
   // spectrum range is set by the user. This enables a background
   // spectrum to be computed for whatever range the user desires and
   // for resulting deconvolved spectrum to have the entire original
   // raw spectrum with the background subtracted out.
-  SpectrumDeconvolved_H = new TH1F("Deconvolved spectrum", "Deconvolved spectrum", 
-				   ADAQSettings->SpectrumNumBins, 
-				   ADAQSettings->SpectrumMinBin, 
-				   ADAQSettings->SpectrumMaxBin);
+  SpectrumDeconvolved_H = PrepareHistogram(SpectrumDeconvolved_H,
+					   "Deconvolved spectrum", "Deconvolved spectrum", 
+					   ADAQSettings->SpectrumNumBins, 
+					   ADAQSettings->SpectrumMinBin, 
+					   ADAQSettings->SpectrumMaxBin);
   SpectrumDeconvolved_H->SetLineColor(4);
   SpectrumDeconvolved_H->SetLineWidth(2);
 
   // Create an object to hold the sum of the squares of the bin
   // weights is created and calculated (i.e. error will be propogated
-  // during the background subtraction into the deconvolved spectrum)
-  SpectrumDeconvolved_H->Sumw2();
+  // during the background subtraction into the deconvolved spectrum).
+  // Note that a reused histogram will already have the structure
+  if(SpectrumDeconvolved_H->GetSumw2N() == 0)
+    SpectrumDeconvolved_H->Sumw2();
   
   SpectrumDeconvolved_H->SetLineColor(kBlue);
   SpectrumDeconvolved_H->SetLineWidth(2);
@@ -1754,6 +2901,9 @@ void AAComputation::CalculateSpectrumBackground()//TH1F *Spectrum_H)
   // Set the bool that flags whether or not the SpectrumBackground_H
   // object is available
   SpectrumBackgroundExists = true;
+
+  BackgroundSpectrumRevision = SpectrumRevision;
+  BackgroundAnalysisRevision = ADAQSettings->GetStageRevision(zStageAnalysis);
 }
 
 double Range;
@@ -1787,16 +2937,13 @@ void AAComputation::IntegrateSpectrum()
   if(UpperIntLimit < LowerIntLimit)
     UpperIntLimit = LowerIntLimit+1;
 
-  // Clone the appropriate spectrum object depending on user's
-  // selection into a new TH1F object for integration
-
-  if(SpectrumIntegral_H)
-    delete SpectrumIntegral_H;
+  // Copy the appropriate spectrum object depending on user's
+  // selection into the reused TH1F object for integration
 
   if(ADAQSettings->PlotLessBackground)
-    SpectrumIntegral_H = (TH1F *)SpectrumDeconvolved_H->Clone("SpectrumToIntegrate_H");
+    SpectrumIntegral_H = CopyHistogram(SpectrumDeconvolved_H, SpectrumIntegral_H, "SpectrumToIntegrate_H");
   else
-    SpectrumIntegral_H = (TH1F *)Spectrum_H->Clone("SpectrumToIntegrate_H");
+    SpectrumIntegral_H = CopyHistogram(Spectrum_H, SpectrumIntegral_H, "SpectrumToIntegrate_H");
   
   // Set the integration TH1F object attributes and draw it
   SpectrumIntegral_H->SetLineColor(4);
@@ -1894,7 +3041,7 @@ void AAComputation::FitSpectrum()
   
   // Project the gaussian fit into a histogram with identical
   // binning to the original spectrum to make analysis easier
-  TH1F *SpectrumFit_H = (TH1F *)SpectrumIntegral_H->Clone("SpectrumFit_H");
+  TH1F *SpectrumFit_H = GetPooledClone(SpectrumIntegral_H, "SpectrumFit_H");
   SpectrumFit_H->Eval(SpectrumFit_F);
   
   // Compute the integral and error between the lower/upper limits
@@ -1974,27 +3121,42 @@ Bool_t AAComputation::WriteSpectrumFitResultsFile(string FName)
 
   // Output to file
     
-  ofstream Out(FName.c_str(), ofstream::trunc);
-
-  Out << "# File name : " << FName << "\n"
-      << "# File date : " << ctime(&Time)
-      << "# File desc : " << "Gaussian fit parameters and energy resolution with absolute error\n"
-      << "# ADAQ file : " << ADAQFileName << "\n"
-      << "\n"
-      << setw(10) << "Integral:" << setw(10) << SpectrumIntegralValue << setw(20) << TotalError << "\n"
-      << setw(10) << "Constant:" << setw(10) << Const << setw(20) << ConstErr << "\n"
-      << setw(10) << "Mean:" << setw(10) << Mean << setw(20) << MeanErr << "\n"
-      << setw(10) << "Sigma:" << setw(10) << Sigma << setw(20) << SigmaErr << "\n"
-      << setw(10) << "Res:" << setw(10) << Res << setw(20) << ResErr << "\n"
-      << setw(10) << "Covariance:" << setw(10) << "Const/Sigma" << setw(20) << CovConstSigma << "\n"
-      << endl;
-
-  return true;
+  AABufferedWriter Out(FName);
+  if(!Out.IsOpen())
+    return false;
+  
+  Out.Write("# File name : " + FName + "\n");
+  Out.Write(string("# File date : ") + ctime(&Time));
+  Out.Write("# File desc : Gaussian fit parameters and energy resolution with absolute error\n");
+  Out.Write("# ADAQ file : " + ADAQFileName + "\n");
+  Out.Write('\n');
+
+  const char *Labels[5] = {"Integral:", "Constant:", "Mean:", "Sigma:", "Res:"};
+  const Double_t Values[5] = {SpectrumIntegralValue, Const, Mean, Sigma, Res};
+  const Double_t Errors[5] = {TotalError, ConstErr, MeanErr, SigmaErr, ResErr};
+  
+  for(Int_t i=0; i<5; i++){
+    Out.Write(Labels[i], 10);
+    Out.Write(Values[i], 10);
+    Out.Write(Errors[i], 20);
+    Out.Write('\n');
+  }
+  
+  Out.Write("Covariance:", 10);
+  Out.Write("Const/Sigma", 10);
+  Out.Write(CovConstSigma, 20);
+  Out.Write("\n\n");
+  
+  return Out.Close();
 }
 
 
 // Method used to output a generic TH1 object to a data text file in
-// the format column1 == bin center, column2 == bin content. Note that
+// the format column1 == bin center, column2 == bin content, or a
+// generic TH2 object in the format column1 == X bin center, column2
+// == Y bin center, column3 == bin content. The same layout is used
+// for the binary NumPy (.npy) format, which stores the columns as a
+// 2D array of doubles for direct loading with numpy.load(). Note that
 // the function accepts class types TH1 such that any derived class
 // (TH1F, TH1D ...) can be saved with this function
 bool AAComputation::SaveHistogramData(string Type, string FileName, string FileExtension)
@@ -2019,25 +3181,121 @@ bool AAComputation::SaveHistogramData(string Type, string FileName, string FileE
     
     string FullFileName = FileName + FileExtension;
     
-    ofstream HistogramOutput(FullFileName.c_str(), ofstream::trunc);
+    AABufferedWriter HistogramOutput(FullFileName);
+    if(!HistogramOutput.IsOpen())
+      return false;
     
     // Assign the data separator based on file extension
-    string separator;
-    if(FileExtension == ".dat")
-      separator = "\t";
-    else if(FileExtension == ".csv")
-      separator = ",";
+    char Separator = '\t';
+    if(FileExtension == ".csv")
+      Separator = ',';
+
+    if(HistogramToSave_H2){
+      Int_t NumXBins = HistogramToSave_H2->GetNbinsX();
+      Int_t NumYBins = HistogramToSave_H2->GetNbinsY();
 
-    int NumBins = HistogramToSave_H1->GetNbinsX();
+      TAxis *XAxis = HistogramToSave_H2->GetXaxis();
+      TAxis *YAxis = HistogramToSave_H2->GetYaxis();
+      
+      for(Int_t xbin=1; xbin<=NumXBins; xbin++){
+	for(Int_t ybin=1; ybin<=NumYBins; ybin++){
+	  HistogramOutput.Write(XAxis->GetBinCenter(xbin));
+	  HistogramOutput.Write(Separator);
+	  HistogramOutput.Write(YAxis->GetBinCenter(ybin));
+	  HistogramOutput.Write(Separator);
+	  HistogramOutput.Write(HistogramToSave_H2->GetBinContent(xbin, ybin));
+	  HistogramOutput.Write('\n');
+	}
+      }
+    }
+    else{
+      Int_t NumBins = HistogramToSave_H1->GetNbinsX();
+      
+      for(Int_t bin=0; bin<=NumBins; bin++){
+	HistogramOutput.Write(HistogramToSave_H1->GetBinCenter(bin));
+	HistogramOutput.Write(Separator);
+	HistogramOutput.Write(HistogramToSave_H1->GetBinContent(bin));
+	HistogramOutput.Write('\n');
+      }
+    }
     
-    for(int bin=0; bin<=NumBins; bin++)
-      HistogramOutput << HistogramToSave_H1->GetBinCenter(bin) << separator
-		      << HistogramToSave_H1->GetBinContent(bin)
-		      << endl;
+    return HistogramOutput.Close();
+  }
+  else if(FileExtension == ".npy"){
+
+    string FullFileName = FileName + FileExtension;
+
+    // Assemble the histogram into a row-major array of doubles with
+    // the same column layout as the ASCII formats above
+
+    vector<Double_t> Data;
+    Int_t NumRows = 0, NumColumns = 0;
     
-    HistogramOutput.close();
+    if(HistogramToSave_H2){
+      Int_t NumXBins = HistogramToSave_H2->GetNbinsX();
+      Int_t NumYBins = HistogramToSave_H2->GetNbinsY();
 
-    return true;
+      NumRows = NumXBins * NumYBins;
+      NumColumns = 3;
+      Data.reserve(NumRows * NumColumns);
+      
+      for(Int_t xbin=1; xbin<=NumXBins; xbin++){
+	for(Int_t ybin=1; ybin<=NumYBins; ybin++){
+	  Data.push_back(HistogramToSave_H2->GetXaxis()->GetBinCenter(xbin));
+	  Data.push_back(HistogramToSave_H2->GetYaxis()->GetBinCenter(ybin));
+	  Data.push_back(HistogramToSave_H2->GetBinContent(xbin, ybin));
+	}
+      }
+    }
+    else{
+      Int_t NumBins = HistogramToSave_H1->GetNbinsX();
+      
+      NumRows = NumBins + 1;
+      NumColumns = 2;
+      Data.reserve(NumRows * NumColumns);
+      
+      for(Int_t bin=0; bin<=NumBins; bin++){
+	Data.push_back(HistogramToSave_H1->GetBinCenter(bin));
+	Data.push_back(HistogramToSave_H1->GetBinContent(bin));
+      }
+    }
+
+    // Create the NumPy version 1.0 format header: a magic string, the
+    // format version, the header length, and a Python dictionary
+    // literal describing the array. The header is padded with spaces
+    // such that the array data begins on a 64-byte boundary
+
+    const UShort_t EndianTest = 1;
+    string Descr = (*(const char *)&EndianTest == 1) ? "<f8" : ">f8";
+    
+    stringstream SS;
+    SS << "{'descr': '" << Descr << "', 'fortran_order': False, 'shape': ("
+       << NumRows << ", " << NumColumns << "), }";
+    string Header = SS.str();
+    
+    const size_t PreambleSize = 10;
+    size_t HeaderSize = Header.size() + 1;
+    size_t Padding = (64 - (PreambleSize + HeaderSize) % 64) % 64;
+    Header.append(Padding, ' ');
+    Header += '\n';
+
+    UShort_t HeaderLength = Header.size();
+    const char Preamble[8] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+    
+    AABufferedWriter HistogramOutput(FullFileName);
+    if(!HistogramOutput.IsOpen())
+      return false;
+    
+    HistogramOutput.WriteBinary(Preamble, 8);
+    
+    // The header length is always stored little-endian
+    char HeaderLengthBytes[2] = {(char)(HeaderLength & 0xff), (char)(HeaderLength >> 8)};
+    HistogramOutput.WriteBinary(HeaderLengthBytes, 2);
+    
+    HistogramOutput.WriteBinary(Header.c_str(), Header.size());
+    HistogramOutput.WriteBinary(&Data[0], Data.size() * sizeof(Double_t));
+    
+    return HistogramOutput.Close();
   }
   else if(FileExtension == ".root"){
     
@@ -2064,25 +3322,25 @@ bool AAComputation::SaveHistogramData(string Type, string FileName, string FileE
 
 TH2F *AAComputation::ProcessPSDHistogramWaveforms()
 {
-  if(PSDHistogramExists){
-    delete PSDHistogram_H;
-    PSDHistogramExists = false;
-  }
+  PSDHistogramExists = false;
+
+  BeginProfile("PSD histogram");
   
-  if(SequentialArchitecture){
+  if(SequentialArchitecture and ProcessingProgressBar){
     ProcessingProgressBar->Reset();
     ProcessingProgressBar->SetBarColor(ColorManager->Number2Pixel(33));
     ProcessingProgressBar->SetForegroundColor(ColorManager->Number2Pixel(1));
   }
   
-  // Create a 2-dimensional histogram to store the PSD integrals
-  PSDHistogram_H = new TH2F("PSDHistogram_H","PSDHistogram_H", 
-			    ADAQSettings->PSDNumTotalBins, 
-			    ADAQSettings->PSDMinTotalBin,
-			    ADAQSettings->PSDMaxTotalBin,
-			    ADAQSettings->PSDNumTailBins,
-			    ADAQSettings->PSDMinTailBin,
-			    ADAQSettings->PSDMaxTailBin);
+  // Reset (or create) the 2-dimensional histogram to store the PSD
+  // integrals
+  PSDHistogram_H = PrepareHistogram(PSDHistogram_H, "PSDHistogram_H","PSDHistogram_H", 
+				    ADAQSettings->PSDNumTotalBins, 
+				    ADAQSettings->PSDMinTotalBin,
+				    ADAQSettings->PSDMaxTotalBin,
+				    ADAQSettings->PSDNumTailBins,
+				    ADAQSettings->PSDMinTailBin,
+				    ADAQSettings->PSDMaxTailBin);
   
   Int_t Channel = ADAQSettings->WaveformChannel;
 
@@ -2122,34 +3380,48 @@ TH2F *AAComputation::ProcessPSDHistogramWaveforms()
 
     ///////////////////////////////////////////////////
     // Readout the waveform data into the PSD histogram
+
+    // Collect the entries to be discriminated in which the channel
+    // triggered
+    Int_t EntryEnd = min(ADAQSettings->PSDWaveformsToDiscriminate,
+			 (Int_t)ADAQWaveformTree->GetEntries());
     
-    // Set the ADAQWaveformData branch name depending on channel number
-    stringstream SS;
-    SS << "WaveformDataCh" << Channel;
-    string WDName = SS.str();
+    BuildTriggerIndex(0, EntryEnd);
 
-    // Create and set address of ADAQWavefomData object in the waveform tree
-    ADAQWaveformData *WD = new ADAQWaveformData;
+    vector<Int_t> Entries;
+    for(Int_t entry=NextTriggeredEntry(Channel, 0); entry<EntryEnd;
+	entry=NextTriggeredEntry(Channel, entry+1))
+      Entries.push_back(entry);
 
-    // Clone the ADAQWaveformTree for use to prevent TTree memory
-    // modifications that cause seg fault when PSD mode is switched
-    // from waveform data back to other PSD modes
-    TTree *CloneTree = (TTree *)ADAQWaveformTree->Clone("CloneTree");
-    CloneTree->SetBranchAddress(WDName.c_str(), &WD);
+    // Read the stored waveform data of the entries (in parallel)
+    vector<ListModeRecordStruct> Records;
+    Bool_t ReadSuccessful = false;
+    {
+      AAProfileTimer Timer(&Profiler, zProfileRead);
+      ReadSuccessful = ReadWaveformData(Channel, Entries, Records);
+    }
     
-    // Readout appropriate waveform data into the spectrum
-    for(Int_t entry=0; entry<CloneTree->GetEntries(); entry++){
-      
-      // Ensure only the specified number of events are processed
-      if(entry == ADAQSettings->PSDWaveformsToDiscriminate)
-	break;
+    if(!ReadSuccessful){
+      cout << "\nADAQAnalysis error! The stored waveform data could not be read!\n" << endl;
+      PSDHistogramExists = false;
+      return PSDHistogram_H;
+    }
+    
+    Profiler.Count(zCountWaveforms, Records.size());
 
-      // Get the entry
-      CloneTree->GetEntry(entry);
+    PSDHistogramTotalVec[Channel].reserve(Records.size());
+    PSDHistogramTailVec[Channel].reserve(Records.size());
+
+    // Create the list-mode file if the user has enabled it
+    OpenListModeFile();
+
+    // Histogram the waveform data in entry order such that the results
+    // (and list-mode output) are independent of the number of threads
+    for(size_t r=0; r<Records.size(); r++){
       
       // Get the stored total and tail PSD integrals
-      TotalIntegral = WD->GetPSDTotalIntegral();
-      TailIntegral = WD->GetPSDTailIntegral();
+      TotalIntegral = Records[r].PSDTotal;
+      TailIntegral = Records[r].PSDTail;
 
       // ...and also storem them in vectors for later use
       PSDHistogramTotalVec[Channel].push_back(TotalIntegral);
@@ -2163,32 +3435,38 @@ TH2F *AAComputation::ProcessPSDHistogramWaveforms()
       // If the user wants to plot the X-axis (PSD total integral) in
       // energy [MeVee] then use the spectra calibrations
       if(ADAQSettings->PSDXAxisEnergy and UseSpectraCalibrations[Channel]){
+	AAProfileTimer Timer(&Profiler, zProfileCalibration);
 	if(SpectraCalibrationType[Channel] == zCalibrationFit)
 	  TotalIntegral = ADAQSettings->SpectraCalibrations[Channel]->Eval(TotalIntegral);
 	else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
 	  TotalIntegral = ADAQSettings->SpectraCalibrationData[Channel]->Eval(TotalIntegral);
       }
       
+      // If the user has enabled a PSD filter then determine whether
+      // to accept/exclude the event
+      Bool_t PSDReject = false;
+      if(UsePSDRegions[ADAQSettings->WaveformChannel])
+	PSDReject = ApplyPSDRegion(TotalIntegral, TailIntegral);
+
+      // Stream the waveform data to the list-mode file (if enabled)
+      Records[r].PSDFilterFlag = PSDReject;
+      FillListModeRecord(Records[r]);
+      
+      if(PSDReject)
+	Profiler.Count(zCountPSDRejected);
+      
       // Determine if waveform exceeds the PSD threshold
-      if(TotalIntegral > ADAQSettings->PSDThreshold){
-	
-	// If the user has enabled a PSD filter ...
-	if(UsePSDRegions[ADAQSettings->WaveformChannel]){
-	  
-	  // Determine whether to accept/exclude the event
-	  if(!ApplyPSDRegion(TotalIntegral, TailIntegral))
-	    PSDHistogram_H->Fill(TotalIntegral, TailIntegral);
-	}
-	
-	// ... otherwise straight PSD histogramming
-	else
-	  PSDHistogram_H->Fill(TotalIntegral, TailIntegral);
+      if(TotalIntegral > ADAQSettings->PSDThreshold and !PSDReject){
+	AAProfileTimer Timer(&Profiler, zProfileHistogramFill);
+	PSDHistogram_H->Fill(TotalIntegral, TailIntegral);
+	Profiler.Count(zCountHistogramEntries);
       }
     }
 
-    // Memory clean up
-    delete CloneTree;
-    delete WD;
+    // Write and close the list-mode file (if enabled)
+    CloseListModeFile();
+
+    EndProfile();
     
     PSDHistogramExists = true;
   }
@@ -2202,6 +3480,12 @@ TH2F *AAComputation::ProcessPSDHistogramWaveforms()
     // Reboot the PeakFinder with up-to-date max peaks
     if(PeakFinder) delete PeakFinder;
     PeakFinder = new TSpectrum(ADAQSettings->MaxPeaks);
+
+    // Create the list-mode file if the user has enabled it
+    OpenListModeFile();
+
+    // Prepare the average pulse template accumulators (if enabled)
+    BeginPulseTemplates();
     
     // See documention in either ::ProcessSpectrumWaveforms() or
     // ::CreateDesplicedFile for parallel processing assignemnts
@@ -2237,19 +3521,40 @@ TH2F *AAComputation::ProcessPSDHistogramWaveforms()
 #endif
     
     Bool_t PeaksFound = false;
+
+    // Determine whether the waveforms may be processed in fixed point
+    const Bool_t FixedPoint = UseFixedPointProcessing(true);
+
+    BuildTriggerIndex(WaveformStart, WaveformEnd);
     
-    for(Int_t waveform=WaveformStart; waveform<WaveformEnd; waveform++){
+    for(Int_t waveform=NextTriggeredEntry(Channel, WaveformStart); waveform<WaveformEnd;
+	waveform=NextTriggeredEntry(Channel, waveform+1)){
       if(SequentialArchitecture)
 	gSystem->ProcessEvents();
 
-      ADAQWaveformTree->GetEntry(waveform);
+      {
+	AAProfileTimer Timer(&Profiler, zProfileRead);
+	Profiler.Count(zCountBytesRead, ADAQWaveformTree->GetEntry(waveform));
+      }
+      Profiler.Count(zCountWaveforms);
+
+      if(FixedPoint){
+	if(IsMaster)
+	  if((waveform+1) % int(WaveformEnd*ADAQSettings->UpdateFreq*1.0/100) == 0)
+	    UpdateProcessingProgress(waveform);
+	
+	ProcessFixedPointPSDWaveform(waveform, Channel);
+	continue;
+      }
 
       RawVoltage = *Waveforms[Channel];
     
+      AAProfileTimer TransformTimer(&Profiler, zProfileTransform);
       if(ADAQSettings->RawWaveform or ADAQSettings->BSWaveform)
 	CalculateBSWaveform(Channel, waveform);
       else if(ADAQSettings->ZSWaveform)
 	CalculateZSWaveform(Channel, waveform);
+      TransformTimer.Stop();
     
       // Find the peaks and peak limits in the current waveform. The
       // second argument ('true') indicates the find peaks calculation
@@ -2277,14 +3582,23 @@ TH2F *AAComputation::ProcessPSDHistogramWaveforms()
       // peak. Because we want to create a PSD histogram, pass "true" to
       // the function to indicate the results should be histogrammed
       CalculatePSDIntegrals(true);
+
+      // Stream all peaks to the list-mode file (if enabled)
+      FillListModeRecords(waveform, Channel);
     }
   
-    if(SequentialArchitecture){
+    if(SequentialArchitecture and ProcessingProgressBar){
       ProcessingProgressBar->Increment(100);
       ProcessingProgressBar->SetBarColor(ColorManager->Number2Pixel(32));
       ProcessingProgressBar->SetForegroundColor(ColorManager->Number2Pixel(0));
     }
 
+    // Write and close the list-mode file (if enabled)
+    CloseListModeFile();
+
+    // Write the average pulse templates (if enabled)
+    WritePulseTemplates(Channel);
+
 #ifdef MPI_ENABLED
 
     if(ParallelVerbose)
@@ -2442,6 +3756,7 @@ TH2F *AAComputation::ProcessPSDHistogramWaveforms()
       ParallelFile->Write();
     }
 #endif
+    EndProfile();
     
     // Update the bool to alert the code that a valid PSDHistogram_H object exists.
     PSDHistogramExists = true;
@@ -2452,18 +3767,15 @@ TH2F *AAComputation::ProcessPSDHistogramWaveforms()
 
 TH2F *AAComputation::CreatePSDHistogram()
 {
-  if(PSDHistogram_H){
-    delete PSDHistogram_H;
-    PSDHistogramExists = false;
-  }
+  PSDHistogramExists = false;
   
-  PSDHistogram_H = new TH2F("PSDHistogram_H","PSDHistogram_H", 
-			    ADAQSettings->PSDNumTotalBins, 
-			    ADAQSettings->PSDMinTotalBin,
-			    ADAQSettings->PSDMaxTotalBin,
-			    ADAQSettings->PSDNumTailBins,
-			    ADAQSettings->PSDMinTailBin,
-			    ADAQSettings->PSDMaxTailBin);
+  PSDHistogram_H = PrepareHistogram(PSDHistogram_H, "PSDHistogram_H","PSDHistogram_H", 
+				    ADAQSettings->PSDNumTotalBins, 
+				    ADAQSettings->PSDMinTotalBin,
+				    ADAQSettings->PSDMaxTotalBin,
+				    ADAQSettings->PSDNumTailBins,
+				    ADAQSettings->PSDMinTailBin,
+				    ADAQSettings->PSDMaxTailBin);
 
   Int_t Channel = ADAQSettings->WaveformChannel;
 
@@ -2517,6 +3829,152 @@ TH2F *AAComputation::CreatePSDHistogram()
 }
 
 
+// Function object that reads the stored waveform data of a single
+// channel for a contiguous slice of a list of entries. Each reader
+// opens its own TFile and reads only the channel's waveform data
+// branch through its own TTreeCache such that readers share no ROOT
+// objects and may be run concurrently in separate threads, each
+// profiled into its own AAProfiler
+class AAWaveformDataReader
+{
+public:
+  AAWaveformDataReader(string FN, string BN, const vector<Int_t> *E,
+		       size_t F, size_t L, Int_t CS,
+		       vector<ListModeRecordStruct> *R, AAProfiler *P, Int_t *S)
+    : FileName(FN), BranchName(BN), Entries(E), First(F), Last(L),
+      CacheSize(CS), Records(R), Profiler(P), Success(S)
+  {}
+
+  void operator()()
+  {
+    *Success = false;
+    
+    TFile *F = new TFile(FileName.c_str(), "read");
+    TTree *T = (F->IsOpen()) ? (TTree *)F->Get("WaveformTree") : NULL;
+    TBranch *B = (T) ? T->GetBranch(BranchName.c_str()) : NULL;
+    
+    if(B == NULL){
+      delete F;
+      return;
+    }
+    
+    ADAQWaveformData *WD = new ADAQWaveformData;
+    T->SetBranchStatus("*", 0);
+    T->SetBranchStatus(BranchName.c_str(), 1);
+    T->SetBranchAddress(BranchName.c_str(), &WD);
+
+    if(CacheSize > 0 and Last > First){
+      T->SetCacheSize((Long64_t)CacheSize*1024*1024);
+      T->SetCacheEntryRange((*Entries)[First], (*Entries)[Last-1]+1);
+      T->AddBranchToCache(BranchName.c_str(), true);
+      T->StopCacheLearningPhase();
+    }
+
+    ListModeRecordStruct Record;
+    Records->reserve(Last - First);
+    
+    for(size_t e=First; e<Last; e++){
+      {
+	AAProfileTimer Timer(Profiler, zProfileRead);
+	Profiler->Count(zCountBytesRead, B->GetEntry((*Entries)[e]));
+      }
+
+      Record.Entry = (*Entries)[e];
+      Record.PulseHeight = WD->GetPulseHeight();
+      Record.PulseArea = WD->GetPulseArea();
+      Record.PSDTotal = WD->GetPSDTotalIntegral();
+      Record.PSDTail = WD->GetPSDTailIntegral();
+      Record.TimeStamp = WD->GetTimeStamp();
+      Records->push_back(Record);
+    }
+    
+    T->ResetBranchAddresses();
+    delete WD;
+    F->Close();
+    delete F;
+    
+    *Success = true;
+  }
+  
+private:
+  string FileName, BranchName;
+  const vector<Int_t> *Entries;
+  size_t First, Last;
+  Int_t CacheSize;
+  vector<ListModeRecordStruct> *Records;
+  AAProfiler *Profiler;
+  Int_t *Success;
+};
+
+
+// Method to read the stored waveform data of the specified channel at
+// the specified entries into list-mode records (in entry order). The
+// entries are divided into contiguous slices that are read in
+// parallel by independent readers, avoiding both a clone of the
+// entire waveform TTree and any conflict with the branch addresses of
+// ADAQWaveformTree. Threads are only used for large numbers of
+// entries and require ROOT v6 or higher for thread safety
+Bool_t AAComputation::ReadWaveformData(Int_t Channel, const vector<Int_t> &Entries,
+				       vector<ListModeRecordStruct> &Records)
+{
+  stringstream SS;
+  SS << "WaveformDataCh" << Channel;
+  string BranchName = SS.str();
+
+  const size_t MinEntriesPerThread = 50000;
+  
+  Int_t NumThreads = 1;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+  NumThreads = min((size_t)max(1u, boost::thread::hardware_concurrency()),
+		   max((size_t)1, Entries.size()/MinEntriesPerThread));
+  if(NumThreads > 1)
+    ROOT::EnableThreadSafety();
+#endif
+
+  Int_t CacheSize = (ADAQSettings->TreeCacheSize > 0) ? ADAQSettings->TreeCacheSize : 0;
+  
+  vector< vector<ListModeRecordStruct> > ThreadRecords(NumThreads);
+  vector<AAProfiler> ThreadProfilers(NumThreads);
+  vector<Int_t> ThreadSuccess(NumThreads, false);
+
+  boost::thread_group Threads;
+  
+  for(Int_t t=0; t<NumThreads; t++){
+    ThreadProfilers[t].SetEnabled(Profiler.GetEnabled());
+    
+    size_t First = Entries.size()*t/NumThreads;
+    size_t Last = Entries.size()*(t+1)/NumThreads;
+    
+    AAWaveformDataReader Reader(ADAQFileName, BranchName, &Entries, First, Last, CacheSize,
+				&ThreadRecords[t], &ThreadProfilers[t], &ThreadSuccess[t]);
+    
+    if(NumThreads == 1)
+      Reader();
+    else
+      Threads.create_thread(Reader);
+  }
+  
+  Threads.join_all();
+
+  // Merge the slices in order
+  Records.clear();
+  Records.reserve(Entries.size());
+  
+  Bool_t Success = true;
+  for(Int_t t=0; t<NumThreads; t++){
+    Success = Success and ThreadSuccess[t];
+    Records.insert(Records.end(), ThreadRecords[t].begin(), ThreadRecords[t].end());
+  }
+  Profiler.MergeThreads(ThreadProfilers);
+
+  // Each record is identified by the channel whose data it holds
+  for(size_t r=0; r<Records.size(); r++)
+    Records[r].Channel = Channel;
+  
+  return Success;
+}
+
+
 // Method to calculate the "tail" and "total" integrals of each of the
 // peaks located by the peak finding algorithm and stored in the class
 // member vector of PeakInfoStruct. Because calculating these
@@ -2528,6 +3986,8 @@ TH2F *AAComputation::CreatePSDHistogram()
 // function argment boolean to provide flexibility
 void AAComputation::CalculatePSDIntegrals(Bool_t FillPSDHistogram)
 {
+  AAProfileTimer Timer(&Profiler, zProfilePSDIntegrals);
+
   // Get the present channel for analysis
   Int_t Channel = ADAQSettings->WaveformChannel;
   
@@ -2562,20 +4022,7 @@ void AAComputation::CalculatePSDIntegrals(Bool_t FillPSDHistogram)
     PSDHistogramTotalVec[Channel].push_back(TotalIntegral);
     PSDHistogramTailVec[Channel].push_back(TailIntegral);
     
-      // If the user wants to plot (Tail integral / Total integral) on
-    // the y-axis of the PSD histogram then modify the TailIntegral:
-    if(ADAQSettings->PSDYAxisTailTotal)
-      TailIntegral /= TotalIntegral;
-    
-    // If the user wants to plot the X-axis (PSD total integral) in
-    // energy [MeVee] then use the spectra calibrations
-    
-    if(ADAQSettings->PSDXAxisEnergy and ADAQSettings->UseSpectraCalibrations[Channel]){
-      if(SpectraCalibrationType[Channel] == zCalibrationFit)
-	TotalIntegral = ADAQSettings->SpectraCalibrations[Channel]->Eval(TotalIntegral);
-      else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
-	TotalIntegral = ADAQSettings->SpectraCalibrationData[Channel]->Eval(TotalIntegral);
-    }
+    ConvertPSDIntegrals(Channel, TotalIntegral, TailIntegral);
     
     // If the user has enabled a PSD filter ...
     if(ADAQSettings->UsePSDRegions[Channel]){
@@ -2591,9 +4038,40 @@ void AAComputation::CalculatePSDIntegrals(Bool_t FillPSDHistogram)
     // in order to be histogrammed. This allows the user flexibility
     // in eliminating the large numbers of small waveform events.
     if((TotalIntegral > ADAQSettings->PSDThreshold) and FillPSDHistogram){
-      if((*it).PSDFilterFlag == false)
+      if((*it).PSDFilterFlag == false){
 	PSDHistogram_H->Fill(TotalIntegral, TailIntegral);
+	Profiler.Count(zCountHistogramEntries);
+      }
     }
+
+    // Add single (not piled-up) pulses above the PSD threshold,
+    // aligned on their time if available, to the average pulse
+    // templates (if enabled) using the PSD total integral axis as the
+    // template window
+    if((TotalIntegral > ADAQSettings->PSDThreshold) and FillPSDHistogram and
+       ADAQSettings->BuildPulseTemplates and !(*it).PileupFlag)
+      AccumulatePulseTemplate(Waveform_H[Channel], ((*it).PeakTime >= 0.) ? (*it).PeakTime : Peak,
+			      (*it).PeakPosY, TotalIntegral, (*it).PSDFilterFlag);
+  }
+}
+
+
+// Method to convert the PSD integrals into the quantities of the PSD
+// histogram axes
+void AAComputation::ConvertPSDIntegrals(Int_t Channel, Double_t &TotalIntegral, Double_t &TailIntegral)
+{
+  // If the user wants to plot (Tail integral / Total integral) on
+  // the y-axis of the PSD histogram then modify the TailIntegral:
+  if(ADAQSettings->PSDYAxisTailTotal)
+    TailIntegral /= TotalIntegral;
+  
+  // If the user wants to plot the X-axis (PSD total integral) in
+  // energy [MeVee] then use the spectra calibrations
+  if(ADAQSettings->PSDXAxisEnergy and ADAQSettings->UseSpectraCalibrations[Channel]){
+    if(SpectraCalibrationType[Channel] == zCalibrationFit)
+      TotalIntegral = ADAQSettings->SpectraCalibrations[Channel]->Eval(TotalIntegral);
+    else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
+      TotalIntegral = ADAQSettings->SpectraCalibrationData[Channel]->Eval(TotalIntegral);
   }
 }
 
@@ -2698,11 +4176,11 @@ TGraph *AAComputation::CalculateSpectrumDerivative()
   // subtract off the vertical offset used for plotting to ensure the
   // derivative is vertically centered at zero.
   
-  if(SpectrumDerivative_H) delete SpectrumDerivative_H;
-  SpectrumDerivative_H = new TH1F("SpectrumDerivative_H","SpectrumDerivative_H", 
-				  ADAQSettings->SpectrumNumBins, 
-				  ADAQSettings->SpectrumMinBin, 
-				  ADAQSettings->SpectrumMaxBin);
+  SpectrumDerivative_H = PrepareHistogram(SpectrumDerivative_H,
+					  "SpectrumDerivative_H","SpectrumDerivative_H", 
+					  ADAQSettings->SpectrumNumBins, 
+					  ADAQSettings->SpectrumMinBin, 
+					  ADAQSettings->SpectrumMaxBin);
     
   double x,y;
   for(int bin=0; bin<ADAQSettings->SpectrumNumBins; bin++){
@@ -2788,6 +4266,8 @@ void AAComputation::ProcessWaveformsInParallel(string ProcessingType)
 
       Spectrum_H = (TH1F *)ParallelFile->Get("MasterHistogram");
       SpectrumExists = true;
+      SpectrumRevision++;
+      ProcessedSpectrumChannel = -1;
 
       // Retrieve the master TVectorT<double> objects that contain the
       // pulse height and areas computed by all MPI nodes and use them
@@ -2851,39 +4331,483 @@ void AAComputation::ProcessWaveformsInParallel(string ProcessingType)
     cout << "Removing depracated parallel processing files!\n"
 	 << endl;
   
-  // Remove the parallel processing ROOT file since it is no longer
-  // needed now that we have extracted all the results produced by the
-  // parallel processing session and stored them in the seq. binary
+  // Remove the parallel processing ROOT file since it is no longer
+  // needed now that we have extracted all the results produced by the
+  // parallel processing session and stored them in the seq. binary
+  
+  string RemoveFilesCommand;
+  RemoveFilesCommand = "rm " + FileName + " -f";
+  system(RemoveFilesCommand.c_str()); 
+}
+
+
+// Method to create the list-mode TFile and TTree into which
+// per-pulse records are streamed during waveform processing. Each
+// member of the ListModeRecordStruct is assigned to its own branch to
+// produce a compact columnar TTree; baskets are flushed to disk by
+// ROOT as they fill such that memory usage remains constant
+// regardless of the number of pulses processed. In sequential
+// architecture the TFile is created directly with the name specified
+// by the user; in parallel architecture, each node writes to its own
+// TFile in /tmp with the suffix ".node<MPI_Rank>", which are then
+// merged by the master in AAComputation::CloseListModeFile()
+Bool_t AAComputation::OpenListModeFile()
+{
+  ListModeActive = false;
+  
+  if(!ADAQSettings->ListModeOutput)
+    return false;
+
+  string ListModeFileName = ADAQSettings->ListModeFileName;
+  
+  if(ParallelArchitecture){
+    stringstream SS;
+    SS << "/tmp/ADAQListMode_" << getenv("USER") << ".root.node" << MPI_Rank;
+    ListModeFileName = SS.str();
+  }
+
+  // Store the present ROOT directory so that it may be restored after
+  // the list-mode TFile is created; otherwise, all waveform
+  // histograms created during processing would be attached to (and
+  // deleted with) the list-mode TFile
+  TDirectory *PreviousDirectory = gDirectory;
+  
+  ListModeFile = new TFile(ListModeFileName.c_str(), "recreate");
+  
+  if(!ListModeFile->IsOpen()){
+    cout << "\nADAQAnalysis error! The list-mode file '" << ListModeFileName << "' could not be created!\n"
+	 << endl;
+    
+    delete ListModeFile;
+    ListModeFile = 0;
+    
+    PreviousDirectory->cd();
+    return false;
+  }
+  
+  ListModeTree = new TTree("ListModeTree", "Per-pulse features from ADAQAnalysis waveform processing");
+  ListModeTree->Branch("Entry", &ListModeRecord.Entry, "Entry/I");
+  ListModeTree->Branch("Channel", &ListModeRecord.Channel, "Channel/I");
+  ListModeTree->Branch("PeakPosX", &ListModeRecord.PeakPosX, "PeakPosX/D");
+  ListModeTree->Branch("PulseHeight", &ListModeRecord.PulseHeight, "PulseHeight/D");
+  ListModeTree->Branch("PulseArea", &ListModeRecord.PulseArea, "PulseArea/D");
+  ListModeTree->Branch("PSDTotal", &ListModeRecord.PSDTotal, "PSDTotal/D");
+  ListModeTree->Branch("PSDTail", &ListModeRecord.PSDTail, "PSDTail/D");
+  ListModeTree->Branch("PileupFlag", &ListModeRecord.PileupFlag, "PileupFlag/O");
+  ListModeTree->Branch("PSDFilterFlag", &ListModeRecord.PSDFilterFlag, "PSDFilterFlag/O");
+  ListModeTree->Branch("TimeStamp", &ListModeRecord.TimeStamp, "TimeStamp/D");
+  ListModeTree->Branch("PeakTime", &ListModeRecord.PeakTime, "PeakTime/D");
+  
+  PreviousDirectory->cd();
+
+  ListModeActive = true;
+  
+  return true;
+}
+
+
+// Method to write a single list-mode record for a pulse that was
+// obtained by processing the waveform presently stored in
+// Waveform_H. The PSD integrals are always calculated about the
+// peak position with the present PSD integration limits so that
+// they are available downstream even if PSD filtering is unused
+void AAComputation::FillListModeRecord(Int_t Entry, Int_t Channel, Double_t PeakPosX,
+				       Double_t PulseHeight, Double_t PulseArea,
+				       Bool_t PileupFlag, Bool_t PSDFilterFlag,
+				       Double_t PeakTime)
+{
+  if(!ListModeActive)
+    return;
+
+  AAProfileTimer Timer(&Profiler, zProfileOutput);
+
+  ListModeRecord.Entry = Entry;
+  ListModeRecord.Channel = Channel;
+  ListModeRecord.PeakPosX = PeakPosX;
+  ListModeRecord.PulseHeight = PulseHeight;
+  ListModeRecord.PulseArea = PulseArea;
+  
+  ListModeRecord.PSDTotal = Waveform_H[Channel]->Integral(PeakPosX + ADAQSettings->PSDTotalStart,
+							  PeakPosX + ADAQSettings->PSDTotalStop);
+  ListModeRecord.PSDTail = Waveform_H[Channel]->Integral(PeakPosX + ADAQSettings->PSDTailStart,
+							 PeakPosX + ADAQSettings->PSDTailStop);
+  
+  ListModeRecord.PileupFlag = PileupFlag;
+  ListModeRecord.PSDFilterFlag = PSDFilterFlag;
+
+  // Trigger time stamps are only available in production ADAQ files
+  if(ADAQLegacyFileLoaded)
+    ListModeRecord.TimeStamp = -1.;
+  else
+    ListModeRecord.TimeStamp = WaveformData[Channel]->GetTimeStamp();
+
+  ListModeRecord.PeakTime = PeakTime;
+  
+  ListModeTree->Fill();
+}
+
+
+// Method to stream a complete list-mode record (e.g. one assembled
+// from stored waveform data) to the list-mode file
+void AAComputation::FillListModeRecord(const ListModeRecordStruct &Record)
+{
+  if(!ListModeActive)
+    return;
+
+  AAProfileTimer Timer(&Profiler, zProfileOutput);
+
+  ListModeRecord = Record;
+  ListModeTree->Fill();
+}
+
+
+// Method to write a single list-mode record for a pulse from the
+// waveform data that was calculated and stored during acquisition
+void AAComputation::FillListModeRecord(Int_t Entry, Int_t Channel,
+				       ADAQWaveformData *WD, Bool_t PSDFilterFlag)
+{
+  if(!ListModeActive)
+    return;
+
+  AAProfileTimer Timer(&Profiler, zProfileOutput);
+  
+  ListModeRecord.Entry = Entry;
+  ListModeRecord.Channel = Channel;
+  ListModeRecord.PeakPosX = -1;
+  ListModeRecord.PulseHeight = WD->GetPulseHeight();
+  ListModeRecord.PulseArea = WD->GetPulseArea();
+  ListModeRecord.PSDTotal = WD->GetPSDTotalIntegral();
+  ListModeRecord.PSDTail = WD->GetPSDTailIntegral();
+  ListModeRecord.PileupFlag = false;
+  ListModeRecord.PSDFilterFlag = PSDFilterFlag;
+  ListModeRecord.TimeStamp = WD->GetTimeStamp();
+  ListModeRecord.PeakTime = -1.;
+  
+  ListModeTree->Fill();
+}
+
+
+// Method to write list-mode records for all peaks found by the peak
+// finding algorithm in the current waveform. Every peak within the
+// waveform analysis region is written -- including those flagged as
+// pileup or failing the PSD region -- such that downstream tools may
+// apply their own selection using the stored flags
+void AAComputation::FillListModeRecords(Int_t Entry, Int_t Channel)
+{
+  if(!ListModeActive)
+    return;
+  
+  vector<PeakInfoStruct>::iterator it;
+  for(it=PeakInfoVec.begin(); it!=PeakInfoVec.end(); it++){
+    
+    if((*it).PeakPosX < ADAQSettings->AnalysisRegionMin or
+       (*it).PeakPosX > ADAQSettings->AnalysisRegionMax)
+      continue;
+    
+    // Peaks found with the "whole waveform" algorithm have no peak
+    // limits so the waveform analysis region is used instead
+    Int_t Lower = (*it).PeakLimit_Lower;
+    Int_t Upper = (*it).PeakLimit_Upper;
+    if(Lower < 0 or Upper < 0){
+      Lower = ADAQSettings->AnalysisRegionMin;
+      Upper = ADAQSettings->AnalysisRegionMax;
+    }
+    
+    Double_t PeakHeight = 0., PeakArea = 0.;
+    MeasurePeak(Waveform_H[Channel], *it, Lower, Upper, PeakHeight, PeakArea);
+    
+    FillListModeRecord(Entry, Channel, (*it).PeakPosX, PeakHeight, PeakArea,
+		       (*it).PileupFlag, (*it).PSDFilterFlag, (*it).PeakTime);
+  }
+}
+
+
+// Method to write the list-mode TTree to disk and close the
+// list-mode TFile. In parallel architecture, the master uses a
+// TChain to merge the TTrees from each node's TFile into a single
+// list-mode TFile with the name specified by the user
+void AAComputation::CloseListModeFile()
+{
+  if(!ListModeActive)
+    return;
+
+  AAProfileTimer Timer(&Profiler, zProfileOutput);
+
+  TDirectory *PreviousDirectory = gDirectory;
+  
+  ListModeFile->cd();
+  ListModeTree->Write();
+  ListModeFile->Close();
+  
+  delete ListModeFile;
+  ListModeFile = 0;
+  ListModeTree = 0;
+  
+  ListModeActive = false;
+
+  PreviousDirectory->cd();
+
+#ifdef MPI_ENABLED
+
+  // Ensure all nodes have closed their list-mode TFiles
+  MPI::COMM_WORLD.Barrier();
+  
+  if(IsMaster){
+    
+    if(ParallelVerbose)
+      cout << "\nADAQAnalysis_MPI Node[0] : Aggregating list-mode TFiles into a single TFile!"
+	   << endl;
+    
+    string USER = getenv("USER");
+    
+    TChain *ListModeChain = new TChain("ListModeTree");
+    
+    for(Int_t node=0; node<MPI_Size; node++){
+      stringstream SS;
+      SS << "/tmp/ADAQListMode_" << USER << ".root.node" << node;
+      ListModeChain->Add(SS.str().c_str());
+    }
+    
+    ListModeChain->Merge(ADAQSettings->ListModeFileName.c_str());
+    delete ListModeChain;
+
+    // Remove the now-depracated node list-mode TFiles
+    string RemoveFilesCommand = "rm /tmp/ADAQListMode_" + USER + ".root.node* -f";
+    system(RemoveFilesCommand.c_str());
+
+    PreviousDirectory->cd();
+  }
+#endif
+}
+
+
+void AAComputation::RejectPileup(TH1F *Histogram_H)
+{
+  vector<PeakInfoStruct>::iterator it1, it2;
+
+  for(it1=PeakInfoVec.begin(); it1!=PeakInfoVec.end(); it1++){
+    
+    int PileupCounter = 0;
+    vector<bool> PileupRejection(false, PeakLimits.size());
+    
+    for(it2=PeakInfoVec.begin(); it2!=PeakInfoVec.end(); it2++){
+      
+      if((*it1).PeakLimit_Lower == (*it2).PeakLimit_Lower){
+	PileupRejection[it2 - PeakInfoVec.begin()] = true;
+	PileupCounter++;
+      }
+      else
+	PileupRejection[it2 - PeakInfoVec.begin()] = false;
+    }
+    
+    if(PileupCounter != 1)
+      (*it1).PileupFlag = true;
+
+  }
+}
+
+
+// Method to recover the individual pulses of pileup events by fitting
+// the channel's pulse template to each group of peaks that share the
+// same rising floor crossing (i.e. the peaks flagged by
+// RejectPileup). The fit region extends from the group's lower peak
+// limit to the largest upper peak limit in the group. Peaks with a
+// positive fitted height are assigned the fitted height and the area
+// of the fitted template within their own peak limits;
+// peaks whose group cannot be separated remain flagged as pileup
+void AAComputation::RecoverPileup(TH1F *Histogram_H, Int_t Channel)
+{
+  AAProfileTimer Timer(&Profiler, zProfilePileupFit);
+
+  AAPileupFitter &Fitter = PileupFitters[Channel];
+  
+  // Stream over the bin array, in which the index is the bin number
+  const Float_t *X = Histogram_H->GetArray();
+  const Int_t LastBin = Histogram_H->GetNbinsX();
+  
+  const Int_t NumPeakInfo = PeakInfoVec.size();
+  vector<Bool_t> Grouped(NumPeakInfo, false);
+  
+  vector<Int_t> Group;
+  vector<Double_t> Positions, Heights;
+  
+  for(Int_t peak=0; peak<NumPeakInfo; peak++){
+    
+    if(!PeakInfoVec[peak].PileupFlag or Grouped[peak] or
+       PeakInfoVec[peak].PeakLimit_Lower < 0)
+      continue;
+    
+    Group.clear();
+    Positions.clear();
+    
+    Int_t Min = PeakInfoVec[peak].PeakLimit_Lower;
+    Int_t Max = PeakInfoVec[peak].PeakLimit_Upper;
+    
+    for(Int_t p=peak; p<NumPeakInfo; p++){
+      if(PeakInfoVec[p].PeakLimit_Lower != PeakInfoVec[peak].PeakLimit_Lower)
+	continue;
+      
+      Group.push_back(p);
+      Positions.push_back(PeakInfoVec[p].PeakPosX);
+      Grouped[p] = true;
+      
+      if(PeakInfoVec[p].PeakLimit_Upper > Max)
+	Max = PeakInfoVec[p].PeakLimit_Upper;
+    }
+    
+    if(Max > LastBin)
+      Max = LastBin;
+    
+    if(!Fitter.Fit(X, Min, Max, Positions, Heights))
+      continue;
+    
+    for(Int_t g=0; g<(Int_t)Group.size(); g++){
+      if(Heights[g] <= 0.)
+	continue;
+      
+      // The fitted area is the fitted template integrated over the
+      // same peak limits as the integral of an unfitted peak
+      PeakInfoStruct &Peak = PeakInfoVec[Group[g]];
+      Int_t Upper = (Peak.PeakLimit_Upper > LastBin) ? LastBin : Peak.PeakLimit_Upper;
+      
+      Peak.FitHeight = Heights[g];
+      Peak.FitArea = Heights[g]*Fitter.Integrate(Positions[g], Peak.PeakLimit_Lower, Upper);
+      Profiler.Count(zCountRecoveredPeaks);
+    }
+  }
+}
+
+
+// Method to load the per-channel average pulse templates used for
+// pileup recovery from a ROOT file containing one histogram named
+// "PulseTemplate_Ch<N>" for each channel with a template. The
+// templates are only re-read when a different file is specified or
+// the file has been modified since it was loaded
+Bool_t AAComputation::LoadPulseTemplates(string FileName)
+{
+  FileStat_t FileStat;
+  Long_t FileTime = 0;
+  if(gSystem->GetPathInfo(FileName.c_str(), FileStat) == 0)
+    FileTime = FileStat.fMtime;
+  
+  if(FileName == PulseTemplateFileName and FileTime == PulseTemplateFileTime)
+    return true;
+  
+  PulseTemplateFileName = "";
+  for(Int_t ch=0; ch<MAX_DG_CHANNELS; ch++)
+    PileupFitters[ch].ClearTemplate();
+  
+  TDirectory *PreviousDirectory = gDirectory;
+  
+  TFile *TemplateFile = new TFile(FileName.c_str(), "read");
+  
+  if(!TemplateFile->IsOpen()){
+    cout << "\nADAQAnalysis error! The pulse template file '" << FileName << "' could not be opened!\n"
+	 << endl;
+    
+    delete TemplateFile;
+    PreviousDirectory->cd();
+    return false;
+  }
+  
+  Int_t NumTemplates = 0;
+  
+  for(Int_t ch=0; ch<MAX_DG_CHANNELS; ch++){
+    stringstream SS;
+    SS << "PulseTemplate_Ch" << ch;
+    
+    TH1 *Template_H = dynamic_cast<TH1 *>(TemplateFile->Get(SS.str().c_str()));
+    if(!Template_H)
+      continue;
+    
+    vector<Double_t> Samples(Template_H->GetNbinsX());
+    for(Int_t bin=1; bin<=Template_H->GetNbinsX(); bin++)
+      Samples[bin-1] = Template_H->GetBinContent(bin);
+    
+    if(PileupFitters[ch].SetTemplate(&Samples[0], Samples.size()))
+      NumTemplates++;
+  }
+  
+  TemplateFile->Close();
+  delete TemplateFile;
+  PreviousDirectory->cd();
+  
+  if(NumTemplates == 0){
+    cout << "\nADAQAnalysis error! The file '" << FileName << "' contains no valid pulse templates!\n"
+	 << endl;
+    return false;
+  }
+  
+  PulseTemplateFileName = FileName;
+  PulseTemplateFileTime = FileTime;
   
-  string RemoveFilesCommand;
-  RemoveFilesCommand = "rm " + FileName + " -f";
-  system(RemoveFilesCommand.c_str()); 
+  return true;
 }
 
 
-void AAComputation::RejectPileup(TH1F *Histogram_H)
+// Method to prepare the average pulse template accumulators at the
+// start of waveform processing
+void AAComputation::BeginPulseTemplates()
 {
-  vector<PeakInfoStruct>::iterator it1, it2;
+  if(!ADAQSettings->BuildPulseTemplates)
+    return;
+  
+  TemplateBuilder.Configure(ADAQSettings->TemplatePreSamples,
+			    ADAQSettings->TemplatePostSamples);
+}
 
-  for(it1=PeakInfoVec.begin(); it1!=PeakInfoVec.end(); it1++){
-    
-    int PileupCounter = 0;
-    vector<bool> PileupRejection(false, PeakLimits.size());
-    
-    for(it2=PeakInfoVec.begin(); it2!=PeakInfoVec.end(); it2++){
-      
-      if((*it1).PeakLimit_Lower == (*it2).PeakLimit_Lower){
-	PileupRejection[it2 - PeakInfoVec.begin()] = true;
-	PileupCounter++;
-      }
-      else
-	PileupRejection[it2 - PeakInfoVec.begin()] = false;
-    }
-    
-    if(PileupCounter != 1)
-      (*it1).PileupFlag = true;
 
-  }
+// Method to add a single pulse, aligned at the specified (fractional)
+// sample, to the average pulse templates if its energy (in units of
+// the spectrum or PSD total integral axis) is within the template
+// window. Rejected pulses are those that fail the PSD region
+void AAComputation::AccumulatePulseTemplate(TH1F *Histogram_H, Double_t Position,
+					    Double_t Height, Double_t Energy,
+					    Bool_t Rejected)
+{
+  if(Energy < ADAQSettings->TemplateWindowMin or
+     Energy > ADAQSettings->TemplateWindowMax)
+    return;
+  
+  AAProfileTimer Timer(&Profiler, zProfileTemplates);
+  
+  // Stream over the bin array, in which the index is the bin number
+  if(TemplateBuilder.Accumulate((Rejected ?
+				 AAPulseTemplateBuilder::zRejectedPulses :
+				 AAPulseTemplateBuilder::zAcceptedPulses),
+				Histogram_H->GetArray(), Histogram_H->GetNbinsX()+1,
+				Position, Height))
+    Profiler.Count(zCountTemplatePulses);
+}
+
+
+// Method to write the average pulse templates at the end of waveform
+// processing. In parallel architecture the accumulators of all nodes
+// are summed to the master, which alone writes the templates
+void AAComputation::WritePulseTemplates(Int_t Channel)
+{
+  if(!ADAQSettings->BuildPulseTemplates)
+    return;
+  
+#ifdef MPI_ENABLED
+  vector<Double_t> &State = TemplateBuilder.GetState();
+  Double_t *MasterState = AAParallel::GetInstance()->SumDoubleArrayToMaster(&State[0], State.size());
+  if(IsMaster)
+    State.assign(MasterState, MasterState + State.size());
+  delete [] MasterState;
+#endif
+  
+  if(!IsMaster)
+    return;
+  
+  AAProfileTimer Timer(&Profiler, zProfileOutput);
+  
+  TemplateBuilder.Write(ADAQSettings->PulseTemplateOutputFileName, Channel);
+
+  // Overwriting the loaded template file invalidates the templates
+  // even if the modification time is unchanged at 1 s resolution
+  if(ADAQSettings->PulseTemplateOutputFileName == PulseTemplateFileName)
+    PulseTemplateFileName = "";
 }
 
 
@@ -3002,14 +4926,17 @@ Bool_t AAComputation::WriteCalibrationFile(Int_t Channel,
   if(!UseSpectraCalibrations[Channel])
     return false;
   else{
-    ofstream Out(FName.c_str(), ofstream::trunc);
-    for(UInt_t ch=0; ch<CalibrationData[Channel].PointID.size(); ch++)
-      Out << setw(10) << CalibrationData[Channel].Energy[ch]
-	  << setw(10) << CalibrationData[Channel].PulseUnit[ch]
-	  << endl;
-    Out.close();
+    AABufferedWriter Out(FName);
+    if(!Out.IsOpen())
+      return false;
+    
+    for(UInt_t ch=0; ch<CalibrationData[Channel].PointID.size(); ch++){
+      Out.Write(CalibrationData[Channel].Energy[ch], 10);
+      Out.Write(CalibrationData[Channel].PulseUnit[ch], 10);
+      Out.Write('\n');
+    }
     
-    return true;
+    return Out.Close();
   }
 }
 
@@ -3130,7 +5057,7 @@ void AAComputation::CreateDesplicedFile()
   
   // Reset the progres bar if binary is sequential architecture
   
-  if(SequentialArchitecture){
+  if(SequentialArchitecture and ProcessingProgressBar){
     ProcessingProgressBar->Reset();
     ProcessingProgressBar->SetBarColor(ColorManager->Number2Pixel(33));
     ProcessingProgressBar->SetForegroundColor(ColorManager->Number2Pixel(1));
@@ -3139,6 +5066,8 @@ void AAComputation::CreateDesplicedFile()
   
   if(PeakFinder) delete PeakFinder;
   PeakFinder = new TSpectrum(ADAQSettings->MaxPeaks);
+
+  BeginProfile("Despliced file");
   
   ////////////////////////////////////
   // Assign waveform processing ranges
@@ -3248,9 +5177,12 @@ void AAComputation::CreateDesplicedFile()
   // associated with the despliced waveform TFile must be sufficiently
   // long to accomodate the longest despliced waveform. This new
   // RecordLength value is mainly updated to allow viewing of the
-  // waveform by ADAQAnalysisGUI during future analysis sessions.
+  // waveform by ADAQAnalysisGUI during future analysis sessions. Note
+  // that production ADAQ files do not contain an ADAQRootMeasParams
+  // object and so there is nothing to update or write in that case
   ADAQRootMeasParams *MP = ADAQMeasParams;
-  MP->RecordLength = ADAQSettings->DesplicedWaveformLength;
+  if(MP)
+    MP->RecordLength = ADAQSettings->DesplicedWaveformLength;
   
   // Create a new TObjString object representing the measurement
   // commend. This feature is currently unimplemented.
@@ -3279,8 +5211,11 @@ void AAComputation::CreateDesplicedFile()
   bool PeaksFound = false;
 
   int Channel = ADAQSettings->WaveformChannel;
+
+  BuildTriggerIndex(WaveformStart, WaveformEnd);
   
-  for(int waveform=WaveformStart; waveform<WaveformEnd; waveform++){
+  for(int waveform=NextTriggeredEntry(Channel, WaveformStart); waveform<WaveformEnd;
+      waveform=NextTriggeredEntry(Channel, waveform+1)){
 
     // Run sequential desplicing in a separate thread to allow full
     // control of the ADAQAnalysisGUI while processing
@@ -3291,16 +5226,22 @@ void AAComputation::CreateDesplicedFile()
     // Calculate the Waveform_H member object
     
     // Get a set of data channal voltages from the TTree
-    ADAQWaveformTree->GetEntry(waveform);
+    {
+      AAProfileTimer Timer(&Profiler, zProfileRead);
+      Profiler.Count(zCountBytesRead, ADAQWaveformTree->GetEntry(waveform));
+    }
+    Profiler.Count(zCountWaveforms);
 
     // Assign the current data channel's voltage to RawVoltage
     RawVoltage = *Waveforms[Channel];
 
     // Select the type of Waveform_H object to create
+    AAProfileTimer TransformTimer(&Profiler, zProfileTransform);
     if(ADAQSettings->RawWaveform or ADAQSettings->BSWaveform)
       CalculateBSWaveform(Channel, waveform);
     else if(ADAQSettings->ZSWaveform)
       CalculateZSWaveform(Channel, waveform);
+    TransformTimer.Stop();
     
 
     ///////////////////////////
@@ -3367,8 +5308,14 @@ void AAComputation::CreateDesplicedFile()
       // Fill the TTree with this despliced waveform provided that the
       // current peak is not flagged as a piled up pulse nor flagged
       // as a pulse to be filtered out by pulse shape
-      if((*peak_iter).PileupFlag == false and (*peak_iter).PSDFilterFlag == false)
+      if((*peak_iter).PileupFlag == false and (*peak_iter).PSDFilterFlag == false){
+	AAProfileTimer Timer(&Profiler, zProfileOutput);
 	T->Fill();
+      }
+      else if((*peak_iter).PileupFlag)
+	Profiler.Count(zCountPileupPeaks);
+      else
+	Profiler.Count(zCountPSDRejected);
     }
     
     // Update the user with progress
@@ -3379,7 +5326,7 @@ void AAComputation::CreateDesplicedFile()
   
   // Make final updates to the progress bar, ensuring that it reaches
   // 100% and changes color to acknoqledge that processing is complete
-  if(SequentialArchitecture){
+  if(SequentialArchitecture and ProcessingProgressBar){
     ProcessingProgressBar->Increment(100);
     ProcessingProgressBar->SetBarColor(ColorManager->Number2Pixel(32));
     ProcessingProgressBar->SetForegroundColor(ColorManager->Number2Pixel(0));
@@ -3413,11 +5360,14 @@ void AAComputation::CreateDesplicedFile()
   // /tmp directory for later aggregation; in sequential architecture,
   // the final despliced ROOT will be created with the specified fle
   // name and file path
+  AAProfileTimer OutputTimer(&Profiler, zProfileOutput);
   T->Write();
-  MP->Write("MeasParams");
+  if(MP)
+    MP->Write("MeasParams");
   MC->Write("MeasComment");
   PR->Write("ParResults");
   F->Close();
+  OutputTimer.Stop();
 
   // Switch back to the ADAQFile TFile directory
   ADAQFile->cd();
@@ -3467,7 +5417,8 @@ void AAComputation::CreateDesplicedFile()
     // Open the final despliced TFile, write the measurement
     // parameters and comment objects to it, and close the TFile.
     TFile *F_Final = new TFile(ADAQSettings->DesplicedFileName.c_str(), "update");
-    MP->Write("MeasParams");
+    if(MP)
+      MP->Write("MeasParams");
     MC->Write("MeasComment");
     PR->Write("ParResults");
     F_Final->Close();
@@ -3479,6 +5430,8 @@ void AAComputation::CreateDesplicedFile()
 	 << endl;  
   }
 #endif
+
+  EndProfile();
 }
 
 
@@ -3628,64 +5581,366 @@ void AAComputation::CreatePSDHistogramSlice(int XPixel, int YPixel)
 }
 
 
-void AAComputation::CreateASIMSpectrum()
+// Class that applies the spectra calibration of a channel to batches
+// of quantities, e.g. ASIM spectrum quantities or stored pulse
+// heights. Fit calibrations are evaluated with the fit parameters
+// fetched once per batch; interpolation calibrations use sorted
+// copies of the calibration points with the same linear interpolation
+// (and extrapolation) as TGraph::Eval(). Since TF1 evaluation is not
+// thread safe each thread requires its own TF1
+class AABatchCalibrator
+{
+public:
+  AABatchCalibrator() : Fit(NULL) {}
+  
+  void SetFit(TF1 *F) { Fit = F; }
+  
+  void SetInterp(TGraph *G)
+  {
+    vector< pair<Double_t, Double_t> > Points;
+    for(Int_t p=0; p<G->GetN(); p++)
+      Points.push_back(make_pair(G->GetX()[p], G->GetY()[p]));
+    sort(Points.begin(), Points.end());
+    
+    X.clear();
+    Y.clear();
+    for(size_t p=0; p<Points.size(); p++){
+      X.push_back(Points[p].first);
+      Y.push_back(Points[p].second);
+    }
+  }
+  
+  void Apply(Double_t *Values, size_t N) const
+  {
+    if(Fit){
+      const Double_t *Params = Fit->GetParameters();
+      for(size_t v=0; v<N; v++)
+	Values[v] = Fit->EvalPar(&Values[v], Params);
+    }
+    else if(X.size() == 1){
+      for(size_t v=0; v<N; v++)
+	Values[v] = Y[0];
+    }
+    else if(X.size() > 1){
+      for(size_t v=0; v<N; v++){
+	Int_t Low = (upper_bound(X.begin(), X.end(), Values[v]) - X.begin()) - 1;
+	if(Low < 0)
+	  Low = 0;
+	if(X[Low] == Values[v]){
+	  Values[v] = Y[Low];
+	  continue;
+	}
+	if(Low == (Int_t)X.size()-1)
+	  Low--;
+	
+	Values[v] = Y[Low] + (Values[v] - X[Low])*(Y[Low+1] - Y[Low])/(X[Low+1] - X[Low]);
+      }
+    }
+  }
+  
+private:
+  TF1 *Fit;
+  vector<Double_t> X, Y;
+};
+
+
+// Function object that histograms one or more ASIMEvent data members
+// for a contiguous range of entries of an ASIM event TTree. Each
+// reader opens its own TFile and fills its own histograms such that
+// readers share no ROOT objects and may be run concurrently in
+// separate threads, each profiled into its own AAProfiler. When the
+// ASIMEvent branch is split only the
+// sub-branches of the requested data members are read. Quantities are
+// calibrated, thresholded and histogrammed in batches
+class AAASIMEventReader
+{
+public:
+  AAASIMEventReader(string FN, string TN, vector<Int_t> Q, vector<TH1F *> H,
+		    Long64_t F, Long64_t L, Int_t CS, AABatchCalibrator C,
+		    Double_t Min, Double_t Max, AAProfiler *P, Int_t *S)
+    : FileName(FN), TreeName(TN), Quantities(Q), Spectra(H), First(F), Last(L),
+      CacheSize(CS), Calibrator(C), MinThresh(Min), MaxThresh(Max),
+      Profiler(P), Success(S)
+  {}
+  
+  void operator()()
+  {
+    *Success = false;
+    
+    TFile *F = new TFile(FileName.c_str(), "read");
+    TTree *T = (F->IsOpen()) ? (TTree *)F->Get(TreeName.c_str()) : NULL;
+    
+    if(T == NULL or T->GetBranch("ASIMEventBranch") == NULL){
+      delete F;
+      return;
+    }
+    
+    const char *MemberPattern[zNumASIMQuantities] = {"*EnergyDep*",
+						     "*PhotonsCreated*",
+						     "*PhotonsDetected*"};
+    
+    // Disable all branches except those of the data members; if the
+    // ASIMEvent branch is not split the entire object must be read
+    T->SetBranchStatus("*", 0);
+    for(size_t q=0; q<Quantities.size(); q++){
+      UInt_t Found = 0;
+      T->SetBranchStatus(MemberPattern[Quantities[q]], 1, &Found);
+      if(Found == 0){
+	T->SetBranchStatus("*", 1);
+	break;
+      }
+    }
+    
+    ASIMEvent *Evt = new ASIMEvent;
+    T->SetBranchAddress("ASIMEventBranch", &Evt);
+    
+    // The cache learns the enabled branches from the first entries
+    if(CacheSize > 0 and Last > First){
+      T->SetCacheSize((Long64_t)CacheSize*1024*1024);
+      T->SetCacheEntryRange(First, Last);
+    }
+    
+    const size_t BatchSize = 4096;
+    
+    vector< vector<Double_t> > Batches(Quantities.size());
+    for(size_t q=0; q<Quantities.size(); q++)
+      Batches[q].reserve(BatchSize);
+    
+    for(Long64_t e=First; e<Last; e++){
+      {
+	AAProfileTimer Timer(Profiler, zProfileRead);
+	Profiler->Count(zCountBytesRead, T->GetEntry(e));
+      }
+      
+      Profiler->Count(zCountWaveforms);
+      
+      for(size_t q=0; q<Quantities.size(); q++){
+	if(Quantities[q] == zASIMEnergyDep)
+	  Batches[q].push_back(Evt->GetEnergyDep());
+	else if(Quantities[q] == zASIMPhotonsCreated)
+	  Batches[q].push_back(Evt->GetPhotonsCreated());
+	else
+	  Batches[q].push_back(Evt->GetPhotonsDetected());
+      }
+      
+      if(Batches[0].size() == BatchSize or e == Last-1)
+	for(size_t q=0; q<Quantities.size(); q++)
+	  FillBatch(Batches[q], Spectra[q]);
+    }
+    
+    T->ResetBranchAddresses();
+    delete Evt;
+    F->Close();
+    delete F;
+    
+    *Success = true;
+  }
+  
+private:
+  void FillBatch(vector<Double_t> &Batch, TH1F *Spectrum_H)
+  {
+    if(Batch.empty())
+      return;
+    
+    AAProfileTimer CalibrationTimer(Profiler, zProfileCalibration);
+    Calibrator.Apply(&Batch[0], Batch.size());
+    CalibrationTimer.Stop();
+    
+    // Compact the quantities within the thresholds to the front of
+    // the batch such that they are histogrammed with a single call
+    size_t N = 0;
+    for(size_t v=0; v<Batch.size(); v++)
+      if(Batch[v] > MinThresh and Batch[v] < MaxThresh)
+	Batch[N++] = Batch[v];
+    
+    if(N > 0){
+      AAProfileTimer Timer(Profiler, zProfileHistogramFill);
+      Spectrum_H->FillN(N, &Batch[0], NULL);
+      Profiler->Count(zCountHistogramEntries, N);
+    }
+    
+    Batch.clear();
+  }
+  
+  string FileName, TreeName;
+  vector<Int_t> Quantities;
+  vector<TH1F *> Spectra;
+  Long64_t First, Last;
+  Int_t CacheSize;
+  AABatchCalibrator Calibrator;
+  Double_t MinThresh, MaxThresh;
+  AAProfiler *Profiler;
+  Int_t *Success;
+};
+
+
+// Method to create one or more spectra from the ASIM file. Each
+// ASIMSpectrumStruct specifies an ASIM event tree, the ASIMEvent data
+// member to histogram and the (prepared) histogram to fill. All
+// spectra of an event tree are created in a single pass over up to
+// MaxEntries entries of the tree. The entries are divided into
+// contiguous ranges that are processed in parallel into thread-local
+// histograms, which are then merged in order; threads require ROOT v6
+// or higher. The spectra calibration and thresholds of the present
+// channel are applied to all spectra
+Bool_t AAComputation::CreateASIMSpectra(vector<ASIMSpectrumStruct> &Spectra, Long64_t MaxEntries)
 {
-  if(SpectrumExists){
-    delete Spectrum_H;
-    SpectrumExists = false;
+  const Long64_t MinEntriesPerThread = 100000;
+  
+  Int_t Channel = ADAQSettings->WaveformChannel;
+  Bool_t UseCalibration = ADAQSettings->UseSpectraCalibrations[Channel];
+  
+  Int_t CacheSize = (ADAQSettings->TreeCacheSize > 0) ? ADAQSettings->TreeCacheSize : 0;
+  
+  Bool_t Success = true;
+  
+  BeginProfile("ASIM spectra");
+  
+  // Collect the distinct event trees in order of first appearance
+  vector<string> TreeNames;
+  for(size_t s=0; s<Spectra.size(); s++)
+    if(find(TreeNames.begin(), TreeNames.end(), Spectra[s].TreeName) == TreeNames.end())
+      TreeNames.push_back(Spectra[s].TreeName);
+  
+  for(size_t t=0; t<TreeNames.size(); t++){
+    
+    Long64_t Entries = min(MaxEntries, GetASIMEventTreeEntries(TreeNames[t]));
+    if(Entries < 0){
+      cout << "Warning: The TTree named '" << TreeNames[t] << "' cannot be found!\n"
+	   << endl;
+      Success = false;
+      continue;
+    }
+    
+    vector<ASIMSpectrumStruct *> TreeSpectra;
+    vector<Int_t> Quantities;
+    for(size_t s=0; s<Spectra.size(); s++){
+      if(Spectra[s].TreeName == TreeNames[t]){
+	TreeSpectra.push_back(&Spectra[s]);
+	Quantities.push_back(Spectra[s].Quantity);
+      }
+    }
+    
+    Int_t NumThreads = 1;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+    NumThreads = min((Long64_t)max(1u, boost::thread::hardware_concurrency()),
+		     max((Long64_t)1, Entries/MinEntriesPerThread));
+    if(NumThreads > 1)
+      ROOT::EnableThreadSafety();
+#endif
+    
+    // Create the thread-local histograms and calibrations in this
+    // thread since neither TH1::Clone() nor TF1::Clone() are thread safe
+    vector< vector<TH1F *> > ThreadSpectra(NumThreads);
+    vector<TF1 *> ThreadFits(NumThreads, (TF1 *)NULL);
+    vector<AABatchCalibrator> ThreadCalibrators(NumThreads);
+    vector<AAProfiler> ThreadProfilers(NumThreads);
+    vector<Int_t> ThreadSuccess(NumThreads, false);
+    
+    for(Int_t th=0; th<NumThreads; th++){
+      ThreadProfilers[th].SetEnabled(Profiler.GetEnabled());
+      
+      for(size_t s=0; s<TreeSpectra.size(); s++){
+	TH1F *H = (TH1F *)TreeSpectra[s]->Spectrum_H->Clone();
+	H->SetDirectory(0);
+	H->Reset();
+	ThreadSpectra[th].push_back(H);
+      }
+      
+      if(UseCalibration){
+	if(SpectraCalibrationType[Channel] == zCalibrationFit){
+	  ThreadFits[th] = (TF1 *)SpectraCalibrations[Channel]->Clone();
+	  ThreadCalibrators[th].SetFit(ThreadFits[th]);
+	}
+	else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
+	  ThreadCalibrators[th].SetInterp(SpectraCalibrationData[Channel]);
+      }
+    }
+    
+    boost::thread_group Threads;
+    
+    for(Int_t th=0; th<NumThreads; th++){
+      Long64_t First = Entries*th/NumThreads;
+      Long64_t Last = Entries*(th+1)/NumThreads;
+      
+      AAASIMEventReader Reader(ASIMFileName, TreeNames[t], Quantities, ThreadSpectra[th],
+			       First, Last, CacheSize, ThreadCalibrators[th],
+			       ADAQSettings->SpectrumMinThresh,
+			       ADAQSettings->SpectrumMaxThresh,
+			       &ThreadProfilers[th], &ThreadSuccess[th]);
+      
+      if(NumThreads == 1)
+	Reader();
+      else
+	Threads.create_thread(Reader);
+    }
+    
+    Threads.join_all();
+    
+    Profiler.MergeThreads(ThreadProfilers);
+    
+    // Merge the thread-local histograms in order
+    for(Int_t th=0; th<NumThreads; th++){
+      Success = Success and ThreadSuccess[th];
+      
+      for(size_t s=0; s<TreeSpectra.size(); s++){
+	TreeSpectra[s]->Spectrum_H->Add(ThreadSpectra[th][s]);
+	delete ThreadSpectra[th][s];
+      }
+      delete ThreadFits[th];
+    }
+    
+    if(!Success)
+      cout << "Warning: The TTree named '" << TreeNames[t] << "' could not be read!\n"
+	   << endl;
   }
   
-  Spectrum_H = new TH1F("Spectrum_H", "ADAQ Simulation (ASIM) Spectrum",
-			ADAQSettings->SpectrumNumBins,
-			ADAQSettings->SpectrumMinBin,
-			ADAQSettings->SpectrumMaxBin);
+  EndProfile();
+  
+  return Success;
+}
+
+
+void AAComputation::CreateASIMSpectrum()
+{
+  SpectrumExists = false;
+  
+  Spectrum_H = PrepareHistogram(Spectrum_H, "Spectrum_H", "ADAQ Simulation (ASIM) Spectrum",
+				ADAQSettings->SpectrumNumBins,
+				ADAQSettings->SpectrumMinBin,
+				ADAQSettings->SpectrumMaxBin);
   
   // Get the name of the ASIM event tree to be analyzed as specified
   // by the associated combo box setting.
-  TString ASIMEventTreeName = ADAQSettings->ASIMEventTreeName;
-  TTree *ASIMEventTree = (TTree *)ASIMEventTreeList->FindObject(ASIMEventTreeName);
+  ASIMSpectrumStruct ASIMSpectrum;
+  ASIMSpectrum.TreeName = ADAQSettings->ASIMEventTreeName;
+  ASIMSpectrum.Spectrum_H = Spectrum_H;
   
   // Bail out if the TTree cannot be found!
-  if(ASIMEventTree == NULL){
-    cout << "Warning: The TTree named '" << ASIMEventTreeName << "' cannot be found!\n"
+  if(GetASIMEventTree(ASIMSpectrum.TreeName) == NULL){
+    cout << "Warning: The TTree named '" << ASIMSpectrum.TreeName << "' cannot be found!\n"
 	 << endl;
     return;
   }
   
-  // Set the branch address of the ASIM event
-  ASIMEventTree->SetBranchAddress("ASIMEventBranch", &ASIMEvt);
+  ASIMSpectrum.Quantity = zASIMEnergyDep;
+  if(ADAQSettings->ASIMSpectrumTypePhotonsCreated)
+    ASIMSpectrum.Quantity = zASIMPhotonsCreated;
+  else if(ADAQSettings->ASIMSpectrumTypePhotonsDetected)
+    ASIMSpectrum.Quantity = zASIMPhotonsDetected;
   
   // When the user selected an ASIM EventTree via the combo box, the
   // ADAQSettings::WaveformsToHistogram NEL is updated to reflect the
   // total number of events contained within the TTree. This enables
   // the user to select a smaller number than the total entries via
   // this value without exceeding the maximum
-  int MaxEntriesToPlot = ADAQSettings->WaveformsToHistogram;
-
-  for(int entry=0; entry<MaxEntriesToPlot; entry++){
-    
-    ASIMEventTree->GetEvent(entry);
-
-    double Quantity = 0.;
-    if(ADAQSettings->ASIMSpectrumTypeEnergy)
-      Quantity = ASIMEvt->GetEnergyDep();
-    else if(ADAQSettings->ASIMSpectrumTypePhotonsCreated)
-      Quantity = ASIMEvt->GetPhotonsCreated();
-    else if(ADAQSettings->ASIMSpectrumTypePhotonsDetected)
-      Quantity = ASIMEvt->GetPhotonsDetected();
-
-    if(ADAQSettings->UseSpectraCalibrations[ADAQSettings->WaveformChannel]){
-      if(SpectraCalibrationType[ADAQSettings->WaveformChannel] == zCalibrationFit)
-	Quantity = SpectraCalibrations[ADAQSettings->WaveformChannel]->Eval(Quantity);
-      else if(SpectraCalibrationType[ADAQSettings->WaveformChannel] == zCalibrationInterp)
-	Quantity = SpectraCalibrationData[ADAQSettings->WaveformChannel]->Eval(Quantity);
-    }
-
-    if(Quantity > ADAQSettings->SpectrumMinThresh and
-       Quantity < ADAQSettings->SpectrumMaxThresh)
-      Spectrum_H->Fill(Quantity);
-  }
+  vector<ASIMSpectrumStruct> ASIMSpectra(1, ASIMSpectrum);
+  
+  if(!CreateASIMSpectra(ASIMSpectra, ADAQSettings->WaveformsToHistogram))
+    return;
+  
   SpectrumExists = true;
+  SpectrumRevision++;
 }
 
 
@@ -3699,3 +5954,355 @@ void AAComputation::AnalyzeWaveform(TH1F *Histogram_H)
     WaveformAnalysisArea += PulseHeight;
   }
 }
+
+
+// Function object that accumulates the samples of a contiguous range
+// of waveforms into a thread-local (time, voltage) count array of a
+// persistence map. Each reader opens its own TFile and reads only the
+// digitized waveform branch of the channel (and the stored waveform
+// data branch if gates are applied) such that readers may be run
+// concurrently in separate threads. Waveforms may be gated on the
+// calibrated stored pulse height and on the PSD region using the
+// stored PSD integrals
+class AAPersistenceReader
+{
+public:
+  AAPersistenceReader(string FN, string WB, string DB, Long64_t F, Long64_t L, Int_t CS,
+		      const vector<Int_t> *XB, Int_t NY, Double_t YMin, Double_t YMax,
+		      Bool_t BS, Double_t P, const AABaselineEstimator &BE,
+		      Bool_t EG, Double_t EMin, Double_t EMax,
+		      Bool_t PG, TCutG *R, Bool_t Inside, Bool_t TailTotal, Bool_t XEnergy,
+		      AABatchCalibrator C, vector<UInt_t> *N, Long64_t *A, AAProfiler *P, Int_t *S)
+    : FileName(FN), WaveformBranchName(WB), DataBranchName(DB), First(F), Last(L),
+      CacheSize(CS), XBins(XB), NumYBins(NY), MinY(YMin), YScale(NY/(YMax-YMin)),
+      BaselineSubtract(BS), Polarity(P), Estimator(BE),
+      EnergyGate(EG), MinEnergy(EMin), MaxEnergy(EMax),
+      PSDGate(PG), PSDRegion(R), PSDInside(Inside), PSDTailTotal(TailTotal), PSDXEnergy(XEnergy),
+      Calibrator(C), Counts(N), Accepted(A), Profiler(P), Success(S)
+  {}
+  
+  void operator()()
+  {
+    *Success = false;
+    
+    TFile *F = new TFile(FileName.c_str(), "read");
+    TTree *T = (F->IsOpen()) ? (TTree *)F->Get("WaveformTree") : NULL;
+    TBranch *WB = (T) ? T->GetBranch(WaveformBranchName.c_str()) : NULL;
+    
+    Bool_t UseGates = (EnergyGate or PSDGate);
+    TBranch *DB = (T and UseGates) ? T->GetBranch(DataBranchName.c_str()) : NULL;
+    
+    if(WB == NULL or (UseGates and DB == NULL)){
+      delete F;
+      return;
+    }
+    
+    vector<Int_t> *Voltage = NULL;
+    ADAQWaveformData *WD = new ADAQWaveformData;
+    
+    T->SetBranchStatus("*", 0);
+    T->SetBranchStatus(WaveformBranchName.c_str(), 1);
+    T->SetBranchAddress(WaveformBranchName.c_str(), &Voltage);
+    if(UseGates){
+      T->SetBranchStatus(DataBranchName.c_str(), 1);
+      T->SetBranchAddress(DataBranchName.c_str(), &WD);
+    }
+    
+    if(CacheSize > 0 and Last > First){
+      T->SetCacheSize((Long64_t)CacheSize*1024*1024);
+      T->SetCacheEntryRange(First, Last);
+      T->AddBranchToCache(WaveformBranchName.c_str(), true);
+      if(UseGates)
+	T->AddBranchToCache(DataBranchName.c_str(), true);
+      T->StopCacheLearningPhase();
+    }
+    
+    const Int_t NumSamples = XBins->size();
+    UInt_t *N = &(*Counts)[0];
+    
+    vector<Float_t> Voltages(NumSamples);
+    
+    for(Long64_t e=First; e<Last; e++){
+      
+      // The (small) waveform data is read first such that gated
+      // waveforms are never read
+      AAProfileTimer ReadTimer(Profiler, zProfileRead);
+      
+      if(UseGates){
+	Profiler->Count(zCountBytesRead, DB->GetEntry(e));
+	if(!PassGates(WD))
+	  continue;
+      }
+      
+      Profiler->Count(zCountBytesRead, WB->GetEntry(e));
+      ReadTimer.Stop();
+      Profiler->Count(zCountWaveforms);
+      
+      const Int_t Size = min((Int_t)Voltage->size(), NumSamples);
+      if(Size == 0)
+	continue;
+      
+      const Int_t *V = &(*Voltage)[0];
+      Float_t *BSV = &Voltages[0];
+      
+      AAProfileTimer TransformTimer(Profiler, zProfileTransform);
+      if(BaselineSubtract)
+	Estimator.Subtract(V, Size, Polarity, BSV);
+      else
+	for(Int_t s=0; s<Size; s++)
+	  BSV[s] = V[s];
+      TransformTimer.Stop();
+      
+      // Samples outside of the voltage range are not counted
+      AAProfileTimer FillTimer(Profiler, zProfileHistogramFill);
+      for(Int_t s=0; s<Size; s++){
+	Int_t Y = (Int_t)floor((BSV[s] - MinY)*YScale);
+	if(Y >= 0 and Y < NumYBins)
+	  N[(*XBins)[s]*NumYBins + Y]++;
+      }
+      
+      (*Accepted)++;
+    }
+    
+    T->ResetBranchAddresses();
+    delete WD;
+    delete Voltage;
+    F->Close();
+    delete F;
+    
+    *Success = true;
+  }
+  
+private:
+  Bool_t PassGates(ADAQWaveformData *WD)
+  {
+    if(EnergyGate){
+      Double_t Energy = WD->GetPulseHeight();
+      Calibrator.Apply(&Energy, 1);
+      if(Energy < MinEnergy or Energy > MaxEnergy)
+	return false;
+    }
+    
+    if(PSDGate){
+      Double_t Total = WD->GetPSDTotalIntegral();
+      Double_t Tail = WD->GetPSDTailIntegral();
+      
+      // The tail/total ratio is undefined for a zero total integral;
+      // such waveforms are rejected since they can never lie within
+      // a PSD region drawn on the (thresholded) PSD histogram
+      if(PSDTailTotal){
+	if(Total == 0.)
+	  return false;
+	Tail /= Total;
+      }
+      
+      if(PSDXEnergy)
+	Calibrator.Apply(&Total, 1);
+      
+      if(PSDRegion->IsInside(Total, Tail) != PSDInside)
+	return false;
+    }
+    
+    return true;
+  }
+  
+  string FileName, WaveformBranchName, DataBranchName;
+  Long64_t First, Last;
+  Int_t CacheSize;
+  const vector<Int_t> *XBins;
+  Int_t NumYBins;
+  Double_t MinY, YScale;
+  Bool_t BaselineSubtract;
+  Double_t Polarity;
+  AABaselineEstimator Estimator;
+  Bool_t EnergyGate;
+  Double_t MinEnergy, MaxEnergy;
+  Bool_t PSDGate;
+  TCutG *PSDRegion;
+  Bool_t PSDInside, PSDTailTotal, PSDXEnergy;
+  AABatchCalibrator Calibrator;
+  vector<UInt_t> *Counts;
+  Long64_t *Accepted;
+  AAProfiler *Profiler;
+  Int_t *Success;
+};
+
+
+// Method to create a persistence (density) map of the waveforms of
+// the present channel, i.e. a 2D histogram of the number of samples
+// at each (time, voltage). The map is binned more coarsely than the
+// digitizer (at most one bin per sample in time) such that it may be
+// drawn as a single image regardless of the number of waveforms. The
+// waveforms are divided into contiguous ranges that are processed in
+// parallel into thread-local count arrays, which are then summed in
+// order; threads require ROOT v6 or higher
+TH2F *AAComputation::CreatePersistenceMap()
+{
+  const Long64_t MinEntriesPerThread = 20000;
+  
+  PersistenceMapExists = false;
+  
+  if(!ADAQFileLoaded)
+    return NULL;
+  
+  Int_t Channel = ADAQSettings->WaveformChannel;
+  
+  Long64_t First = max(0, ADAQSettings->PersistenceFirstWaveform);
+  Long64_t Last = min((Long64_t)ADAQSettings->PersistenceLastWaveform,
+		      ADAQWaveformTree->GetEntries());
+  
+  Int_t NumXBins = min(ADAQSettings->PersistenceXBins, RecordLength);
+  Int_t NumYBins = ADAQSettings->PersistenceYBins;
+  Double_t MinY = ADAQSettings->PersistenceYMin;
+  Double_t MaxY = ADAQSettings->PersistenceYMax;
+  
+  if(Last <= First or RecordLength < 1 or NumXBins < 1 or NumYBins < 1 or MaxY <= MinY){
+    cout << "\nADAQAnalysis error! The persistence map waveform range or binning is invalid!\n"
+	 << endl;
+    return NULL;
+  }
+  
+  // Gates require the stored waveform data, which is not available
+  // for legacy ADAQ files
+  Bool_t EnergyGate = ADAQSettings->PersistenceEnergyGate;
+  Bool_t PSDGate = ADAQSettings->PersistencePSDGate;
+  if((EnergyGate or PSDGate) and ADAQLegacyFileLoaded){
+    cout << "\nADAQAnalysis warning! Persistence map gates are not available for legacy ADAQ files!\n"
+	 << endl;
+    EnergyGate = PSDGate = false;
+  }
+  
+  if(PSDGate and ADAQSettings->PSDRegions[Channel]->GetN() < 3){
+    cout << "\nADAQAnalysis warning! A PSD region must be created to gate the persistence map!\n"
+	 << endl;
+    PSDGate = false;
+  }
+  
+  Bool_t UseCalibration = ((EnergyGate or (PSDGate and ADAQSettings->PSDXAxisEnergy)) and
+			   ADAQSettings->UseSpectraCalibrations[Channel]);
+  
+  stringstream SS;
+  SS << ((ADAQLegacyFileLoaded) ? "VoltageInADC_Ch" : "WaveformCh") << Channel;
+  string WaveformBranchName = SS.str();
+  
+  SS.str("");
+  SS << "WaveformDataCh" << Channel;
+  string DataBranchName = SS.str();
+  
+  // Map each sample to its time bin once rather than per sample
+  vector<Int_t> XBins(RecordLength);
+  for(Int_t s=0; s<RecordLength; s++)
+    XBins[s] = (Int_t)((Long64_t)s*NumXBins/RecordLength);
+  
+  // Each reader receives its own copy of the baseline estimator
+  ConfigureBaselineEstimator();
+  
+  Int_t CacheSize = (ADAQSettings->TreeCacheSize > 0) ? ADAQSettings->TreeCacheSize : 0;
+  
+  Int_t NumThreads = 1;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+  NumThreads = min((Long64_t)max(1u, boost::thread::hardware_concurrency()),
+		   max((Long64_t)1, (Last-First)/MinEntriesPerThread));
+  if(NumThreads > 1)
+    ROOT::EnableThreadSafety();
+#endif
+  
+  // Create the thread-local calibrations in this thread since
+  // TF1::Clone() is not thread safe
+  vector<TF1 *> ThreadFits(NumThreads, (TF1 *)NULL);
+  vector<AABatchCalibrator> ThreadCalibrators(NumThreads);
+  vector< vector<UInt_t> > ThreadCounts(NumThreads);
+  vector<Long64_t> ThreadAccepted(NumThreads, 0);
+  vector<AAProfiler> ThreadProfilers(NumThreads);
+  vector<Int_t> ThreadSuccess(NumThreads, false);
+  
+  BeginProfile("Persistence map");
+  
+  for(Int_t th=0; th<NumThreads; th++){
+    ThreadCounts[th].assign((size_t)NumXBins*NumYBins, 0);
+    ThreadProfilers[th].SetEnabled(Profiler.GetEnabled());
+    
+    if(UseCalibration){
+      if(SpectraCalibrationType[Channel] == zCalibrationFit){
+	ThreadFits[th] = (TF1 *)SpectraCalibrations[Channel]->Clone();
+	ThreadCalibrators[th].SetFit(ThreadFits[th]);
+      }
+      else if(SpectraCalibrationType[Channel] == zCalibrationInterp)
+	ThreadCalibrators[th].SetInterp(SpectraCalibrationData[Channel]);
+    }
+  }
+  
+  boost::thread_group Threads;
+  
+  for(Int_t th=0; th<NumThreads; th++){
+    Long64_t ThreadFirst = First + (Last-First)*th/NumThreads;
+    Long64_t ThreadLast = First + (Last-First)*(th+1)/NumThreads;
+    
+    AAPersistenceReader Reader(ADAQFileName, WaveformBranchName, DataBranchName,
+			       ThreadFirst, ThreadLast, CacheSize,
+			       &XBins, NumYBins, MinY, MaxY,
+			       !ADAQSettings->RawWaveform, ADAQSettings->WaveformPolarity,
+			       BaselineEstimator,
+			       EnergyGate,
+			       ADAQSettings->PersistenceEnergyMin,
+			       ADAQSettings->PersistenceEnergyMax,
+			       PSDGate, ADAQSettings->PSDRegions[Channel],
+			       ADAQSettings->PSDInsideRegion,
+			       ADAQSettings->PSDYAxisTailTotal,
+			       ADAQSettings->PSDXAxisEnergy,
+			       ThreadCalibrators[th], &ThreadCounts[th],
+			       &ThreadAccepted[th], &ThreadProfilers[th], &ThreadSuccess[th]);
+    
+    if(NumThreads == 1)
+      Reader();
+    else
+      Threads.create_thread(Reader);
+  }
+  
+  Threads.join_all();
+  
+  // Sum the thread-local counts in order
+  Bool_t Success = true;
+  Long64_t Accepted = 0;
+  vector<Double_t> Counts((size_t)NumXBins*NumYBins, 0.);
+  
+  for(Int_t th=0; th<NumThreads; th++){
+    Success = Success and ThreadSuccess[th];
+    Accepted += ThreadAccepted[th];
+    
+    for(size_t b=0; b<Counts.size(); b++)
+      Counts[b] += ThreadCounts[th][b];
+    
+    delete ThreadFits[th];
+  }
+  
+  Profiler.MergeThreads(ThreadProfilers);
+  EndProfile();
+  
+  if(!Success){
+    cout << "\nADAQAnalysis error! The waveforms of the persistence map could not be read!\n"
+	 << endl;
+    return NULL;
+  }
+  
+  PersistenceMap_H = PrepareHistogram(PersistenceMap_H, "PersistenceMap_H", "Waveform persistence map",
+				      NumXBins, 0, RecordLength,
+				      NumYBins, MinY, MaxY);
+  
+  Double_t Samples = 0.;
+  for(Int_t x=0; x<NumXBins; x++){
+    for(Int_t y=0; y<NumYBins; y++){
+      Double_t N = Counts[(size_t)x*NumYBins + y];
+      if(N > 0){
+	PersistenceMap_H->SetBinContent(x+1, y+1, N);
+	Samples += N;
+      }
+    }
+  }
+  PersistenceMap_H->SetEntries(Samples);
+  
+  PersistenceMapWaveforms = Accepted;
+  PersistenceMapExists = true;
+  
+  return PersistenceMap_H;
+}
@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AADigitalShaper.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AADigitalShaper class implements recursive trapezoidal
+//       and CR-RC^n digital pulse shapers with optional pole-zero
+//       correction for the digital shaping (DS) spectrum algorithm.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <cmath>
+using namespace std;
+
+// ADAQAnalysis
+#include "AADigitalShaper.hh"
+
+
+AADigitalShaper::AADigitalShaper()
+  : Type(zTrapezoidShaper), RiseTime(1), FlatTop(0), Order(1),
+    ShapingTime(1.), DecayTime(0.),
+    PZCoefficient(0.), CRCoefficient(0.), RCCoefficient(0.), Normalization(1.)
+{
+  Configure(zTrapezoidShaper, 1, 0, 1., 1, 0.);
+}
+
+
+void AADigitalShaper::Configure(Int_t T, Int_t Rise, Int_t Flat,
+				Double_t Shaping, Int_t O, Double_t Decay)
+{
+  Type = T;
+  RiseTime = (Rise < 1) ? 1 : Rise;
+  FlatTop = (Flat < 0) ? 0 : Flat;
+  ShapingTime = (Shaping > 0.) ? Shaping : 1.;
+  Order = (O < 1) ? 1 : O;
+  DecayTime = (Decay > 0.) ? Decay : 0.;
+
+  // The pole-zero correction converts x(n) = A*q^n into a step of
+  // amplitude A: s(n) = s(n-1) + x(n) - q*x(n-1)
+  PZCoefficient = (DecayTime > 0.) ? exp(-1./DecayTime) : 0.;
+
+  // Single pole high-pass (CR) and low-pass (RC) recursions with the
+  // shaping time as the time constant
+  CRCoefficient = ShapingTime/(ShapingTime + 1.);
+  RCCoefficient = 1./(ShapingTime + 1.);
+
+  RCState.assign(Order, 0.);
+
+  if(Type == zTrapezoidShaper)
+    Normalization = 1./RiseTime;
+
+  // The maximum of the discrete CR-RC^n response to a unit step is
+  // found by running the recursion until the response has peaked
+  else{
+    Double_t CR = 0., Input = 0., Max = 0.;
+    for(Int_t n=0; n<100*(Order+1)*ShapingTime; n++){
+      CR = CRCoefficient*(CR + 1. - Input);
+      Input = 1.;
+
+      Double_t Output = CR;
+      for(Int_t o=0; o<Order; o++){
+	RCState[o] += RCCoefficient*(Output - RCState[o]);
+	Output = RCState[o];
+      }
+
+      if(Output > Max)
+	Max = Output;
+      else if(Output < 0.5*Max)
+	break;
+    }
+    Normalization = (Max > 0.) ? 1./Max : 1.;
+  }
+}
+
+
+void AADigitalShaper::Shape(const Float_t *Samples, Int_t N, Int_t Min, Int_t Max,
+			    Double_t &Height, Int_t &HeightPos, Double_t &Area)
+{
+  Height = 0.;
+  HeightPos = Min;
+  Area = 0.;
+
+  if(Type == zTrapezoidShaper and (Int_t)Step.size() < N)
+    Step.resize(N);
+
+  RCState.assign(Order, 0.);
+
+  const Int_t K = RiseTime;
+  const Int_t L = RiseTime + FlatTop;
+
+  Double_t Input = 0., PrevInput = 0., PrevSample = 0.;
+  Double_t Trapezoid = 0., CR = 0.;
+
+  for(Int_t n=0; n<N; n++){
+
+    // Pole-zero correction
+    if(DecayTime > 0.)
+      Input += Samples[n] - PZCoefficient*PrevSample;
+    else
+      Input = Samples[n];
+
+    Double_t Output = 0.;
+
+    // The trapezoid is the running sum of the difference of the
+    // (step) input delayed by 0, K, L and K+L samples
+    if(Type == zTrapezoidShaper){
+      Step[n] = Input;
+
+      Double_t D = Input;
+      if(n >= K) D -= Step[n-K];
+      if(n >= L) D -= Step[n-L];
+      if(n >= K+L) D += Step[n-K-L];
+
+      Trapezoid += D;
+      Output = Trapezoid*Normalization;
+    }
+
+    // One CR differentiator followed by n RC integrators
+    else{
+      CR = CRCoefficient*(CR + Input - PrevInput);
+      Output = CR;
+      for(Int_t o=0; o<Order; o++){
+	RCState[o] += RCCoefficient*(Output - RCState[o]);
+	Output = RCState[o];
+      }
+      Output *= Normalization;
+    }
+
+    PrevInput = Input;
+    PrevSample = Samples[n];
+
+    if(n >= Min and n <= Max){
+      if(Output > Height){
+	Height = Output;
+	HeightPos = n;
+      }
+      Area += Output;
+    }
+  }
+}
@@ -0,0 +1,100 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAFixedPointWaveform.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAFixedPointWaveform class implements integer fixed-point
+//       pulse features of baseline-subtracted waveforms.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <algorithm>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAFixedPointWaveform.hh"
+
+
+AAFixedPointWaveform::AAFixedPointWaveform()
+  : Samples(0), NumSamples(0), Polarity(1), Baseline(0)
+{;}
+
+
+void AAFixedPointWaveform::Set(const Int_t *S, Int_t N, Int_t P, Int_t Min, Int_t Max)
+{
+  Samples = S;
+  NumSamples = (S) ? N : 0;
+  Polarity = (P < 0) ? -1 : 1;
+  Baseline = 0;
+
+  Min = max(Min, 0);
+  Max = min(Max, NumSamples);
+  if(Min >= Max)
+    return;
+
+  Long64_t Sum = 0;
+  for(Int_t s=Min; s<Max; s++)
+    Sum += Samples[s];
+
+  // Round the average to the nearest fixed-point value
+  const Long64_t Length = Max - Min;
+  const Long64_t Scaled = Sum*(1 << FractionalBits);
+  Baseline = (Scaled >= 0) ? (2*Scaled + Length)/(2*Length) : -((-2*Scaled + Length)/(2*Length));
+}
+
+
+// The maximum of Polarity*(Sample - Baseline) is found from the
+// maximum (or minimum for negative polarity) integer sample in a
+// first pass without a data-dependent branch and its first sample
+// in a second pass that ends at the maximum
+Int_t AAFixedPointWaveform::GetMaximum(Int_t Min, Int_t Max, Long64_t &Height) const
+{
+  Height = 0;
+
+  Min = max(Min, 0);
+  Max = min(Max, NumSamples-1);
+  if(Min > Max)
+    return -1;
+
+  Int_t Extreme = Polarity*Samples[Min];
+  for(Int_t s=Min+1; s<=Max; s++)
+    Extreme = max(Extreme, Polarity*Samples[s]);
+
+  Int_t Position = Min;
+  while(Polarity*Samples[Position] != Extreme)
+    Position++;
+
+  Height = (Long64_t)Extreme*(1 << FractionalBits) - Polarity*Baseline;
+
+  return Position;
+}
+
+
+Long64_t AAFixedPointWaveform::GetIntegral(Int_t Min, Int_t Max) const
+{
+  Min = max(Min, 0);
+  Max = min(Max, NumSamples-1);
+  if(Min > Max)
+    return 0;
+
+  Long64_t Sum = 0;
+  for(Int_t s=Min; s<=Max; s++)
+    Sum += Samples[s];
+
+  return Polarity*(Sum*(1 << FractionalBits) - (Max-Min+1)*Baseline);
+}
@@ -51,6 +51,7 @@
 using namespace std;
 
 #include "AAGraphics.hh"
+#include "AAInterpolation.hh"
 
 
 // The static meyer's singleton 
@@ -73,7 +74,9 @@ AAGraphics::AAGraphics()
     CanvasContentType(zEmpty), 
     WaveformColor(kBlue), WaveformLineWidth(1), WaveformMarkerSize(1.),
     SpectrumLineColor(kBlue), SpectrumLineWidth(2), 
-    SpectrumFillColor(kRed), SpectrumFillStyle(3002), PSDFigureOfMerit(0.)
+    SpectrumFillColor(kRed), SpectrumFillStyle(3002), PSDFigureOfMerit(0.),
+    DecimatedType(-1), DecimatedChannel(-1), DecimatedWaveform(-1), DecimatedRevision(-1),
+    WaveformEnvelope_G(new TGraph), LastPlottedWaveform(-1)
 {
   if(TheGraphicsManager)
     cout << "\nERROR! TheGraphicsManager was constructed twice\n" << endl;
@@ -177,18 +180,56 @@ void AAGraphics::PlotWaveform(int Color)
   
   int Channel = ADAQSettings->WaveformChannel;
   int Waveform = ADAQSettings->WaveformToPlot;
-  
+
+  int Type = zBSWaveform;
   if(ADAQSettings->RawWaveform)
-    Waveform_H = ComputationMgr->CalculateRawWaveform(Channel, Waveform);
+    Type = zRawWaveform;
+  else if(ADAQSettings->ZSWaveform)
+    Type = zZSWaveform;
 
-  else if(ADAQSettings->BSWaveform)
-    Waveform_H = ComputationMgr->CalculateBSWaveform(Channel, Waveform);
+  // Reuse the presently calculated waveform if only settings
+  // downstream of waveform extraction have changed (e.g. plotting
+  // options) to avoid rereading the waveform from the ADAQ file
+  Waveform_H = ComputationMgr->GetCachedWaveform(Type, Channel, Waveform);
 
-  else if(ADAQSettings->ZSWaveform)
-    Waveform_H = ComputationMgr->CalculateZSWaveform(Channel, Waveform);
+  if(!Waveform_H){
+    ComputationMgr->ReadWaveformEntry(Channel, Waveform);
+    
+    if(Type == zRawWaveform)
+      Waveform_H = ComputationMgr->CalculateRawWaveform(Channel, Waveform);
+    
+    else if(Type == zBSWaveform)
+      Waveform_H = ComputationMgr->CalculateBSWaveform(Channel, Waveform);
+    
+    else if(Type == zZSWaveform)
+      Waveform_H = ComputationMgr->CalculateZSWaveform(Channel, Waveform);
+  }
   
+  // Begin reading the next waveforms in the browsing direction into
+  // the waveform cache while the present waveform is drawn
+  if(Waveform != LastPlottedWaveform){
+    ComputationMgr->PrefetchWaveforms(Channel, Waveform,
+				      (Waveform >= LastPlottedWaveform) ? 1 : -1);
+    LastPlottedWaveform = Waveform;
+  }
+
   if(ADAQSettings->WaveformAnalysis)
     ComputationMgr->AnalyzeWaveform(Waveform_H);
+
+  // The min/max pyramid is only rebuilt when the plotted waveform
+  // changes; zooming and panning reuse it
+  Int_t Revision = ADAQSettings->GetStageRevision(zStageWaveform);
+  if(Type != DecimatedType or Channel != DecimatedChannel or
+     Waveform != DecimatedWaveform or Revision != DecimatedRevision or
+     Waveform_H->GetNbinsX() != WaveformDecimator.GetNumSamples()){
+    WaveformDecimator.Build(Waveform_H->GetArray()+1, Waveform_H->GetNbinsX(),
+			    Waveform_H->GetXaxis()->GetBinCenter(1),
+			    Waveform_H->GetXaxis()->GetBinWidth(1));
+    DecimatedType = Type;
+    DecimatedChannel = Channel;
+    DecimatedWaveform = Waveform;
+    DecimatedRevision = Revision;
+  }
   
 
   // Determine the X-axis size and min/max values
@@ -315,7 +356,30 @@ void AAGraphics::PlotWaveform(int Color)
   else if(ADAQSettings->WaveformBoth)
     DrawString = "CP";
   
-  Waveform_H->Draw(DrawString.c_str());
+  // Waveforms with many more samples within the visible range than
+  // there are pixel columns on the canvas are drawn as their min/max
+  // envelope at pixel resolution, which is visually equivalent but
+  // whose cost no longer scales with the record length; the samples
+  // themselves are drawn once zoomed in
+  Int_t Columns = TheCanvas->GetWw() * (1 - TheCanvas->GetLeftMargin() - TheCanvas->GetRightMargin());
+  
+  Bool_t Decimated = false;
+  if(!ADAQSettings->CanvasXAxisLog)
+    Decimated = WaveformDecimator.Decimate(XMin, XMax, Columns, EnvelopeX, EnvelopeY);
+  
+  if(Decimated){
+    WaveformEnvelope_G->Set(EnvelopeX.size());
+    for(size_t p=0; p<EnvelopeX.size(); p++)
+      WaveformEnvelope_G->SetPoint(p, EnvelopeX[p], EnvelopeY[p]);
+    
+    WaveformEnvelope_G->SetLineColor(WaveformColor);
+    WaveformEnvelope_G->SetLineWidth(ADAQSettings->WaveformLineWidth);
+    
+    Waveform_H->Draw("AXIS");
+    WaveformEnvelope_G->Draw("L");
+  }
+  else
+    Waveform_H->Draw(DrawString.c_str());
     
   if(ADAQSettings->PlotZeroSuppressionCeiling)
     ZSCeiling_L->DrawLine(XMin,
@@ -378,13 +442,18 @@ void AAGraphics::PlotWaveform(int Color)
     
     if(ADAQSettings->UsePSDRegions[ADAQSettings->WaveformChannel]){
       
-      if((*it).PSDFilterFlag)
-	Waveform_H->SetLineColor(kRed);
-      else
-	Waveform_H->SetLineColor(kGreen+2);
+      Int_t PSDColor = ((*it).PSDFilterFlag) ? kRed : kGreen+2;
       
-      string NewDrawString = DrawString + " SAME";
-      Waveform_H->Draw(DrawString.c_str());
+      if(Decimated){
+	WaveformEnvelope_G->SetLineColor(PSDColor);
+	WaveformEnvelope_G->Draw("L");
+      }
+      else{
+	Waveform_H->SetLineColor(PSDColor);
+	
+	string NewDrawString = DrawString + " SAME";
+	Waveform_H->Draw(DrawString.c_str());
+      }
     }
     
     if(ADAQSettings->FindPeaks){
@@ -481,6 +550,113 @@ void AAGraphics::PlotWaveform(int Color)
 }
 
 
+// Method to plot the waveform persistence map. The map is binned at
+// (at most) one time bin per sample by AAComputation such that it is
+// drawn as a single color image regardless of the number of
+// waveforms that it contains
+void AAGraphics::PlotPersistenceMap()
+{
+  TH2F *PersistenceMap_H = ComputationMgr->GetPersistenceMap();
+  
+  if(!ComputationMgr->GetPersistenceMapExists() or PersistenceMap_H->GetEntries() == 0)
+    return;
+  
+  //////////////////////
+  // X and Y axis ranges
+  
+  double XMin = PersistenceMap_H->GetXaxis()->GetXmax() * ADAQSettings->XAxisMin;
+  double XMax = PersistenceMap_H->GetXaxis()->GetXmax() * ADAQSettings->XAxisMax;
+  PersistenceMap_H->GetXaxis()->SetRangeUser(XMin, XMax);
+  
+  double YLow = PersistenceMap_H->GetYaxis()->GetXmin();
+  double YSpan = PersistenceMap_H->GetYaxis()->GetXmax() - YLow;
+  double YMin = YLow + YSpan * (1-ADAQSettings->YAxisMax);
+  double YMax = YLow + YSpan * (1-ADAQSettings->YAxisMin);
+  PersistenceMap_H->GetYaxis()->SetRangeUser(YMin, YMax);
+  
+  string Title, XTitle, YTitle, ZTitle, PaletteTitle;
+  
+  if(ADAQSettings->OverrideGraphicalDefault){
+    Title = ADAQSettings->PlotTitle;
+    XTitle = ADAQSettings->XAxisTitle;
+    YTitle = ADAQSettings->YAxisTitle;
+    ZTitle = ADAQSettings->ZAxisTitle;
+    PaletteTitle = ADAQSettings->PaletteTitle;
+  }
+  else{
+    stringstream SS;
+    SS << "Waveform persistence map (" << ComputationMgr->GetPersistenceMapWaveforms()
+       << " waveforms)";
+    Title = SS.str();
+    XTitle = "Time [sample]";
+    YTitle = (ADAQSettings->RawWaveform) ? "Voltage [ADC]" : "Baseline-subtracted voltage [ADC]";
+    ZTitle = "Number of samples";
+    PaletteTitle = "";
+  }
+  
+  PersistenceMap_H->SetStats(false);
+  
+  TheCanvas->SetLeftMargin(0.13);
+  TheCanvas->SetBottomMargin(0.12);
+  TheCanvas->SetRightMargin(0.17);
+  
+  gPad->SetGrid(ADAQSettings->CanvasGrid, ADAQSettings->CanvasGrid);
+  gPad->SetLogx(false);
+  gPad->SetLogy(false);
+  gPad->SetLogz(ADAQSettings->CanvasZAxisLog);
+  
+  PersistenceMap_H->SetTitle(Title.c_str());
+  
+  PersistenceMap_H->GetXaxis()->SetTitle(XTitle.c_str());
+  PersistenceMap_H->GetXaxis()->SetTitleSize(ADAQSettings->XSize);
+  PersistenceMap_H->GetXaxis()->SetLabelSize(ADAQSettings->XSize);
+  PersistenceMap_H->GetXaxis()->SetTitleOffset(ADAQSettings->XOffset);
+  PersistenceMap_H->GetXaxis()->CenterTitle();
+  PersistenceMap_H->GetXaxis()->SetNdivisions(ADAQSettings->XDivs, true);
+  
+  PersistenceMap_H->GetYaxis()->SetTitle(YTitle.c_str());
+  PersistenceMap_H->GetYaxis()->SetTitleSize(ADAQSettings->YSize);
+  PersistenceMap_H->GetYaxis()->SetLabelSize(ADAQSettings->YSize);
+  PersistenceMap_H->GetYaxis()->SetTitleOffset(ADAQSettings->YOffset);
+  PersistenceMap_H->GetYaxis()->CenterTitle();
+  PersistenceMap_H->GetYaxis()->SetNdivisions(ADAQSettings->YDivs, true);
+  
+  PersistenceMap_H->GetZaxis()->SetTitle(ZTitle.c_str());
+  PersistenceMap_H->GetZaxis()->SetTitleSize(ADAQSettings->ZSize);
+  PersistenceMap_H->GetZaxis()->SetLabelSize(ADAQSettings->ZSize);
+  PersistenceMap_H->GetZaxis()->SetTitleOffset(ADAQSettings->ZOffset);
+  PersistenceMap_H->GetZaxis()->CenterTitle();
+  PersistenceMap_H->GetZaxis()->SetNdivisions(ADAQSettings->ZDivs, true);
+  
+  // Each bin is drawn as a single colored cell (an image of at most
+  // XBins x YBins cells) rather than as per-sample graphics
+  PersistenceMap_H->Draw("COLZ");
+  
+  // The canvas must be updated before the TPaletteAxis is accessed
+  TheCanvas->Update();
+  
+  TPaletteAxis *ColorPalette = (TPaletteAxis *)PersistenceMap_H->GetListOfFunctions()->FindObject("palette");
+  if(ColorPalette != NULL){
+    ColorPalette->GetAxis()->SetTitle(PaletteTitle.c_str());
+    ColorPalette->GetAxis()->SetTitleSize(ADAQSettings->PaletteSize);
+    ColorPalette->GetAxis()->SetTitleOffset(ADAQSettings->PaletteOffset);
+    ColorPalette->GetAxis()->CenterTitle();
+    ColorPalette->GetAxis()->SetLabelSize(ADAQSettings->PaletteSize);
+    
+    ColorPalette->SetX1NDC(ADAQSettings->PaletteX1);
+    ColorPalette->SetX2NDC(ADAQSettings->PaletteX2);
+    ColorPalette->SetY1NDC(ADAQSettings->PaletteY1);
+    ColorPalette->SetY2NDC(ADAQSettings->PaletteY2);
+    
+    ColorPalette->Draw("SAME");
+  }
+  
+  CanvasContentType = zPersistenceMap;
+  
+  TheCanvas->Update();
+}
+
+
 void AAGraphics::PlotSpectrum()
 {
   //////////////////////////////////
@@ -505,6 +681,14 @@ void AAGraphics::PlotSpectrum()
 
   Spectrum_H->GetXaxis()->SetRangeUser(XMin, XMax);
 
+  // Convert a calibrated spectrum into the selected particle energy
+  TH1F *Converted_H = ConvertSpectrumEnergy(Spectrum_H);
+  Bool_t Converted = (Converted_H != NULL);
+  if(Converted){
+    delete Spectrum_H;
+    Spectrum_H = Converted_H;
+  }
+
 
   // Set the spectrum y-axis range
 
@@ -547,7 +731,17 @@ void AAGraphics::PlotSpectrum()
   else{
     Title = "ADAQ Spectrum";
     
-    if(ComputationMgr->GetUseSpectraCalibrations()[ADAQSettings->WaveformChannel]){
+    if(Converted){
+      if(ADAQSettings->SpectrumParticleEnergy == zGammaEnergy)
+	XTitle = "Gamma energy [MeV]";
+      else if(ADAQSettings->SpectrumParticleEnergy == zProtonEnergy)
+	XTitle = "Proton energy [MeV]";
+      else if(ADAQSettings->SpectrumParticleEnergy == zAlphaEnergy)
+	XTitle = "Alpha energy [MeV]";
+      else if(ADAQSettings->SpectrumParticleEnergy == zCarbonEnergy)
+	XTitle = "Carbon energy [GeV]";
+    }
+    else if(ComputationMgr->GetUseSpectraCalibrations()[ADAQSettings->WaveformChannel]){
       if(ADAQSettings->EnergyUnit == 0)
 	XTitle = "Energy deposited [keV]";
       else
@@ -648,12 +842,23 @@ void AAGraphics::PlotSpectrum()
   if(ADAQSettings->FindBackground and ADAQSettings->PlotWithBackground){
     TH1F *SpectrumBackground_H = ComputationMgr->GetSpectrumBackground();
     SpectrumBackground_H->GetXaxis()->SetRangeUser(XMin, XMax);
-    SpectrumBackground_H->Draw("C SAME");
+    if(Converted){
+      TH1F *ConvertedBackground_H = ConvertSpectrumEnergy(SpectrumBackground_H);
+      delete SpectrumBackground_H;
+      SpectrumBackground_H = ConvertedBackground_H;
+    }
+    if(SpectrumBackground_H)
+      SpectrumBackground_H->Draw("C SAME");
   }
   
-  if(ADAQSettings->SpectrumFindIntegral){
-    TH1F *SpectrumIntegral_H = ComputationMgr->GetSpectrumIntegral();
-
+  // Note that the integral is owned by the computation manager and is
+  // only replaced by a converted copy for drawing
+  TH1F *SpectrumIntegral_H = NULL;
+  if(ADAQSettings->SpectrumFindIntegral)
+    SpectrumIntegral_H = (Converted) ? ConvertSpectrumEnergy(ComputationMgr->GetSpectrumIntegral())
+      : ComputationMgr->GetSpectrumIntegral();
+  
+  if(SpectrumIntegral_H){
     SpectrumIntegral_H->SetLineColor(SpectrumLineColor);
     SpectrumIntegral_H->SetLineWidth(ADAQSettings->SpectrumLineWidth);
     SpectrumIntegral_H->SetFillColor(SpectrumFillColor);
@@ -670,7 +875,9 @@ void AAGraphics::PlotSpectrum()
       SpectrumIntegral_H->Draw("HIST C SAME");
   }
     
-  if(ADAQSettings->SpectrumUseGaussianFit){
+  // The fit is a function of the energy deposited and so is only
+  // drawn on an unconverted spectrum
+  if(ADAQSettings->SpectrumUseGaussianFit and !Converted){
     TF1 *SpectrumFit_F = ComputationMgr->GetSpectrumFit();
     SpectrumFit_F->Draw("HIST SAME");
   }
@@ -820,6 +1027,48 @@ void AAGraphics::PlotPSDHistogram()
 }
 
 
+// Method to convert a calibrated (electron equivalent) ADAQ spectrum
+// into the particle energy selected by the user using the channel's
+// scintillator response library. The conversion only
+// maps the bin edges, so the visible bin range is carried over
+TH1F *AAGraphics::ConvertSpectrumEnergy(TH1F *EE_H)
+{
+  if(EE_H == NULL or
+     ADAQSettings->SpectrumParticleEnergy == zEnergyDeposited or
+     ComputationMgr->GetASIMFileLoaded() or
+     !ComputationMgr->GetUseSpectraCalibrations()[ADAQSettings->WaveformChannel])
+    return NULL;
+
+  Int_t Type = -1;
+  switch(ADAQSettings->SpectrumParticleEnergy){
+  case zGammaEnergy: Type = AAInterpolation::zGammaConversion; break;
+  case zProtonEnergy: Type = AAInterpolation::zProtonConversion; break;
+  case zAlphaEnergy: Type = AAInterpolation::zAlphaConversion; break;
+  case zCarbonEnergy: Type = AAInterpolation::zCarbonConversion; break;
+  default: return NULL;
+  }
+
+  // The responses are in MeVee while the spectra may be in keVee
+  Double_t Unit = (ADAQSettings->EnergyUnit == 0) ? 1.e-3 : 1.;
+
+  // Convert with the scintillator response assigned to the channel
+  AAInterpolation *InterpolationMgr = AAInterpolation::GetInstance();
+  AAScintillatorResponse *Response = NULL;
+  
+  const Int_t Channel = ADAQSettings->WaveformChannel;
+  if(Channel < (Int_t)ADAQSettings->ScintillatorResponses.size())
+    Response = InterpolationMgr->GetResponseLibrary(ADAQSettings->ScintillatorResponses[Channel]);
+  if(Response == NULL)
+    Response = InterpolationMgr->GetDefaultResponse();
+
+  TH1F *Converted_H = Response->ConvertSpectrum(EE_H, Type, Unit);
+  if(Converted_H)
+    Converted_H->GetXaxis()->SetRange(EE_H->GetXaxis()->GetFirst(), EE_H->GetXaxis()->GetLast());
+
+  return Converted_H;
+}
+
+
 void AAGraphics::PlotSpectrumDerivative()
 {
   TGraph *SpectrumDerivative_G = ComputationMgr->CalculateSpectrumDerivative();
@@ -84,6 +84,10 @@ void AAGraphicsSlots::HandleCheckButtons()
     case zPSDHistogram:
       GraphicsMgr->PlotPSDHistogram();
       break;
+
+    case zPersistenceMap:
+      GraphicsMgr->PlotPersistenceMap();
+      break;
     }
     break;
     
@@ -154,6 +158,10 @@ void AAGraphicsSlots::HandleNumberEntries()
     case zPSDHistogram:
       GraphicsMgr->PlotPSDHistogram();
       break;
+
+    case zPersistenceMap:
+      GraphicsMgr->PlotPersistenceMap();
+      break;
     }
     break;
 
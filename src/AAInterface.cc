@@ -73,6 +73,8 @@ AAInterface::AAInterface(string CmdLineArg)
     NumEdgeBoundingPoints(0), EdgeBoundX0(0.), EdgeBoundY0(0.),
     DataDirectory(getenv("PWD")), PrintDirectory(getenv("HOME")),
     DesplicedDirectory(getenv("HOME")), HistogramDirectory(getenv("HOME")),
+    ListModeDirectory(getenv("HOME")), ProfileDirectory(getenv("HOME")),
+    PulseTemplateDirectory(getenv("HOME")), ResponseDirectory(getenv("PWD")),
     ADAQFileLoaded(false), ASIMFileLoaded(false), EnableInterface(false),
     ColorMgr(new TColor), RndmMgr(new TRandom3)
 {
@@ -88,6 +90,10 @@ AAInterface::AAInterface(string CmdLineArg)
     TotalY = 610;
   }
 
+  // Scintillator response libraries are shipped in the source tree
+  if(getenv("ADAQANALYSIS_HOME")!=NULL)
+    ResponseDirectory = (string)getenv("ADAQANALYSIS_HOME") + "/responses";
+
   // Create the slot handler classes for the widgets on each of the
   // five tabs and the remaining nontab widgets
   WaveformSlots = new AAWaveformSlots(this);
@@ -108,12 +114,14 @@ AAInterface::AAInterface(string CmdLineArg)
   // Get pointers to singleton managers
   ComputationMgr = AAComputation::GetInstance();
   ComputationMgr->SetProgressBarPointer(ProcessingProgress_PB);
+  ComputationMgr->SetProfileTextViewPointer(ProfileReport_TV);
   
   GraphicsMgr = AAGraphics::GetInstance();
   GraphicsMgr->SetCanvasPointer(Canvas_EC->GetCanvas());
   GraphicsMgr->SetInterfacePointer(this);
 
   InterpolationMgr = AAInterpolation::GetInstance();
+  UpdateEAResponseWidgets();
 
   // If the user has specified an ADAQ or ASIM root file on the
   // command line then automatically process and load it
@@ -555,6 +563,57 @@ TGGroupFrame *PeakFindingOptions_GF = new TGGroupFrame(WaveformFrame_VF, "Peak f
   BaselineRegion_HF->AddFrame(PlotBaselineRegion_CB = new TGCheckButton(BaselineRegion_HF, "Plot", PlotBaselineRegion_CB_ID),
 			      new TGLayoutHints(kLHintsLeft, 5,5,5,0));
   PlotBaselineRegion_CB->Connect("Clicked()", "AAWaveformSlots", WaveformSlots, "HandleCheckButtons()");
+
+  TGHorizontalFrame *BaselineEstimator_HF = new TGHorizontalFrame(WaveformFrame_VF);
+  WaveformFrame_VF->AddFrame(BaselineEstimator_HF, new TGLayoutHints(kLHintsLeft, 15,5,0,5));
+
+  BaselineEstimator_HF->AddFrame(BaselineEstimator_CBL = new ADAQComboBoxWithLabel(BaselineEstimator_HF, "", BaselineEstimator_CBL_ID),
+				 new TGLayoutHints(kLHintsLeft, 0,5,0,0));
+  BaselineEstimator_CBL->GetComboBox()->AddEntry("Mean", 0);
+  BaselineEstimator_CBL->GetComboBox()->AddEntry("Trimmed mean", 1);
+  BaselineEstimator_CBL->GetComboBox()->AddEntry("Running median", 2);
+  BaselineEstimator_CBL->GetComboBox()->AddEntry("Moving", 3);
+  BaselineEstimator_CBL->GetComboBox()->Resize(120,20);
+  BaselineEstimator_CBL->GetComboBox()->Select(0);
+  BaselineEstimator_CBL->GetComboBox()->Connect("Selected(int,int)", "AAWaveformSlots", WaveformSlots, "HandleComboBoxes(int,int)");
+
+  BaselineEstimator_HF->AddFrame(BaselineTrimFraction_NEL = new ADAQNumberEntryWithLabel(BaselineEstimator_HF, "Trim", BaselineTrimFraction_NEL_ID),
+				 new TGLayoutHints(kLHintsLeft, 0,5,0,0));
+  BaselineTrimFraction_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESRealTwo);
+  BaselineTrimFraction_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  BaselineTrimFraction_NEL->GetEntry()->SetLimitValues(0.,0.49);
+  BaselineTrimFraction_NEL->GetEntry()->SetNumber(0.1);
+  BaselineTrimFraction_NEL->GetEntry()->Resize(55, 20);
+  BaselineTrimFraction_NEL->GetEntry()->Connect("ValueSet(long)", "AAWaveformSlots", WaveformSlots, "HandleNumberEntries()");
+
+  TGHorizontalFrame *BaselineTracking_HF = new TGHorizontalFrame(WaveformFrame_VF);
+  WaveformFrame_VF->AddFrame(BaselineTracking_HF, new TGLayoutHints(kLHintsLeft, 15,5,0,5));
+
+  BaselineTracking_HF->AddFrame(BaselineMedianWindow_NEL = new ADAQNumberEntryWithLabel(BaselineTracking_HF, "Window", BaselineMedianWindow_NEL_ID),
+				new TGLayoutHints(kLHintsLeft, 0,5,0,0));
+  BaselineMedianWindow_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  BaselineMedianWindow_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  BaselineMedianWindow_NEL->GetEntry()->SetLimitValues(3,100000);
+  BaselineMedianWindow_NEL->GetEntry()->SetNumber(101);
+  BaselineMedianWindow_NEL->GetEntry()->Resize(55, 20);
+  BaselineMedianWindow_NEL->GetEntry()->Connect("ValueSet(long)", "AAWaveformSlots", WaveformSlots, "HandleNumberEntries()");
+
+  BaselineTracking_HF->AddFrame(BaselineTimeConstant_NEL = new ADAQNumberEntryWithLabel(BaselineTracking_HF, "Tau", BaselineTimeConstant_NEL_ID),
+				new TGLayoutHints(kLHintsLeft, 0,5,0,0));
+  BaselineTimeConstant_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  BaselineTimeConstant_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  BaselineTimeConstant_NEL->GetEntry()->SetLimitValues(1.,1.e6);
+  BaselineTimeConstant_NEL->GetEntry()->SetNumber(200.);
+  BaselineTimeConstant_NEL->GetEntry()->Resize(55, 20);
+  BaselineTimeConstant_NEL->GetEntry()->Connect("ValueSet(long)", "AAWaveformSlots", WaveformSlots, "HandleNumberEntries()");
+
+  BaselineTracking_HF->AddFrame(BaselineThreshold_NEL = new ADAQNumberEntryWithLabel(BaselineTracking_HF, "Thresh.", BaselineThreshold_NEL_ID),
+				new TGLayoutHints(kLHintsLeft, 0,5,0,0));
+  BaselineThreshold_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  BaselineThreshold_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEANonNegative);
+  BaselineThreshold_NEL->GetEntry()->SetNumber(20.);
+  BaselineThreshold_NEL->GetEntry()->Resize(55, 20);
+  BaselineThreshold_NEL->GetEntry()->Connect("ValueSet(long)", "AAWaveformSlots", WaveformSlots, "HandleNumberEntries()");
     
 
   //////////////////////////////
@@ -611,6 +670,51 @@ TGGroupFrame *PeakFindingOptions_GF = new TGGroupFrame(WaveformFrame_VF, "Peak f
   UsePileupRejection_CB->Connect("Clicked()", "AAWaveformSlots", WaveformSlots, "HandleCheckButtons()");
   UsePileupRejection_CB->SetState(kButtonDown);
 
+
+  ////////////////////
+  // Timing options //
+  ////////////////////
+
+  TGGroupFrame *PeakTiming_GF = new TGGroupFrame(WaveformFrame_VF, "Peak timing", kVerticalFrame);
+  WaveformFrame_VF->AddFrame(PeakTiming_GF, new TGLayoutHints(kLHintsLeft, 15,5,5,5));
+
+  PeakTiming_GF->AddFrame(UsePeakTiming_CB = new TGCheckButton(PeakTiming_GF, "Calculate peak times", -1),
+			  new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+
+  TGHorizontalFrame *PeakTiming_HF0 = new TGHorizontalFrame(PeakTiming_GF);
+  PeakTiming_GF->AddFrame(PeakTiming_HF0, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+
+  PeakTiming_HF0->AddFrame(PeakTiming_BG = new TGButtonGroup(PeakTiming_HF0, "Method", kVerticalFrame),
+			   new TGLayoutHints(kLHintsLeft, 0,5,0,5));
+  
+  TimingCFD_RB = new TGRadioButton(PeakTiming_BG, "CFD", -1);
+  TimingCFD_RB->SetState(kButtonDown);
+
+  TimingLeadingEdge_RB = new TGRadioButton(PeakTiming_BG, "Leading edge", -1);
+
+  TGVerticalFrame *PeakTiming_VF0 = new TGVerticalFrame(PeakTiming_HF0);
+  PeakTiming_HF0->AddFrame(PeakTiming_VF0, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+  
+  PeakTiming_VF0->AddFrame(CFDFraction_NEL = new ADAQNumberEntryWithLabel(PeakTiming_VF0, "Fraction", -1),
+			   new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  CFDFraction_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESRealTwo);
+  CFDFraction_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  CFDFraction_NEL->GetEntry()->SetLimitValues(0.01,0.99);
+  CFDFraction_NEL->GetEntry()->SetNumber(0.3);
+
+  PeakTiming_VF0->AddFrame(CFDDelay_NEL = new ADAQNumberEntryWithLabel(PeakTiming_VF0, "Delay (samples)", -1),
+			   new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+  CFDDelay_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  CFDDelay_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  CFDDelay_NEL->GetEntry()->SetLimitValues(1,1000);
+  CFDDelay_NEL->GetEntry()->SetNumber(4);
+
+  PeakTiming_VF0->AddFrame(LeadingEdgeThreshold_NEL = new ADAQNumberEntryWithLabel(PeakTiming_VF0, "Threshold (ADC)", -1),
+			   new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+  LeadingEdgeThreshold_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESRealOne);
+  LeadingEdgeThreshold_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEAPositive);
+  LeadingEdgeThreshold_NEL->GetEntry()->SetNumber(100.);
+
   ///////////////////////
   // Graphical options //
   ///////////////////////
@@ -645,6 +749,92 @@ TGGroupFrame *PeakFindingOptions_GF = new TGGroupFrame(WaveformFrame_VF, "Peak f
   WaveformHeight_NEL->GetEntry()->SetNumber(0.);
   WaveformHeight_NEL->GetEntry()->SetState(false);
   WaveformHeight_NEL->GetEntry()->Resize(125,20);
+
+
+  /////////////////////
+  // Persistence map //
+  /////////////////////
+
+  TGGroupFrame *Persistence_GF = new TGGroupFrame(WaveformFrame_VF, "Persistence map", kVerticalFrame);
+  WaveformFrame_VF->AddFrame(Persistence_GF, new TGLayoutHints(kLHintsLeft, 15,5,5,5));
+
+  TGHorizontalFrame *Persistence_HF0 = new TGHorizontalFrame(Persistence_GF);
+  Persistence_GF->AddFrame(Persistence_HF0, new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+
+  Persistence_HF0->AddFrame(PersistenceFirstWaveform_NEL = new ADAQNumberEntryWithLabel(Persistence_HF0, "First", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceFirstWaveform_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  PersistenceFirstWaveform_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEANonNegative);
+  PersistenceFirstWaveform_NEL->GetEntry()->Resize(75,20);
+  PersistenceFirstWaveform_NEL->GetEntry()->SetNumber(0);
+
+  Persistence_HF0->AddFrame(PersistenceLastWaveform_NEL = new ADAQNumberEntryWithLabel(Persistence_HF0, "Last", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceLastWaveform_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  PersistenceLastWaveform_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEANonNegative);
+  PersistenceLastWaveform_NEL->GetEntry()->Resize(75,20);
+  PersistenceLastWaveform_NEL->GetEntry()->SetNumber(100000);
+
+  TGHorizontalFrame *Persistence_HF1 = new TGHorizontalFrame(Persistence_GF);
+  Persistence_GF->AddFrame(Persistence_HF1, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+
+  Persistence_HF1->AddFrame(PersistenceXBins_NEL = new ADAQNumberEntryWithLabel(Persistence_HF1, "Time bins", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceXBins_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  PersistenceXBins_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEAPositive);
+  PersistenceXBins_NEL->GetEntry()->Resize(55,20);
+  PersistenceXBins_NEL->GetEntry()->SetNumber(1024);
+
+  Persistence_HF1->AddFrame(PersistenceYBins_NEL = new ADAQNumberEntryWithLabel(Persistence_HF1, "ADC bins", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceYBins_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  PersistenceYBins_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEAPositive);
+  PersistenceYBins_NEL->GetEntry()->Resize(55,20);
+  PersistenceYBins_NEL->GetEntry()->SetNumber(512);
+
+  TGHorizontalFrame *Persistence_HF2 = new TGHorizontalFrame(Persistence_GF);
+  Persistence_GF->AddFrame(Persistence_HF2, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+
+  Persistence_HF2->AddFrame(PersistenceYMin_NEL = new ADAQNumberEntryWithLabel(Persistence_HF2, "Min (ADC)", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceYMin_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  PersistenceYMin_NEL->GetEntry()->Resize(55,20);
+  PersistenceYMin_NEL->GetEntry()->SetNumber(-256);
+
+  Persistence_HF2->AddFrame(PersistenceYMax_NEL = new ADAQNumberEntryWithLabel(Persistence_HF2, "Max (ADC)", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceYMax_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  PersistenceYMax_NEL->GetEntry()->Resize(55,20);
+  PersistenceYMax_NEL->GetEntry()->SetNumber(4096);
+
+  TGHorizontalFrame *Persistence_HF3 = new TGHorizontalFrame(Persistence_GF);
+  Persistence_GF->AddFrame(Persistence_HF3, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+
+  Persistence_HF3->AddFrame(PersistenceEnergyGate_CB = new TGCheckButton(Persistence_HF3, "Energy gate", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,5,0));
+
+  Persistence_HF3->AddFrame(PersistenceEnergyMin_NEL = new ADAQNumberEntryWithLabel(Persistence_HF3, "Min", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceEnergyMin_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  PersistenceEnergyMin_NEL->GetEntry()->Resize(55,20);
+  PersistenceEnergyMin_NEL->GetEntry()->SetNumber(0.);
+
+  Persistence_HF3->AddFrame(PersistenceEnergyMax_NEL = new ADAQNumberEntryWithLabel(Persistence_HF3, "Max", -1),
+			    new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  PersistenceEnergyMax_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  PersistenceEnergyMax_NEL->GetEntry()->Resize(55,20);
+  PersistenceEnergyMax_NEL->GetEntry()->SetNumber(1.e9);
+
+  Persistence_GF->AddFrame(PersistencePSDGate_CB = new TGCheckButton(Persistence_GF, "PSD region gate", -1),
+			   new TGLayoutHints(kLHintsNormal, 0,5,5,0));
+
+  Persistence_GF->AddFrame(CreatePersistenceMap_TB = new TGTextButton(Persistence_GF, "Create persistence map", CreatePersistenceMap_TB_ID),
+			   new TGLayoutHints(kLHintsLeft, 20,0,10,5));
+  CreatePersistenceMap_TB->Resize(200, 30);
+  CreatePersistenceMap_TB->SetBackgroundColor(ColorMgr->Number2Pixel(36));
+  CreatePersistenceMap_TB->SetForegroundColor(ColorMgr->Number2Pixel(0));
+  CreatePersistenceMap_TB->ChangeOptions(CreatePersistenceMap_TB->GetOptions() | kFixedSize);
+  CreatePersistenceMap_TB->Connect("Clicked()", "AAWaveformSlots", WaveformSlots, "HandleTextButtons()");
 }
 
 
@@ -771,6 +961,68 @@ void AAInterface::FillSpectrumFrame()
   ADAQSpectrumAlgorithm_VF->AddFrame(ADAQSpectrumAlgorithmWD_RB = new TGRadioButton(ADAQSpectrumAlgorithm_VF, "Waveform data", ADAQSpectrumAlgorithmWD_RB_ID),
 				     new TGLayoutHints(kLHintsNormal, 0,0,0,0));
   ADAQSpectrumAlgorithmWD_RB->Connect("Clicked()", "AASpectrumSlots", SpectrumSlots, "HandleRadioButtons()");
+
+  ADAQSpectrumAlgorithm_VF->AddFrame(ADAQSpectrumAlgorithmDS_RB = new TGRadioButton(ADAQSpectrumAlgorithm_VF, "Digital shaper", ADAQSpectrumAlgorithmDS_RB_ID),
+				     new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+  ADAQSpectrumAlgorithmDS_RB->Connect("Clicked()", "AASpectrumSlots", SpectrumSlots, "HandleRadioButtons()");
+
+
+  ///////////////////////////
+  // Digital shaper options
+
+  TGGroupFrame *ShaperOptions_GF = new TGGroupFrame(SpectrumFrame_VF, "Digital shaper (DS)", kVerticalFrame);
+  SpectrumFrame_VF->AddFrame(ShaperOptions_GF, new TGLayoutHints(kLHintsLeft, 15,0,5,0));
+
+  TGHorizontalFrame *ShaperType_HF = new TGHorizontalFrame(ShaperOptions_GF);
+  ShaperOptions_GF->AddFrame(ShaperType_HF, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+
+  ShaperType_HF->AddFrame(ShaperTrapezoid_RB = new TGRadioButton(ShaperType_HF, "Trapezoidal", ShaperTrapezoid_RB_ID),
+			  new TGLayoutHints(kLHintsNormal, 0,15,5,0));
+  ShaperTrapezoid_RB->SetState(kButtonDown);
+  ShaperTrapezoid_RB->Connect("Clicked()", "AASpectrumSlots", SpectrumSlots, "HandleRadioButtons()");
+
+  ShaperType_HF->AddFrame(ShaperCRRC_RB = new TGRadioButton(ShaperType_HF, "CR-RC^n", ShaperCRRC_RB_ID),
+			  new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  ShaperCRRC_RB->Connect("Clicked()", "AASpectrumSlots", SpectrumSlots, "HandleRadioButtons()");
+
+  TGHorizontalFrame *ShaperTrapezoid_HF = new TGHorizontalFrame(ShaperOptions_GF);
+  ShaperOptions_GF->AddFrame(ShaperTrapezoid_HF, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+
+  ShaperTrapezoid_HF->AddFrame(ShaperRiseTime_NEL = new ADAQNumberEntryWithLabel(ShaperTrapezoid_HF, "Rise", -1),
+			       new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  ShaperRiseTime_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  ShaperRiseTime_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  ShaperRiseTime_NEL->GetEntry()->SetLimitValues(1,10000);
+  ShaperRiseTime_NEL->GetEntry()->SetNumber(10);
+
+  ShaperTrapezoid_HF->AddFrame(ShaperFlatTop_NEL = new ADAQNumberEntryWithLabel(ShaperTrapezoid_HF, "Flat top", -1),
+			       new TGLayoutHints(kLHintsNormal, 15,0,5,0));
+  ShaperFlatTop_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  ShaperFlatTop_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  ShaperFlatTop_NEL->GetEntry()->SetLimitValues(0,10000);
+  ShaperFlatTop_NEL->GetEntry()->SetNumber(5);
+
+  TGHorizontalFrame *ShaperCRRC_HF = new TGHorizontalFrame(ShaperOptions_GF);
+  ShaperOptions_GF->AddFrame(ShaperCRRC_HF, new TGLayoutHints(kLHintsNormal, 0,0,0,0));
+
+  ShaperCRRC_HF->AddFrame(ShaperShapingTime_NEL = new ADAQNumberEntryWithLabel(ShaperCRRC_HF, "Shaping", -1),
+			  new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  ShaperShapingTime_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  ShaperShapingTime_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEAPositive);
+  ShaperShapingTime_NEL->GetEntry()->SetNumber(8);
+
+  ShaperCRRC_HF->AddFrame(ShaperOrder_NEL = new ADAQNumberEntryWithLabel(ShaperCRRC_HF, "Order", -1),
+			  new TGLayoutHints(kLHintsNormal, 15,0,5,0));
+  ShaperOrder_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  ShaperOrder_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  ShaperOrder_NEL->GetEntry()->SetLimitValues(1,10);
+  ShaperOrder_NEL->GetEntry()->SetNumber(4);
+
+  ShaperOptions_GF->AddFrame(ShaperDecayTime_NEL = new ADAQNumberEntryWithLabel(ShaperOptions_GF, "Pole-zero decay (0 = off)", -1),
+			     new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  ShaperDecayTime_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  ShaperDecayTime_NEL->GetEntry()->SetNumAttr(TGNumberFormat::kNEANonNegative);
+  ShaperDecayTime_NEL->GetEntry()->SetNumber(0);
   
 
   //////////////////////////
@@ -1305,6 +1557,24 @@ void AAInterface::FillAnalysisFrame()
   EAEscapePeaks_CB->SetState(kButtonDisabled);
 
 
+  TGHorizontalFrame *EA_HF1 = new TGHorizontalFrame(EA_GF);
+  EA_GF->AddFrame(EA_HF1, new TGLayoutHints(kLHintsNormal, 5,5,5,0));
+
+  // The scintillator response of the present channel is selected from
+  // the loaded response libraries (see AAInterpolation)
+  EA_HF1->AddFrame(EAResponse_CBL = new ADAQComboBoxWithLabel(EA_HF1, "", EAResponse_CBL_ID),
+		   new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  EAResponse_CBL->GetComboBox()->Resize(130,20);
+  EAResponse_CBL->GetComboBox()->SetEnabled(false);
+  EAResponse_CBL->GetComboBox()->Connect("Selected(int,int)", "AAAnalysisSlots", AnalysisSlots, "HandleComboBoxes(int,int)");
+
+  EA_HF1->AddFrame(EAResponseLoad_TB = new TGTextButton(EA_HF1, "Load response", EAResponseLoad_TB_ID),
+		   new TGLayoutHints(kLHintsNormal, 5,0,0,0));
+  EAResponseLoad_TB->Connect("Clicked()", "AAAnalysisSlots", AnalysisSlots, "HandleTextButtons()");
+  EAResponseLoad_TB->Resize(110,20);
+  EAResponseLoad_TB->ChangeOptions(EAResponseLoad_TB->GetOptions() | kFixedSize);
+  EAResponseLoad_TB->SetState(kButtonDisabled);
+
   EA_GF->AddFrame(EALightConversionFactor_NEL = new ADAQNumberEntryWithLabel(EA_GF, "Conversion factor", EALightConversionFactor_NEL_ID),
 		   new TGLayoutHints(kLHintsNormal, 5,5,5,0));
   EALightConversionFactor_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
@@ -1360,6 +1630,17 @@ void AAInterface::FillAnalysisFrame()
   EACarbonEnergy_NEL->GetEntry()->Resize(70,20);
   EACarbonEnergy_NEL->GetEntry()->Connect("ValueSet(long)", "AAAnalysisSlots", AnalysisSlots, "HandleNumberEntries()");
   EACarbonEnergy_NEL->GetEntry()->SetState(false);
+
+  EA_GF->AddFrame(EASpectrumEnergy_CBL = new ADAQComboBoxWithLabel(EA_GF, "Plot spectrum as", EASpectrumEnergy_CBL_ID),
+		  new TGLayoutHints(kLHintsNormal, 5,5,5,5));
+  EASpectrumEnergy_CBL->GetComboBox()->AddEntry("Energy deposited", zEnergyDeposited);
+  EASpectrumEnergy_CBL->GetComboBox()->AddEntry("Gamma energy", zGammaEnergy);
+  EASpectrumEnergy_CBL->GetComboBox()->AddEntry("Proton (neutron) energy", zProtonEnergy);
+  EASpectrumEnergy_CBL->GetComboBox()->AddEntry("Alpha energy", zAlphaEnergy);
+  EASpectrumEnergy_CBL->GetComboBox()->AddEntry("Carbon energy", zCarbonEnergy);
+  EASpectrumEnergy_CBL->GetComboBox()->Select(zEnergyDeposited);
+  EASpectrumEnergy_CBL->GetComboBox()->Resize(150,20);
+  EASpectrumEnergy_CBL->GetComboBox()->Connect("Selected(int,int)", "AAAnalysisSlots", AnalysisSlots, "HandleComboBoxes(int,int)");
 }
 
 
@@ -2208,6 +2489,9 @@ void AAInterface::FillProcessingFrame()
   UpdateFreq_NEL->GetEntry()->SetLimitValues(1,100);
   UpdateFreq_NEL->GetEntry()->SetNumber(2);
 
+  ProcessingOptions_GF->AddFrame(UseFixedPoint_CB = new TGCheckButton(ProcessingOptions_GF, "Fixed-point SMS and PSD processing", -1),
+				 new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+
 
   // Despliced file creation options
   
@@ -2257,6 +2541,201 @@ void AAInterface::FillProcessingFrame()
   DesplicedFileCreation_TB->SetForegroundColor(ColorMgr->Number2Pixel(0));
   DesplicedFileCreation_TB->ChangeOptions(DesplicedFileCreation_TB->GetOptions() | kFixedSize);
   DesplicedFileCreation_TB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleTextButtons()");
+
+
+  // List-mode output options
+
+  TGGroupFrame *ListMode_GF = new TGGroupFrame(ProcessingFrame_VF, "List-mode output", kVerticalFrame);
+  ProcessingFrame_VF->AddFrame(ListMode_GF, new TGLayoutHints(kLHintsLeft, 5,5,5,5));
+
+  ListMode_GF->AddFrame(ListModeOutput_CB = new TGCheckButton(ListMode_GF, "Write per-pulse data during processing", ListModeOutput_CB_ID),
+			new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  ListModeOutput_CB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleCheckButtons()");
+
+  TGHorizontalFrame *ListModeName_HF = new TGHorizontalFrame(ListMode_GF);
+  ListMode_GF->AddFrame(ListModeName_HF, new TGLayoutHints(kLHintsLeft, 0,0,0,0));
+  
+  ListModeName_HF->AddFrame(ListModeFileSelection_TB = new TGTextButton(ListModeName_HF, "File ... ", ListModeFileSelection_TB_ID),
+			    new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  ListModeFileSelection_TB->Resize(60,25);
+  ListModeFileSelection_TB->SetBackgroundColor(ThemeForegroundColor);
+  ListModeFileSelection_TB->ChangeOptions(ListModeFileSelection_TB->GetOptions() | kFixedSize);
+  ListModeFileSelection_TB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleTextButtons()");
+  
+  ListModeName_HF->AddFrame(ListModeFileName_TE = new TGTextEntry(ListModeName_HF, "<No file currently selected>", -1),
+			    new TGLayoutHints(kLHintsLeft, 5,0,5,5));
+  ListModeFileName_TE->Resize(180,25);
+  ListModeFileName_TE->SetAlignment(kTextRight);
+  ListModeFileName_TE->SetBackgroundColor(ThemeForegroundColor);
+  ListModeFileName_TE->ChangeOptions(ListModeFileName_TE->GetOptions() | kFixedSize);
+
+
+  // Pileup recovery options
+
+  TGGroupFrame *PileupRecovery_GF = new TGGroupFrame(ProcessingFrame_VF, "Pileup recovery", kVerticalFrame);
+  ProcessingFrame_VF->AddFrame(PileupRecovery_GF, new TGLayoutHints(kLHintsLeft, 5,5,5,5));
+
+  PileupRecovery_GF->AddFrame(UsePileupRecovery_CB = new TGCheckButton(PileupRecovery_GF, "Fit pileup peaks with pulse templates", UsePileupRecovery_CB_ID),
+			      new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  UsePileupRecovery_CB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleCheckButtons()");
+
+  TGHorizontalFrame *PulseTemplateName_HF = new TGHorizontalFrame(PileupRecovery_GF);
+  PileupRecovery_GF->AddFrame(PulseTemplateName_HF, new TGLayoutHints(kLHintsLeft, 0,0,0,0));
+  
+  PulseTemplateName_HF->AddFrame(PulseTemplateFileSelection_TB = new TGTextButton(PulseTemplateName_HF, "File ... ", PulseTemplateFileSelection_TB_ID),
+				 new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  PulseTemplateFileSelection_TB->Resize(60,25);
+  PulseTemplateFileSelection_TB->SetBackgroundColor(ThemeForegroundColor);
+  PulseTemplateFileSelection_TB->ChangeOptions(PulseTemplateFileSelection_TB->GetOptions() | kFixedSize);
+  PulseTemplateFileSelection_TB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleTextButtons()");
+  
+  PulseTemplateName_HF->AddFrame(PulseTemplateFileName_TE = new TGTextEntry(PulseTemplateName_HF, "<No file currently selected>", -1),
+				 new TGLayoutHints(kLHintsLeft, 5,0,5,5));
+  PulseTemplateFileName_TE->Resize(180,25);
+  PulseTemplateFileName_TE->SetAlignment(kTextRight);
+  PulseTemplateFileName_TE->SetBackgroundColor(ThemeForegroundColor);
+  PulseTemplateFileName_TE->ChangeOptions(PulseTemplateFileName_TE->GetOptions() | kFixedSize);
+
+
+  // Average pulse template options
+
+  TGGroupFrame *PulseTemplates_GF = new TGGroupFrame(ProcessingFrame_VF, "Average pulse templates", kVerticalFrame);
+  ProcessingFrame_VF->AddFrame(PulseTemplates_GF, new TGLayoutHints(kLHintsLeft, 5,5,5,5));
+
+  PulseTemplates_GF->AddFrame(BuildPulseTemplates_CB = new TGCheckButton(PulseTemplates_GF, "Build templates during processing", BuildPulseTemplates_CB_ID),
+			      new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  BuildPulseTemplates_CB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleCheckButtons()");
+
+  TGHorizontalFrame *PulseTemplateOutput_HF = new TGHorizontalFrame(PulseTemplates_GF);
+  PulseTemplates_GF->AddFrame(PulseTemplateOutput_HF, new TGLayoutHints(kLHintsLeft, 0,0,0,0));
+  
+  PulseTemplateOutput_HF->AddFrame(PulseTemplateOutputSelection_TB = new TGTextButton(PulseTemplateOutput_HF, "File ... ", PulseTemplateOutputSelection_TB_ID),
+				   new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  PulseTemplateOutputSelection_TB->Resize(60,25);
+  PulseTemplateOutputSelection_TB->SetBackgroundColor(ThemeForegroundColor);
+  PulseTemplateOutputSelection_TB->ChangeOptions(PulseTemplateOutputSelection_TB->GetOptions() | kFixedSize);
+  PulseTemplateOutputSelection_TB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleTextButtons()");
+  
+  PulseTemplateOutput_HF->AddFrame(PulseTemplateOutputFileName_TE = new TGTextEntry(PulseTemplateOutput_HF, "<No file currently selected>", -1),
+				   new TGLayoutHints(kLHintsLeft, 5,0,5,5));
+  PulseTemplateOutputFileName_TE->Resize(180,25);
+  PulseTemplateOutputFileName_TE->SetAlignment(kTextRight);
+  PulseTemplateOutputFileName_TE->SetBackgroundColor(ThemeForegroundColor);
+  PulseTemplateOutputFileName_TE->ChangeOptions(PulseTemplateOutputFileName_TE->GetOptions() | kFixedSize);
+
+  TGHorizontalFrame *TemplateSamples_HF = new TGHorizontalFrame(PulseTemplates_GF);
+  PulseTemplates_GF->AddFrame(TemplateSamples_HF, new TGLayoutHints(kLHintsLeft, 0,0,0,0));
+
+  TemplateSamples_HF->AddFrame(TemplatePreSamples_NEL = new ADAQNumberEntryWithLabel(TemplateSamples_HF, "Pre", -1),
+			       new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  TemplatePreSamples_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  TemplatePreSamples_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  TemplatePreSamples_NEL->GetEntry()->SetLimitValues(0,10000);
+  TemplatePreSamples_NEL->GetEntry()->SetNumber(20);
+
+  TemplateSamples_HF->AddFrame(TemplatePostSamples_NEL = new ADAQNumberEntryWithLabel(TemplateSamples_HF, "Post (samples)", -1),
+			       new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  TemplatePostSamples_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  TemplatePostSamples_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  TemplatePostSamples_NEL->GetEntry()->SetLimitValues(1,100000);
+  TemplatePostSamples_NEL->GetEntry()->SetNumber(100);
+
+  TGHorizontalFrame *TemplateWindow_HF = new TGHorizontalFrame(PulseTemplates_GF);
+  PulseTemplates_GF->AddFrame(TemplateWindow_HF, new TGLayoutHints(kLHintsLeft, 0,0,0,0));
+
+  TemplateWindow_HF->AddFrame(TemplateWindowMin_NEL = new ADAQNumberEntryWithLabel(TemplateWindow_HF, "Min", -1),
+			      new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  TemplateWindowMin_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  TemplateWindowMin_NEL->GetEntry()->SetNumber(0.);
+
+  TemplateWindow_HF->AddFrame(TemplateWindowMax_NEL = new ADAQNumberEntryWithLabel(TemplateWindow_HF, "Max (spectrum units)", -1),
+			      new TGLayoutHints(kLHintsNormal, 0,5,0,0));
+  TemplateWindowMax_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESReal);
+  TemplateWindowMax_NEL->GetEntry()->SetNumber(1.e9);
+
+
+  // ADAQ file I/O tuning options
+
+  TGGroupFrame *TreeIO_GF = new TGGroupFrame(ProcessingFrame_VF, "File I/O tuning", kVerticalFrame);
+  ProcessingFrame_VF->AddFrame(TreeIO_GF, new TGLayoutHints(kLHintsLeft, 5,5,5,5));
+
+  TreeIO_GF->AddFrame(TreeCacheSize_NEL = new ADAQNumberEntryWithLabel(TreeIO_GF, "TTree cache size (MB)", -1),
+		      new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  TreeCacheSize_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  TreeCacheSize_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  TreeCacheSize_NEL->GetEntry()->SetLimitValues(0,4096);
+  TreeCacheSize_NEL->GetEntry()->SetNumber(64);
+
+  TreeIO_GF->AddFrame(TreeCacheLearnEntries_NEL = new ADAQNumberEntryWithLabel(TreeIO_GF, "Cache learning entries", -1),
+		      new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  TreeCacheLearnEntries_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  TreeCacheLearnEntries_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  TreeCacheLearnEntries_NEL->GetEntry()->SetLimitValues(1,10000);
+  TreeCacheLearnEntries_NEL->GetEntry()->SetNumber(10);
+
+  TreeIO_GF->AddFrame(TreeCacheChannelOnly_CB = new TGCheckButton(TreeIO_GF, "Read selected channel only", -1),
+		      new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  TreeCacheChannelOnly_CB->SetState(kButtonUp);
+
+  TreeIO_GF->AddFrame(IMTThreads_NEL = new ADAQNumberEntryWithLabel(TreeIO_GF, "Implicit MT threads (0 = off)", -1),
+		      new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  IMTThreads_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  IMTThreads_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  IMTThreads_NEL->GetEntry()->SetLimitValues(0,NumProcessors);
+  IMTThreads_NEL->GetEntry()->SetNumber(0);
+
+  TreeIO_GF->AddFrame(ReadAheadSize_NEL = new ADAQNumberEntryWithLabel(TreeIO_GF, "Read-ahead size (kB)", -1),
+		      new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  ReadAheadSize_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  ReadAheadSize_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  ReadAheadSize_NEL->GetEntry()->SetLimitValues(0,65536);
+  ReadAheadSize_NEL->GetEntry()->SetNumber(256);
+
+  TreeIO_GF->AddFrame(WaveformCacheSize_NEL = new ADAQNumberEntryWithLabel(TreeIO_GF, "Waveform cache per channel (MB)", -1),
+		      new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  WaveformCacheSize_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  WaveformCacheSize_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  WaveformCacheSize_NEL->GetEntry()->SetLimitValues(0,4096);
+  WaveformCacheSize_NEL->GetEntry()->SetNumber(64);
+
+  TreeIO_GF->AddFrame(WaveformPrefetch_NEL = new ADAQNumberEntryWithLabel(TreeIO_GF, "Waveforms to prefetch", -1),
+		      new TGLayoutHints(kLHintsNormal, 0,0,5,0));
+  WaveformPrefetch_NEL->GetEntry()->SetNumStyle(TGNumberFormat::kNESInteger);
+  WaveformPrefetch_NEL->GetEntry()->SetNumLimits(TGNumberFormat::kNELLimitMinMax);
+  WaveformPrefetch_NEL->GetEntry()->SetLimitValues(0,10000);
+  WaveformPrefetch_NEL->GetEntry()->SetNumber(32);
+
+
+  // Processing profile options
+
+  TGGroupFrame *Profile_GF = new TGGroupFrame(ProcessingFrame_VF, "Processing profile", kVerticalFrame);
+  ProcessingFrame_VF->AddFrame(Profile_GF, new TGLayoutHints(kLHintsLeft, 5,5,5,5));
+
+  Profile_GF->AddFrame(ProfileProcessing_CB = new TGCheckButton(Profile_GF, "Time and count processing stages", ProfileProcessing_CB_ID),
+		       new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  ProfileProcessing_CB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleCheckButtons()");
+
+  TGHorizontalFrame *ProfileName_HF = new TGHorizontalFrame(Profile_GF);
+  Profile_GF->AddFrame(ProfileName_HF, new TGLayoutHints(kLHintsLeft, 0,0,0,0));
+  
+  ProfileName_HF->AddFrame(ProfileFileSelection_TB = new TGTextButton(ProfileName_HF, "JSON ... ", ProfileFileSelection_TB_ID),
+			   new TGLayoutHints(kLHintsLeft, 0,5,5,0));
+  ProfileFileSelection_TB->Resize(60,25);
+  ProfileFileSelection_TB->SetBackgroundColor(ThemeForegroundColor);
+  ProfileFileSelection_TB->ChangeOptions(ProfileFileSelection_TB->GetOptions() | kFixedSize);
+  ProfileFileSelection_TB->Connect("Clicked()", "AAProcessingSlots", ProcessingSlots, "HandleTextButtons()");
+  
+  ProfileName_HF->AddFrame(ProfileFileName_TE = new TGTextEntry(ProfileName_HF, "<No file currently selected>", -1),
+			   new TGLayoutHints(kLHintsLeft, 5,0,5,5));
+  ProfileFileName_TE->Resize(180,25);
+  ProfileFileName_TE->SetAlignment(kTextRight);
+  ProfileFileName_TE->SetBackgroundColor(ThemeForegroundColor);
+  ProfileFileName_TE->ChangeOptions(ProfileFileName_TE->GetOptions() | kFixedSize);
+
+  // The profile of the most recent processing run is displayed here
+  Profile_GF->AddFrame(ProfileReport_TV = new TGTextView(Profile_GF, 310, 220),
+		       new TGLayoutHints(kLHintsLeft, 0,0,5,5));
+  ProfileReport_TV->SetBackgroundColor(ThemeForegroundColor);
 }
 
 
@@ -2405,8 +2884,11 @@ void AAInterface::FillCanvasFrame()
 
 void AAInterface::SaveSettings(bool SaveToFile)
 {
-  delete ADAQSettings;
-  ADAQSettings = new AASettings;
+  // The settings object is updated in place (the manager classes hold
+  // the same pointer) after a copy of the previous values is made so
+  // that the changed fields and invalidated pipeline stages can be
+  // determined once all widget values have been read
+  AASettings PreviousSettings(*ADAQSettings);
   
   TFile *ADAQSettingsFile = 0;
   if(SaveToFile)
@@ -2444,6 +2926,13 @@ void AAInterface::SaveSettings(bool SaveToFile)
 
   ADAQSettings->UsePileupRejection = UsePileupRejection_CB->IsDown();
 
+  ADAQSettings->UsePeakTiming = UsePeakTiming_CB->IsDown();
+  ADAQSettings->TimingCFD = TimingCFD_RB->IsDown();
+  ADAQSettings->TimingLeadingEdge = TimingLeadingEdge_RB->IsDown();
+  ADAQSettings->CFDFraction = CFDFraction_NEL->GetEntry()->GetNumber();
+  ADAQSettings->CFDDelay = CFDDelay_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->LeadingEdgeThreshold = LeadingEdgeThreshold_NEL->GetEntry()->GetNumber();
+
   ADAQSettings->PlotAnalysisRegion = PlotAnalysisRegion_CB->IsDown();
   ADAQSettings->AnalysisRegionMin = AnalysisRegionMin_NEL->GetEntry()->GetIntNumber();
   ADAQSettings->AnalysisRegionMax = AnalysisRegionMax_NEL->GetEntry()->GetIntNumber();
@@ -2451,11 +2940,27 @@ void AAInterface::SaveSettings(bool SaveToFile)
   ADAQSettings->PlotBaselineRegion = PlotBaselineRegion_CB->IsDown();
   ADAQSettings->BaselineRegionMin = BaselineRegionMin_NEL->GetEntry()->GetIntNumber();
   ADAQSettings->BaselineRegionMax = BaselineRegionMax_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->BaselineEstimator = BaselineEstimator_CBL->GetComboBox()->GetSelected();
+  ADAQSettings->BaselineTrimFraction = BaselineTrimFraction_NEL->GetEntry()->GetNumber();
+  ADAQSettings->BaselineMedianWindow = BaselineMedianWindow_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->BaselineTimeConstant = BaselineTimeConstant_NEL->GetEntry()->GetNumber();
+  ADAQSettings->BaselineThreshold = BaselineThreshold_NEL->GetEntry()->GetNumber();
   
   ADAQSettings->PlotTrigger = PlotTrigger_CB->IsDown();
   
   ADAQSettings->WaveformAnalysis = WaveformAnalysis_CB->IsDown();
 
+  ADAQSettings->PersistenceFirstWaveform = PersistenceFirstWaveform_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->PersistenceLastWaveform = PersistenceLastWaveform_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->PersistenceXBins = PersistenceXBins_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->PersistenceYBins = PersistenceYBins_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->PersistenceYMin = PersistenceYMin_NEL->GetEntry()->GetNumber();
+  ADAQSettings->PersistenceYMax = PersistenceYMax_NEL->GetEntry()->GetNumber();
+  ADAQSettings->PersistenceEnergyGate = PersistenceEnergyGate_CB->IsDown();
+  ADAQSettings->PersistenceEnergyMin = PersistenceEnergyMin_NEL->GetEntry()->GetNumber();
+  ADAQSettings->PersistenceEnergyMax = PersistenceEnergyMax_NEL->GetEntry()->GetNumber();
+  ADAQSettings->PersistencePSDGate = PersistencePSDGate_CB->IsDown();
+
 
   //////////////////////////////////////
   // Values from "Spectrum" tabbed frame
@@ -2472,6 +2977,15 @@ void AAInterface::SaveSettings(bool SaveToFile)
   ADAQSettings->ADAQSpectrumAlgorithmSMS = ADAQSpectrumAlgorithmSMS_RB->IsDown();
   ADAQSettings->ADAQSpectrumAlgorithmPF = ADAQSpectrumAlgorithmPF_RB->IsDown();
   ADAQSettings->ADAQSpectrumAlgorithmWD = ADAQSpectrumAlgorithmWD_RB->IsDown();
+  ADAQSettings->ADAQSpectrumAlgorithmDS = ADAQSpectrumAlgorithmDS_RB->IsDown();
+
+  ADAQSettings->ShaperTrapezoid = ShaperTrapezoid_RB->IsDown();
+  ADAQSettings->ShaperCRRC = ShaperCRRC_RB->IsDown();
+  ADAQSettings->ShaperRiseTime = ShaperRiseTime_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->ShaperFlatTop = ShaperFlatTop_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->ShaperShapingTime = ShaperShapingTime_NEL->GetEntry()->GetNumber();
+  ADAQSettings->ShaperOrder = ShaperOrder_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->ShaperDecayTime = ShaperDecayTime_NEL->GetEntry()->GetNumber();
 
   ADAQSettings->ASIMSpectrumTypeEnergy = ASIMSpectrumTypeEnergy_RB->IsDown();
   ADAQSettings->ASIMSpectrumTypePhotonsCreated = ASIMSpectrumTypePhotonsCreated_RB->IsDown();
@@ -2501,6 +3015,7 @@ void AAInterface::SaveSettings(bool SaveToFile)
   ADAQSettings->PlotLessBackground = SpectrumLessBackground_RB->IsDown();
   
   ADAQSettings->SpectrumFindIntegral = SpectrumFindIntegral_CB->IsDown();
+  ADAQSettings->SpectrumParticleEnergy = EASpectrumEnergy_CBL->GetComboBox()->GetSelected();
   ADAQSettings->SpectrumIntegralInCounts = SpectrumIntegralInCounts_CB->IsDown();
   ADAQSettings->SpectrumUseGaussianFit = SpectrumUseGaussianFit_CB->IsDown();
 
@@ -2612,12 +3127,34 @@ void AAInterface::SaveSettings(bool SaveToFile)
 
   ADAQSettings->NumProcessors = NumProcessors_NEL->GetEntry()->GetIntNumber();
   ADAQSettings->UpdateFreq = UpdateFreq_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->UseFixedPoint = UseFixedPoint_CB->IsDown();
 
   ADAQSettings->WaveformsToDesplice = DesplicedWaveformNumber_NEL->GetEntry()->GetIntNumber();
   ADAQSettings->DesplicedWaveformBuffer = DesplicedWaveformBuffer_NEL->GetEntry()->GetIntNumber();
   ADAQSettings->DesplicedWaveformLength = DesplicedWaveformLength_NEL->GetEntry()->GetIntNumber();
   ADAQSettings->DesplicedFileName = DesplicedFileName_TE->GetText();
 
+  ADAQSettings->ListModeOutput = ListModeOutput_CB->IsDown();
+  ADAQSettings->ListModeFileName = ListModeFileName_TE->GetText();
+  ADAQSettings->UsePileupRecovery = UsePileupRecovery_CB->IsDown();
+  ADAQSettings->PulseTemplateFileName = PulseTemplateFileName_TE->GetText();
+  ADAQSettings->BuildPulseTemplates = BuildPulseTemplates_CB->IsDown();
+  ADAQSettings->PulseTemplateOutputFileName = PulseTemplateOutputFileName_TE->GetText();
+  ADAQSettings->TemplatePreSamples = TemplatePreSamples_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->TemplatePostSamples = TemplatePostSamples_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->TemplateWindowMin = TemplateWindowMin_NEL->GetEntry()->GetNumber();
+  ADAQSettings->TemplateWindowMax = TemplateWindowMax_NEL->GetEntry()->GetNumber();
+  ADAQSettings->ProfileProcessing = ProfileProcessing_CB->IsDown();
+  ADAQSettings->ProfileFileName = ProfileFileName_TE->GetText();
+
+  ADAQSettings->TreeCacheSize = TreeCacheSize_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->TreeCacheLearnEntries = TreeCacheLearnEntries_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->TreeCacheChannelOnly = TreeCacheChannelOnly_CB->IsDown();
+  ADAQSettings->IMTThreads = IMTThreads_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->ReadAheadSize = ReadAheadSize_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->WaveformCacheSize = WaveformCacheSize_NEL->GetEntry()->GetIntNumber();
+  ADAQSettings->WaveformPrefetch = WaveformPrefetch_NEL->GetEntry()->GetIntNumber();
+
   
   /////////////////////////////////
   // Values from the "Canvas" frame
@@ -2646,11 +3183,17 @@ void AAInterface::SaveSettings(bool SaveToFile)
   ADAQSettings->UseSpectraCalibrations = ComputationMgr->GetUseSpectraCalibrations();
   ADAQSettings->SpectraCalibrationData = ComputationMgr->GetSpectraCalibrationData();
   ADAQSettings->SpectraCalibrations = ComputationMgr->GetSpectraCalibrations();
+
+  // Scintillator response libraries assigned to the channels
+  ADAQSettings->ScintillatorResponses = InterpolationMgr->GetChannelResponseNames(NumDataChannels);
   
   // PSD filter objects
   ADAQSettings->UsePSDRegions = ComputationMgr->GetUsePSDRegions();
   ADAQSettings->PSDRegions = ComputationMgr->GetPSDRegions();
 
+  // Determine which settings have changed since the previous update
+  ADAQSettings->TrackChanges(&PreviousSettings);
+
   // Update the settings object pointer in the manager classes
   ComputationMgr->SetADAQSettings(ADAQSettings);
   GraphicsMgr->SetADAQSettings(ADAQSettings);
@@ -2804,6 +3347,9 @@ void AAInterface::UpdateForADAQFile()
   PSDWaveforms_NEL->GetEntry()->SetLimitValues(1, WaveformsInFile);
   PSDWaveforms_NEL->GetEntry()->SetNumber(WaveformsInFile);
 
+  // Select the scintillator response assigned to the channel
+  UpdateEAResponseWidgets();
+
   // Resetting radio buttons must account for enabling/disabling
   
   if(ADAQSpectrumTypePAS_RB->IsDown()){
@@ -2841,6 +3387,13 @@ void AAInterface::UpdateForADAQFile()
   else
     ADAQSpectrumAlgorithmWD_RB->SetEnabled(true);
 
+  if(ADAQSpectrumAlgorithmDS_RB->IsDown()){
+    ADAQSpectrumAlgorithmDS_RB->SetEnabled(true);
+    ADAQSpectrumAlgorithmDS_RB->SetState(kButtonDown);
+  }
+  else
+    ADAQSpectrumAlgorithmDS_RB->SetEnabled(true);
+
   
   // Disable all ASIM-specific analysis widgets
 
@@ -2887,6 +3440,7 @@ void AAInterface::UpdateForASIMFile()
   ADAQSpectrumAlgorithmSMS_RB->SetState(kButtonDisabled);
   ADAQSpectrumAlgorithmPF_RB->SetState(kButtonDisabled);
   ADAQSpectrumAlgorithmWD_RB->SetState(kButtonDisabled);
+  ADAQSpectrumAlgorithmDS_RB->SetState(kButtonDisabled);
 
   if(ASIMSpectrumTypeEnergy_RB->IsDown()){
     ASIMSpectrumTypeEnergy_RB->SetEnabled(true);
@@ -2909,26 +3463,21 @@ void AAInterface::UpdateForASIMFile()
   else
     ASIMSpectrumTypePhotonsCreated_RB->SetEnabled(true);
 
-  TList *ASIMEventTreeList = ComputationMgr->GetASIMEventTreeList();
+  const vector<string> &ASIMEventTreeNames = ComputationMgr->GetASIMEventTreeNames();
 
   ASIMEventTree_CB->SetEnabled(true);
   ASIMEventTree_CB->RemoveAll();
 
-  TIter It(ASIMEventTreeList);
-  TTree *EventTree = NULL;
-  int EventTreeID = 0;
-  int EventTreeEntries = 0;
-  while((EventTree = (TTree *)It.Next())){
-    // Add the event tree name to the combo box with integer ID
-    ASIMEventTree_CB->AddEntry(EventTree->GetName(), EventTreeID);
-
-    // Get the total entries in the first TTree
-    if(EventTreeID == 0)
-      EventTreeEntries = EventTree->GetEntries();
+  // Add the event tree names to the combo box with integer IDs. Only
+  // the first TTree is read from the file to get its total entries
+  Long64_t EventTreeEntries = 0;
+  for(size_t t=0; t<ASIMEventTreeNames.size(); t++)
+    ASIMEventTree_CB->AddEntry(ASIMEventTreeNames[t].c_str(), t);
 
-    // Increment the integer ID
-    EventTreeID++;
-  }
+  if(!ASIMEventTreeNames.empty())
+    EventTreeEntries = ComputationMgr->GetASIMEventTreeEntries(ASIMEventTreeNames[0]);
+  if(EventTreeEntries < 0)
+    EventTreeEntries = 0;
 
   ASIMEventTree_CB->Select(0,false);
 
@@ -3076,6 +3625,8 @@ void AAInterface::SetEAGammaWidgetState(bool WidgetState, EButtonState ButtonSta
 
 void AAInterface::SetEANeutronWidgetState(bool WidgetState, EButtonState ButtonState)
 {
+  EAResponse_CBL->GetComboBox()->SetEnabled(WidgetState);
+  EAResponseLoad_TB->SetState(ButtonState);
   EALightConversionFactor_NEL->GetEntry()->SetState(WidgetState);
   EAErrorWidth_NEL->GetEntry()->SetState(WidgetState);
   EAElectronEnergy_NEL->GetEntry()->SetState(WidgetState);
@@ -3086,6 +3637,26 @@ void AAInterface::SetEANeutronWidgetState(bool WidgetState, EButtonState ButtonS
 }
 
 
+void AAInterface::UpdateEAResponseWidgets()
+{
+  int Channel = ChannelSelector_CBL->GetComboBox()->GetSelected();
+  AAScintillatorResponse *Response = InterpolationMgr->GetChannelResponse(Channel);
+
+  // The combo box entry IDs index the (sorted) response library names
+  vector<string> Names = InterpolationMgr->GetResponseLibraryNames();
+
+  TGComboBox *Response_CB = EAResponse_CBL->GetComboBox();
+  Response_CB->RemoveAll();
+  for(size_t i=0; i<Names.size(); i++){
+    Response_CB->AddEntry(Names[i].c_str(), i);
+    if(Names[i] == Response->GetName())
+      Response_CB->Select(i, false);
+  }
+  
+  EALightConversionFactor_NEL->GetEntry()->SetNumber(Response->GetConversionFactor());
+}
+
+
 void AAInterface::SetSpectrumBackgroundWidgetState(bool WidgetState, EButtonState ButtonState)
 {
   SpectrumBackgroundIterations_NEL->GetEntry()->SetState(WidgetState);
@@ -22,16 +22,15 @@
 //       calibrated energy deposition spectra) into incident kinetic
 //       energy of various particles. It is constructed as a Meyer's
 //       singleton and made available throughout the code via static
-//       methods. At present, only a single set of response functions
-//       for EJ301/BC501A/NE213 is implemented; future work will
-//       incorporate multiple response functions and multiple
-//       scintillators for a more thorough set of analysis tools.
+//       methods. The compiled EJ301/BC501A/NE213 response functions
+//       are the default response; additional scintillator response
+//       libraries (see AAScintillatorResponse) may be loaded from data
+//       files and assigned to individual digitizer channels.
 //
 /////////////////////////////////////////////////////////////////////////////////
 
 // C++
 #include <iostream>
-#include <cmath>
 using namespace std;
 
 // ADAQAnalysis
@@ -47,108 +46,110 @@ AAInterpolation *AAInterpolation::GetInstance()
 
 
 AAInterpolation::AAInterpolation()
-  : m_e(0.511), MeV2GeV(0.001), NumParticles(4),
-    ConversionFactor(1.)
 {
   if(TheInterpolationManager)
     cout << "\nError! TheInterpolationManager was constructed twice!\n" << endl;
   TheInterpolationManager = this;
 
-  // Put the data arrays into a vector for indexable access. There is
-  // no electron data since it is constructed from the linear response
+  // Construct the default EJ301 response from the compiled data
 
-  Data.push_back(NULL);
-  Data.push_back(ProtonData);
-  Data.push_back(AlphaData);
-  Data.push_back(CarbonData);
-
-  // Initialize the vectors
-
-  vector<double> Init;
-  for(int i=0; i<NumParticles; i++){
-    Light.push_back(Init);
-    Response.push_back(new TGraph);
-    Inverse.push_back(new TGraph);
-  }
-
-  ConstructResponses();
+  vector<double> E(EnergyDep, EnergyDep+LightEntries);
+  vector<double> Proton(ProtonData, ProtonData+LightEntries);
+  vector<double> Alpha(AlphaData, AlphaData+LightEntries);
+  vector<double> Carbon(CarbonData, CarbonData+LightEntries);
+  
+  DefaultResponse = new AAScintillatorResponse("EJ301", PhotonsPerMeVee, 1.,
+					       E, Proton, Alpha, Carbon);
+  ResponseLibraries[DefaultResponse->GetName()] = DefaultResponse;
 }
 
 
 AAInterpolation::~AAInterpolation()
 {
-  for(int particle=0; particle<NumParticles; particle++){
-    delete Response[particle];
-    delete Inverse[particle];
-  }  
+  map<string, AAScintillatorResponse *>::iterator It;
+  for(It=ResponseLibraries.begin(); It!=ResponseLibraries.end(); It++)
+    delete It->second;
 }
 
 
-void AAInterpolation::ConstructResponses()
+string AAInterpolation::LoadResponseLibrary(string FileName)
 {
-  // Iterate to construct the scintillation light response
-  // (E_deposited vs light output) and inverse response (light output
-  // vs. E_deposited) for all particles
-  for(int particle=0; particle<NumParticles; particle++){
-
-    // Clear previous responses
-    Light[particle].clear();
-    delete Response[particle];
-    delete Inverse[particle];
-
-    for(int entry=0; entry<LightEntries; entry++){
-      // Linear e- response is constructed from energy deposition
-      if(particle == ELECTRON)
-	Light[particle].push_back(EnergyDep[entry] * PhotonsPerMeVee);
-
-      // Nonlinear p/a/c response is constructed from data
-      else
-	Light[particle].push_back(Data[particle][entry] * PhotonsPerMeVee * ConversionFactor);
-    }
-
-    // Construct the response and inversve functions
-    Response[particle] = new TGraph(LightEntries, EnergyDep, &Light[particle][0]);
-    Inverse[particle] = new TGraph(LightEntries, &Light[particle][0], EnergyDep);
+  AAScintillatorResponse *Response = AAScintillatorResponse::Load(FileName);
+  if(Response == NULL)
+    return "";
+
+  string Name = Response->GetName();
+
+  // The default response may not be replaced since it is referenced
+  // throughout the code
+  if(Name == DefaultResponse->GetName()){
+    cout << "\nError! The response library name '" << Name << "' is reserved!\n" << endl;
+    delete Response;
+    return "";
+  }
+
+  // Replace any library of the same name, including its assignments
+  if(ResponseLibraries.count(Name)){
+    AAScintillatorResponse *Previous = ResponseLibraries[Name];
+    for(size_t ch=0; ch<ChannelResponses.size(); ch++)
+      if(ChannelResponses[ch] == Previous)
+	ChannelResponses[ch] = Response;
+    delete Previous;
   }
+  ResponseLibraries[Name] = Response;
+  
+  return Name;
 }
 
 
-// Method to get the electron energy deposition based on the energy
-// deposited by the specified particle
-double AAInterpolation::GetElectronEnergy(double Energy, int Particle)
+vector<string> AAInterpolation::GetResponseLibraryNames()
 {
-  double Light = Response[Particle]->Eval(Energy, 0, "S");
-  return Inverse[ELECTRON]->Eval(Light, 0, "S");
+  vector<string> Names;
+  map<string, AAScintillatorResponse *>::iterator It;
+  for(It=ResponseLibraries.begin(); It!=ResponseLibraries.end(); It++)
+    Names.push_back(It->first);
+  return Names;
 }
 
 
-// Method to get the gamma energy from electron equivalent energy (EE)
-double AAInterpolation::GetGammaEnergy(double EE)
+AAScintillatorResponse *AAInterpolation::GetResponseLibrary(string Name)
 {
-  double square_root = sqrt(pow(EE,2)-(4*-1*EE*m_e/2));
-  return ((EE+square_root)/2);
+  map<string, AAScintillatorResponse *>::iterator It = ResponseLibraries.find(Name);
+  return (It == ResponseLibraries.end()) ? NULL : It->second;
 }
 
 
-// Method to get the proton/neutron energy from EE energy
-double AAInterpolation::GetProtonEnergy(double EE)
+bool AAInterpolation::SetChannelResponse(int Channel, string Name)
 {
-  double Light = Response[ELECTRON]->Eval(EE, 0, "S");
-  return Inverse[PROTON]->Eval(Light, 0, "S");
+  AAScintillatorResponse *Response = GetResponseLibrary(Name);
+  if(Channel < 0 or Response == NULL)
+    return false;
+
+  if(Channel >= (int)ChannelResponses.size())
+    ChannelResponses.resize(Channel+1, NULL);
+  ChannelResponses[Channel] = Response;
+  
+  return true;
 }
 
 
-// Method to get the alpha energy from the EE energy
-double AAInterpolation::GetAlphaEnergy(double EE)
+// Method to get the response of a channel. The returned pointer
+// remains valid until the library is replaced and is intended to be
+// fetched once outside of any processing loop
+AAScintillatorResponse *AAInterpolation::GetChannelResponse(int Channel)
 {
-  double Light = Response[ELECTRON]->Eval(EE, 0, "S");
-  return Inverse[ALPHA]->Eval(Light, 0, "S");
+  if(Channel < 0 or Channel >= (int)ChannelResponses.size() or ChannelResponses[Channel] == NULL)
+    return DefaultResponse;
+  return ChannelResponses[Channel];
 }
 
 
-// Method to get the carbon energy from the EE energy
-double AAInterpolation::GetCarbonEnergy(double EE)
+// Method to get the names of the responses assigned to the first N
+// channels, e.g. for storage in the analysis settings
+vector<string> AAInterpolation::GetChannelResponseNames(int N)
 {
-  double Light = Response[ELECTRON]->Eval(EE, 0, "S");
-  return (Inverse[CARBON]->Eval(Light, 0, "S") * MeV2GeV);
+  vector<string> Names;
+  for(int ch=0; ch<N; ch++)
+    Names.push_back(GetChannelResponse(ch)->GetName());
+  return Names;
 }
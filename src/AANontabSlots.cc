@@ -184,6 +184,9 @@ void AANontabSlots::HandleDoubleSliders()
     else if(GraphicsMgr->GetCanvasContentType() == zPSDHistogram and ComputationMgr->GetPSDHistogramExists())
       GraphicsMgr->PlotPSDHistogram();
     
+    else if(GraphicsMgr->GetCanvasContentType() == zPersistenceMap and ComputationMgr->GetPersistenceMapExists())
+      GraphicsMgr->PlotPersistenceMap();
+    
     break;
 
   case SpectrumIntegrationLimits_DHS_ID:
@@ -422,11 +425,13 @@ void AANontabSlots::HandleMenu(int MenuID)
   case MenuFileSavePSDHistogramSlice_ID:{
 
     // Create character arrays that enable file type selection (.dat
-    // files have data columns separated by spaces and .csv have data
-    // columns separated by commas)
+    // files have data columns separated by spaces, .csv have data
+    // columns separated by commas, and .npy store the data columns as
+    // a binary NumPy array of doubles)
     const char *FileTypes[] = {"ASCII file",  "*.dat",
 			       "CSV file",    "*.csv",
 			       "ROOT file",   "*.root",
+			       "NumPy file",  "*.npy",
 			       0,             0};
 
     TGFileInfo FileInformation;
@@ -521,11 +526,6 @@ void AANontabSlots::HandleMenu(int MenuID)
 	  break;
 	}
 
-	if(FileExtension != ".root"){
-	  TheInterface->CreateMessageBox("PSD histograms may only be saved to a ROOT TFile (*.root). Please reselect file type!","Stop");
-	  break;
-	}
-
 	Success = ComputationMgr->SaveHistogramData("PSDHistogram", FileName, FileExtension);
       }
       
@@ -543,6 +543,8 @@ void AANontabSlots::HandleMenu(int MenuID)
 	  TheInterface->CreateMessageBox("The histogram was successfully saved to the .dat file","Asterisk");
 	else if(FileExtension == ".csv")
 	  TheInterface->CreateMessageBox("The histogram was successfully saved to the .csv file","Asterisk");
+	else if(FileExtension == ".npy")
+	  TheInterface->CreateMessageBox("The histogram was successfully saved to the .npy file","Asterisk");
 	else if(FileExtension == ".root")
 	  TheInterface->CreateMessageBox("The histogram (named 'Waveform','Spectrum',or 'PSDHistogram') \nwas successfully saved to the .root file!\n","Asterisk");
       }
@@ -759,16 +761,17 @@ void AANontabSlots::HandleTripleSliderPointer()
     
     // The user can drag the triple slider point in order to calculate
     // the energy deposition from other particle to produce the
-    // equivalent amount of light as electrons. This feature is only
-    // intended for use for EJ301/EJ309 liqoid organic scintillators.
-    // Note that the spectra must be calibrated in MeVee.
+    // equivalent amount of light as electrons using the scintillator
+    // response library assigned to the channel. Note that the spectra
+    // must be calibrated in MeVee and plotted as the energy deposited.
     
     const int Channel = TheInterface->ChannelSelector_CBL->GetComboBox()->GetSelected();
     bool SpectrumIsCalibrated = ComputationMgr->GetUseSpectraCalibrations()[Channel];
+    bool SpectrumIsConverted = (TheInterface->EASpectrumEnergy_CBL->GetComboBox()->GetSelected() != zEnergyDeposited);
     
     if(TheInterface->EAEnable_CB->IsDown()){
 
-      if((TheInterface->ADAQFileLoaded and SpectrumIsCalibrated) or
+      if((TheInterface->ADAQFileLoaded and SpectrumIsCalibrated and !SpectrumIsConverted) or
 	 TheInterface->ASIMFileLoaded){
       
 	int Type = TheInterface->EASpectrumType_CBL->GetComboBox()->GetSelected();
@@ -793,16 +796,19 @@ void AANontabSlots::HandleTripleSliderPointer()
 	  
 	  TheInterface->EAElectronEnergy_NEL->GetEntry()->SetNumber(XPos);
 	  
-	  double GE = InterpolationMgr->GetGammaEnergy(XPos);
+	  // Use the scintillator response assigned to the channel
+	  AAScintillatorResponse *Response = InterpolationMgr->GetChannelResponse(Channel);
+	  
+	  double GE = Response->GetGammaEnergy(XPos);
 	  TheInterface->EAGammaEnergy_NEL->GetEntry()->SetNumber(GE);
 	  
-	  double PE = InterpolationMgr->GetProtonEnergy(XPos);
+	  double PE = Response->GetProtonEnergy(XPos);
 	  TheInterface->EAProtonEnergy_NEL->GetEntry()->SetNumber(PE);
 	  
-	  double AE = InterpolationMgr->GetAlphaEnergy(XPos);
+	  double AE = Response->GetAlphaEnergy(XPos);
 	  TheInterface->EAAlphaEnergy_NEL->GetEntry()->SetNumber(AE);
 	  
-	  double CE = InterpolationMgr->GetCarbonEnergy(XPos);
+	  double CE = Response->GetCarbonEnergy(XPos);
 	  TheInterface->EACarbonEnergy_NEL->GetEntry()->SetNumber(CE);
 	}
       }
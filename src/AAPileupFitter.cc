@@ -0,0 +1,184 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAPileupFitter.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAPileupFitter class fits average pulse templates to
+//       pileup events to recover the height and area of each
+//       constituent pulse.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <cmath>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAPileupFitter.hh"
+
+
+AAPileupFitter::AAPileupFitter()
+  : TemplatePeak(0)
+{;}
+
+
+Bool_t AAPileupFitter::SetTemplate(const Double_t *Samples, Int_t N)
+{
+  ClearTemplate();
+
+  if(N < 2)
+    return false;
+
+  Int_t Peak = 0;
+  for(Int_t n=1; n<N; n++)
+    if(Samples[n] > Samples[Peak])
+      Peak = n;
+
+  if(Samples[Peak] <= 0.)
+    return false;
+
+  Template.assign(Samples, Samples+N);
+  TemplatePeak = Peak;
+  
+  for(Int_t n=0; n<N; n++)
+    Template[n] /= Samples[Peak];
+  
+  return true;
+}
+
+
+void AAPileupFitter::ClearTemplate()
+{
+  Template.clear();
+  TemplatePeak = 0;
+}
+
+
+// Linear interpolation of the template at the (fractional) sample X
+// relative to the start of the template; zero outside the template
+Double_t AAPileupFitter::Evaluate(Double_t X)
+{
+  if(X < 0.)
+    return 0.;
+
+  Int_t n = (Int_t)X;
+  if(n >= (Int_t)Template.size()-1)
+    return (n == (Int_t)Template.size()-1 and X == n) ? Template[n] : 0.;
+
+  Double_t Fraction = X - n;
+  return Template[n] + Fraction*(Template[n+1] - Template[n]);
+}
+
+
+Double_t AAPileupFitter::Integrate(Double_t Position, Int_t Lower, Int_t Upper)
+{
+  Double_t Offset = TemplatePeak - Position;
+  Double_t Sum = 0.;
+  for(Int_t sample=Lower; sample<=Upper; sample++)
+    Sum += Evaluate(sample + Offset);
+  return Sum;
+}
+
+
+Bool_t AAPileupFitter::Fit(const Float_t *Samples, Int_t Min, Int_t Max,
+			   const vector<Double_t> &Positions, vector<Double_t> &Heights)
+{
+  const Int_t K = Positions.size();
+  const Int_t L = Max - Min + 1;
+
+  Heights.assign(K, 0.);
+
+  if(Template.empty() or K == 0 or L < K)
+    return false;
+
+  // Shift the template to each pulse position over the fit region
+  Shifted.resize(K*L);
+  for(Int_t k=0; k<K; k++){
+    Double_t Offset = TemplatePeak - Positions[k];
+    for(Int_t i=0; i<L; i++)
+      Shifted[k*L + i] = Evaluate(Min + i + Offset);
+  }
+
+  // Build the normal equations A*h = b where A(j,k) is the overlap of
+  // the shifted templates j and k and b(j) is the overlap of the
+  // shifted template j with the waveform
+  Matrix.assign(K*K, 0.);
+  Vector.assign(K, 0.);
+
+  for(Int_t j=0; j<K; j++){
+    const Double_t *Tj = &Shifted[j*L];
+    
+    for(Int_t i=0; i<L; i++)
+      Vector[j] += Tj[i]*Samples[Min+i];
+    
+    for(Int_t k=j; k<K; k++){
+      const Double_t *Tk = &Shifted[k*L];
+      Double_t Sum = 0.;
+      for(Int_t i=0; i<L; i++)
+	Sum += Tj[i]*Tk[i];
+      Matrix[j*K + k] = Matrix[k*K + j] = Sum;
+    }
+  }
+
+  Double_t Scale = 0.;
+  for(Int_t j=0; j<K; j++)
+    if(Matrix[j*K + j] > Scale)
+      Scale = Matrix[j*K + j];
+
+  if(Scale <= 0.)
+    return false;
+
+  // Gaussian elimination with partial pivoting; pulses too close
+  // together to be separated by the template produce a (near)
+  // singular system
+  for(Int_t c=0; c<K; c++){
+    Int_t Pivot = c;
+    for(Int_t r=c+1; r<K; r++)
+      if(fabs(Matrix[r*K + c]) > fabs(Matrix[Pivot*K + c]))
+	Pivot = r;
+    
+    if(fabs(Matrix[Pivot*K + c]) < 1.e-9*Scale)
+      return false;
+
+    if(Pivot != c){
+      for(Int_t k=0; k<K; k++){
+	Double_t Temp = Matrix[c*K + k];
+	Matrix[c*K + k] = Matrix[Pivot*K + k];
+	Matrix[Pivot*K + k] = Temp;
+      }
+      Double_t Temp = Vector[c];
+      Vector[c] = Vector[Pivot];
+      Vector[Pivot] = Temp;
+    }
+
+    for(Int_t r=c+1; r<K; r++){
+      Double_t Factor = Matrix[r*K + c]/Matrix[c*K + c];
+      for(Int_t k=c; k<K; k++)
+	Matrix[r*K + k] -= Factor*Matrix[c*K + k];
+      Vector[r] -= Factor*Vector[c];
+    }
+  }
+  
+  for(Int_t r=K-1; r>=0; r--){
+    Double_t Sum = Vector[r];
+    for(Int_t k=r+1; k<K; k++)
+      Sum -= Matrix[r*K + k]*Heights[k];
+    Heights[r] = Sum/Matrix[r*K + r];
+  }
+  
+  return true;
+}
@@ -57,6 +57,41 @@ void AAProcessingSlots::HandleCheckButtons()
   TheInterface->SaveSettings();
 
   switch(CheckButtonID){
+
+  case ListModeOutput_CB_ID:
+    // Alert the user that a list-mode file must be selected before
+    // any per-pulse data can be written during waveform processing
+    if(TheInterface->ListModeOutput_CB->IsDown() and
+       TheInterface->ADAQSettings->ListModeFileName == "<No file currently selected>"){
+      TheInterface->CreateMessageBox("A list-mode file must be selected before list-mode output can be enabled!","Stop");
+      TheInterface->ListModeOutput_CB->SetState(kButtonUp);
+      TheInterface->SaveSettings();
+    }
+    break;
+
+  case UsePileupRecovery_CB_ID:
+    // Pileup recovery requires a pulse template file and pileup
+    // flagging, which is enabled with the pileup rejection option
+    if(TheInterface->UsePileupRecovery_CB->IsDown() and
+       TheInterface->ADAQSettings->PulseTemplateFileName == "<No file currently selected>"){
+      TheInterface->CreateMessageBox("A pulse template file must be selected before pileup recovery can be enabled!","Stop");
+      TheInterface->UsePileupRecovery_CB->SetState(kButtonUp);
+      TheInterface->SaveSettings();
+    }
+    else if(TheInterface->UsePileupRecovery_CB->IsDown() and
+	    !TheInterface->ADAQSettings->UsePileupRejection)
+      TheInterface->CreateMessageBox("Pileup recovery requires that pileup rejection be enabled in the waveform tab!","Asterisk");
+    break;
+
+  case BuildPulseTemplates_CB_ID:
+    if(TheInterface->BuildPulseTemplates_CB->IsDown() and
+       TheInterface->ADAQSettings->PulseTemplateOutputFileName == "<No file currently selected>"){
+      TheInterface->CreateMessageBox("A pulse template output file must be selected before templates can be built!","Stop");
+      TheInterface->BuildPulseTemplates_CB->SetState(kButtonUp);
+      TheInterface->SaveSettings();
+    }
+    break;
+    
   default:
     break;
   }
@@ -203,6 +238,148 @@ void AAProcessingSlots::HandleTextButtons()
     break;
   }
     
+  case ListModeFileSelection_TB_ID:{
+
+    const char *FileTypes[] = {"ROOT file", "*.root",
+			       "All files", "*",
+			       0, 0};
+    
+    // Use the presently open ADAQ ROOT file name as the basis for the
+    // default list-mode file name presented to the user in the
+    // TGFileDialog, denoting list-mode files with the ".lm.root"
+    // extension in analogy to despliced files
+    string InitialFileName;
+    size_t Pos = TheInterface->ADAQFileName.find_last_of("/");
+    if(Pos != string::npos){
+      string RawFileName = TheInterface->ADAQFileName.substr(Pos+1,
+							     TheInterface->ADAQFileName.size());
+
+      Pos = RawFileName.find_last_of(".");
+      if(Pos != string::npos)
+	InitialFileName = RawFileName.substr(0,Pos) + ".lm.root";
+    }
+
+    TGFileInfo FileInformation;
+    FileInformation.fFileTypes = FileTypes;
+    FileInformation.fFilename = StrDup(InitialFileName.c_str());
+    FileInformation.fIniDir = StrDup(TheInterface->ListModeDirectory.c_str());
+    new TGFileDialog(gClient->GetRoot(), TheInterface, kFDSave, &FileInformation);
+    
+    if(FileInformation.fFilename==NULL)
+      TheInterface->CreateMessageBox("A file was not selected so list-mode data will not be saved!\nSelect a valid file to save the list-mode data","Stop");
+    else{
+      string ListModeFileName = FileInformation.fFilename;
+      
+      // Set the "current" directory to the directory from which the
+      // list-mode file was selected
+      size_t Found = ListModeFileName.find_last_of("/");
+      if(Found != string::npos)
+	TheInterface->ListModeDirectory = ListModeFileName.substr(0, Found);
+
+      // Ensure the list-mode file carries a ROOT file extension
+      Found = ListModeFileName.find_last_of(".");
+      if(Found == string::npos or ListModeFileName.substr(Found) != ".root")
+	ListModeFileName += ".root";
+      
+      TheInterface->ListModeFileName_TE->SetText(ListModeFileName.c_str());
+    }
+    break;
+  }
+
+  case PulseTemplateFileSelection_TB_ID:{
+
+    const char *FileTypes[] = {"ROOT file", "*.root",
+			       "All files", "*",
+			       0, 0};
+    
+    TGFileInfo FileInformation;
+    FileInformation.fFileTypes = FileTypes;
+    FileInformation.fIniDir = StrDup(TheInterface->PulseTemplateDirectory.c_str());
+    new TGFileDialog(gClient->GetRoot(), TheInterface, kFDOpen, &FileInformation);
+    
+    if(FileInformation.fFilename==NULL)
+      TheInterface->CreateMessageBox("A pulse template file was not selected!","Stop");
+    else{
+      string PulseTemplateFileName = FileInformation.fFilename;
+      
+      size_t Found = PulseTemplateFileName.find_last_of("/");
+      if(Found != string::npos)
+	TheInterface->PulseTemplateDirectory = PulseTemplateFileName.substr(0, Found);
+
+      // Load the templates now such that an invalid file is reported
+      // before any waveform processing is attempted
+      if(ComputationMgr->LoadPulseTemplates(PulseTemplateFileName))
+	TheInterface->PulseTemplateFileName_TE->SetText(PulseTemplateFileName.c_str());
+      else
+	TheInterface->CreateMessageBox("The selected file does not contain any valid pulse templates!","Stop");
+    }
+    break;
+  }
+
+  case PulseTemplateOutputSelection_TB_ID:{
+
+    const char *FileTypes[] = {"ROOT file", "*.root",
+			       "All files", "*",
+			       0, 0};
+    
+    TGFileInfo FileInformation;
+    FileInformation.fFileTypes = FileTypes;
+    FileInformation.fFilename = StrDup("PulseTemplates.root");
+    FileInformation.fIniDir = StrDup(TheInterface->PulseTemplateDirectory.c_str());
+    new TGFileDialog(gClient->GetRoot(), TheInterface, kFDSave, &FileInformation);
+    
+    if(FileInformation.fFilename==NULL)
+      TheInterface->CreateMessageBox("A file was not selected so the pulse templates will not be saved!\nSelect a valid file to save the pulse templates","Stop");
+    else{
+      string PulseTemplateFileName = FileInformation.fFilename;
+      
+      size_t Found = PulseTemplateFileName.find_last_of("/");
+      if(Found != string::npos)
+	TheInterface->PulseTemplateDirectory = PulseTemplateFileName.substr(0, Found);
+
+      // Ensure the template file carries a ROOT file extension
+      Found = PulseTemplateFileName.find_last_of(".");
+      if(Found == string::npos or PulseTemplateFileName.substr(Found) != ".root")
+	PulseTemplateFileName += ".root";
+      
+      TheInterface->PulseTemplateOutputFileName_TE->SetText(PulseTemplateFileName.c_str());
+    }
+    break;
+  }
+
+  case ProfileFileSelection_TB_ID:{
+
+    const char *FileTypes[] = {"JSON file", "*.json",
+			       "All files", "*",
+			       0, 0};
+    
+    TGFileInfo FileInformation;
+    FileInformation.fFileTypes = FileTypes;
+    FileInformation.fFilename = StrDup("ADAQAnalysisProfile.json");
+    FileInformation.fIniDir = StrDup(TheInterface->ProfileDirectory.c_str());
+    new TGFileDialog(gClient->GetRoot(), TheInterface, kFDSave, &FileInformation);
+    
+    if(FileInformation.fFilename==NULL)
+      TheInterface->CreateMessageBox("A file was not selected so the processing profile will not be saved!\nSelect a valid file to save the processing profile","Stop");
+    else{
+      string ProfileFileName = FileInformation.fFilename;
+      
+      // Set the "current" directory to the directory from which the
+      // profile file was selected
+      size_t Found = ProfileFileName.find_last_of("/");
+      if(Found != string::npos)
+	TheInterface->ProfileDirectory = ProfileFileName.substr(0, Found);
+
+      // Ensure the profile file carries a JSON file extension
+      Found = ProfileFileName.find_last_of(".");
+      if(Found == string::npos or ProfileFileName.substr(Found) != ".json")
+	ProfileFileName += ".json";
+      
+      TheInterface->ProfileFileName_TE->SetText(ProfileFileName.c_str());
+    }
+    break;
+  }
+    
   case DesplicedFileCreation_TB_ID:
     // Alert the user the filtering particles by PSD into the spectra
     // requires integration type peak finder to be used
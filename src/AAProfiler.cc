@@ -0,0 +1,256 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAProfiler.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAProfiler class accumulates per-region processing times
+//       and event counters over a single waveform processing run and
+//       reports them as text (GUI/stdout) or JSON.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <ctime>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAProfiler.hh"
+#include "AAParallel.hh"
+
+
+// Names of the profiled regions and counters (ordered to match the
+// ProfileRegions and ProfileCounters enumerators in AATypes.hh) used
+// in both the text and JSON reports
+static const char *RegionNames[zNumProfileRegions] = {
+  "TreeRead", "Transform", "PeakFinding", "PeakLimits",
+  "PeakTiming", "PileupFit", "Templates", "PSDIntegrals",
+  "Calibration", "HistogramFill", "Output"
+};
+
+static const char *CounterNames[zNumProfileCounters] = {
+  "Waveforms", "BytesRead", "Peaks", "PileupPeaks",
+  "RecoveredPeaks", "TemplatePulses", "PSDRejected",
+  "HistogramEntries", "ReadCalls"
+};
+
+
+AAProfiler::AAProfiler()
+  : Enabled(false), RunName(""), RunStart(0.), RunTime(0.), Nodes(1), Threads(1)
+{
+  BeginRun("");
+}
+
+
+Double_t AAProfiler::Now()
+{
+  timespec TS;
+  clock_gettime(CLOCK_MONOTONIC, &TS);
+  return TS.tv_sec + TS.tv_nsec*1.e-9;
+}
+
+
+void AAProfiler::BeginRun(string Name)
+{
+  RunName = Name;
+  RunTime = 0.;
+  Nodes = 1;
+  Threads = 1;
+
+  for(Int_t r=0; r<zNumProfileRegions; r++){
+    RegionTime[r] = 0.;
+    RegionCalls[r] = 0;
+  }
+
+  for(Int_t c=0; c<zNumProfileCounters; c++)
+    Counters[c] = 0;
+
+  ParameterNames.clear();
+  ParameterValues.clear();
+
+  RunStart = Now();
+}
+
+
+void AAProfiler::EndRun()
+{
+  RunTime = Now() - RunStart;
+}
+
+
+void AAProfiler::SetParameter(string Name, Double_t Value)
+{
+  for(size_t p=0; p<ParameterNames.size(); p++){
+    if(ParameterNames[p] == Name){
+      ParameterValues[p] = Value;
+      return;
+    }
+  }
+  ParameterNames.push_back(Name);
+  ParameterValues.push_back(Value);
+}
+
+
+// Merging is intended for profilers that ran concurrently (e.g. one
+// per thread) such that the run time is the longest of the two while
+// the region times and counters are summed
+void AAProfiler::Merge(const AAProfiler &Other)
+{
+  for(Int_t r=0; r<zNumProfileRegions; r++){
+    RegionTime[r] += Other.RegionTime[r];
+    RegionCalls[r] += Other.RegionCalls[r];
+  }
+
+  for(Int_t c=0; c<zNumProfileCounters; c++)
+    Counters[c] += Other.Counters[c];
+
+  if(Other.RunTime > RunTime)
+    RunTime = Other.RunTime;
+}
+
+
+// The largest number of threads merged by a stage is recorded such
+// that the report notes that its region times are summed over threads
+void AAProfiler::MergeThreads(const vector<AAProfiler> &Thread)
+{
+  for(size_t t=0; t<Thread.size(); t++)
+    Merge(Thread[t]);
+
+  if((Int_t)Thread.size() > Threads)
+    Threads = Thread.size();
+}
+
+
+void AAProfiler::AggregateToMaster()
+{
+#ifdef MPI_ENABLED
+  AAParallel *ParallelMgr = AAParallel::GetInstance();
+
+  // Pack all results into a single array such that only one MPI
+  // reduction is required
+  const Int_t ArraySize = 2*zNumProfileRegions + zNumProfileCounters;
+  Double_t Array[ArraySize];
+
+  for(Int_t r=0; r<zNumProfileRegions; r++){
+    Array[r] = RegionTime[r];
+    Array[zNumProfileRegions + r] = RegionCalls[r];
+  }
+  for(Int_t c=0; c<zNumProfileCounters; c++)
+    Array[2*zNumProfileRegions + c] = Counters[c];
+
+  Double_t *Sum = ParallelMgr->SumDoubleArrayToMaster(Array, ArraySize);
+
+  if(ParallelMgr->GetIsMaster()){
+    for(Int_t r=0; r<zNumProfileRegions; r++){
+      RegionTime[r] = Sum[r];
+      RegionCalls[r] = (Long64_t)Sum[zNumProfileRegions + r];
+    }
+    for(Int_t c=0; c<zNumProfileCounters; c++)
+      Counters[c] = (Long64_t)Sum[2*zNumProfileRegions + c];
+  }
+  delete [] Sum;
+
+  Nodes = ParallelMgr->GetSize();
+#endif
+}
+
+
+string AAProfiler::GetReport() const
+{
+  stringstream SS;
+
+  Double_t Waveforms = Counters[zCountWaveforms];
+
+  SS << "Processing profile : " << RunName << "\n"
+     << "  Run time      : " << fixed << setprecision(3) << RunTime << " s";
+  if(Nodes > 1)
+    SS << " (" << Nodes << " nodes; region times summed over nodes)";
+  SS << "\n";
+  if(Threads > 1)
+    SS << "  Threads       : " << Threads << " (region times summed over threads)\n";
+
+  if(RunTime > 0.)
+    SS << "  Throughput    : " << setprecision(1) << Waveforms/RunTime << " waveforms/s\n";
+
+  for(size_t p=0; p<ParameterNames.size(); p++)
+    SS << "  " << setw(14) << left << ParameterNames[p] << ": "
+       << setprecision(4) << ParameterValues[p] << "\n";
+
+  SS << "\n  " << setw(14) << left << "Region"
+     << setw(10) << right << "Time [s]"
+     << setw(8) << "% run"
+     << setw(12) << "Calls"
+     << setw(12) << "Mean [us]" << "\n";
+
+  for(Int_t r=0; r<zNumProfileRegions; r++){
+    Double_t Fraction = (RunTime > 0.) ? 100.*RegionTime[r]/(RunTime*Nodes) : 0.;
+    Double_t Mean = (RegionCalls[r] > 0) ? 1.e6*RegionTime[r]/RegionCalls[r] : 0.;
+
+    SS << "  " << setw(14) << left << RegionNames[r]
+       << setw(10) << right << setprecision(4) << RegionTime[r]
+       << setw(8) << setprecision(1) << Fraction
+       << setw(12) << RegionCalls[r]
+       << setw(12) << setprecision(2) << Mean << "\n";
+  }
+
+  SS << "\n";
+  for(Int_t c=0; c<zNumProfileCounters; c++)
+    SS << "  " << setw(18) << left << CounterNames[c] << ": " << Counters[c] << "\n";
+
+  return SS.str();
+}
+
+
+Bool_t AAProfiler::WriteJSON(string FileName) const
+{
+  ofstream Out(FileName.c_str(), ofstream::trunc);
+  if(!Out.is_open())
+    return false;
+
+  Out << setprecision(9)
+      << "{\n"
+      << "  \"run\": \"" << RunName << "\",\n"
+      << "  \"nodes\": " << Nodes << ",\n"
+      << "  \"threads\": " << Threads << ",\n"
+      << "  \"run_time_s\": " << RunTime << ",\n";
+
+  Out << "  \"parameters\": {";
+  for(size_t p=0; p<ParameterNames.size(); p++)
+    Out << (p ? ", " : "") << "\"" << ParameterNames[p] << "\": " << ParameterValues[p];
+  Out << "},\n";
+
+  Out << "  \"regions\": {\n";
+  for(Int_t r=0; r<zNumProfileRegions; r++)
+    Out << "    \"" << RegionNames[r] << "\": {\"time_s\": " << RegionTime[r]
+	<< ", \"calls\": " << RegionCalls[r] << "}"
+	<< ((r < zNumProfileRegions-1) ? ",\n" : "\n");
+  Out << "  },\n";
+
+  Out << "  \"counters\": {\n";
+  for(Int_t c=0; c<zNumProfileCounters; c++)
+    Out << "    \"" << CounterNames[c] << "\": " << Counters[c]
+	<< ((c < zNumProfileCounters-1) ? ",\n" : "\n");
+  Out << "  }\n"
+      << "}\n";
+
+  Out.close();
+
+  return true;
+}
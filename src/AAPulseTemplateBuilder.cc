@@ -0,0 +1,182 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAPulseTemplateBuilder.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAPulseTemplateBuilder class accumulates per-class average
+//       pulse templates during waveform processing.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// ROOT
+#include <TFile.h>
+#include <TDirectory.h>
+
+// C++
+#include <iostream>
+#include <sstream>
+#include <cmath>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAPulseTemplateBuilder.hh"
+
+
+AAPulseTemplateBuilder::AAPulseTemplateBuilder()
+  : PreSamples(0), Length(0)
+{
+  Configure(20, 100);
+}
+
+
+void AAPulseTemplateBuilder::Configure(Int_t Pre, Int_t Post)
+{
+  PreSamples = (Pre < 0) ? 0 : Pre;
+  Length = PreSamples + ((Post < 1) ? 1 : Post);
+  Reset();
+}
+
+
+void AAPulseTemplateBuilder::Reset()
+{
+  State.assign(zNumTemplateClasses*(1 + 2*Length), 0.);
+}
+
+
+Bool_t AAPulseTemplateBuilder::Accumulate(Int_t Class, const Float_t *Samples, Int_t N,
+					  Double_t Position, Double_t Height)
+{
+  if(Class < 0 or Class >= zNumTemplateClasses or Height <= 0.)
+    return false;
+
+  // The waveform position of the first template sample is split into
+  // an integer sample and the fraction towards the next sample
+  Double_t Start = Position - PreSamples;
+  Int_t First = (Int_t)floor(Start);
+  Double_t Fraction = Start - First;
+
+  if(First < 0 or First + Length >= N)
+    return false;
+
+  Double_t *S = Sum(Class);
+  Double_t *S2 = SumSq(Class);
+  const Double_t Scale = 1./Height;
+
+  for(Int_t i=0; i<Length; i++){
+    const Float_t *X = &Samples[First+i];
+    Double_t Value = (X[0] + Fraction*(X[1] - X[0]))*Scale;
+    S[i] += Value;
+    S2[i] += Value*Value;
+  }
+  
+  State[Class]++;
+
+  return true;
+}
+
+
+TH1F *AAPulseTemplateBuilder::CreateMean(Int_t Class, string Name)
+{
+  const Double_t NumPulses = State[Class];
+  if(NumPulses <= 0.)
+    return NULL;
+
+  TH1F *Mean_H = new TH1F(Name.c_str(), Name.c_str(), Length, -PreSamples, Length-PreSamples);
+  Mean_H->SetDirectory(0);
+  
+  const Double_t *S = Sum(Class);
+  const Double_t *S2 = SumSq(Class);
+  
+  // The bin errors are the standard errors of the mean
+  for(Int_t i=0; i<Length; i++){
+    Double_t Mean = S[i]/NumPulses;
+    Double_t Variance = S2[i]/NumPulses - Mean*Mean;
+    Mean_H->SetBinContent(i+1, Mean);
+    Mean_H->SetBinError(i+1, (Variance > 0.) ? sqrt(Variance/NumPulses) : 0.);
+  }
+  Mean_H->SetEntries(NumPulses);
+  
+  return Mean_H;
+}
+
+
+TH1F *AAPulseTemplateBuilder::CreateRMS(Int_t Class, string Name)
+{
+  const Double_t NumPulses = State[Class];
+  if(NumPulses <= 0.)
+    return NULL;
+
+  TH1F *RMS_H = new TH1F(Name.c_str(), Name.c_str(), Length, -PreSamples, Length-PreSamples);
+  RMS_H->SetDirectory(0);
+  
+  const Double_t *S = Sum(Class);
+  const Double_t *S2 = SumSq(Class);
+  
+  for(Int_t i=0; i<Length; i++){
+    Double_t Mean = S[i]/NumPulses;
+    Double_t Variance = S2[i]/NumPulses - Mean*Mean;
+    RMS_H->SetBinContent(i+1, (Variance > 0.) ? sqrt(Variance) : 0.);
+  }
+  RMS_H->SetEntries(NumPulses);
+  
+  return RMS_H;
+}
+
+
+// The templates are named "PulseTemplate_Ch<N>" for pulses that pass
+// the PSD region (or all pulses if no PSD region is used) and
+// "PulseTemplate_Ch<N>_Rejected" for pulses that fail it, with the
+// RMS histograms named "PulseTemplateRMS_Ch<N>[_Rejected]"
+Bool_t AAPulseTemplateBuilder::Write(string FileName, Int_t Channel)
+{
+  TDirectory *PreviousDirectory = gDirectory;
+  
+  TFile *TemplateFile = new TFile(FileName.c_str(), "update");
+  
+  if(!TemplateFile->IsOpen()){
+    cout << "\nADAQAnalysis error! The pulse template file '" << FileName << "' could not be opened!\n"
+	 << endl;
+    
+    delete TemplateFile;
+    PreviousDirectory->cd();
+    return false;
+  }
+  
+  const char *Suffix[zNumTemplateClasses] = {"", "_Rejected"};
+  
+  for(Int_t c=0; c<zNumTemplateClasses; c++){
+    stringstream SS;
+    SS << "Ch" << Channel << Suffix[c];
+    
+    TH1F *Mean_H = CreateMean(c, "PulseTemplate_" + SS.str());
+    TH1F *RMS_H = CreateRMS(c, "PulseTemplateRMS_" + SS.str());
+    
+    if(Mean_H){
+      Mean_H->Write(0, TObject::kOverwrite);
+      RMS_H->Write(0, TObject::kOverwrite);
+    }
+    
+    delete Mean_H;
+    delete RMS_H;
+  }
+  
+  TemplateFile->Close();
+  delete TemplateFile;
+  PreviousDirectory->cd();
+  
+  return true;
+}
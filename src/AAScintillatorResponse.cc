@@ -0,0 +1,302 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAScintillatorResponse.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAScintillatorResponse class holds the particle-dependent
+//       scintillation light response of a single scintillator and
+//       converts electron equivalent energies into particle energies
+//       using precomputed cubic splines of the response functions.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAScintillatorResponse.hh"
+
+
+AAScintillatorResponse::AAScintillatorResponse(string N, double PPM, double CF,
+					       const vector<double> &E,
+					       const vector<double> &ProtonData,
+					       const vector<double> &AlphaData,
+					       const vector<double> &CarbonData)
+  : m_e(0.511), MeV2GeV(0.001),
+    Name(N), PhotonsPerMeVee(PPM), ConversionFactor(CF), EnergyDep(E)
+{
+  // Put the data arrays into a vector for indexable access. There is
+  // no electron data since it is constructed from the linear response
+
+  Data.push_back(vector<double>());
+  Data.push_back(ProtonData);
+  Data.push_back(AlphaData);
+  Data.push_back(CarbonData);
+
+  // Initialize the vectors
+
+  vector<double> Init;
+  for(int i=0; i<NumParticles; i++){
+    Light.push_back(Init);
+    Response.push_back(NULL);
+    Inverse.push_back(NULL);
+    ResponseSpline.push_back(NULL);
+    InverseSpline.push_back(NULL);
+  }
+
+  ConstructResponses();
+}
+
+
+AAScintillatorResponse::~AAScintillatorResponse()
+{
+  for(int particle=0; particle<NumParticles; particle++){
+    delete Response[particle];
+    delete Inverse[particle];
+    delete ResponseSpline[particle];
+    delete InverseSpline[particle];
+  }
+}
+
+
+AAScintillatorResponse *AAScintillatorResponse::Load(string FileName)
+{
+  ifstream In(FileName.c_str());
+  if(!In.is_open()){
+    cout << "\nError! The response library '" << FileName << "' could not be opened!\n" << endl;
+    return NULL;
+  }
+
+  string ResponseName = "";
+  double PPM = 0., CF = 1.;
+  vector<double> E, ProtonData, AlphaData, CarbonData;
+
+  string Line;
+  while(getline(In, Line)){
+    stringstream SS(Line);
+    string Token;
+    if(!(SS >> Token) or Token[0] == '#')
+      continue;
+
+    if(Token == "Name")
+      SS >> ResponseName;
+    else if(Token == "PhotonsPerMeVee")
+      SS >> PPM;
+    else if(Token == "ConversionFactor")
+      SS >> CF;
+    else{
+      double Values[4];
+      stringstream Row(Line);
+      if(!(Row >> Values[0] >> Values[1] >> Values[2] >> Values[3])){
+	cout << "\nError! The response library '" << FileName << "' contains an invalid line:\n"
+	     << "       " << Line << "\n" << endl;
+	return NULL;
+      }
+      E.push_back(Values[0]);
+      ProtonData.push_back(Values[1]);
+      AlphaData.push_back(Values[2]);
+      CarbonData.push_back(Values[3]);
+    }
+  }
+
+  // The response and inverse response splines require at least three
+  // points and strictly increasing energy deposition and light output
+  bool Valid = (ResponseName != "" and PPM > 0. and E.size() >= 3);
+  for(size_t i=1; Valid and i<E.size(); i++)
+    Valid = (E[i] > E[i-1] and ProtonData[i] > ProtonData[i-1] and
+	     AlphaData[i] > AlphaData[i-1] and CarbonData[i] > CarbonData[i-1]);
+
+  if(!Valid){
+    cout << "\nError! The response library '" << FileName << "' requires a Name, a positive\n"
+	 << "       PhotonsPerMeVee, and at least three rows of strictly increasing data!\n"
+	 << endl;
+    return NULL;
+  }
+
+  return new AAScintillatorResponse(ResponseName, PPM, CF, E, ProtonData, AlphaData, CarbonData);
+}
+
+
+void AAScintillatorResponse::ConstructResponses()
+{
+  const int LightEntries = EnergyDep.size();
+
+  // Iterate to construct the scintillation light response
+  // (E_deposited vs light output) and inverse response (light output
+  // vs. E_deposited) for all particles
+  for(int particle=0; particle<NumParticles; particle++){
+
+    // Clear previous responses
+    Light[particle].clear();
+    delete Response[particle];
+    delete Inverse[particle];
+    delete ResponseSpline[particle];
+    delete InverseSpline[particle];
+
+    for(int entry=0; entry<LightEntries; entry++){
+      // Linear e- response is constructed from energy deposition
+      if(particle == ELECTRON)
+	Light[particle].push_back(EnergyDep[entry] * PhotonsPerMeVee);
+
+      // Nonlinear p/a/c response is constructed from data
+      else
+	Light[particle].push_back(Data[particle][entry] * PhotonsPerMeVee * ConversionFactor);
+    }
+
+    // Construct the response and inversve functions
+    Response[particle] = new TGraph(LightEntries, &EnergyDep[0], &Light[particle][0]);
+    Inverse[particle] = new TGraph(LightEntries, &Light[particle][0], &EnergyDep[0]);
+
+    // Construct the cubic splines identical to those that are built
+    // internally by TGraph::Eval() with the "S" option
+    ResponseSpline[particle] = new TSpline3("", Response[particle]);
+    InverseSpline[particle] = new TSpline3("", Inverse[particle]);
+  }
+}
+
+
+// Method to get the electron energy deposition based on the energy
+// deposited by the specified particle
+double AAScintillatorResponse::GetElectronEnergy(double Energy, int Particle)
+{
+  double Light = ResponseSpline[Particle]->Eval(Energy);
+  return InverseSpline[ELECTRON]->Eval(Light);
+}
+
+
+// Method to get the gamma energy from electron equivalent energy (EE)
+double AAScintillatorResponse::GetGammaEnergy(double EE)
+{
+  double square_root = sqrt(pow(EE,2)-(4*-1*EE*m_e/2));
+  return ((EE+square_root)/2);
+}
+
+
+// Method to get the proton/neutron energy from EE energy
+double AAScintillatorResponse::GetProtonEnergy(double EE)
+{
+  double Light = ResponseSpline[ELECTRON]->Eval(EE);
+  return InverseSpline[PROTON]->Eval(Light);
+}
+
+
+// Method to get the alpha energy from the EE energy
+double AAScintillatorResponse::GetAlphaEnergy(double EE)
+{
+  double Light = ResponseSpline[ELECTRON]->Eval(EE);
+  return InverseSpline[ALPHA]->Eval(Light);
+}
+
+
+// Method to get the carbon energy from the EE energy
+double AAScintillatorResponse::GetCarbonEnergy(double EE)
+{
+  double Light = ResponseSpline[ELECTRON]->Eval(EE);
+  return (InverseSpline[CARBON]->Eval(Light) * MeV2GeV);
+}
+
+
+// Batch methods to convert N EE energies into particle energies
+
+void AAScintillatorResponse::GetGammaEnergy(const double *EE, double *Energy, int N)
+{
+  for(int i=0; i<N; i++)
+    Energy[i] = GetGammaEnergy(EE[i]);
+}
+
+
+void AAScintillatorResponse::GetProtonEnergy(const double *EE, double *Energy, int N)
+{
+  for(int i=0; i<N; i++)
+    Energy[i] = GetProtonEnergy(EE[i]);
+}
+
+
+void AAScintillatorResponse::GetAlphaEnergy(const double *EE, double *Energy, int N)
+{
+  for(int i=0; i<N; i++)
+    Energy[i] = GetAlphaEnergy(EE[i]);
+}
+
+
+void AAScintillatorResponse::GetCarbonEnergy(const double *EE, double *Energy, int N)
+{
+  for(int i=0; i<N; i++)
+    Energy[i] = GetCarbonEnergy(EE[i]);
+}
+
+
+void AAScintillatorResponse::ConvertEnergies(int Type, const double *EE, double *Energy, int N)
+{
+  switch(Type){
+  case zGammaConversion: GetGammaEnergy(EE, Energy, N); break;
+  case zProtonConversion: GetProtonEnergy(EE, Energy, N); break;
+  case zAlphaConversion: GetAlphaEnergy(EE, Energy, N); break;
+  case zCarbonConversion: GetCarbonEnergy(EE, Energy, N); break;
+  default:
+    cout << "\nError! Unknown conversion type " << Type << " in AAScintillatorResponse!\n" << endl;
+  }
+}
+
+
+// Method to convert an EE energy spectrum into a particle energy
+// spectrum. Since the conversions are monotonic only the bin edges
+// need to be converted: the converted spectrum has variable width bins
+// with the contents (and errors) of the EE spectrum. NULL is returned
+// if the converted bin edges are not strictly increasing, e.g. when
+// the spectrum extends to unphysical (negative) energies
+TH1F *AAScintillatorResponse::ConvertSpectrum(TH1F *EESpectrum, int Type, double Unit)
+{
+  if(EESpectrum == NULL)
+    return NULL;
+  
+  const int NumBins = EESpectrum->GetNbinsX();
+
+  vector<double> EEEdges(NumBins+1), Edges(NumBins+1);
+  for(int bin=0; bin<=NumBins; bin++)
+    EEEdges[bin] = EESpectrum->GetXaxis()->GetBinLowEdge(bin+1) * Unit;
+
+  ConvertEnergies(Type, &EEEdges[0], &Edges[0], NumBins+1);
+
+  for(int bin=0; bin<NumBins; bin++){
+    if(!(Edges[bin+1] > Edges[bin])){
+      cout << "\nError! The converted spectrum bin edges are not increasing! Please restrict\n"
+	   << "       the EE spectrum to positive energies within the response data.\n"
+	   << endl;
+      return NULL;
+    }
+  }
+
+  stringstream SS;
+  SS << EESpectrum->GetName() << "_Conversion" << Type;
+  
+  TH1F *Spectrum = new TH1F(SS.str().c_str(), EESpectrum->GetTitle(), NumBins, &Edges[0]);
+  Spectrum->SetDirectory(0);
+  
+  // Copy the contents and errors including under/overflow bins
+  for(int bin=0; bin<=NumBins+1; bin++){
+    Spectrum->SetBinContent(bin, EESpectrum->GetBinContent(bin));
+    Spectrum->SetBinError(bin, EESpectrum->GetBinError(bin));
+  }
+  Spectrum->SetEntries(EESpectrum->GetEntries());
+
+  return Spectrum;
+}
@@ -0,0 +1,427 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AASettings.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: AASettings is the container for all values of the GUI
+//       widgets, which is passed to the manager classes and written
+//       to disk for parallel processing. This file contains the
+//       settings change tracking: each setting is assigned the mask
+//       of the waveform processing pipeline stages whose results
+//       depend on it. When the settings are updated, the changed
+//       fields invalidate only those stages such that only results
+//       depending on them need to be recomputed, e.g. changing a
+//       plot color does not touch computation, changing a
+//       calibration does not reread waveforms, and changing a PSD
+//       integration limit does not discard the stored pulse heights
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// ROOT
+#include <TF1.h>
+
+// C++
+#include <sstream>
+
+// ADAQAnalysis
+#include "AASettings.hh"
+
+
+AASettings::AASettings()
+  : UsePileupRecovery(false), PulseTemplateFileName(""),
+    UsePeakTiming(false), TimingCFD(true), TimingLeadingEdge(false),
+    CFDFraction(0.3), CFDDelay(4), LeadingEdgeThreshold(100.),
+    BaselineEstimator(0), BaselineTrimFraction(0.1), BaselineMedianWindow(101),
+    BaselineTimeConstant(200.), BaselineThreshold(20.),
+    PersistenceFirstWaveform(0), PersistenceLastWaveform(100000),
+    PersistenceXBins(1024), PersistenceYBins(512),
+    PersistenceYMin(-256.), PersistenceYMax(4096.),
+    PersistenceEnergyGate(false), PersistenceEnergyMin(0.), PersistenceEnergyMax(1.e9),
+    PersistencePSDGate(false),
+    ADAQSpectrumAlgorithmDS(false), ShaperTrapezoid(true), ShaperCRRC(false),
+    ShaperRiseTime(10), ShaperFlatTop(5), ShaperShapingTime(8.), ShaperOrder(4),
+    ShaperDecayTime(0.),
+    SpectrumParticleEnergy(zEnergyDeposited),
+    UseFixedPoint(false),
+    ListModeOutput(false), ListModeFileName(""),
+    BuildPulseTemplates(false), PulseTemplateOutputFileName(""),
+    TemplatePreSamples(20), TemplatePostSamples(100),
+    TemplateWindowMin(0.), TemplateWindowMax(1.e9),
+    ProfileProcessing(false), ProfileFileName(""),
+    TreeCacheSize(64), TreeCacheLearnEntries(10), TreeCacheChannelOnly(false),
+    IMTThreads(0), ReadAheadSize(256),
+    WaveformCacheSize(64), WaveformPrefetch(32),
+    Tracked(false), ChangedStages(0)
+{
+  for(Int_t s=0; s<zNumPipelineStages; s++)
+    StageRevisions[s] = 0;
+}
+
+
+Int_t AASettings::GetRevision(UInt_t Stages) const
+{
+  // Revisions only ever increase so their sum changes whenever any
+  // one of the revisions changes
+  Int_t Revision = 0;
+  for(Int_t s=0; s<zNumPipelineStages; s++)
+    if(Stages & (1<<s))
+      Revision += StageRevisions[s];
+  return Revision;
+}
+
+
+void AASettings::InvalidateStages(string Field, UInt_t Stages)
+{
+  ChangedFields.push_back(Field);
+
+  // Note that each stage's revision is incremented at most once per
+  // update regardless of the number of fields that affect it
+  for(Int_t s=0; s<zNumPipelineStages; s++){
+    if((Stages & (1<<s)) and !(ChangedStages & (1<<s))){
+      ChangedStages |= (1<<s);
+      StageRevisions[s]++;
+    }
+  }
+}
+
+
+namespace{
+
+  // Serializes the contents of objects held by pointer such that
+  // modifications made in place are detected
+
+  string SerializeContents(const TGraph *Graph)
+  {
+    if(!Graph)
+      return "";
+    
+    ostringstream SS;
+    SS.precision(17);
+    SS << Graph->GetName();
+    for(Int_t p=0; p<Graph->GetN(); p++)
+      SS << " " << Graph->GetX()[p] << " " << Graph->GetY()[p];
+    return SS.str();
+  }
+
+  
+  string SerializeContents(const TF1 *Function)
+  {
+    if(!Function)
+      return "";
+    
+    ostringstream SS;
+    SS.precision(17);
+    SS << Function->GetExpFormula() << " "
+       << Function->GetXmin() << " " << Function->GetXmax();
+    for(Int_t p=0; p<Function->GetNpar(); p++)
+      SS << " " << Function->GetParameter(p);
+    return SS.str();
+  }
+}
+
+
+void AASettings::RecordContents()
+{
+  PSDRegionContents.clear();
+  for(size_t i=0; i<PSDRegions.size(); i++)
+    PSDRegionContents.push_back(SerializeContents(PSDRegions[i]));
+
+  SpectraCalibrationContents.clear();
+  for(size_t i=0; i<SpectraCalibrations.size(); i++)
+    SpectraCalibrationContents.push_back(SerializeContents(SpectraCalibrations[i]));
+
+  SpectraCalibrationDataContents.clear();
+  for(size_t i=0; i<SpectraCalibrationData.size(); i++)
+    SpectraCalibrationDataContents.push_back(SerializeContents(SpectraCalibrationData[i]));
+}
+
+
+// Macro to compare a single field to its previous value and, if the
+// value has changed, invalidate the specified mask of pipeline stages
+#define AATrackField(Field, Stages)		\
+  if(Field != Previous->Field)			\
+    InvalidateStages(#Field, Stages);
+
+
+void AASettings::TrackChanges(const AASettings *Previous)
+{
+  ChangedStages = 0;
+  ChangedFields.clear();
+
+  // The previous settings hold the contents recorded when they were
+  // tracked since the pointed-to objects may be shared between them
+  RecordContents();
+
+  // The previous values of the first settings update are undefined so
+  // all stages are invalidated
+  if(!Previous or !Previous->Tracked){
+    InvalidateStages("All", zAllStagesMask);
+    Tracked = true;
+    return;
+  }
+
+
+  /////////////////////////
+  // Waveform extraction //
+  /////////////////////////
+
+  AATrackField(ADAQFileName, zWaveformMask);
+  AATrackField(ASIMFileName, zWaveformMask);
+  AATrackField(WaveformChannel, zWaveformMask);
+  AATrackField(RawWaveform, zWaveformMask);
+  AATrackField(BSWaveform, zWaveformMask);
+  AATrackField(ZSWaveform, zWaveformMask);
+  AATrackField(WaveformPolarity, zWaveformMask);
+  AATrackField(ZeroSuppressionCeiling, zWaveformMask);
+  AATrackField(ZeroSuppressionBuffer, zWaveformMask);
+  AATrackField(BaselineRegionMin, zWaveformMask);
+  AATrackField(BaselineRegionMax, zWaveformMask);
+  AATrackField(BaselineEstimator, zWaveformMask);
+  AATrackField(BaselineTrimFraction, zWaveformMask);
+  AATrackField(BaselineMedianWindow, zWaveformMask);
+  AATrackField(BaselineTimeConstant, zWaveformMask);
+  AATrackField(BaselineThreshold, zWaveformMask);
+  AATrackField(WaveformsToHistogram, zWaveformMask);
+  AATrackField(UseFixedPoint, zWaveformMask);
+  AATrackField(PSDWaveformsToDiscriminate, zPSDMask);
+
+  // List-mode records are only written during waveform processing
+  AATrackField(ListModeOutput, zWaveformMask);
+  AATrackField(ListModeFileName, zWaveformMask);
+
+  // Pulse templates are likewise only accumulated during processing
+  AATrackField(BuildPulseTemplates, zWaveformMask);
+  AATrackField(PulseTemplateOutputFileName, zWaveformMask);
+  AATrackField(TemplatePreSamples, zWaveformMask);
+  AATrackField(TemplatePostSamples, zWaveformMask);
+  AATrackField(TemplateWindowMin, zWaveformMask);
+  AATrackField(TemplateWindowMax, zWaveformMask);
+
+  // Processing profiles are likewise only collected during waveform
+  // processing, so enabling profiling must force reprocessing
+  AATrackField(ProfileProcessing, zWaveformMask);
+  AATrackField(ProfileFileName, zWaveformMask);
+
+  // Note that the waveform to plot is intentionally not tracked: the
+  // results computed for a single waveform are keyed on the waveform
+  // number itself, so browsing waveforms invalidates nothing. The
+  // file I/O tuning settings (TreeCacheSize, etc) are likewise not
+  // tracked: they change how waveforms are read but never the
+  // result of processing them. The persistence map
+  // settings are likewise not tracked since the map is recomputed
+  // each time that it is requested
+
+
+  //////////////////
+  // Peak finding //
+  //////////////////
+
+  AATrackField(FindPeaks, zPeakFindingMask);
+  AATrackField(UseMarkovSmoothing, zPeakFindingMask);
+  AATrackField(MaxPeaks, zPeakFindingMask);
+  AATrackField(Sigma, zPeakFindingMask);
+  AATrackField(Resolution, zPeakFindingMask);
+  AATrackField(Floor, zPeakFindingMask);
+  AATrackField(UsePileupRejection, zPeakFindingMask);
+  AATrackField(UsePeakTiming, zPeakFindingMask);
+  AATrackField(TimingCFD, zPeakFindingMask);
+  AATrackField(TimingLeadingEdge, zPeakFindingMask);
+  AATrackField(CFDFraction, zPeakFindingMask);
+  AATrackField(CFDDelay, zPeakFindingMask);
+  AATrackField(LeadingEdgeThreshold, zPeakFindingMask);
+  AATrackField(AnalysisRegionMin, zPeakFindingMask);
+  AATrackField(AnalysisRegionMax, zPeakFindingMask);
+  AATrackField(ADAQSpectrumAlgorithmSMS, zPeakFindingMask);
+  AATrackField(ADAQSpectrumAlgorithmPF, zPeakFindingMask);
+  AATrackField(ADAQSpectrumAlgorithmWD, zPeakFindingMask);
+  AATrackField(ADAQSpectrumAlgorithmDS, zPeakFindingMask);
+  AATrackField(PSDAlgorithmSMS, zPSDMask);
+  AATrackField(PSDAlgorithmPF, zPSDMask);
+  AATrackField(PSDAlgorithmWD, zPSDMask);
+
+
+  ////////////////////////
+  // Feature extraction //
+  ////////////////////////
+
+  AATrackField(ShaperTrapezoid, zFeaturesMask);
+  AATrackField(ShaperCRRC, zFeaturesMask);
+  AATrackField(ShaperRiseTime, zFeaturesMask);
+  AATrackField(ShaperFlatTop, zFeaturesMask);
+  AATrackField(ShaperShapingTime, zFeaturesMask);
+  AATrackField(ShaperOrder, zFeaturesMask);
+  AATrackField(ShaperDecayTime, zFeaturesMask);
+  AATrackField(UsePileupRecovery, zFeaturesMask);
+  AATrackField(PulseTemplateFileName, zFeaturesMask);
+
+
+  ///////////////////
+  // PSD integrals //
+  ///////////////////
+
+  AATrackField(PSDTotalStart, zPSDMask);
+  AATrackField(PSDTotalStop, zPSDMask);
+  AATrackField(PSDTailStart, zPSDMask);
+  AATrackField(PSDTailStop, zPSDMask);
+  AATrackField(PSDThreshold, zPSDMask);
+  AATrackField(PSDInsideRegion, zPSDMask);
+  AATrackField(PSDOutsideRegion, zPSDMask);
+  if(PSDRegionContents != Previous->PSDRegionContents)
+    InvalidateStages("PSDRegions", zPSDMask);
+
+  // The PSD regions filter the waveforms entering the spectrum
+  AATrackField(UsePSDRegions, zFeaturesMask | zPSDMask);
+
+
+  /////////////////
+  // Calibration //
+  /////////////////
+
+  AATrackField(CalibrationType, zCalibrationMask);
+  AATrackField(CalibrationMin, zCalibrationMask);
+  AATrackField(CalibrationMax, zCalibrationMask);
+  AATrackField(EnergyUnit, zCalibrationMask | zPlotMask);
+  AATrackField(UseSpectraCalibrations, zCalibrationMask);
+  if(SpectraCalibrationContents != Previous->SpectraCalibrationContents)
+    InvalidateStages("SpectraCalibrations", zCalibrationMask);
+  if(SpectraCalibrationDataContents != Previous->SpectraCalibrationDataContents)
+    InvalidateStages("SpectraCalibrationData", zCalibrationMask);
+  AATrackField(PSDXAxisADC, zCalibrationMask | zHistogramMask);
+  AATrackField(PSDXAxisEnergy, zCalibrationMask | zHistogramMask);
+
+
+  ///////////////////
+  // Histogramming //
+  ///////////////////
+
+  AATrackField(SpectrumNumBins, zHistogramMask);
+  AATrackField(SpectrumMinBin, zHistogramMask);
+  AATrackField(SpectrumMaxBin, zHistogramMask);
+  AATrackField(SpectrumMinThresh, zHistogramMask);
+  AATrackField(SpectrumMaxThresh, zHistogramMask);
+  AATrackField(ADAQSpectrumTypePAS, zHistogramMask);
+  AATrackField(ADAQSpectrumTypePHS, zHistogramMask);
+  AATrackField(ASIMSpectrumTypeEnergy, zHistogramMask);
+  AATrackField(ASIMSpectrumTypePhotonsCreated, zHistogramMask);
+  AATrackField(ASIMSpectrumTypePhotonsDetected, zHistogramMask);
+  AATrackField(ASIMEventTreeName, zHistogramMask);
+  AATrackField(PSDNumTotalBins, zHistogramMask);
+  AATrackField(PSDMinTotalBin, zHistogramMask);
+  AATrackField(PSDMaxTotalBin, zHistogramMask);
+  AATrackField(PSDNumTailBins, zHistogramMask);
+  AATrackField(PSDMinTailBin, zHistogramMask);
+  AATrackField(PSDMaxTailBin, zHistogramMask);
+  AATrackField(PSDYAxisTail, zHistogramMask);
+  AATrackField(PSDYAxisTailTotal, zHistogramMask);
+
+
+  /////////////////////////////////////
+  // Spectrum background/integration //
+  /////////////////////////////////////
+
+  AATrackField(FindBackground, zAnalysisMask);
+  AATrackField(BackgroundIterations, zAnalysisMask);
+  AATrackField(BackgroundCompton, zAnalysisMask);
+  AATrackField(BackgroundSmoothing, zAnalysisMask);
+  AATrackField(BackgroundMinBin, zAnalysisMask);
+  AATrackField(BackgroundMaxBin, zAnalysisMask);
+  AATrackField(BackgroundDirection, zAnalysisMask);
+  AATrackField(BackgroundFilterOrder, zAnalysisMask);
+  AATrackField(BackgroundSmoothingWidth, zAnalysisMask);
+  AATrackField(PlotWithBackground, zAnalysisMask);
+  AATrackField(PlotLessBackground, zAnalysisMask);
+  AATrackField(SpectrumFindIntegral, zAnalysisMask);
+  AATrackField(SpectrumIntegralInCounts, zAnalysisMask);
+  AATrackField(SpectrumUseGaussianFit, zAnalysisMask);
+  AATrackField(SpectrumIntegrationMin, zAnalysisMask);
+  AATrackField(SpectrumIntegrationMax, zAnalysisMask);
+  AATrackField(PSDXSlice, zAnalysisMask);
+  AATrackField(PSDYSlice, zAnalysisMask);
+  AATrackField(PSDCalculateFOM, zAnalysisMask);
+  AATrackField(PSDLowerFOMFitMin, zAnalysisMask);
+  AATrackField(PSDLowerFOMFitMax, zAnalysisMask);
+  AATrackField(PSDUpperFOMFitMin, zAnalysisMask);
+  AATrackField(PSDUpperFOMFitMax, zAnalysisMask);
+
+
+  //////////////
+  // Plotting //
+  //////////////
+
+  AATrackField(PlotZeroSuppressionCeiling, zPlotMask);
+  AATrackField(SpectrumParticleEnergy, zPlotMask);
+  AATrackField(ScintillatorResponses, zPlotMask);
+  AATrackField(PlotFloor, zPlotMask);
+  AATrackField(PlotCrossings, zPlotMask);
+  AATrackField(PlotPeakIntegrationRegion, zPlotMask);
+  AATrackField(PlotBaselineRegion, zPlotMask);
+  AATrackField(PlotAnalysisRegion, zPlotMask);
+  AATrackField(PlotTrigger, zPlotMask);
+  AATrackField(WaveformAnalysis, zPlotMask);
+  AATrackField(PSDPlotType, zPlotMask);
+  AATrackField(PSDPlotIntegrationLimits, zPlotMask);
+
+  AATrackField(WaveformLine, zPlotMask);
+  AATrackField(WaveformCurve, zPlotMask);
+  AATrackField(WaveformMarkers, zPlotMask);
+  AATrackField(WaveformBoth, zPlotMask);
+  AATrackField(WaveformLineWidth, zPlotMask);
+  AATrackField(WaveformMarkerSize, zPlotMask);
+  AATrackField(SpectrumLine, zPlotMask);
+  AATrackField(SpectrumCurve, zPlotMask);
+  AATrackField(SpectrumError, zPlotMask);
+  AATrackField(SpectrumBars, zPlotMask);
+  AATrackField(SpectrumLineWidth, zPlotMask);
+  AATrackField(SpectrumFillStyle, zPlotMask);
+  AATrackField(HistogramStats, zPlotMask);
+  AATrackField(CanvasGrid, zPlotMask);
+  AATrackField(CanvasXAxisLog, zPlotMask);
+  AATrackField(CanvasYAxisLog, zPlotMask);
+  AATrackField(CanvasZAxisLog, zPlotMask);
+  AATrackField(PlotSpectrumDerivativeError, zPlotMask);
+  AATrackField(PlotAbsValueSpectrumDerivative, zPlotMask);
+  AATrackField(PlotYAxisWithAutoRange, zPlotMask);
+  AATrackField(OverrideGraphicalDefault, zPlotMask);
+  AATrackField(PlotTitle, zPlotMask);
+  AATrackField(XAxisTitle, zPlotMask);
+  AATrackField(YAxisTitle, zPlotMask);
+  AATrackField(ZAxisTitle, zPlotMask);
+  AATrackField(PaletteTitle, zPlotMask);
+  AATrackField(XSize, zPlotMask);
+  AATrackField(YSize, zPlotMask);
+  AATrackField(ZSize, zPlotMask);
+  AATrackField(PaletteSize, zPlotMask);
+  AATrackField(XOffset, zPlotMask);
+  AATrackField(YOffset, zPlotMask);
+  AATrackField(ZOffset, zPlotMask);
+  AATrackField(PaletteOffset, zPlotMask);
+  AATrackField(XDivs, zPlotMask);
+  AATrackField(YDivs, zPlotMask);
+  AATrackField(ZDivs, zPlotMask);
+  AATrackField(PaletteX1, zPlotMask);
+  AATrackField(PaletteX2, zPlotMask);
+  AATrackField(PaletteY1, zPlotMask);
+  AATrackField(PaletteY2, zPlotMask);
+  AATrackField(XAxisMin, zPlotMask);
+  AATrackField(XAxisMax, zPlotMask);
+  AATrackField(YAxisMin, zPlotMask);
+  AATrackField(YAxisMax, zPlotMask);
+
+  // Note that the processing frame settings (architecture, number of
+  // processors, update frequency, desplicing) are not tracked since
+  // they only affect explicitly requested actions
+}
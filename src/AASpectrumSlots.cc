@@ -87,14 +87,13 @@ void AASpectrumSlots::HandleComboBoxes(int ComboBoxID, int SelectedID)
 
   case ASIMEventTree_CB_ID:{
     
-    TList *ASIMEventTreeList = ComputationMgr->GetASIMEventTreeList();
-    TString EventTreeName = TheInterface->ASIMEventTree_CB->GetSelectedEntry()->GetTitle();
-    TTree *EventTree = (TTree *)ASIMEventTreeList->FindObject(EventTreeName);
-    if(EventTree == NULL)
+    string EventTreeName = TheInterface->ASIMEventTree_CB->GetSelectedEntry()->GetTitle();
+    Long64_t EventTreeEntries = ComputationMgr->GetASIMEventTreeEntries(EventTreeName);
+    if(EventTreeEntries < 0)
       return;
     
-    TheInterface->WaveformsToHistogram_NEL->GetEntry()->SetNumber(EventTree->GetEntries());
-    TheInterface->WaveformsToHistogram_NEL->GetEntry()->SetLimitValues(0, EventTree->GetEntries());
+    TheInterface->WaveformsToHistogram_NEL->GetEntry()->SetNumber(EventTreeEntries);
+    TheInterface->WaveformsToHistogram_NEL->GetEntry()->SetLimitValues(0, EventTreeEntries);
     break;
   }
 
@@ -215,6 +214,7 @@ void AASpectrumSlots::HandleRadioButtons()
     if(RadioButton->IsDown()){
       TheInterface->ADAQSpectrumAlgorithmPF_RB->SetState(kButtonUp);
       TheInterface->ADAQSpectrumAlgorithmWD_RB->SetState(kButtonUp);
+      TheInterface->ADAQSpectrumAlgorithmDS_RB->SetState(kButtonUp);
     }
     break;
 
@@ -222,6 +222,7 @@ void AASpectrumSlots::HandleRadioButtons()
     if(RadioButton->IsDown()){
       TheInterface->ADAQSpectrumAlgorithmSMS_RB->SetState(kButtonUp);
       TheInterface->ADAQSpectrumAlgorithmWD_RB->SetState(kButtonUp);
+      TheInterface->ADAQSpectrumAlgorithmDS_RB->SetState(kButtonUp);
     }
     break;
 
@@ -229,9 +230,28 @@ void AASpectrumSlots::HandleRadioButtons()
     if(RadioButton->IsDown()){
       TheInterface->ADAQSpectrumAlgorithmPF_RB->SetState(kButtonUp);
       TheInterface->ADAQSpectrumAlgorithmSMS_RB->SetState(kButtonUp);
+      TheInterface->ADAQSpectrumAlgorithmDS_RB->SetState(kButtonUp);
     }
     break;
 
+  case ADAQSpectrumAlgorithmDS_RB_ID:
+    if(RadioButton->IsDown()){
+      TheInterface->ADAQSpectrumAlgorithmSMS_RB->SetState(kButtonUp);
+      TheInterface->ADAQSpectrumAlgorithmPF_RB->SetState(kButtonUp);
+      TheInterface->ADAQSpectrumAlgorithmWD_RB->SetState(kButtonUp);
+    }
+    break;
+
+  case ShaperTrapezoid_RB_ID:
+    if(RadioButton->IsDown())
+      TheInterface->ShaperCRRC_RB->SetState(kButtonUp);
+    break;
+
+  case ShaperCRRC_RB_ID:
+    if(RadioButton->IsDown())
+      TheInterface->ShaperTrapezoid_RB->SetState(kButtonUp);
+    break;
+
   case ASIMSpectrumTypeEnergy_RB_ID:
     if(RadioButton->IsDown()){
       TheInterface->ASIMSpectrumTypePhotonsCreated_RB->SetState(kButtonUp);
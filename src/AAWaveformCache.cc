@@ -0,0 +1,382 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAWaveformCache.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAWaveformCache class implements the per-channel LRU cache
+//       of decoded waveforms and the background waveform prefetcher.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// ROOT
+#include <TFile.h>
+#include <TTree.h>
+#include <TBranch.h>
+#include <TROOT.h>
+#include <RVersion.h>
+
+// C++
+#include <list>
+#include <map>
+#include <sstream>
+using namespace std;
+
+// Boost
+#include <boost/thread.hpp>
+
+// ADAQAnalysis
+#include "AAWaveformCache.hh"
+
+
+namespace{
+
+  typedef list< pair<Int_t, vector<Int_t> > > WaveformList;
+
+  // The cached waveforms of a channel ordered from the most to the
+  // least recently used with an index of their positions by entry
+  struct ChannelCache{
+    ChannelCache() : Bytes(0) {}
+    
+    WaveformList Waveforms;
+    map<Int_t, WaveformList::iterator> Index;
+    size_t Bytes;
+  };
+}
+
+
+// The cache and prefetch request state is shared between the main
+// thread and the prefetch thread and is protected by the mutex
+struct AAWaveformCacheData
+{
+  AAWaveformCacheData()
+    : Budget(0), PrefetchEntries(0), Hits(0), Misses(0),
+      Worker(NULL), Stop(false), Pending(false), Generation(0),
+      RequestChannel(0), RequestEntry(0), RequestDirection(1)
+  {}
+
+  Bool_t Contains(Int_t Channel, Int_t Entry)
+  {
+    map<Int_t, ChannelCache>::iterator It = Channels.find(Channel);
+    return (It != Channels.end() and It->second.Index.count(Entry));
+  }
+  
+  void Insert(Int_t Channel, Int_t Entry, const vector<Int_t> &Waveform)
+  {
+    size_t Size = Waveform.size()*sizeof(Int_t);
+    if(Size == 0 or Size > Budget)
+      return;
+
+    ChannelCache &C = Channels[Channel];
+
+    map<Int_t, WaveformList::iterator>::iterator It = C.Index.find(Entry);
+    if(It != C.Index.end()){
+      C.Waveforms.splice(C.Waveforms.begin(), C.Waveforms, It->second);
+      return;
+    }
+
+    // Evict the least recently used waveforms until the waveform fits
+    // within the budget. The storage of an evicted waveform is reused
+    // such that a full cache does not allocate for each insertion
+    WaveformList Recycled;
+    while(C.Bytes + Size > Budget and !C.Waveforms.empty()){
+      WaveformList::iterator Last = --C.Waveforms.end();
+      C.Bytes -= Last->second.size()*sizeof(Int_t);
+      C.Index.erase(Last->first);
+      if(Recycled.empty())
+	Recycled.splice(Recycled.begin(), C.Waveforms, Last);
+      else
+	C.Waveforms.erase(Last);
+    }
+
+    if(Recycled.empty())
+      C.Waveforms.push_front(make_pair(Entry, vector<Int_t>()));
+    else
+      C.Waveforms.splice(C.Waveforms.begin(), Recycled);
+
+    C.Waveforms.front().first = Entry;
+    C.Waveforms.front().second.assign(Waveform.begin(), Waveform.end());
+    C.Index[Entry] = C.Waveforms.begin();
+    C.Bytes += Size;
+  }
+
+  void Trim()
+  {
+    map<Int_t, ChannelCache>::iterator It;
+    for(It=Channels.begin(); It!=Channels.end(); It++){
+      ChannelCache &C = It->second;
+      while(C.Bytes > Budget){
+	C.Bytes -= C.Waveforms.back().second.size()*sizeof(Int_t);
+	C.Index.erase(C.Waveforms.back().first);
+	C.Waveforms.pop_back();
+      }
+    }
+  }
+  
+  map<Int_t, ChannelCache> Channels;
+  size_t Budget;
+  Int_t PrefetchEntries;
+  Long64_t Hits, Misses;
+
+  string FileName, TreeName, BranchPrefix;
+
+  boost::mutex Mutex;
+  boost::condition_variable Condition;
+  boost::thread *Worker;
+  Bool_t Stop, Pending;
+
+  // Incremented by each new request (and by changes of file or
+  // cache) such that the prefetcher abandons superseded requests
+  Long64_t Generation;
+  Int_t RequestChannel, RequestEntry, RequestDirection;
+};
+
+
+namespace{
+
+  // The prefetch thread waits for requests and reads the requested
+  // entries of a single channel's waveform branch from its own TFile,
+  // which remains open between requests
+  void PrefetchWaveforms(AAWaveformCacheData *D)
+  {
+    TFile *F = NULL;
+    TTree *T = NULL;
+    TBranch *B = NULL;
+    vector<Int_t> *Voltage = NULL;
+
+    string OpenFileName = "";
+    Int_t OpenChannel = -1;
+
+    while(true){
+      string FileName, TreeName, BranchPrefix;
+      Int_t Channel, Entry, Direction, NumEntries;
+      Long64_t Generation;
+      size_t Budget;
+      
+      {
+	boost::unique_lock<boost::mutex> Lock(D->Mutex);
+	while(!D->Stop and !D->Pending)
+	  D->Condition.wait(Lock);
+
+	if(D->Stop)
+	  break;
+
+	D->Pending = false;
+
+	FileName = D->FileName;
+	TreeName = D->TreeName;
+	BranchPrefix = D->BranchPrefix;
+	Channel = D->RequestChannel;
+	Entry = D->RequestEntry;
+	Direction = D->RequestDirection;
+	NumEntries = D->PrefetchEntries;
+	Generation = D->Generation;
+	Budget = D->Budget;
+      }
+
+      if(FileName != OpenFileName){
+	if(T)
+	  T->ResetBranchAddresses();
+	delete F;
+	
+	F = new TFile(FileName.c_str(), "read");
+	T = (F->IsOpen()) ? (TTree *)F->Get(TreeName.c_str()) : NULL;
+	B = NULL;
+	
+	OpenFileName = FileName;
+	OpenChannel = -1;
+      }
+
+      if(T and Channel != OpenChannel){
+	stringstream SS;
+	SS << BranchPrefix << Channel;
+
+	T->SetBranchStatus("*", 0);
+	B = T->GetBranch(SS.str().c_str());
+	if(B){
+	  T->SetBranchStatus(SS.str().c_str(), 1);
+	  T->SetBranchAddress(SS.str().c_str(), &Voltage);
+	}
+	OpenChannel = Channel;
+      }
+
+      if(!B)
+	continue;
+
+      // At most half of the budget is used for prefetched waveforms
+      // such that recently viewed waveforms are not evicted
+      Long64_t Entries = T->GetEntries();
+      size_t PrefetchBytes = 0;
+      
+      for(Int_t n=1; n<=NumEntries; n++){
+	Long64_t e = Entry + (Long64_t)n*Direction;
+	if(e < 0 or e >= Entries)
+	  break;
+	
+	{
+	  boost::unique_lock<boost::mutex> Lock(D->Mutex);
+	  if(D->Stop or D->Generation != Generation)
+	    break;
+	  if(D->Contains(Channel, e))
+	    continue;
+	}
+
+	B->GetEntry(e);
+
+	PrefetchBytes += Voltage->size()*sizeof(Int_t);
+	if(PrefetchBytes > Budget/2)
+	  break;
+	
+	{
+	  boost::unique_lock<boost::mutex> Lock(D->Mutex);
+	  if(D->Generation != Generation)
+	    break;
+	  D->Insert(Channel, e, *Voltage);
+	}
+      }
+    }
+
+    if(T)
+      T->ResetBranchAddresses();
+    delete Voltage;
+    delete F;
+  }
+}
+
+
+AAWaveformCache::AAWaveformCache()
+  : Data(new AAWaveformCacheData)
+{;}
+
+
+AAWaveformCache::~AAWaveformCache()
+{
+  if(Data->Worker){
+    {
+      boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+      Data->Stop = true;
+    }
+    Data->Condition.notify_all();
+    Data->Worker->join();
+    delete Data->Worker;
+  }
+  delete Data;
+}
+
+
+void AAWaveformCache::SetFile(string FileName, string TreeName, string BranchPrefix)
+{
+  boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+
+  Data->FileName = FileName;
+  Data->TreeName = TreeName;
+  Data->BranchPrefix = BranchPrefix;
+  
+  Data->Channels.clear();
+  Data->Pending = false;
+  Data->Generation++;
+}
+
+
+void AAWaveformCache::Configure(Int_t Budget, Int_t PrefetchEntries)
+{
+  boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+
+  Data->Budget = (Budget > 0) ? (size_t)Budget*1024*1024 : 0;
+  Data->PrefetchEntries = (PrefetchEntries > 0) ? PrefetchEntries : 0;
+  Data->Trim();
+}
+
+
+void AAWaveformCache::Clear()
+{
+  boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+
+  Data->Channels.clear();
+  Data->Generation++;
+}
+
+
+Bool_t AAWaveformCache::Get(Int_t Channel, Int_t Entry, vector<Int_t> &Waveform)
+{
+  boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+
+  if(Data->Budget == 0)
+    return false;
+
+  map<Int_t, ChannelCache>::iterator C = Data->Channels.find(Channel);
+  if(C != Data->Channels.end()){
+    map<Int_t, WaveformList::iterator>::iterator It = C->second.Index.find(Entry);
+    if(It != C->second.Index.end()){
+      WaveformList &Waveforms = C->second.Waveforms;
+      Waveforms.splice(Waveforms.begin(), Waveforms, It->second);
+      Waveform = It->second->second;
+      Data->Hits++;
+      return true;
+    }
+  }
+  
+  Data->Misses++;
+  return false;
+}
+
+
+void AAWaveformCache::Insert(Int_t Channel, Int_t Entry, const vector<Int_t> &Waveform)
+{
+  boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+  Data->Insert(Channel, Entry, Waveform);
+}
+
+
+void AAWaveformCache::Prefetch(Int_t Channel, Int_t Entry, Int_t Direction)
+{
+  // ROOT objects may only be used in separate threads with ROOT v6
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0)
+  {
+    boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+    
+    if(Data->Budget == 0 or Data->PrefetchEntries == 0 or Data->FileName == "")
+      return;
+    
+    Data->RequestChannel = Channel;
+    Data->RequestEntry = Entry;
+    Data->RequestDirection = (Direction < 0) ? -1 : 1;
+    Data->Pending = true;
+    Data->Generation++;
+    
+    if(!Data->Worker){
+      ROOT::EnableThreadSafety();
+      Data->Worker = new boost::thread(PrefetchWaveforms, Data);
+    }
+  }
+  Data->Condition.notify_all();
+#endif
+}
+
+
+Long64_t AAWaveformCache::GetHits() const
+{
+  boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+  return Data->Hits;
+}
+
+
+Long64_t AAWaveformCache::GetMisses() const
+{
+  boost::unique_lock<boost::mutex> Lock(Data->Mutex);
+  return Data->Misses;
+}
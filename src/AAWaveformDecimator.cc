@@ -0,0 +1,140 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: AAWaveformDecimator.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: The AAWaveformDecimator class computes the min/max envelope
+//       of long waveforms for plotting from a precomputed pyramid.
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <algorithm>
+#include <cmath>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAWaveformDecimator.hh"
+
+
+AAWaveformDecimator::AAWaveformDecimator()
+  : NumSamples(0), Start(0.), Width(1.)
+{;}
+
+
+void AAWaveformDecimator::Build(const Float_t *Samples, Int_t N, Double_t S, Double_t W)
+{
+  NumSamples = (N > 0) ? N : 0;
+  Start = S;
+  Width = (W > 0.) ? W : 1.;
+
+  // The level vectors are reused between waveforms to avoid
+  // reallocation when browsing records of the same length
+  Int_t Levels = 1;
+  for(Int_t Size=NumSamples; Size>1; Size=(Size+1)/2)
+    Levels++;
+
+  Min.resize(Levels);
+  Max.resize(Levels);
+
+  Min[0].assign(Samples, Samples + NumSamples);
+  Max[0].assign(Samples, Samples + NumSamples);
+
+  // Each block is the union of two blocks of the level below; the
+  // last block of a level with an odd number of blocks is carried up
+  for(Int_t l=1; l<Levels; l++){
+    const vector<Float_t> &LowerMin = Min[l-1];
+    const vector<Float_t> &LowerMax = Max[l-1];
+    Int_t LowerSize = LowerMin.size();
+    Int_t Size = (LowerSize+1)/2;
+
+    Min[l].resize(Size);
+    Max[l].resize(Size);
+
+    for(Int_t b=0; b<Size; b++){
+      Int_t b0 = 2*b, b1 = min(2*b+1, LowerSize-1);
+      Min[l][b] = min(LowerMin[b0], LowerMin[b1]);
+      Max[l][b] = max(LowerMax[b0], LowerMax[b1]);
+    }
+  }
+}
+
+
+void AAWaveformDecimator::GetRange(Int_t First, Int_t Last, Float_t &RangeMin, Float_t &RangeMax) const
+{
+  RangeMin = Min[0][First];
+  RangeMax = Max[0][First];
+
+  // Combine the largest blocks that lie within the range, moving up
+  // one level per iteration from both ends of the range
+  for(Int_t l=0; First<Last; l++){
+    if(First & 1){
+      RangeMin = min(RangeMin, Min[l][First]);
+      RangeMax = max(RangeMax, Max[l][First]);
+      First++;
+    }
+    if(Last & 1){
+      Last--;
+      RangeMin = min(RangeMin, Min[l][Last]);
+      RangeMax = max(RangeMax, Max[l][Last]);
+    }
+    First >>= 1;
+    Last >>= 1;
+  }
+}
+
+
+Bool_t AAWaveformDecimator::Decimate(Double_t XMin, Double_t XMax, Int_t Columns,
+				     vector<Double_t> &X, vector<Double_t> &Y) const
+{
+  X.clear();
+  Y.clear();
+
+  if(NumSamples == 0 or Columns < 1)
+    return false;
+
+  Int_t First = max(0, (Int_t)floor((XMin - Start)/Width));
+  Int_t Last = min(NumSamples, (Int_t)ceil((XMax - Start)/Width) + 1);
+
+  // Drawing the envelope is only worthwhile if each column contains
+  // several samples
+  if(Last - First <= 2*Columns)
+    return false;
+
+  Double_t SamplesPerColumn = (Double_t)(Last - First)/Columns;
+
+  X.reserve(2*Columns);
+  Y.reserve(2*Columns);
+
+  for(Int_t c=0; c<Columns; c++){
+    Int_t ColumnFirst = First + (Int_t)(c*SamplesPerColumn);
+    Int_t ColumnLast = (c == Columns-1) ? Last : First + (Int_t)((c+1)*SamplesPerColumn);
+
+    Float_t ColumnMin, ColumnMax;
+    GetRange(ColumnFirst, ColumnLast, ColumnMin, ColumnMax);
+
+    Double_t ColumnX = Start + Width*0.5*(ColumnFirst + ColumnLast - 1);
+
+    X.push_back(ColumnX);
+    Y.push_back(ColumnMin);
+    X.push_back(ColumnX);
+    Y.push_back(ColumnMax);
+  }
+
+  return true;
+}
@@ -95,6 +95,10 @@ void AAWaveformSlots::HandleComboBoxes(int ComboBoxID, int SelectedID)
   case ChannelSelector_CBL_ID:
     TheInterface->UpdateForADAQFile();
     break;
+
+  case BaselineEstimator_CBL_ID:
+    GraphicsMgr->PlotWaveform();
+    break;
     
   default:
     break;
@@ -143,6 +147,10 @@ void AAWaveformSlots::HandleNumberEntries()
   case AnalysisRegionMax_NEL_ID:
   case BaselineRegionMin_NEL_ID:
   case BaselineRegionMax_NEL_ID:
+  case BaselineTrimFraction_NEL_ID:
+  case BaselineMedianWindow_NEL_ID:
+  case BaselineTimeConstant_NEL_ID:
+  case BaselineThreshold_NEL_ID:
   case ZeroSuppressionCeiling_NEL_ID:
   case ZeroSuppressionBuffer_NEL_ID:
     GraphicsMgr->PlotWaveform();
@@ -197,3 +205,30 @@ void AAWaveformSlots::HandleRadioButtons()
     break;
   }
 }
+
+
+void AAWaveformSlots::HandleTextButtons()
+{
+  if(!TheInterface->EnableInterface or !TheInterface->ADAQFileLoaded)
+    return;
+  
+  TGTextButton *TextButton = (TGTextButton *) gTQSender;
+  int TextButtonID = TextButton->WidgetId();
+  
+  TheInterface->SaveSettings();
+  
+  switch(TextButtonID){
+    
+  case CreatePersistenceMap_TB_ID:
+    ComputationMgr->CreatePersistenceMap();
+    
+    if(ComputationMgr->GetPersistenceMapExists())
+      GraphicsMgr->PlotPersistenceMap();
+    else
+      TheInterface->CreateMessageBox("The persistence map could not be created! Check the waveform range and binning.","Stop");
+    break;
+    
+  default:
+    break;
+  }
+}
@@ -0,0 +1,140 @@
+/////////////////////////////////////////////////////////////////////////////////
+//                                                                             //
+//                           Copyright (C) 2012-2016                           //
+//                 Zachary Seth Hartwig : All rights reserved                  //
+//                                                                             //
+//      The ADAQAnalysis source code is licensed under the GNU GPL v3.0.       //
+//      You have the right to modify and/or redistribute this source code      //
+//      under the terms specified in the license, which may be found online    //
+//      at http://www.gnu.org/licenses or at $ADAQANALYSIS/License.txt.        //
+//                                                                             //
+/////////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////////
+//
+// name: ADAQFixedPointTest.cc
+// date: 19 Oct 26
+// auth: Zach Hartwig
+// mail: hartwig@psfc.mit.edu
+//
+// desc: ADAQFixedPointTest checks the fixed-point pulse features of
+//       AAFixedPointWaveform against the floating point path, i.e. the
+//       baseline-subtracted waveform of the mean AABaselineEstimator,
+//       over a set of pseudo-random waveforms of both polarities. The
+//       fixed-point baseline is rounded to the nearest 1/256 ADC such
+//       that the maximum must agree within 1/512 ADC and the integral
+//       within 1/512 ADC per integrated sample, plus the rounding of
+//       the floating point samples. The sample of the maximum must
+//       agree exactly. A nonzero value is returned if any check fails.
+//       It is built and run by "make test".
+//
+//       $ ADAQFixedPointTest
+//
+/////////////////////////////////////////////////////////////////////////////////
+
+// C++
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+using namespace std;
+
+// ADAQAnalysis
+#include "AAFixedPointWaveform.hh"
+#include "AABaselineEstimator.hh"
+
+
+// A minimal linear congruential generator such that the waveforms are
+// identical on all platforms
+static UInt_t Seed = 12345;
+
+Double_t Uniform()
+{
+  Seed = 1664525*Seed + 1013904223;
+  return (Seed >> 8)*(1./(1 << 24));
+}
+
+
+int main()
+{
+  const Int_t NumWaveforms = 2000;
+  const Int_t NumSamples = 512;
+  const Int_t BaselineMin = 0, BaselineMax = 100;
+  const Int_t AnalysisMin = 90, AnalysisMax = 400;
+
+  const Double_t Bound = 1./512;
+
+  AABaselineEstimator Estimator;
+  Estimator.Configure(AABaselineEstimator::zMeanBaseline, BaselineMin, BaselineMax,
+		      0., 1, 1., 0.);
+
+  AAFixedPointWaveform FixedPoint;
+
+  vector<Int_t> Samples(NumSamples);
+  vector<Float_t> BSSamples(NumSamples);
+
+  Int_t Failures = 0;
+  Double_t MaxHeightDeviation = 0., MaxIntegralDeviation = 0.;
+
+  for(Int_t w=0; w<NumWaveforms; w++){
+
+    // A noisy baseline at an arbitrary (14-bit) offset and a pulse of
+    // random amplitude and position of either polarity
+    const Int_t Polarity = (w % 2) ? -1 : 1;
+    const Double_t Offset = 1000. + 14000.*Uniform();
+    const Double_t Amplitude = (Polarity > 0 ? 16383. - Offset : Offset)*Uniform();
+    const Double_t Start = 150. + 100.*Uniform();
+
+    for(Int_t s=0; s<NumSamples; s++){
+      Double_t V = Offset + 8.*(Uniform() - 0.5);
+      if(s > Start)
+	V += Polarity*Amplitude*exp(-(s-Start)/40.)*(1. - exp(-(s-Start)/4.));
+      Samples[s] = (Int_t)floor(V + 0.5);
+    }
+
+    // The floating point path
+    Estimator.Subtract(&Samples[0], NumSamples, Polarity, &BSSamples[0]);
+
+    Int_t FloatPosition = AnalysisMin;
+    Double_t FloatHeight = BSSamples[AnalysisMin], FloatIntegral = 0., FloatAbsolute = 0.;
+    for(Int_t s=AnalysisMin; s<=AnalysisMax; s++){
+      if(BSSamples[s] > FloatHeight){
+	FloatHeight = BSSamples[s];
+	FloatPosition = s;
+      }
+      FloatIntegral += BSSamples[s];
+      FloatAbsolute += fabs(BSSamples[s]);
+    }
+
+    // The fixed-point path
+    FixedPoint.Set(&Samples[0], NumSamples, Polarity, BaselineMin, BaselineMax);
+
+    Long64_t Height = 0;
+    Int_t Position = FixedPoint.GetMaximum(AnalysisMin, AnalysisMax, Height);
+    Double_t Integral = AAFixedPointWaveform::ToDouble(FixedPoint.GetIntegral(AnalysisMin, AnalysisMax));
+
+    Double_t HeightDeviation = fabs(AAFixedPointWaveform::ToDouble(Height) - FloatHeight);
+    Double_t IntegralDeviation = fabs(Integral - FloatIntegral);
+
+    MaxHeightDeviation = max(MaxHeightDeviation, HeightDeviation);
+    MaxIntegralDeviation = max(MaxIntegralDeviation, IntegralDeviation);
+
+    const Double_t IntegratedSamples = AnalysisMax - AnalysisMin + 1;
+
+    if(Position != FloatPosition or
+       HeightDeviation > Bound + fabs(FloatHeight)*FLT_EPSILON or
+       IntegralDeviation > IntegratedSamples*Bound + FloatAbsolute*FLT_EPSILON){
+      cout << "  FAIL  Waveform " << w << " : maximum at " << Position << " (float " << FloatPosition
+	   << "), height deviation " << HeightDeviation
+	   << ", integral deviation " << IntegralDeviation << endl;
+      Failures++;
+    }
+  }
+
+  cout << "\nADAQFixedPointTest : " << NumWaveforms - Failures << " of " << NumWaveforms
+       << " waveforms within the fixed-point bound (max height deviation "
+       << MaxHeightDeviation << " ADC, max integral deviation "
+       << MaxIntegralDeviation << " ADC)\n" << endl;
+
+  return (Failures > 0);
+}